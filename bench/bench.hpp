@@ -0,0 +1,96 @@
+/**
+ * AriaSH Benchmark Harness
+ *
+ * Shared by the bench_* programs. Every metric is measured several times
+ * after a warm-up run and reported as the median with its spread, so
+ * numbers from two builds can be compared at a glance:
+ *
+ *   ring_buffer/chunk=4096            5.83 GB/s   (median of 5, 5.71 .. 5.90)
+ *
+ * ARIASH_BENCH_RUNS sets the repetitions (default 5). A spread wider than
+ * a few percent means the machine was busy: rerun before drawing
+ * conclusions.
+ */
+
+#ifndef ARIASH_BENCH_HPP
+#define ARIASH_BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ariash {
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Repetitions per metric (ARIASH_BENCH_RUNS, at least 1)
+ */
+inline int runs() {
+    const char* env = std::getenv("ARIASH_BENCH_RUNS");
+    int n = env ? std::atoi(env) : 5;
+    return n > 0 ? n : 1;
+}
+
+/**
+ * Value at quantile q (0..1) of unsorted samples
+ */
+inline double percentile(std::vector<double> samples, double q) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    size_t idx = static_cast<size_t>(q * static_cast<double>(samples.size() - 1) + 0.5);
+    return samples[std::min(idx, samples.size() - 1)];
+}
+
+/**
+ * Print one result line
+ */
+inline void report(const std::string& name, double median, const char* unit,
+                   int count, double low, double high) {
+    std::printf("%-36s %10.4g %-8s (median of %d, %.4g .. %.4g)\n",
+                name.c_str(), median, unit, count, low, high);
+    std::fflush(stdout);
+}
+
+/**
+ * Call `sample` (which returns one measurement in `unit`) once to warm
+ * up, then runs() times, and report the median
+ *
+ * @return The median
+ */
+inline double measure(const std::string& name, const char* unit,
+                      const std::function<double()>& sample) {
+    sample();  // Warm-up: page faults, caches, lazy buffers
+    std::vector<double> samples;
+    int n = runs();
+    for (int i = 0; i < n; ++i) {
+        samples.push_back(sample());
+    }
+    double median = percentile(samples, 0.5);
+    report(name, median, unit, n,
+           *std::min_element(samples.begin(), samples.end()),
+           *std::max_element(samples.begin(), samples.end()));
+    return median;
+}
+
+/**
+ * Section header
+ */
+inline void section(const char* title) {
+    std::printf("\n== %s ==\n", title);
+    std::fflush(stdout);
+}
+
+} // namespace bench
+} // namespace ariash
+
+#endif // ARIASH_BENCH_HPP
@@ -0,0 +1,81 @@
+/**
+ * Idle Benchmark - StreamDrainer CPU with N quiet jobs
+ *
+ * N background jobs sleep without writing; their output streams stay
+ * registered with the reactor. The shell should spend no CPU on them:
+ * the metric is the shell's CPU time (all threads) per second of wall
+ * time, in percent.
+ */
+
+#include "bench.hpp"
+#include "job/job_control.hpp"
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace ariash;
+using namespace ariash::job;
+
+static constexpr double kWindowSeconds = 1.0;
+
+static double cpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static double idleCpuPercent(size_t jobCount) {
+    JobManager& manager = getJobManager();
+
+    std::vector<uint32_t> ids;
+    for (size_t i = 0; i < jobCount; ++i) {
+        SpawnOptions options;
+        options.command = "/bin/sleep";
+        options.args = {"30"};
+        options.background = true;
+        uint32_t id = manager.spawn(options);
+        if (id == 0) {
+            std::fprintf(stderr, "spawn failed after %zu jobs\n", i);
+            std::exit(1);
+        }
+        manager.getJob(id)->streams->closeStdin();
+        ids.push_back(id);
+    }
+
+    // Let the spawns settle before the window opens
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    double before = cpuSeconds();
+    std::this_thread::sleep_for(std::chrono::duration<double>(kWindowSeconds));
+    double used = cpuSeconds() - before;
+
+    for (uint32_t id : ids) {
+        manager.terminate(id, true);
+    }
+    for (uint32_t id : ids) {
+        manager.wait(id);
+        manager.getJob(id)->streams->waitForDrain(1000);
+        manager.removeJob(id);
+    }
+    return used / kWindowSeconds * 100;
+}
+
+int main() {
+#ifndef _WIN32
+    // Every job holds a handful of FDs
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+
+    bench::section("StreamDrainer idle CPU (shell CPU per wall second)");
+    for (size_t jobs : {1, 16, 128}) {
+        bench::measure("idle/jobs=" + std::to_string(jobs), "% CPU",
+                       [jobs] { return idleCpuPercent(jobs); });
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * Interpreter Benchmark - lexer/parser MB/s and executor loop speed
+ *
+ * The front end is fed a generated multi-megabyte script mixing
+ * declarations, control flow, expressions and command lines. The
+ * executor runs the arithmetic loop the bytecode VM is built for, through
+ * the VM and through the tree-walker, and a string-building loop.
+ */
+
+#include "bench.hpp"
+#include "parser/lexer.hpp"
+#include "parser/parser.hpp"
+#include "executor/executor.hpp"
+
+using namespace ariash;
+
+static constexpr size_t kLoopIterations = 1000000;
+static constexpr size_t kConcatIterations = 200000;
+
+static std::string generateScript(size_t targetBytes) {
+    std::string script;
+    script.reserve(targetBytes + 256);
+    for (size_t i = 0; script.size() < targetBytes; ++i) {
+        std::string n = std::to_string(i);
+        script += "int32 a" + n + " = " + n + ";\n";
+        script += "string s" + n + " = \"value " + n + "\";\n";
+        script += "if (a" + n + " > 10) {\n    a" + n + " = a" + n + " + 1;\n} else {\n    a" + n +
+                  " = a" + n + " * 2 - 3;\n}\n";
+        script += "while (a" + n + " < 5) { a" + n + " = a" + n + " + (1 * 2) / 2; }\n";
+        script += "echo \"line\" " + n + " | grep line;\n";
+    }
+    return script;
+}
+
+static double lexThroughput(const std::string& script) {
+    auto start = bench::Clock::now();
+    parser::ShellLexer lexer(script);
+    std::vector<parser::Token> tokens = lexer.tokenize();
+    double seconds = bench::secondsSince(start);
+    if (tokens.empty()) std::exit(1);
+    return static_cast<double>(script.size()) / seconds / 1e6;
+}
+
+static double parseThroughput(const std::string& script) {
+    parser::ShellLexer lexer(script);
+    std::vector<parser::Token> tokens = lexer.tokenize();
+
+    auto start = bench::Clock::now();
+    parser::ShellParser parser(tokens);
+    auto program = parser.parseProgram();
+    double seconds = bench::secondsSince(start);
+    if (!program || parser.errorCount() != 0) {
+        std::fprintf(stderr, "generated script did not parse\n");
+        std::exit(1);
+    }
+    return static_cast<double>(script.size()) / seconds / 1e6;
+}
+
+// Lexing and parsing together, as the shell streams a script
+static double frontEndThroughput(const std::string& script) {
+    auto start = bench::Clock::now();
+    parser::ShellLexer lexer(script);
+    parser::ShellParser parser(lexer);
+    auto program = parser.parseProgram();
+    double seconds = bench::secondsSince(start);
+    if (!program) std::exit(1);
+    return static_cast<double>(script.size()) / seconds / 1e6;
+}
+
+static double loopSpeed(bool treeWalk) {
+    const std::string loop = "int64 i = 0; int64 s = 0; while (i < " + std::to_string(kLoopIterations) +
+                             ") { s = s + i * 2; i = i + 1; }";
+    parser::ShellLexer lexer(loop);
+    auto tokens = lexer.tokenize();
+    parser::ShellParser parser(tokens);
+    auto program = parser.parseProgram();
+
+    executor::Environment env;
+    executor::Executor exec(env);
+    auto start = bench::Clock::now();
+    if (treeWalk) {
+        program->accept(exec);
+    } else {
+        exec.execute(*program);
+    }
+    double seconds = bench::secondsSince(start);
+    if (std::get<int64_t>(env.get("s")) != static_cast<int64_t>(kLoopIterations * (kLoopIterations - 1))) {
+        std::fprintf(stderr, "loop computed the wrong sum\n");
+        std::exit(1);
+    }
+    return static_cast<double>(kLoopIterations) / seconds / 1e6;
+}
+
+// Path building: append a literal and a number to one string
+static double concatSpeed(bool treeWalk) {
+    const std::string loop = "int64 i = 0; string p = \"\"; while (i < " + std::to_string(kConcatIterations) +
+                             ") { p = p + \"/dir\"; p = p + i; i = i + 1; }";
+    parser::ShellLexer lexer(loop);
+    auto tokens = lexer.tokenize();
+    parser::ShellParser parser(tokens);
+    auto program = parser.parseProgram();
+
+    executor::Environment env;
+    executor::Executor exec(env);
+    auto start = bench::Clock::now();
+    if (treeWalk) {
+        program->accept(exec);
+    } else {
+        exec.execute(*program);
+    }
+    double seconds = bench::secondsSince(start);
+    if (std::get<executor::SharedString>(env.get("p")).view().substr(0, 10) != "/dir0/dir1") {
+        std::fprintf(stderr, "loop built the wrong string\n");
+        std::exit(1);
+    }
+    return static_cast<double>(kConcatIterations) / seconds / 1e6;
+}
+
+int main() {
+    std::string script = generateScript(8 * 1024 * 1024);
+
+    bench::section("Lexer / parser throughput (8 MiB script)");
+    bench::measure("lexer", "MB/s", [&script] { return lexThroughput(script); });
+    bench::measure("parser", "MB/s", [&script] { return parseThroughput(script); });
+    bench::measure("lexer+parser/streaming", "MB/s", [&script] { return frontEndThroughput(script); });
+
+    // One iteration: compare, multiply, two adds, two assignments
+    bench::section("Executor arithmetic loop (1M iterations)");
+    bench::measure("executor/vm", "Miter/s", [] { return loopSpeed(false); });
+    bench::measure("executor/tree-walk", "Miter/s", [] { return loopSpeed(true); });
+
+    // Both append to p's own buffer rather than copying it per statement
+    bench::section("Executor string building (200k iterations)");
+    bench::measure("executor/vm/concat", "Miter/s", [] { return concatSpeed(false); });
+    bench::measure("executor/tree-walk/concat", "Miter/s", [] { return concatSpeed(true); });
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * Pipeline Benchmark - stddato -> stddati throughput
+ *
+ * A producer writes zeros to stream 5 and a consumer reads them from
+ * stream 4, through each HexStreamPipeline connection mode. dd moves
+ * the data in 1 MiB blocks on both ends, so the pipe and the shell's
+ * relay are what is measured. The shared-ring mode needs Aria-aware ends:
+ * this binary re-runs itself as producer and consumer, also in 1 MiB
+ * blocks.
+ */
+
+#include "bench.hpp"
+#include "hexstream/process.hpp"
+#include "hexstream/shared_ring.hpp"
+#include <cstring>
+#include <unistd.h>
+
+using namespace ariash;
+using namespace ariash::hexstream;
+using ariash::job::StreamIndex;
+
+static constexpr size_t kBlocks = 512;  // MiB per run
+static constexpr size_t kBlockSize = 1 << 20;
+
+// --produce / --consume: the Aria-aware ends of the shared-ring run
+static int ringEnd(bool produce, int argc, char** argv) {
+    std::vector<uint8_t> block(kBlockSize);
+    if (produce) {
+        auto out = SharedRingEndpoint::open(StreamIndex::STDDATO, argc, argv);
+        for (size_t i = 0; i < kBlocks; ++i) {
+            ssize_t n = out ? out->write(block.data(), block.size()) : ::write(5, block.data(), block.size());
+            if (n != static_cast<ssize_t>(block.size())) return 1;
+        }
+        return 0;
+    }
+    auto in = SharedRingEndpoint::open(StreamIndex::STDDATI, argc, argv);
+    size_t total = 0;
+    for (;;) {
+        ssize_t n = in ? in->read(block.data(), block.size()) : ::read(4, block.data(), block.size());
+        if (n < 0) return 1;
+        if (n == 0) break;
+        total += static_cast<size_t>(n);
+    }
+    return total == (kBlocks << 20) ? 0 : 1;
+}
+
+static double pipelineThroughput(ConnectionMode mode) {
+    ProcessConfig producer;
+    ProcessConfig consumer;
+    if (mode == ConnectionMode::SHARED_RING) {
+        producer.executable = consumer.executable = "/proc/self/exe";
+        producer.arguments = {"--produce"};
+        consumer.arguments = {"--consume"};
+    } else {
+        producer.executable = "/bin/sh";
+        producer.arguments = {"-c", "exec dd if=/dev/zero bs=1M count=" + std::to_string(kBlocks) +
+                                    " status=none >&5"};
+        consumer.executable = "/bin/sh";
+        consumer.arguments = {"-c", "exec dd of=/dev/null bs=1M status=none <&4"};
+    }
+
+    HexStreamPipeline pipeline;
+    size_t src = pipeline.addProcess(producer);
+    size_t dst = pipeline.addProcess(consumer);
+    pipeline.connect(src, dst, StreamIndex::STDDATO, mode);
+
+    auto start = bench::Clock::now();
+    if (!pipeline.spawn()) {
+        std::fprintf(stderr, "pipeline spawn failed\n");
+        std::exit(1);
+    }
+    std::vector<int> status = pipeline.waitAll();
+    double seconds = bench::secondsSince(start);
+    if (status.size() != 2 || status[0] != 0 || status[1] != 0) {
+        std::fprintf(stderr, "pipeline stage failed\n");
+        std::exit(1);
+    }
+    return static_cast<double>(kBlocks << 20) / seconds / 1e9;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && (std::strcmp(argv[1], "--produce") == 0 || std::strcmp(argv[1], "--consume") == 0)) {
+        return ringEnd(std::strcmp(argv[1], "--produce") == 0, argc, argv);
+    }
+
+    bench::section("stddato -> stddati pipeline throughput (512 MiB)");
+    bench::measure("pipeline/direct", "GB/s", [] { return pipelineThroughput(ConnectionMode::DIRECT); });
+#ifdef __linux__
+    bench::measure("pipeline/splice", "GB/s", [] { return pipelineThroughput(ConnectionMode::SPLICE); });
+    bench::measure("pipeline/tee", "GB/s", [] { return pipelineThroughput(ConnectionMode::TEE); });
+    bench::measure("pipeline/shared-ring", "GB/s", [] { return pipelineThroughput(ConnectionMode::SHARED_RING); });
+#endif
+    return 0;
+}
@@ -0,0 +1,53 @@
+/**
+ * Spawn Benchmark - HexStreamProcess spawn-to-exit latency
+ *
+ * Times the full life of a trivial child as the executor sees it for a
+ * foreground command: six pipes, spawn, reap, and every stream at EOF.
+ */
+
+#include "bench.hpp"
+#include "hexstream/process.hpp"
+
+using namespace ariash;
+using namespace ariash::hexstream;
+
+static constexpr int kSpawnsPerRun = 200;
+
+// Latency of each spawn in microseconds
+static std::vector<double> spawnLatencies(const char* executable) {
+    std::vector<double> latencies;
+    latencies.reserve(kSpawnsPerRun);
+
+    ProcessConfig config;
+    config.executable = executable;
+    for (int i = 0; i < kSpawnsPerRun; ++i) {
+        auto start = bench::Clock::now();
+        HexStreamProcess process(config);
+        if (!process.spawn()) {
+            std::fprintf(stderr, "spawn %s failed\n", executable);
+            std::exit(1);
+        }
+        process.wait();
+        process.waitForStreams(1000);
+        latencies.push_back(bench::secondsSince(start) * 1e6);
+    }
+    return latencies;
+}
+
+int main() {
+    bench::section("HexStreamProcess spawn-to-exit latency (/bin/true)");
+
+    // Percentiles are taken over the spawns of a run, the median over runs
+    bench::measure("spawn/true/p50", "us", [] {
+        return bench::percentile(spawnLatencies("/bin/true"), 0.5);
+    });
+    bench::measure("spawn/true/p99", "us", [] {
+        return bench::percentile(spawnLatencies("/bin/true"), 0.99);
+    });
+    bench::measure("spawn/true/rate", "spawns/s", [] {
+        auto start = bench::Clock::now();
+        spawnLatencies("/bin/true");
+        return kSpawnsPerRun / bench::secondsSince(start);
+    });
+    return 0;
+}
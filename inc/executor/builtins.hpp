@@ -0,0 +1,85 @@
+/**
+ * Builtins - commands the shell runs in-process
+ *
+ * Executor::executeCommand() consults the registry before PATH
+ * resolution. A builtin is a plain function: it reads its arguments (and,
+ * if it wants, its stdin FD) and writes straight to the stream it is
+ * given, without fork/exec or drainer threads.
+ *
+ * Standard set: true, false, echo, printf, test / [, pwd, cd, sleep,
+ * exit / quit, hash, telemetry.
+ *
+ * - Pipeline stages all run at once, chained through kernel pipes: a
+ *   builtin stage reads the previous stage's pipe and writes the next
+ *   one's, so nothing is buffered, and one that ignores stdin lets its
+ *   upstream stage end with EPIPE
+ * - Like the subshell a POSIX shell runs each stage in, cd and exit in a
+ *   multi-stage pipeline leave the shell itself alone
+ * - Background commands (`&`) still spawn the external program
+ */
+
+#ifndef ARIASH_BUILTINS_HPP
+#define ARIASH_BUILTINS_HPP
+
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ariash {
+namespace executor {
+
+/**
+ * What a builtin gets to work with
+ */
+struct BuiltinContext {
+    const std::vector<std::string>& args;  // Without the command name
+    std::ostream& out;
+    std::ostream& err;
+    int lastStatus = 0;                    // Of the previous command
+    bool inPipeline = false;               // One of several stages
+    bool exitRequested = false;            // Set by exit: stop the program
+    int inFd = -1;                         // stdin: a `<` file or the previous stage's pipe
+                                           // (-1 = none); read it, if at all, as needed
+};
+
+/**
+ * @return Exit status
+ */
+using BuiltinFunction = int (*)(BuiltinContext& ctx);
+
+class BuiltinRegistry {
+public:
+    BuiltinRegistry();  // Registers the standard set
+
+    // Non-copyable
+    BuiltinRegistry(const BuiltinRegistry&) = delete;
+    BuiltinRegistry& operator=(const BuiltinRegistry&) = delete;
+
+    /**
+     * Add or replace a builtin
+     */
+    void add(const std::string& name, BuiltinFunction function);
+    void remove(const std::string& name);
+
+    /**
+     * @return The builtin called `name`, or nullptr
+     */
+    BuiltinFunction find(const std::string& name) const;
+
+    std::vector<std::string> names() const;  // Sorted
+
+private:
+    std::unordered_map<std::string, BuiltinFunction> builtins_;
+};
+
+/**
+ * Get the shell's builtin registry (singleton)
+ */
+BuiltinRegistry& getBuiltins();
+
+} // namespace executor
+} // namespace ariash
+
+#endif // ARIASH_BUILTINS_HPP
@@ -0,0 +1,198 @@
+/**
+ * Bytecode - compiled form of a parsed shell program
+ *
+ * The Compiler lowers a parser::Program into a flat Chunk of three-address
+ * instructions that Executor::execute() runs on a register VM. Compared to
+ * walking the AST this removes the virtual accept() dispatch and the
+ * per-node Value copies in and out of exprResult_:
+ *
+ * - Operands address registers or variables directly. A register holds a
+ *   constant (preloaded), a temporary or a block-local variable; a global
+ *   variable operand resolves its Environment binding once per run and
+ *   reuses the pointer.
+ * - Names are resolved while compiling, innermost block scope first:
+ *   declarations inside a BlockStmt get a register for the rest of the
+ *   block, anything else is a global.
+ * - Arithmetic and comparisons on two int64_t operands are computed in
+ *   place; every other type combination goes through the Executor's
+ *   applyArithmetic() / applyComparison() so semantics stay identical.
+ * - Loop and if conditions that are comparisons compile to one fused
+ *   compare-and-branch; loops test at the bottom, so an iteration costs
+ *   one branch.
+ * - Operands the Optimizer proved to be int64_t (ExprNode::staticType)
+ *   use the *_INT instructions, which read them without a type check.
+ *
+ * Commands, pipelines and command substitutions are still run by the
+ * Executor; their instructions point back into the AST, so a Chunk must
+ * not outlive its Program.
+ */
+
+#ifndef ARIASH_BYTECODE_HPP
+#define ARIASH_BYTECODE_HPP
+
+#include "parser/ast.hpp"
+#include "executor/value.hpp"
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ariash {
+namespace executor {
+
+/**
+ * VM opcodes
+ *
+ * Operand fields: dst/a/b (see Instruction). "cmp" is the comparison
+ * opcode carried by fused branches.
+ */
+enum class OpCode : uint8_t {
+    MOVE,           // dst = a (dst variable must exist)
+    DEFINE,         // define variable dst = a (moved out of a if b != 0)
+    ADD, SUB, MUL, DIV,         // dst = a op b
+    LT, LE, GT, GE, EQ, NE,     // dst = a op b (bool)
+    AND, OR,        // dst = truthy(a) op truthy(b) (both sides evaluated)
+    NEG,            // dst = -a
+    NOT,            // dst = !truthy(a)
+    JUMP,           // pc = dst
+    JUMP_IF_FALSE,  // if !truthy(a): pc = dst
+    JUMP_IF_TRUE,   // if truthy(a): pc = dst
+    JUMP_UNLESS,    // if !(a cmp b): pc = dst
+    JUMP_WHEN,      // if (a cmp b): pc = dst
+    // a and b statically int64_t (see Optimizer)
+    ADD_INT, SUB_INT, MUL_INT, DIV_INT,
+    CMP_INT,        // dst = a cmp b (bool)
+    NEG_INT,        // dst = -a
+    JUMP_UNLESS_INT,
+    JUMP_WHEN_INT,
+    PRINT,          // write valueText(a) to stdout
+    PRINT_END,      // end the print() line; dst = 0
+    LEN,            // dst = length of string a
+    RESULT,         // last result = a
+    COMMAND,        // run commands[a]
+    PIPELINE,       // run pipelines[a]
+    PARALLEL,       // run parallels[a], at most b tasks at once
+    CAPTURE,        // dst = output of substitutions[a]
+    ITER_CAPTURE,   // loop dst: lines of substitutions[a], streamed
+    ITER_STRING,    // loop dst: lines of string a (moved out of a if b != 0)
+    ITER_NEXT,      // if loop b has a line: a = line, pc = dst
+    ITER_END,       // end loop a (a capture sets the exit status)
+    FAIL,           // throw std::runtime_error(messages[a])
+    HALT            // return: stop the program
+};
+
+/**
+ * One instruction (16 bytes)
+ */
+struct Instruction {
+    OpCode op;
+    OpCode cmp = OpCode::LT;  // CMP_INT and fused branches: the comparison (LT..NE)
+    int32_t dst = 0;
+    int32_t a = 0;
+    int32_t b = 0;
+};
+
+/**
+ * Operand encoding: registers are >= 0, variable slots are negative
+ */
+constexpr int32_t variableOperand(int32_t slot) { return -1 - slot; }
+constexpr bool isVariableOperand(int32_t operand) { return operand < 0; }
+constexpr int32_t variableSlot(int32_t operand) { return -1 - operand; }
+
+/**
+ * Compiled program
+ */
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<Value> constants;          // Registers [0, constants.size())
+    std::vector<std::string> variables;    // Variable slot -> name
+    std::vector<std::string> messages;     // FAIL texts
+    std::vector<parser::CommandStmt*> commands;
+    std::vector<parser::PipelineStmt*> pipelines;
+    std::vector<parser::ParallelStmt*> parallels;
+    std::vector<parser::CommandSubstExpr*> substitutions;
+    int32_t registerCount = 0;             // Constants + temporaries
+    int32_t loopCount = 0;                 // For loops (line iterators)
+};
+
+/**
+ * AST -> bytecode compiler
+ */
+class Compiler : public parser::ASTVisitor {
+public:
+    Chunk compile(parser::Program& program);
+
+    // Expressions: leave the operand holding the value in result_
+    void visit(parser::IntegerLiteral& node) override;
+    void visit(parser::StringLiteral& node) override;
+    void visit(parser::VariableExpr& node) override;
+    void visit(parser::BinaryOpExpr& node) override;
+    void visit(parser::UnaryOpExpr& node) override;
+    void visit(parser::CallExpr& node) override;
+    void visit(parser::CommandSubstExpr& node) override;
+
+    // Statements
+    void visit(parser::BlockStmt& node) override;
+    void visit(parser::VarDeclStmt& node) override;
+    void visit(parser::AssignStmt& node) override;
+    void visit(parser::IfStmt& node) override;
+    void visit(parser::WhileStmt& node) override;
+    void visit(parser::ForStmt& node) override;
+    void visit(parser::ReturnStmt& node) override;
+    void visit(parser::ExprStmt& node) override;
+    void visit(parser::CommandStmt& node) override;
+    void visit(parser::PipelineStmt& node) override;
+    void visit(parser::ParallelStmt& node) override;
+    void visit(parser::Program& node) override;
+
+private:
+    static constexpr int32_t kNoTarget = INT32_MIN;
+
+    // Temporaries are numbered from kTempBase while compiling and moved
+    // behind the constants once their count is known
+    static constexpr int32_t kTempBase = 1 << 30;
+
+    Chunk chunk_;
+    std::map<Value, int32_t> constantIndex_;
+    std::map<std::string, int32_t> variableIndex_;
+    std::vector<std::map<std::string, int32_t>> scopes_;  // Block locals -> register
+    int32_t result_ = 0;          // Operand of the last compiled expression
+    int32_t target_ = kNoTarget;  // Where the caller wants it (or anywhere)
+    int32_t nextTemp_ = 0;        // First free temporary
+    int32_t maxTemps_ = 0;
+
+    /**
+     * Compile an expression; the value ends up in `target` when given,
+     * otherwise in whatever operand is returned
+     */
+    int32_t compileExpr(parser::ExprNode& expr, int32_t target = kNoTarget);
+
+    /**
+     * Emit a branch taken when `condition` is `whenTrue`, returning its
+     * index (see patchJump)
+     */
+    size_t emitBranch(parser::ExprNode& condition, bool whenTrue);
+    void patchJump(size_t index);
+
+    size_t emit(const Instruction& instruction);
+    int32_t constant(const Value& value);
+    int32_t variable(const std::string& name);
+    int32_t resolve(const std::string& name);  // Local register or global
+    int32_t message(const std::string& text);
+    int32_t substitution(parser::CommandSubstExpr& node);
+    int32_t allocTemp();
+
+    /**
+     * Operand for an expression's result: the caller's target, or a fresh
+     * temporary once the operands' temporaries (above `mark`) are free
+     */
+    int32_t destination(int32_t mark);
+
+    void relocate(int32_t& operand) const;
+};
+
+} // namespace executor
+} // namespace ariash
+
+#endif // ARIASH_BYTECODE_HPP
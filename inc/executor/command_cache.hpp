@@ -0,0 +1,158 @@
+/**
+ * Command Cache - hashed PATH lookup (like bash's `hash`)
+ *
+ * Resolving a bare command name used to split $PATH and stat() every
+ * directory on every command. The cache remembers each name's resolved
+ * path (or that it was not found), filled lazily on first use.
+ *
+ * Validity:
+ * - Keyed on the $PATH value: any change re-splits PATH and starts over
+ * - Linux: an inotify watch per PATH directory drops exactly the names
+ *   that were created, removed or renamed there; checking costs one
+ *   non-blocking read() per lookup
+ * - Elsewhere (or if inotify is unavailable): directory mtimes are
+ *   re-checked at most once per second and a change clears the table.
+ *   "Not found" is then never served from the table: PATH is searched
+ *   again, so a command installed a moment ago is found at once
+ *
+ * `hash -r` clears the table explicitly.
+ *
+ * Every PATH directory carries a version that changes whenever names in
+ * it are invalidated, so listings built from the directories (completion)
+ * can rescan just the ones that changed.
+ *
+ * Short-lived shells (scripts, -c) should turn watches off: tearing down
+ * an inotify instance that has watches waits for an RCU grace period,
+ * which costs several milliseconds at exit.
+ */
+
+#ifndef ARIASH_COMMAND_CACHE_HPP
+#define ARIASH_COMMAND_CACHE_HPP
+
+#include <cstdint>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ariash {
+namespace executor {
+
+class CommandCache {
+public:
+    /**
+     * Cache entry, as listed by `hash`
+     */
+    struct Entry {
+        std::string name;
+        std::string path;
+        uint64_t hits = 0;
+    };
+
+    /**
+     * PATH directory, as seen by directories()
+     */
+    struct DirectoryVersion {
+        std::string path;
+        uint64_t version = 0;  // Changes with every invalidation in it
+    };
+
+    /**
+     * Lookup counters
+     */
+    struct Stats {
+        uint64_t hits = 0;           // Answered from the table
+        uint64_t misses = 0;         // Needed a PATH search
+        uint64_t invalidations = 0;  // Entries dropped by watches/mtimes
+    };
+
+    CommandCache();
+    ~CommandCache();
+
+    // Non-copyable
+    CommandCache(const CommandCache&) = delete;
+    CommandCache& operator=(const CommandCache&) = delete;
+
+    /**
+     * Resolve a command against $PATH
+     *
+     * Names containing '/' are returned untouched.
+     *
+     * @return Full path of the first executable match, or `command`
+     *         itself if PATH has none (exec then reports the failure)
+     */
+    std::string resolve(const std::string& command);
+
+    /**
+     * Whether `command` resolved to a file in PATH (fills the cache)
+     */
+    bool found(const std::string& command);
+
+    /**
+     * Forget every entry (`hash -r`)
+     */
+    void clear();
+
+    /**
+     * Commands currently resolved to a path, sorted by name
+     */
+    std::vector<Entry> entries() const;
+
+    /**
+     * PATH directories in order, revalidated as a lookup would be
+     */
+    std::vector<DirectoryVersion> directories();
+
+    Stats getStats() const;
+
+    /**
+     * Use inotify watches where available (default), or mtime checks only
+     */
+    void setWatchesEnabled(bool enabled);
+
+private:
+    struct Slot {
+        std::string path;   // Empty = not found in PATH
+        uint64_t hits = 0;
+    };
+
+    struct Directory {
+        std::string path;
+        int watch = -1;               // inotify watch descriptor
+        int64_t mtimeNs = -1;         // Fallback validation
+        uint64_t version = 0;
+    };
+
+    // All called with mutex_ held
+    const Slot& lookup(const std::string& command);
+    void syncPath();
+    void drainWatches();
+    void checkMtimes();
+    void rebuildDirectories();
+    void closeWatches();
+    void bumpVersions();
+
+    mutable std::mutex mutex_;
+    std::string pathValue_;
+    bool pathSet_ = false;            // $PATH exists at all
+    bool pathKnown_ = false;          // pathValue_/directories_ are current
+    std::vector<Directory> directories_;
+    bool watchesComplete_ = false;    // Every directory has a live watch
+    std::unordered_map<std::string, Slot> table_;
+    int inotifyFd_ = -1;              // Created on first PATH split
+    bool watchesEnabled_ = true;
+    std::chrono::steady_clock::time_point lastMtimeCheck_;
+    uint64_t lastVersion_ = 0;
+    Stats stats_;
+};
+
+/**
+ * Get the shell's command cache (singleton)
+ */
+CommandCache& getCommandCache();
+
+} // namespace executor
+} // namespace ariash
+
+#endif // ARIASH_COMMAND_CACHE_HPP
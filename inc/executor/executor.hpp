@@ -14,8 +14,13 @@
 #define ARIASH_EXECUTOR_HPP
 
 #include "parser/ast.hpp"
+#include "executor/value.hpp"
+#include "executor/bytecode.hpp"
+#include "executor/builtins.hpp"
+#include "executor/substitution.hpp"
 #include "hexstream/process.hpp"
 #include <unordered_map>
+#include <vector>
 #include <string>
 #include <memory>
 #include <optional>
@@ -24,35 +29,48 @@
 namespace ariash {
 namespace executor {
 
-// Runtime value types
-using Value = std::variant<
-    int64_t,           // Integer
-    double,            // Float
-    std::string,       // String
-    bool               // Boolean
->;
-
-/**
- * Converts value to string representation
- */
-std::string valueToString(const Value& val);
-
 /**
- * Runtime environment - manages variable bindings
+ * Runtime environment - manages global variable bindings
+ * 
+ * Holds the top-level declarations, which persist across REPL
+ * submissions. Variables declared inside a block are lexically scoped:
+ * the compiler gives them VM registers and they never reach the
+ * Environment.
  */
 class Environment {
 public:
-    void define(const std::string& name, const Value& value);
+    // Returns the binding's storage
+    Value& define(const std::string& name, const Value& value);
+    Value& define(const std::string& name, Value&& value);
     void assign(const std::string& name, const Value& value);
-    Value get(const std::string& name) const;
+    void assign(const std::string& name, Value&& value);
+    const Value& get(const std::string& name) const;
     bool exists(const std::string& name) const;
     
+    /**
+     * Binding storage for `name`, or nullptr if undefined
+     * 
+     * Stays valid until the binding is removed (the VM caches it).
+     */
+    Value* find(const std::string& name);
+    
+    /**
+     * Names of all bindings, sorted
+     */
+    std::vector<std::string> names() const;
+    
 private:
     std::unordered_map<std::string, Value> bindings_;
 };
 
 /**
  * Executor - interprets AST and produces side effects
+ * 
+ * execute() compiles the program to bytecode and runs it on the register
+ * VM (bytecode.hpp, vm.cpp). The visit() methods remain as the reference
+ * tree-walking interpreter: program.accept(executor) runs the AST directly.
+ * While the profiler is on (job/profiler.hpp), execute() walks the tree
+ * instead, so every statement is timed against its source location.
  */
 class Executor : public parser::ASTVisitor {
 public:
@@ -61,9 +79,19 @@ public:
     // Execute a program
     void execute(parser::Program& program);
     
+    // Lex, parse and execute source text, reusing cached compilations
+    // (program_cache.hpp)
+    void executeSource(const std::string& source);
+    
     // Get last expression result
     std::optional<Value> getLastResult() const { return lastResult_; }
     
+    // Exit status of the last command or pipeline (0 if none ran)
+    int getLastStatus() const { return lastStatus_; }
+    
+    // The exit builtin ran: the shell should stop (with getLastStatus())
+    bool exitRequested() const { return exitRequested_; }
+    
     // Expression visitors (produce values)
     void visit(parser::IntegerLiteral& node) override;
     void visit(parser::StringLiteral& node) override;
@@ -71,6 +99,7 @@ public:
     void visit(parser::BinaryOpExpr& node) override;
     void visit(parser::UnaryOpExpr& node) override;
     void visit(parser::CallExpr& node) override;
+    void visit(parser::CommandSubstExpr& node) override;
     
     // Statement visitors (produce side effects)
     void visit(parser::BlockStmt& node) override;
@@ -83,6 +112,7 @@ public:
     void visit(parser::ExprStmt& node) override;
     void visit(parser::CommandStmt& node) override;
     void visit(parser::PipelineStmt& node) override;
+    void visit(parser::ParallelStmt& node) override;
     void visit(parser::Program& node) override;
     
 private:
@@ -90,6 +120,20 @@ private:
     std::optional<Value> exprResult_;  // Result of last expression
     std::optional<Value> lastResult_;  // Last statement result
     bool hasReturned_ = false;         // Return flag for early exit
+    int lastStatus_ = 0;               // Last command exit status
+    bool exitRequested_ = false;       // Set by the exit builtin
+    
+    // Tree-walker block scopes: declarations inside a BlockStmt,
+    // innermost last (globals live in env_)
+    std::vector<std::pair<std::string, Value>> locals_;
+    size_t blockDepth_ = 0;
+    struct LocalScope;
+    Value* findLocal(const std::string& name);
+    bool appendInPlace(parser::AssignStmt& node);  // `s = s + x` on a string
+    
+    // Run compiled bytecode (vm.cpp)
+    void run(const Chunk& chunk);
+    Value& bindVariable(const Chunk& chunk, Value** bindings, int32_t slot);
     
     // Helper methods
     Value evaluateExpr(parser::ExprNode& expr);
@@ -101,12 +145,24 @@ private:
     Value applyLogical(parser::TokenType op, const Value& left, const Value& right);
     
     // Process execution
+    void setStatus(int status);  // Record a command's exit status
     void executeCommand(parser::CommandStmt& cmd);
     void executePipeline(parser::PipelineStmt& pipeline);
+    void executeParallel(parser::ParallelStmt& parallel, const Value& limit);
+    
+    // Builtins (builtins.hpp)
+    // `pipeFd`: the previous stage's pipe (-1 = none), unless `<` redirects stdin
+    int runBuiltin(BuiltinFunction builtin, parser::CommandStmt& cmd,
+                   int pipeFd, std::ostream& out, bool inPipeline);
+    // Pipeline with builtin stages, all running at once; the last stage's
+    // output goes to `capture` instead of the terminal when given
+    void executeStages(parser::PipelineStmt& pipeline, std::string* capture = nullptr);
     
-    // File descriptor setup
-    void setupRedirections(const std::vector<parser::Redirection>& redirects,
-                          hexstream::ProcessConfig& config);
+    // Command substitution (substitution.hpp)
+    std::unique_ptr<OutputCapture> startCapture(parser::PipelineStmt& pipeline);
+    SharedString captureOutput(parser::PipelineStmt& pipeline);
+    LineSource linesOf(parser::ExprNode& iterable);
+    LineSource linesOf(parser::CommandSubstExpr& subst);
 };
 
 } // namespace executor
@@ -0,0 +1,109 @@
+/**
+ * Optimizer - AST pass between ShellParser::parseProgram() and execution
+ *
+ * Rewrites a Program in place before it is compiled or walked:
+ *
+ * - Constant folding: integer arithmetic, string concatenation, unary
+ *   minus and len() on literals become a single literal. Anything that
+ *   would throw (division by zero, mixed-type operations) is left alone
+ *   so it still fails at run time with the same message.
+ * - Dead branches: an if/while whose condition is a constant is replaced
+ *   by the branch that runs (the block, and so its scope, is kept).
+ * - Static types: declared types (int8..int64, tbb8..tbb64, string,
+ *   bool) are checked against every value stored into the variable. A
+ *   variable whose stores all provably match its declared type keeps that
+ *   type, and every expression whose type follows from its operands is
+ *   annotated (ExprNode::staticType). The Compiler emits int-specialised
+ *   instructions for INT operands and the tree-walker skips its type
+ *   dispatch for them.
+ *
+ * Types are narrowed statically only; values are not truncated to the
+ * declared width (the runtime stays 64-bit). Stores of the wrong type and
+ * literals outside a declared integer range are reported as warnings.
+ */
+
+#ifndef ARIASH_OPTIMIZER_HPP
+#define ARIASH_OPTIMIZER_HPP
+
+#include "parser/ast.hpp"
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ariash {
+namespace executor {
+
+class Optimizer {
+public:
+    /**
+     * What the last optimize() changed
+     */
+    struct Stats {
+        size_t folded = 0;            // Expressions replaced by a literal
+        size_t branchesRemoved = 0;   // if/while conditions decided statically
+        size_t typedVariables = 0;    // Declarations that kept their static type
+        size_t typedExpressions = 0;  // Non-literal expressions with a static type
+    };
+
+    /**
+     * Optimise `program` in place; a Program is only optimised once
+     */
+    void optimize(parser::Program& program);
+
+    /**
+     * Type check findings of the last optimize() ("line N: ...")
+     */
+    const std::vector<std::string>& warnings() const { return warnings_; }
+
+    /**
+     * Print the warnings to stderr, as the parser does its errors
+     */
+    void reportWarnings() const;
+    const Stats& getStats() const { return stats_; }
+
+private:
+    struct Variable {
+        std::string name;
+        std::string typeName;           // As first declared
+        parser::StaticType declared;    // UNKNOWN: untyped, or redeclared differently
+        parser::StaticType type;        // Proven type (declared, or UNKNOWN)
+    };
+
+    struct Store {
+        Variable* variable;
+        parser::ExprNode* value;        // nullptr: default-initialised
+        const std::string* typeName;    // Declared type at this store
+        parser::SourceLocation location;
+    };
+
+    // Folding
+    void foldStmt(parser::NodePtr<parser::StmtNode>& stmt);
+    void foldExpr(parser::NodePtr<parser::ExprNode>& expr);
+    parser::NodePtr<parser::StmtNode> emptyBlock(parser::SourceLocation location);
+
+    // Typing
+    void collectStmt(parser::StmtNode& stmt);
+    void collectExpr(parser::ExprNode& expr);
+    Variable* lookup(const std::string& name);
+    parser::StaticType infer(parser::ExprNode& expr);
+    void checkStore(const Store& store);
+
+    parser::Program* program_ = nullptr;
+    Stats stats_;
+    std::vector<std::string> warnings_;
+
+    std::deque<Variable> variables_;
+    std::vector<std::unordered_map<std::string, Variable*>> scopes_;  // Block locals
+    std::unordered_map<std::string, Variable*> globals_;              // Declared so far
+    std::unordered_map<const parser::VariableExpr*, Variable*> reads_;
+    std::vector<Store> stores_;
+    std::vector<parser::ExprNode*> roots_;  // Every top-level expression
+    int conditional_ = 0;                   // Inside an unbraced if/while/for body
+};
+
+} // namespace executor
+} // namespace ariash
+
+#endif // ARIASH_OPTIMIZER_HPP
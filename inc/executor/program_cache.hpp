@@ -0,0 +1,102 @@
+/**
+ * Program Cache - compiled programs keyed by their source text
+ *
+ * The REPL and scripts keep submitting the same snippets. Lexing,
+ * parsing and compiling each one again is wasted work, so the cache
+ * keeps the last N (LRU) sources together with their parsed Program and
+ * bytecode Chunk. A hit hashes the source once and goes straight to the
+ * VM.
+ *
+ * - Lookups hash the source text and compare it in full, so a hash
+ *   collision can never run the wrong program
+ * - Sources that failed to parse cleanly are compiled but not cached,
+ *   so their parse errors are reported every time
+ * - Entries are handed out as shared_ptr: one evicted while it is still
+ *   running stays alive until the run finishes
+ */
+
+#ifndef ARIASH_PROGRAM_CACHE_HPP
+#define ARIASH_PROGRAM_CACHE_HPP
+
+#include "parser/ast.hpp"
+#include "executor/bytecode.hpp"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ariash {
+namespace executor {
+
+/**
+ * A parsed and compiled source
+ */
+struct CompiledProgram {
+    std::string source;
+    std::unique_ptr<parser::Program> program;
+    Chunk chunk;  // Points into *program
+};
+
+class ProgramCache {
+public:
+    static constexpr size_t kDefaultCapacity = 512;
+
+    /**
+     * Lookup counters
+     */
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;       // Lexed, parsed and compiled
+        uint64_t evictions = 0;    // Least recently used entries dropped
+    };
+
+    explicit ProgramCache(size_t capacity = kDefaultCapacity);
+
+    // Non-copyable
+    ProgramCache(const ProgramCache&) = delete;
+    ProgramCache& operator=(const ProgramCache&) = delete;
+
+    /**
+     * Compiled form of `source`, from the cache or built now
+     *
+     * Lexer errors propagate; nothing is cached for them.
+     */
+    std::shared_ptr<const CompiledProgram> get(const std::string& source);
+
+    /**
+     * Change the number of entries kept (0 disables caching)
+     */
+    void setCapacity(size_t capacity);
+    size_t size() const;
+    void clear();
+
+    Stats getStats() const;
+
+private:
+    using LruList = std::list<std::shared_ptr<const CompiledProgram>>;
+
+    static std::shared_ptr<const CompiledProgram> build(const std::string& source,
+                                                        bool& cacheable);
+
+    // Called with mutex_ held
+    void evict();
+
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    LruList lru_;  // Most recently used first
+    std::unordered_map<std::string_view, LruList::iterator> index_;  // Views into lru_ sources
+    Stats stats_;
+};
+
+/**
+ * Get the shell's program cache (singleton)
+ */
+ProgramCache& getProgramCache();
+
+} // namespace executor
+} // namespace ariash
+
+#endif // ARIASH_PROGRAM_CACHE_HPP
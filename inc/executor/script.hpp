@@ -0,0 +1,72 @@
+/**
+ * Script Runner - non-interactive execution (`ariash FILE`, `ariash -c CODE`)
+ *
+ * Runs a whole source in one go without any REPL machinery: no terminal
+ * setup, no input engine, no banner. A script file is mmap'd and lexed in
+ * place (tokens view the mapping), parsed once and executed.
+ *
+ * Exit status follows the usual shell rules:
+ * - 0..255  status of the last command or pipeline (0 if none ran)
+ * - 1       runtime error (message on stderr)
+ * - 2       parse errors; nothing is executed
+ * - 127     script file could not be read
+ */
+
+#ifndef ARIASH_SCRIPT_HPP
+#define ARIASH_SCRIPT_HPP
+
+#include "executor/executor.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace ariash {
+namespace executor {
+
+/**
+ * Read-only view of a whole file (mmap where available)
+ */
+class SourceFile {
+public:
+    SourceFile() = default;
+    ~SourceFile();
+
+    // Non-copyable
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    /**
+     * Map `path`
+     *
+     * @return false with errno set on failure
+     */
+    bool open(const std::string& path);
+
+    std::string_view text() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string fallback_;  // Platforms without mmap
+};
+
+/**
+ * Parse and run `source` against `env`
+ *
+ * `source` must stay valid for the call. A leading "#!" line is skipped.
+ *
+ * @param name Shown in error messages
+ * @return Exit status (see above)
+ */
+int runScript(std::string_view source, const std::string& name, Environment& env);
+
+/**
+ * Map and run a script file
+ */
+int runScriptFile(const std::string& path, Environment& env);
+
+} // namespace executor
+} // namespace ariash
+
+#endif // ARIASH_SCRIPT_HPP
@@ -0,0 +1,148 @@
+/**
+ * Shared Strings - the string payload of a Value
+ *
+ * A SharedString is one pointer to a reference-counted heap buffer
+ * (nullptr for ""), so a Value is 16 bytes and copying one through
+ * evaluateExpr(), Environment::get() or a register MOVE is a reference
+ * count increment, never a copy of the text. Moves steal the pointer.
+ *
+ * Buffers are copy-on-write: a mutation (append, assign, resize) works
+ * in place when this is the only reference and copies otherwise, so a
+ * value another variable still sees never changes under it. That makes
+ * a string variable its own builder: `s = s + x` in the VM appends to
+ * s's buffer, which grows geometrically, and reading a loop's lines
+ * into its variable reuses the buffer of the previous line.
+ *
+ * intern() returns the one shared copy of a text; the Compiler interns
+ * every string literal, so all the Values made from a literal share it
+ * and comparing two interned strings is a pointer test. Interned
+ * buffers are never mutated (a mutation copies them). They are counted
+ * like any other buffer. The last reference removes the text from the
+ * intern table, so the table only holds texts some Value still sees,
+ * not every literal ever compiled or evaluated.
+ *
+ * Reference counts are atomic: values cross threads in parallel blocks.
+ */
+
+#ifndef ARIASH_SHARED_STRING_HPP
+#define ARIASH_SHARED_STRING_HPP
+
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace ariash {
+namespace executor {
+
+class SharedString {
+public:
+    SharedString() = default;  // "" (no buffer)
+    explicit SharedString(std::string_view text);
+    explicit SharedString(const std::string& text) : SharedString(std::string_view(text)) {}
+    explicit SharedString(const char* text) : SharedString(std::string_view(text)) {}
+
+    SharedString(const SharedString& other) noexcept : rep_(other.rep_) { retain(); }
+    SharedString(SharedString&& other) noexcept : rep_(other.rep_) { other.rep_ = nullptr; }
+    ~SharedString() { release(); }
+
+    SharedString& operator=(const SharedString& other) noexcept;
+    SharedString& operator=(SharedString&& other) noexcept;
+
+    /**
+     * The interned copy of `text` (created on first use, freed with its
+     * last reference)
+     */
+    static SharedString intern(std::string_view text);
+
+    /**
+     * Texts currently in the intern table
+     */
+    static size_t internedCount();
+
+    std::string_view view() const {
+        return rep_ ? std::string_view(rep_->chars(), rep_->size) : std::string_view();
+    }
+    operator std::string_view() const { return view(); }
+    std::string str() const { return std::string(view()); }
+
+    const char* data() const { return rep_ ? rep_->chars() : ""; }  // NUL-terminated
+    const char* c_str() const { return data(); }
+    size_t size() const { return rep_ ? rep_->size : 0; }
+    size_t length() const { return size(); }
+    size_t capacity() const { return rep_ ? rep_->capacity : 0; }
+    bool empty() const { return size() == 0; }
+
+    /**
+     * True if no other SharedString sees this buffer (mutations are in place)
+     */
+    bool unique() const;
+
+    bool interned() const { return rep_ && rep_->interned; }
+
+    // Mutations: in place when unique(), on a private copy otherwise.
+    // `text` may point into this string.
+    void reserve(size_t wanted);
+    void append(std::string_view text);
+    void append(const char* text, size_t size) { append(std::string_view(text, size)); }
+    void assign(std::string_view text);
+    void resize(size_t size);  // New bytes are '\0'
+    void clear();              // Keeps a unique buffer for reuse
+
+    friend bool operator==(const SharedString& a, const SharedString& b) {
+        return a.rep_ == b.rep_ || a.view() == b.view();
+    }
+    friend std::strong_ordering operator<=>(const SharedString& a, const SharedString& b) {
+        return a.view() <=> b.view();
+    }
+    friend bool operator==(const SharedString& a, std::string_view b) { return a.view() == b; }
+    friend std::strong_ordering operator<=>(const SharedString& a, std::string_view b) {
+        return a.view() <=> b;
+    }
+
+private:
+    struct Rep {
+        std::atomic<uint32_t> refs;
+        bool interned;
+        size_t size;
+        size_t capacity;  // Excluding the NUL
+
+        char* chars() { return reinterpret_cast<char*>(this + 1); }
+        const char* chars() const { return reinterpret_cast<const char*>(this + 1); }
+    };
+
+    static Rep* allocate(size_t capacity);
+
+    // Replace the buffer by a private one of at least `capacity`,
+    // keeping the first `keep` bytes
+    void reallocate(size_t capacity, size_t keep);
+
+    // Ensure a private buffer of at least `wanted`, keeping the text
+    void makeUnique(size_t wanted);
+
+    void retain() const {
+        if (rep_) {
+            rep_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    void release();
+
+    // Last reference to an interned buffer: out of the table, then freed
+    static void releaseInterned(Rep* rep);
+
+    Rep* rep_ = nullptr;
+};
+
+static_assert(sizeof(SharedString) == sizeof(void*));
+
+inline std::ostream& operator<<(std::ostream& out, const SharedString& text) {
+    return out << text.view();
+}
+
+} // namespace executor
+} // namespace ariash
+
+#endif // ARIASH_SHARED_STRING_HPP
@@ -0,0 +1,115 @@
+/**
+ * Command Substitution - $(...) output as Values
+ *
+ * A substituted pipeline runs as a job with no stream callbacks: its
+ * stdout collects in the job's ring buffer and is pulled from there
+ * (StreamController::waitForData / consumeBuffer) straight into the
+ * buffer of the SharedString that becomes the Value, which is then moved,
+ * not copied, into its variable. Nothing goes through the terminal path.
+ *
+ * While the shell is not reading, the full ring stalls the drainer and
+ * the kernel throttles the writer, so iterating over the lines of an
+ * output (LineSource) holds one ring's worth of it at a time.
+ *
+ * stderr goes to the shell's own stderr; stddato is discarded.
+ */
+
+#ifndef ARIASH_SUBSTITUTION_HPP
+#define ARIASH_SUBSTITUTION_HPP
+
+#include "executor/shared_string.hpp"
+#include "job/job_control.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ariash {
+namespace executor {
+
+/**
+ * Standard output of one running pipeline job
+ */
+class OutputCapture {
+public:
+    OutputCapture() = default;
+    ~OutputCapture();  // Kills and reaps a job that was not finish()ed
+
+    // Non-copyable (owns the job)
+    OutputCapture(const OutputCapture&) = delete;
+    OutputCapture& operator=(const OutputCapture&) = delete;
+
+    /**
+     * Spawn `stages` as one job with stdout captured
+     *
+     * @return false if the job could not be spawned
+     */
+    bool start(std::vector<job::SpawnOptions> stages);
+
+    /**
+     * Append all remaining output to `out`
+     *
+     * Capacity is reserved from what is buffered, growing geometrically,
+     * and every ring span is appended in place.
+     */
+    void readAll(SharedString& out);
+
+    /**
+     * Next line of output, without its newline (overwrites `line`, so a
+     * buffer nothing else shares is reused)
+     *
+     * @return false once the output is exhausted
+     */
+    bool nextLine(SharedString& line);
+
+    /**
+     * Discard output not read yet, wait for the job to exit and remove it
+     *
+     * @return Exit status (the rightmost failing stage's)
+     */
+    int finish();
+
+private:
+    uint32_t jobId_ = 0;
+    job::StreamController* streams_ = nullptr;
+};
+
+/**
+ * Drop trailing newlines, as sh does for $(...)
+ */
+void trimTrailingNewlines(SharedString& text);
+
+/**
+ * Lines a for loop iterates over: a running capture, or a string value
+ */
+class LineSource {
+public:
+    LineSource() = default;  // No lines
+    explicit LineSource(std::unique_ptr<OutputCapture> capture);
+    explicit LineSource(SharedString text);  // Shared, not copied
+
+    /**
+     * @return false once every line has been produced
+     */
+    bool next(SharedString& line);
+
+    /**
+     * True if the lines come from a command (finish() has a status)
+     */
+    bool capturing() const { return capture_ != nullptr; }
+
+    /**
+     * Stop iterating; the capture's exit status (0 for a string)
+     */
+    int finish();
+
+private:
+    std::unique_ptr<OutputCapture> capture_;
+    SharedString text_;
+    size_t pos_ = 0;
+};
+
+} // namespace executor
+} // namespace ariash
+
+#endif // ARIASH_SUBSTITUTION_HPP
@@ -0,0 +1,51 @@
+/**
+ * Runtime Values - shared by the Executor and the bytecode VM
+ *
+ * A Value is 16 bytes: the payload (a SharedString is one pointer) and
+ * the variant's tag. Copies of a string value share its buffer.
+ */
+
+#ifndef ARIASH_VALUE_HPP
+#define ARIASH_VALUE_HPP
+
+#include "executor/shared_string.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+
+namespace ariash {
+namespace executor {
+
+// Runtime value types
+using Value = std::variant<
+    int64_t,           // Integer
+    double,            // Float
+    SharedString,      // String
+    bool               // Boolean
+>;
+
+static_assert(sizeof(Value) == 16, "Value payloads must stay one word");
+
+/**
+ * Scratch space for valueText(): the longest "%f" of a double
+ */
+struct ValueTextBuffer {
+    char data[320];
+};
+
+/**
+ * Text of a value without allocating: a string's own characters, or
+ * the number formatted into `buffer` (valid while both are)
+ */
+std::string_view valueText(const Value& val, ValueTextBuffer& buffer);
+
+/**
+ * Converts value to string representation
+ */
+std::string valueToString(const Value& val);
+
+} // namespace executor
+} // namespace ariash
+
+#endif // ARIASH_VALUE_HPP
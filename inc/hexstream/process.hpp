@@ -17,6 +17,7 @@
 
 #include "job/stream_controller.hpp"
 #include "job/job_control.hpp"
+#include "hexstream/shared_ring.hpp"
 
 #ifdef _WIN32
 #include "platform/windows_bootstrap.hpp"
@@ -46,9 +47,14 @@ struct ProcessConfig {
     
     bool foregroundMode = false;  // Passthrough stdout/stderr to TTY
     
-#ifdef _WIN32
-    bool useEnvBootstrap = true;  // Use env var vs CLI flag for Windows
-#endif
+    job::CoalesceWindow coalesce;  // onData() batching (default: every read)
+    job::StreamOptionSet streamOptions = job::defaultStreamOptions();  // Buffer sizing per stream
+    
+    // Bootstrap maps (__ARIA_FD_MAP on Windows, __ARIA_SHM_RING) go in the
+    // environment, or on the command line when false
+    bool useEnvBootstrap = true;
+    
+    job::Placement placement;  // CPUs, NUMA node, priorities, cgroup (Linux)
 };
 
 /**
@@ -97,6 +103,32 @@ public:
     HexStreamProcess(const HexStreamProcess&) = delete;
     HexStreamProcess& operator=(const HexStreamProcess&) = delete;
     
+    /**
+     * Wire a stream directly to an external FD (call before spawn)
+     * 
+     * The child receives `fd` as the given stream instead of a shell-owned
+     * pipe. Ownership of `fd` passes to the process.
+     */
+    bool attachStream(job::StreamIndex stream, int fd);
+    
+    /**
+     * Relay an output stream kernel-side into `outFd` (call before spawn)
+     * 
+     * Linux only: uses splice(2), or tee(2) when `mirror` is set so the data
+     * also lands in this process's ring buffer for inspection.
+     */
+    bool relayStream(job::StreamIndex stream, int outFd, bool mirror = false);
+    
+    /**
+     * Offer a shared-memory ring for stddati or stddato (call before spawn)
+     * 
+     * The child inherits the ring's FDs and finds them through the
+     * __ARIA_SHM_RING bootstrap (see hexstream/shared_ring.hpp); the
+     * stream's pipe is wired as usual. The reference is dropped once the
+     * child is running.
+     */
+    bool offerSharedRing(job::StreamIndex stream, std::shared_ptr<SharedRing> ring);
+    
     /**
      * Spawn the child process
      * 
@@ -167,7 +199,8 @@ public:
     /**
      * Register callback for stream data
      * 
-     * Called asynchronously when data arrives.
+     * Called asynchronously on the drainer threads as data arrives,
+     * batched by ProcessConfig::coalesce.
      */
     void onData(DataCallback callback);
     
@@ -179,6 +212,17 @@ public:
      */
     void flushBuffers();
     
+    /**
+     * Wait until every output stream has reached EOF
+     * 
+     * After wait(), this guarantees all output has been delivered to the
+     * callbacks (or buffered) without guessing with a sleep.
+     * 
+     * @param timeout_ms Max wait time (0 = infinite)
+     * @return true if all streams hit EOF
+     */
+    bool waitForStreams(uint32_t timeout_ms = 0);
+    
     /**
      * Register callback for process exit
      */
@@ -195,6 +239,16 @@ public:
     size_t getTotalBytesTransferred() const;
     size_t getActiveThreadCount() const;
     
+    /**
+     * Resources the process used (once wait() has reaped it)
+     */
+    const job::ResourceUsage& getResourceUsage() const { return usage_; }
+    
+    /**
+     * Bytes read and dropped on one stream
+     */
+    job::StreamStats getStreamStats(job::StreamIndex stream) const;
+    
 private:
     ProcessConfig config_;
     job::StreamController streamController_;
@@ -203,6 +257,11 @@ private:
     int exitCode_;
     bool running_;
     
+    // Accounting (see job/job_stats.hpp)
+    job::ResourceUsage usage_;
+    int64_t launchNs_ = 0;
+    bool firstByteRecorded_ = false;
+    
 #ifdef _WIN32
     std::unique_ptr<platform::WindowsBootstrap> windowsBootstrap_;
     HANDLE processHandle_;
@@ -212,16 +271,40 @@ private:
     
     ExitCallback exitCallback_;
     
+    // Offered rings for stddati [0] and stddato [1]
+    std::shared_ptr<SharedRing> sharedRings_[2];
+    
+    // Keeps the reactor on the placed process's node (until destruction,
+    // so its streams are drained there too)
+    std::unique_ptr<job::ServiceNodeLease> serviceLease_;
+    
+    // cgroup directories the placement created (removed once reaped)
+    job::CgroupLease cgroupLease_;
+    
     // Platform-specific spawn
     bool spawnLinux();
     bool spawnWindows();
 };
 
+/**
+ * How a pipeline connection moves data between two processes
+ */
+enum class ConnectionMode : uint8_t {
+    DIRECT,  // Both child ends of one kernel pipe; the shell never sees the data
+    SPLICE,  // Shell relays kernel-side with splice(2) (no userspace copies)
+    TEE,     // SPLICE plus a tee(2) mirror into the source's ring buffer
+    SHARED_RING  // DIRECT plus a shared-memory ring that Aria-aware ends
+                 // negotiate (stddato only; a plain pipe where unavailable)
+};
+
 /**
  * Hex-Stream Pipeline
  * 
  * Manages multiple processes connected via six-stream pipes.
  * 
+ * Output streams connect to the matching input of the next process:
+ * STDDATO → STDDATI for binary data, STDOUT/STDERR/STDDBG → STDIN for text.
+ * 
  * Example:
  *   Pipeline pipeline;
  *   pipeline.addProcess(producer);
@@ -249,11 +332,19 @@ public:
      * @param srcIdx Source process index
      * @param dstIdx Destination process index
      * @param stream Which stream to connect (STDDATO → STDDATI typical)
+     * @param mode   DIRECT (default), SPLICE, TEE or SHARED_RING
      */
-    void connect(size_t srcIdx, size_t dstIdx, job::StreamIndex stream);
+    void connect(size_t srcIdx, size_t dstIdx, job::StreamIndex stream,
+                 ConnectionMode mode = ConnectionMode::DIRECT);
     
     /**
      * Spawn all processes in pipeline
+     * 
+     * Creates one kernel pipe per connection and wires it before any
+     * process starts.
+     * 
+     * @return false with errno set: EINVAL for an invalid connection,
+     *         ENOSYS for any connection on Windows, or the pipe/spawn error
      */
     bool spawn();
     
@@ -262,6 +353,13 @@ public:
      */
     std::vector<int> waitAll();
     
+    /**
+     * Access a process (e.g. to read its buffers)
+     */
+    HexStreamProcess* getProcess(size_t idx) {
+        return idx < processes_.size() ? processes_[idx].get() : nullptr;
+    }
+    
 private:
     std::vector<std::unique_ptr<HexStreamProcess>> processes_;
     
@@ -269,8 +367,11 @@ private:
         size_t srcIdx;
         size_t dstIdx;
         job::StreamIndex stream;
+        ConnectionMode mode;
     };
     std::vector<Connection> connections_;
+    
+    bool wireConnections();
 };
 
 } // namespace hexstream
@@ -0,0 +1,204 @@
+/**
+ * Shared-Memory Ring Channel for stddato → stddati
+ *
+ * An opt-in transport between two cooperating Aria processes. Even a
+ * spliced pipe moves bulk data through a 64 KB kernel buffer with a
+ * context switch every few chunks; a shared ring lets the producer write
+ * and the consumer read the same pages.
+ *
+ * The shell creates a memfd holding a single-producer single-consumer
+ * ring with the RingBuffer layout (power-of-two capacity, free-running
+ * positions on separate cache lines, storage mapped twice back to back so
+ * copies never split at the wrap-around), plus two eventfd doorbells.
+ * Both processes inherit the three FDs, advertised the same way the
+ * Windows bootstrap advertises its handle map:
+ *
+ *   __ARIA_SHM_RING=4:10,11,12      (or --aria-shm-ring=4:10,11,12)
+ *
+ * i.e. stream:memfd,data-doorbell,space-doorbell per stream.
+ *
+ * The kernel pipe stays wired too, so tools that do not know the protocol
+ * keep using FD 4 / FD 5. An aware consumer marks itself attached in the
+ * ring header; an aware producer writes to the pipe until it sees that,
+ * then records how many bytes went through the pipe and moves to the
+ * ring, so the consumer gets everything in order. The pipe also carries
+ * liveness: its hang-up ends a wait on a peer that died.
+ *
+ * A doorbell is only rung when the other side is asleep on it, so a
+ * channel that keeps flowing costs no syscalls per chunk.
+ *
+ * Linux only (memfd + eventfd); elsewhere no ring is created and the
+ * connection is a plain pipe.
+ */
+
+#ifndef ARIASH_SHARED_RING_HPP
+#define ARIASH_SHARED_RING_HPP
+
+#include "job/stream_controller.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+namespace ariash {
+namespace hexstream {
+
+struct SharedRingHeader;  // Lives in the first page of the memfd
+
+/**
+ * The three FDs behind one ring
+ */
+struct SharedRingFds {
+    int memFd = -1;     // Header page + ring storage
+    int dataFd = -1;    // eventfd: producer → sleeping consumer
+    int spaceFd = -1;   // eventfd: consumer → sleeping producer
+
+    bool valid() const { return memFd >= 0 && dataFd >= 0 && spaceFd >= 0; }
+};
+
+/**
+ * __ARIA_SHM_RING map for streams 4 and 5
+ */
+struct SharedRingMap {
+    SharedRingFds stdDatI;  // Stream 4: this process consumes
+    SharedRingFds stdDatO;  // Stream 5: this process produces
+
+    /**
+     * Serialize to __ARIA_SHM_RING format
+     *
+     * Example: "4:10,11,12;5:13,14,15" (streams without a ring are left out)
+     */
+    std::string serialize() const;
+
+    /**
+     * Parse from __ARIA_SHM_RING format
+     *
+     * @return true if parsing succeeded
+     */
+    bool parse(const std::string& mapString);
+};
+
+/**
+ * Shell-side ring: created before the two processes are spawned
+ *
+ * Its FDs are close-on-exec and live above the hex-stream range; spawning
+ * clears close-on-exec in the two children only. The shell never maps the
+ * ring and may drop it once both are running.
+ */
+class SharedRing {
+public:
+    static constexpr size_t kDefaultCapacity = 4 * 1024 * 1024;
+
+    /**
+     * Create a ring of `capacity` bytes (rounded up to a power of two and
+     * a whole number of pages)
+     *
+     * @return nullptr if shared rings are unavailable (use the pipe alone)
+     */
+    static std::shared_ptr<SharedRing> create(size_t capacity = kDefaultCapacity);
+
+    ~SharedRing();
+
+    // Non-copyable (owns the FDs)
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator=(const SharedRing&) = delete;
+
+    const SharedRingFds& fds() const { return fds_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    SharedRing() = default;
+
+    SharedRingFds fds_;
+    size_t capacity_ = 0;
+};
+
+/**
+ * One end of a ring, as an Aria-aware tool opens it
+ *
+ * STDDATO endpoints produce (write/close), STDDATI endpoints consume
+ * (read). Both fall back to the stream's pipe transparently, so a tool
+ * may write all its stream 4/5 I/O through an endpoint.
+ */
+class SharedRingEndpoint {
+public:
+    /**
+     * Open the ring advertised for `stream` (STDDATI or STDDATO)
+     *
+     * Looks for --aria-shm-ring= in argv first, then __ARIA_SHM_RING.
+     *
+     * @return nullptr if none was advertised (use FD 4 / FD 5 directly)
+     */
+    static std::unique_ptr<SharedRingEndpoint> open(job::StreamIndex stream,
+                                                    int argc = 0, char** argv = nullptr);
+
+    /**
+     * Open a ring from its FDs; `pipeFd` is the stream's own FD
+     *
+     * Takes ownership of the ring FDs (not of `pipeFd`).
+     */
+    static std::unique_ptr<SharedRingEndpoint> attach(job::StreamIndex stream,
+                                                      const SharedRingFds& fds, int pipeFd);
+
+    ~SharedRingEndpoint();
+
+    // Non-copyable (owns the mapping)
+    SharedRingEndpoint(const SharedRingEndpoint&) = delete;
+    SharedRingEndpoint& operator=(const SharedRingEndpoint&) = delete;
+
+    /**
+     * Write all of `data` (producer), blocking while the ring is full
+     *
+     * @return size, or -1 with errno set (EPIPE once the consumer is gone)
+     */
+    ssize_t write(const void* data, size_t size);
+
+    /**
+     * Read up to `maxSize` bytes (consumer), blocking until some arrive
+     *
+     * @return Bytes read, 0 at end of data, -1 with errno set
+     */
+    ssize_t read(void* data, size_t maxSize);
+
+    /**
+     * End of data (producer): also closes the stream's pipe FD
+     */
+    void close();
+
+    /**
+     * True once data moves through shared memory rather than the pipe
+     */
+    bool usingRing() const;
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    SharedRingEndpoint() = default;
+
+    bool waitFor(int doorbell, short pipeEvents);
+    void ring(int doorbell);
+    bool switchToRing();
+
+    job::StreamIndex stream_ = job::StreamIndex::STDDATI;
+    SharedRingFds fds_;
+    int pipeFd_ = -1;
+
+    SharedRingHeader* header_ = nullptr;
+    uint8_t* data_ = nullptr;     // Mirrored ring storage
+    size_t capacity_ = 0;
+    size_t mappedSize_ = 0;
+
+    uint64_t pipeBytes_ = 0;      // Moved through the pipe so far
+    bool switched_ = false;       // Producer: writing to the ring
+    bool pipeEnded_ = false;      // Consumer: the producer's pipe hung up
+    bool closed_ = false;
+};
+
+} // namespace hexstream
+} // namespace ariash
+
+#endif // ARIASH_SHARED_RING_HPP
@@ -0,0 +1,269 @@
+/**
+ * AriaSH I/O Reactor
+ *
+ * One event loop thread that services the output pipes of every job.
+ *
+ * Replaces the one-jthread-per-stream draining model: instead of up to four
+ * threads per process each waking every 100ms, all stream FDs are
+ * registered with a single epoll instance (poll() where epoll is missing)
+ * and the loop sleeps until an FD is readable or a handler timer is due.
+ * Idle cost is zero wakeups, and thread count no longer grows with jobs.
+ *
+ * The reactor performs the reads itself and hands handlers the bytes.
+ * On Linux with io_uring (multishot reads + provided buffer rings) each
+ * FD has one long-lived read request and a busy pipe costs no syscalls
+ * per chunk; kernels before 6.7 get one buffer-select read per chunk
+ * instead, re-armed in the next batched submission. Without io_uring it
+ * falls back to epoll + read(2). ARIASH_IO_BACKEND=epoll forces the
+ * fallback, ARIASH_IO_BACKEND=io_uring-oneshot the single-shot reads.
+ *
+ * On Windows the loop is an I/O completion port: each registered pipe
+ * handle (opened for overlapped I/O) keeps one ReadFile outstanding and
+ * the loop sleeps in GetQueuedCompletionStatusEx.
+ */
+
+#ifndef ARIASH_IO_REACTOR_HPP
+#define ARIASH_IO_REACTOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "job/io_uring_engine.hpp"
+
+namespace ariash {
+namespace job {
+
+/**
+ * What the reactor reads from: an FD, or on Windows a HANDLE opened with
+ * FILE_FLAG_OVERLAPPED (see platform::createOverlappedPipe)
+ */
+#ifdef _WIN32
+using IoHandle = void*;
+#else
+using IoHandle = int;
+#endif
+
+/**
+ * What a handler wants next from the reactor
+ */
+struct IoInterest {
+    bool done = false;      // Unregister the FD (EOF or fatal error)
+    bool armed = true;      // Keep watching the FD for readability
+    int64_t timerUs = -1;   // Call back after this many microseconds (-1 = none)
+};
+
+/**
+ * What the reactor is reporting to a handler
+ */
+struct IoEvent {
+    enum class Kind : uint8_t {
+        DATA,   // `size` bytes at `data` (valid only during the call)
+        END,    // EOF (error == 0) or read failure (error = errno; EIO on Windows)
+        TIMER,  // Requested timer is due
+        NOTIFY  // Another thread called notify() for this registration
+    };
+
+    Kind kind = Kind::TIMER;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    int error = 0;
+    bool inPlace = false;   // Read straight into the handler's IoReadTarget span
+};
+
+/**
+ * Reactor callback
+ *
+ * DATA may still arrive right after a handler disarms (reads already in
+ * flight in the kernel); the handler must keep such bytes itself.
+ */
+using IoHandler = std::function<IoInterest(const IoEvent& event)>;
+
+/**
+ * Optional destination for the next read (readiness backends)
+ *
+ * Returning a non-empty span lets the reactor read(2) directly into the
+ * handler's memory; an empty span falls back to the reactor's scratch
+ * buffer. io_uring reads always land in its provided buffers, IOCP reads
+ * in a buffer owned by the registration.
+ */
+using IoReadTarget = std::function<std::span<uint8_t>()>;
+
+/**
+ * I/O Reactor
+ *
+ * Handlers always run on the reactor thread, one at a time. They must not
+ * block: a handler that cannot make progress returns armed = false with a
+ * timer and is retried later.
+ */
+class IoReactor {
+public:
+    IoReactor();
+    ~IoReactor();
+
+    // Non-copyable
+    IoReactor(const IoReactor&) = delete;
+    IoReactor& operator=(const IoReactor&) = delete;
+
+    /**
+     * Register a readable FD
+     *
+     * The reactor reads from the FD (switching it to non-blocking where
+     * needed). The caller keeps ownership and must remove() the
+     * registration before closing it. On Windows the handle is bound to
+     * the completion port, which fails for handles not opened overlapped.
+     *
+     * @param readChunk Max bytes per read (0 = backend default; io_uring
+     *                  reads are bounded by its provided buffer size, IOCP
+     *                  reads are 64 KiB when 0)
+     * @param target    Where to read (nullptr = scratch buffer)
+     * @return Registration token (0 on failure)
+     */
+    uint64_t add(IoHandle fd, IoHandler handler, size_t readChunk = 0,
+                 IoReadTarget target = nullptr);
+
+    /**
+     * Unregister an FD
+     *
+     * Synchronous: once this returns the handler is not running and will
+     * never be called again. Safe to call from inside a handler.
+     *
+     * @return true if the token was still registered
+     */
+    bool remove(uint64_t token);
+
+    /**
+     * Wake a registration from any thread
+     *
+     * The handler receives a NOTIFY event on the reactor thread. Takes
+     * only a leaf lock, so it is safe while holding locks a handler also
+     * takes. Unknown tokens are ignored.
+     */
+    void notify(uint64_t token);
+
+    /**
+     * Number of live registrations
+     */
+    size_t size() const;
+
+    /**
+     * Reactor thread count (fixed, independent of job count)
+     */
+    static constexpr size_t threadCount() { return 1; }
+
+    /**
+     * Active backend: "io_uring", "io_uring-oneshot", "epoll", "poll" or "iocp"
+     */
+    const char* backendName() const;
+
+    /**
+     * Pin the reactor thread to `cpus` (empty: the shell's own CPU set)
+     *
+     * Used to keep it on the node of the jobs it serves (job/placement.hpp).
+     *
+     * @return false if the thread could not be pinned
+     */
+    bool setAffinity(const std::vector<int>& cpus);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+#ifdef _WIN32
+    struct OverlappedRead;  // OVERLAPPED + the buffer it reads into
+#endif
+
+    struct Registration {
+        IoHandle fd;
+        size_t readChunk = 0;
+        std::shared_ptr<IoHandler> handler;
+        IoReadTarget target;
+        bool armed = true;
+        bool inFlight = false;  // io_uring: multishot read outstanding
+                                // IOCP: ReadFile outstanding
+        bool hasDeadline = false;
+        Clock::time_point deadline;
+#ifdef _WIN32
+        std::shared_ptr<OverlappedRead> overlapped;
+#endif
+    };
+
+    void loop();
+    void wake();
+    std::optional<IoInterest> deliver(uint64_t token, const IoEvent& event);
+    void unregister(uint64_t token);
+    void apply(uint64_t token, Registration& reg, const IoInterest& next);
+    void armBackend(uint64_t token, Registration& reg);
+    void disarmBackend(uint64_t token, Registration& reg);
+    void runTimers();
+    void runNotifications();
+    int nextTimeoutMs();
+
+#ifdef __linux__
+    void loopUring();
+    void submitPending();
+    void onCompletion(const UringEngine::Completion& completion);
+
+    std::unique_ptr<UringEngine> uring;  // null: epoll backend
+    std::vector<uint64_t> pendingArms;       // io_uring requests queued by
+    std::vector<uint64_t> pendingCancels;    // any thread, submitted by the loop
+    int epollFd = -1;
+    int wakeFd = -1;        // eventfd
+#elif defined(_WIN32)
+    void loopCompletionPort();
+    void startRead(uint64_t token, Registration& reg);
+    void onCompletion(OverlappedRead* read);
+
+    void* port = nullptr;   // I/O completion port HANDLE
+    // Reads cancelled by remove(): the kernel owns their buffers until
+    // the cancellation completes
+    std::vector<std::shared_ptr<OverlappedRead>> retired;
+#else
+    int wakePipe[2] = {-1, -1};
+#endif
+
+#ifndef _WIN32
+    void loopReadiness();
+    void readReady(uint64_t token);
+#endif
+
+    // Held by the loop while a handler runs; remove() takes it to wait out
+    // an in-flight dispatch (recursive so handlers may remove themselves)
+    mutable std::recursive_mutex mutex;
+    std::unordered_map<uint64_t, Registration> registrations;
+    uint64_t nextToken = 1;
+
+    std::vector<uint8_t> scratch;   // Readiness backends read here
+
+    std::mutex notifyMutex;         // Leaf lock: never held with `mutex`
+    std::vector<uint64_t> notified;
+
+    std::atomic<bool> running{true};
+    std::thread worker;
+};
+
+/**
+ * Shared reactor instance (started on first use)
+ */
+IoReactor& getIoReactor();
+
+/**
+ * Start the shared reactor on epoll instead of io_uring
+ *
+ * Only effective before the first getIoReactor(). Setting up a ring and
+ * its buffer pool costs a couple of milliseconds, more than a short-lived
+ * shell (script, -c) gets back from it.
+ */
+void preferReadinessBackend();
+
+} // namespace job
+} // namespace ariash
+
+#endif // ARIASH_IO_REACTOR_HPP
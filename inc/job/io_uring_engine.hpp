@@ -0,0 +1,113 @@
+/**
+ * AriaSH io_uring Engine
+ *
+ * Minimal raw-syscall io_uring wrapper used by IoReactor (no liburing).
+ *
+ * Each drained FD gets one multishot read (IORING_OP_READ_MULTISHOT,
+ * Linux 6.7+) that picks buffers from a shared provided-buffer ring
+ * (IORING_REGISTER_PBUF_RING, Linux 5.19+; IORING_OP_PROVIDE_BUFFERS
+ * requests where the ring is unusable). A pipe that keeps producing data
+ * costs no syscalls per chunk: completions are reaped from the shared CQ
+ * ring and the buffer is handed back to the kernel.
+ *
+ * Before 6.7 each FD gets single-shot buffer-select reads instead
+ * (IORING_OP_READ, 5.7+): every completion ends the request (no
+ * Completion::more) and the reactor re-arms it with its next submission.
+ * The ring still needs IORING_FEAT_EXT_ARG, so Linux 5.11 or later.
+ *
+ * Not thread-safe: every call must come from the reactor thread.
+ */
+
+#ifndef ARIASH_IO_URING_ENGINE_HPP
+#define ARIASH_IO_URING_ENGINE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace ariash {
+namespace job {
+
+class UringEngine {
+public:
+    /**
+     * A reaped completion
+     */
+    struct Completion {
+        uint64_t tag = 0;             // user_data of the request
+        int32_t res = 0;              // Bytes read, or -errno
+        bool more = false;            // Multishot request still armed
+        bool hasBuffer = false;
+        uint16_t bufferId = 0;
+        const uint8_t* data = nullptr;  // Valid until recycle(bufferId)
+    };
+
+    /**
+     * Set up a ring with `bufferCount` provided buffers of `bufferSize`
+     * bytes (bufferCount must be a power of two)
+     *
+     * @param multishot Use multishot reads where the kernel has them
+     *                  (false forces the single-shot fallback)
+     * @return nullptr if io_uring or buffer-select reads are unavailable
+     *         (old kernel, seccomp, compiled out)
+     */
+    static std::unique_ptr<UringEngine> create(unsigned entries = 256,
+                                               unsigned bufferCount = 256,
+                                               unsigned bufferSize = 16 * 1024,
+                                               bool multishot = true);
+
+    ~UringEngine();
+
+    // Non-copyable
+    UringEngine(const UringEngine&) = delete;
+    UringEngine& operator=(const UringEngine&) = delete;
+
+    /**
+     * Queue a read of `fd` into provided buffers (multishot where
+     * multishotReads())
+     */
+    bool armRead(int fd, uint64_t tag);
+
+    bool multishotReads() const;
+
+    /**
+     * Queue a multishot poll (used for the reactor's wakeup eventfd)
+     */
+    bool armPoll(int fd, uint64_t tag);
+
+    /**
+     * Queue cancellation of every request carrying `tag`
+     *
+     * The cancel's own completion is reported with `cancelTag`.
+     */
+    bool cancel(uint64_t tag, uint64_t cancelTag);
+
+    /**
+     * Submit queued requests and wait for at least one completion
+     *
+     * @param timeout_ms Max wait (-1 = infinite, 0 = don't wait)
+     * @return false on a fatal ring error
+     */
+    bool submitAndWait(int timeout_ms);
+
+    /**
+     * Pop the next completion (false when the CQ ring is empty)
+     */
+    bool popCompletion(Completion& out);
+
+    /**
+     * Return a provided buffer to the kernel
+     */
+    void recycle(uint16_t bufferId);
+
+private:
+    UringEngine() = default;
+
+    struct Ring;
+    std::unique_ptr<Ring> ring;
+};
+
+} // namespace job
+} // namespace ariash
+
+#endif // ARIASH_IO_URING_ENGINE_HPP
@@ -17,6 +17,10 @@
 #define ARIASH_JOB_CONTROL_HPP
 
 #include "job/job_state.hpp"
+#include "job/job_stats.hpp"
+#include "job/placement.hpp"
+#include "job/stream_controller.hpp"
+#include <array>
 #include <atomic>
 #include <memory>
 #include <vector>
@@ -50,9 +54,11 @@ struct ProcessHandle {
     HANDLE handle = INVALID_HANDLE_VALUE;
     DWORD processId = 0;
 #else
-    int pidfd = -1;     // File descriptor for process (Linux 5.3+)
+    int pidfd = -1;     // File descriptor for process (Linux 5.3+); open until the JCB goes
     pid_t pid = -1;     // Traditional PID (fallback)
 #endif
+    int status = 0;     // Exit code (128+N when killed by signal N)
+    bool reaped = false;
 
     bool isValid() const;
     void close();
@@ -80,6 +86,7 @@ struct JobControlBlock {
     // State Machine
     std::atomic<JobState> state{JobState::NONE};
     std::atomic<bool> notified{false};      // Status change notification flag
+    std::mutex reapMutex;                   // One reaper at a time (waiters, event loop)
 
     // Terminal State
 #ifndef _WIN32
@@ -88,7 +95,7 @@ struct JobControlBlock {
 #endif
 
     // Exit Information
-    int exitCode = 0;                       // Aggregated exit code
+    int exitCode = 0;                       // Aggregated exit code (pipefail)
     bool exitedNormally = false;
     bool stoppedBySignal = false;
     int stopSignal = 0;
@@ -96,10 +103,26 @@ struct JobControlBlock {
     // Stream Controller (Hex-Stream)
     std::unique_ptr<StreamController> streams;
 
+    // Keeps the reactor on the job's NUMA node while the job is tracked
+    std::unique_ptr<ServiceNodeLease> serviceLease;
+
+    // cgroup directories the placements created, removed when the job is retired
+    std::vector<CgroupLease> cgroupLeases;
+
+    // Parsed stddbg records (outlives the job, see TelemetryRegistry)
+    std::shared_ptr<TelemetryMetrics> telemetry;
+
     // Timestamps
     uint64_t startTime = 0;
     uint64_t endTime = 0;
 
+    // Accounting (see job/job_stats.hpp)
+    ResourceUsage usage;                    // Processes reaped so far
+    int64_t launchNs = 0;                   // steadyNanos() when spawning began
+    int64_t exitNs = 0;                     // ... and when the last process was reaped
+    double spawnSeconds = 0;
+    bool firstByteRecorded = false;         // In getLatencyMetrics()
+
     JobControlBlock() = default;
     ~JobControlBlock();
 
@@ -118,6 +141,17 @@ struct JobControlBlock {
 using JobStatusCallback = std::function<void(uint32_t jobId, JobState oldState,
                                               JobState newState)>;
 
+/**
+ * A stream the child takes straight from an open file (<, >, >>)
+ *
+ * The FD is dup2()'d onto the stream in the child, so the bytes move
+ * between the file and the process without passing through the shell.
+ */
+struct StreamRedirect {
+    StreamIndex stream;
+    int fd;  // Owned by the caller; close it once spawned
+};
+
 /**
  * Spawn options for new processes
  */
@@ -135,6 +169,10 @@ struct SpawnOptions {
     bool captureStddbg = true;              // FD 3 - telemetry
     bool captureStddati = false;            // FD 4 - data input
     bool captureStddato = false;            // FD 5 - data output
+    bool parseTelemetry = true;             // Aggregate stddbg records (job/telemetry.hpp)
+    StreamOptionSet streamOptions = defaultStreamOptions();  // Buffer sizing per stream
+    std::vector<StreamRedirect> redirects;  // Override this stage's streams (and pipe links)
+    Placement placement;                    // CPUs, NUMA node, priorities, cgroup of this stage
 };
 
 /**
@@ -181,6 +219,24 @@ public:
      */
     uint32_t spawn(const SpawnOptions& options);
 
+    /**
+     * Spawn a pipeline as a single job
+     *
+     * Stage i's stdout is connected to stage i+1's stdin through a kernel
+     * pipe; the shell never touches the bytes in between. The job's stream
+     * controller owns stdin of the first stage, stdout of the last stage and
+     * the stderr/stddbg/stddati/stddato streams shared by every stage.
+     * All stages join one process group (led by the first stage).
+     *
+     * The job's exit code follows pipefail rules: the status of the
+     * rightmost stage that failed, or 0 if every stage succeeded.
+     * Background mode and process-group creation are taken from stages[0].
+     *
+     * @param stages Spawn configuration per stage, left to right
+     * @return Job ID on success, 0 on failure
+     */
+    uint32_t spawnPipeline(const std::vector<SpawnOptions>& stages);
+
     /**
      * Get job by ID
      */
@@ -237,12 +293,57 @@ public:
     /**
      * Wait for a job to complete
      *
+     * Sleeps on the job's own pidfds, so it returns as soon as the last
+     * process exits, whichever thread reaps it (processes without a pidfd
+     * are checked every 10ms).
+     *
      * @param jobId Job to wait for
      * @param timeout_ms Timeout in milliseconds (0 = infinite)
      * @return Exit code, or -1 on error/timeout
      */
     int wait(uint32_t jobId, uint32_t timeout_ms = 0);
 
+    /**
+     * Wait for the first of several jobs to complete
+     *
+     * Sleeps on the pidfds of every job in the set, as wait() does.
+     *
+     * @param jobIds Jobs to watch
+     * @param timeout_ms Timeout in milliseconds (0 = infinite)
+     * @return ID of a terminated job from jobIds, or 0 on timeout (or if
+     *         none of them exists)
+     */
+    uint32_t waitAny(const std::vector<uint32_t>& jobIds, uint32_t timeout_ms = 0);
+
+    /**
+     * Forget a terminated job
+     *
+     * Releases its JCB (and stream buffers). Call once the output has been
+     * consumed; running jobs are left alone.
+     *
+     * @return true if the job was removed
+     */
+    bool removeJob(uint32_t jobId);
+
+    // =========================================================================
+    // Statistics
+    // =========================================================================
+
+    // Removed jobs whose statistics are kept
+    static constexpr size_t kRetainedStats = 32;
+
+    /**
+     * Statistics of a job, live or among the last kRetainedStats removed
+     *
+     * @return false if the job is unknown
+     */
+    bool getStats(uint32_t jobId, JobStats& stats) const;
+
+    /**
+     * Statistics of every live job and retained removed job, by job ID
+     */
+    std::vector<JobStats> getAllStats() const;
+
     // =========================================================================
     // Signal Handling (Raw Mode)
     // =========================================================================
@@ -278,6 +379,9 @@ public:
      * - State changes
      * - Stream data
      *
+     * Returns once the ready events are handled; waits at most
+     * timeout_ms for the first one.
+     *
      * @param timeout_ms Max wait time
      * @return Number of events processed
      */
@@ -316,10 +420,34 @@ private:
     struct Impl;
     std::unique_ptr<Impl> impl;
 
-    // Job storage
-    mutable std::mutex jobsMutex;
-    std::unordered_map<uint32_t, std::unique_ptr<JobControlBlock>> jobs;
-    uint32_t nextJobId = 1;
+    // Job storage: sharded by job ID, so spawns, lookups and removals
+    // of different jobs do not contend. A shard is locked only to find,
+    // insert or erase; spawning happens outside any lock. Waiters hold
+    // their jobs by reference, so a removal (from another thread) never
+    // frees a JCB under them.
+    static constexpr size_t kJobShards = 16;
+    struct JobShard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint32_t, std::shared_ptr<JobControlBlock>> jobs;
+    };
+    std::array<JobShard, kJobShards> shards;
+    std::atomic<uint32_t> nextJobId{1};
+
+    JobShard& shardFor(uint32_t jobId) { return shards[jobId % kJobShards]; }
+    const JobShard& shardFor(uint32_t jobId) const { return shards[jobId % kJobShards]; }
+
+    // Job by ID, kept alive by the caller's reference
+    std::shared_ptr<JobControlBlock> holdJob(uint32_t jobId) const;
+
+    // Every live job
+    std::vector<std::shared_ptr<JobControlBlock>> snapshotJobs() const;
+
+    // Statistics of removed jobs, oldest first
+    mutable std::mutex statsMutex;
+    std::vector<JobStats> retiredStats;
+
+    // epoll events fetched per epoll_wait() in processEvents()
+    static constexpr size_t kEventBatch = 256;
 
     // Status callbacks
     std::vector<JobStatusCallback> statusCallbacks;
@@ -329,6 +457,12 @@ private:
     bool sendSignal(JobControlBlock* job, int signal);
     void reapJob(JobControlBlock* job);
     void cleanupJob(uint32_t jobId);
+    void recordFirstByte(JobControlBlock* job);
+    void retire(JobControlBlock& job);
+    // `exitCode` (if given) is read with the job still held and reaped
+    uint32_t waitJobs(const std::vector<uint32_t>& jobIds, uint32_t timeout_ms,
+                      int* exitCode = nullptr);
+    static JobStats collectStats(const JobControlBlock& job);
 
 #ifndef _WIN32
     // Linux-specific
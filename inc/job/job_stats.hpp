@@ -0,0 +1,105 @@
+/**
+ * AriaSH Job Statistics - resource accounting and plumbing latency
+ *
+ * What a job cost the machine, and how much of its wall time was the
+ * shell's own doing:
+ *
+ * - Resource usage of every reaped process (wait4): CPU, max RSS and
+ *   context switches
+ * - Bytes per stream, and bytes dropped by a full drop-on-overflow
+ *   buffer (stddbg, tee mirrors)
+ * - Spawn latency (pipes, fork and exec of every stage) and first-byte
+ *   latency (spawn to the first output byte reaching the shell)
+ *
+ * Latencies are also aggregated across every external command run by
+ * the shell (jobs and foreground commands alike) in the histograms of
+ * getLatencyMetrics(), in microseconds.
+ */
+
+#ifndef ARIASH_JOB_STATS_HPP
+#define ARIASH_JOB_STATS_HPP
+
+#include "job/job_state.hpp"
+#include "job/telemetry.hpp"
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace ariash {
+namespace job {
+
+/**
+ * Resources used by a job's processes (summed; max RSS is the largest)
+ */
+struct ResourceUsage {
+    double userSeconds = 0;
+    double systemSeconds = 0;
+    uint64_t maxRssKb = 0;
+    uint64_t voluntarySwitches = 0;     // Blocked (I/O, sleeps)
+    uint64_t involuntarySwitches = 0;   // Preempted
+
+#ifndef _WIN32
+    /**
+     * Account one reaped process
+     */
+    void add(const struct rusage& usage);
+#endif
+};
+
+/**
+ * Traffic of one stream
+ */
+struct StreamStats {
+    uint64_t bytes = 0;      // Read from the child
+    uint64_t dropped = 0;    // Discarded by the overflow policy
+};
+
+/**
+ * A job's statistics at one point in time
+ */
+struct JobStats {
+    uint32_t jobId = 0;
+    std::string command;
+    JobState state = JobState::NONE;
+    int exitCode = 0;                   // Once terminated
+    size_t processes = 0;
+    double wallSeconds = 0;             // Spawn to exit (or to now)
+    double spawnSeconds = 0;            // Until every stage had exec'd
+    double firstByteSeconds = -1;       // Spawn to first output (-1: none yet)
+    ResourceUsage usage;                // Reaped processes only
+    std::array<StreamStats, 6> streams; // By StreamIndex
+};
+
+/**
+ * Histogram names in getLatencyMetrics()
+ */
+inline constexpr const char* kSpawnLatencyMetric = "spawn_us";
+inline constexpr const char* kFirstByteLatencyMetric = "first_byte_us";
+
+/**
+ * Monotonic clock in nanoseconds (the stamps latencies are taken from)
+ */
+int64_t steadyNanos();
+
+/**
+ * Shell-wide latency histograms (singleton)
+ */
+TelemetryMetrics& getLatencyMetrics();
+
+/**
+ * Machine-readable dump: one JSON object holding every job and the
+ * latency histograms
+ */
+void writeJobStatsJson(std::ostream& out, const std::vector<JobStats>& jobs,
+                       const TelemetrySnapshot& latency);
+
+} // namespace job
+} // namespace ariash
+
+#endif // ARIASH_JOB_STATS_HPP
@@ -0,0 +1,233 @@
+/**
+ * AriaSH Job Placement - where a job's processes run
+ *
+ * A Placement in SpawnOptions (JobManager) or ProcessConfig
+ * (HexStreamProcess) pins a job's processes before they exec:
+ *
+ * - CPU set and/or NUMA node: sched_setaffinity() to the allowed CPUs
+ *   (a node's CPUs, intersected with an explicit set), and a preferred
+ *   memory policy on the node, so pages are allocated next to the CPUs
+ * - nice value (setpriority) and I/O priority class/level (ioprio_set)
+ * - cgroup v2 leaf: created on demand with its cpu.max / memory.max
+ *   limits; the child joins it before exec. Directories the shell
+ *   created are removed again once the last job placed in them has been
+ *   reaped (CgroupLease)
+ *
+ * Everything that can fail is done by the parent (PlacementPlan::prepare:
+ * reading the node's CPU list, creating the cgroup, opening its
+ * cgroup.procs); the child only issues syscalls, as spawn_engine.hpp
+ * requires. A placement that cannot be honoured fails the spawn.
+ *
+ * The shell's threads serving a placed job follow it to its node:
+ * the splice/tee relay threads of its streams are pinned to the node's
+ * CPUs, and the shared reactor thread is pinned to the node most placed
+ * jobs are running on (ServiceNodeLease), going back to the shell's own
+ * CPU set once none are running.
+ *
+ * Linux only; elsewhere a non-empty placement fails with ENOSYS.
+ *
+ * Placements are set through the C++ API only; no shell syntax makes one.
+ */
+
+#ifndef ARIASH_PLACEMENT_HPP
+#define ARIASH_PLACEMENT_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace ariash {
+namespace job {
+
+/**
+ * I/O scheduling class (ioprio_set)
+ */
+enum class IoPriorityClass : uint8_t {
+    INHERIT,
+    REALTIME,       // Needs CAP_SYS_ADMIN
+    BEST_EFFORT,
+    IDLE            // Only when the disk is otherwise idle
+};
+
+/**
+ * Placement of a job's processes (all fields default to "inherit")
+ */
+struct Placement {
+    std::vector<int> cpus;              // Allowed CPUs (empty = inherit)
+    int numaNode = -1;                  // Run on this node's CPUs, prefer its memory (-1 = any)
+    std::optional<int> nice;            // -20..19 (lowering it needs privileges)
+    IoPriorityClass ioClass = IoPriorityClass::INHERIT;
+    int ioLevel = 4;                    // 0 (highest) - 7, REALTIME and BEST_EFFORT
+
+    // cgroup v2 leaf: absolute, or relative to /sys/fs/cgroup (e.g.
+    // "ariash.slice/build"). The shell must be allowed to write there.
+    std::string cgroup;
+    uint64_t cpuQuotaUs = 0;            // cpu.max: quota per period (0 = unlimited)
+    uint64_t cpuPeriodUs = 100000;
+    uint64_t memoryMax = 0;             // memory.max in bytes (0 = unlimited)
+
+    bool empty() const {
+        return cpus.empty() && numaNode < 0 && !nice &&
+               ioClass == IoPriorityClass::INHERIT && cgroup.empty();
+    }
+};
+
+/**
+ * Parse a kernel CPU list ("0-3,8,10-11")
+ *
+ * @return false on malformed input
+ */
+bool parseCpuList(std::string_view text, std::vector<int>& cpus);
+
+/**
+ * CPUs of NUMA node `node` (sorted)
+ *
+ * @return false if the node does not exist
+ */
+bool numaNodeCpus(int node, std::vector<int>& cpus);
+
+/**
+ * The one NUMA node holding all of `cpus`, or -1
+ */
+int numaNodeOf(const std::vector<int>& cpus);
+
+/**
+ * cgroup directories a placement created
+ *
+ * Every job placed in a directory the shell created holds it; when the
+ * last holder lets go the directory is removed (deepest first), which
+ * the kernel refuses while processes are still in it. Hold one until
+ * the job's processes have been reaped.
+ */
+class CgroupLease {
+public:
+    CgroupLease() = default;
+    ~CgroupLease() { release(); }
+
+    CgroupLease(CgroupLease&& other) noexcept : dirs_(std::move(other.dirs_)) { other.dirs_.clear(); }
+    CgroupLease& operator=(CgroupLease&& other) noexcept;
+
+    CgroupLease(const CgroupLease&) = delete;
+    CgroupLease& operator=(const CgroupLease&) = delete;
+
+    /**
+     * Let go now (rmdir where this was the last holder)
+     */
+    void release();
+
+    bool empty() const { return dirs_.empty(); }
+
+private:
+    friend class PlacementPlan;
+    std::vector<std::string> dirs_;  // Shell-created, deepest first
+};
+
+/**
+ * A Placement resolved for spawnProcess()
+ */
+class PlacementPlan {
+public:
+    PlacementPlan() = default;
+    ~PlacementPlan();
+
+    // Non-copyable (owns the cgroup.procs FD)
+    PlacementPlan(const PlacementPlan&) = delete;
+    PlacementPlan& operator=(const PlacementPlan&) = delete;
+
+    /**
+     * Resolve `placement`: CPU and node masks, cgroup created and limited
+     *
+     * @return false with errno set (EINVAL: no CPU left, ENOENT: no such
+     *         node, ENOSYS: unsupported platform, or the cgroup error)
+     */
+    bool prepare(const Placement& placement);
+
+    /**
+     * Apply to the calling process (the child, before exec)
+     *
+     * Syscalls only: safe on the vfork path.
+     *
+     * @return 0, or the errno of the first step that failed
+     */
+    int applyInChild() const;
+
+    /**
+     * Node the job runs on (-1 if not confined to one)
+     */
+    int serviceNode() const { return serviceNode_; }
+
+    /**
+     * CPUs of serviceNode() (empty if none)
+     */
+    const std::vector<int>& serviceCpus() const { return serviceCpus_; }
+
+    /**
+     * The cgroup directories this plan created or joined (call after the
+     * spawn; dropped with the plan, they are removed right away)
+     */
+    CgroupLease takeCgroupLease() { return std::move(cgroupLease_); }
+
+private:
+    int serviceNode_ = -1;
+    std::vector<int> serviceCpus_;
+    CgroupLease cgroupLease_;
+
+#ifdef __linux__
+    bool setAffinity_ = false;
+    cpu_set_t cpus_;
+    bool setMemoryPolicy_ = false;
+    unsigned long nodeMask_[16] = {};   // 1024 nodes
+    bool setNice_ = false;
+    int nice_ = 0;
+    int ioPriority_ = -1;               // ioprio_set() value (-1 = inherit)
+    int cgroupProcsFd_ = -1;            // The child writes "0" here
+#endif
+};
+
+/**
+ * Pin the calling thread to `cpus` (empty: back to the shell's own set)
+ *
+ * @return false if the kernel refused
+ */
+bool pinCurrentThread(const std::vector<int>& cpus);
+
+/**
+ * Pin `thread` the same way
+ */
+bool pinThread(std::thread& thread, const std::vector<int>& cpus);
+
+/**
+ * Keeps the shared reactor thread near one running job
+ *
+ * While leases exist the reactor runs on the node most of them name
+ * (ties go to the lowest node); without any it runs anywhere the shell
+ * may. A lease for node -1 is empty.
+ */
+class ServiceNodeLease {
+public:
+    explicit ServiceNodeLease(int node = -1);
+    ~ServiceNodeLease();
+
+    ServiceNodeLease(const ServiceNodeLease&) = delete;
+    ServiceNodeLease& operator=(const ServiceNodeLease&) = delete;
+
+    /**
+     * Node the reactor is pinned to (-1 = unpinned)
+     */
+    static int reactorNode();
+
+private:
+    int node_;
+};
+
+} // namespace job
+} // namespace ariash
+
+#endif // ARIASH_PLACEMENT_HPP
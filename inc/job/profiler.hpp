@@ -0,0 +1,147 @@
+/**
+ * AriaSH Profiler - where a script's wall time goes
+ *
+ * `ariash --profile` times every statement the executor runs, and inside
+ * them every HexStreamProcess spawn, wait and stream drain, on the
+ * monotonic clock (steadyNanos). Spans nest, so a statement's time is
+ * split into its own and its children's.
+ *
+ * Samples go to a buffer owned by the recording thread: recording takes
+ * only that buffer's (uncontended) lock, and a site (the AST node or
+ * call site, with its label and source location) is interned there on
+ * first sight, so a sample is four integers.
+ *
+ * When profiling is off a ProfileScope costs one relaxed atomic load.
+ *
+ * Output:
+ * - writeHotspots(): table of sites by self time, for the terminal
+ * - writeChromeTrace(): Trace Event JSON (chrome://tracing, Perfetto)
+ * - writeFoldedStacks(): "a;b;c <microseconds>" lines, the input of
+ *   flamegraph.pl and speedscope
+ *
+ * Reports read every thread's buffer; take them once the profiled work
+ * has finished.
+ */
+
+#ifndef ARIASH_PROFILER_HPP
+#define ARIASH_PROFILER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ariash {
+namespace job {
+
+/**
+ * One site, aggregated over every sample
+ */
+struct Hotspot {
+    std::string label;
+    size_t line = 0;          // 0: not from the script (process spans)
+    size_t column = 0;
+    uint64_t count = 0;
+    int64_t totalNanos = 0;   // Including nested spans
+    int64_t selfNanos = 0;    // Excluding them
+};
+
+/**
+ * Shell-wide profiler (singleton)
+ */
+class Profiler {
+public:
+    /**
+     * True while samples are recorded (cheap enough for every statement)
+     */
+    static bool active() { return active_.load(std::memory_order_relaxed); }
+
+    void start();
+    void stop();
+
+    /**
+     * Drop every sample (and interned site)
+     */
+    void clear();
+
+    /**
+     * Sites of all threads by self time, largest first
+     */
+    std::vector<Hotspot> hotspots() const;
+
+    /**
+     * Table of the `limit` largest hotspots
+     */
+    void writeHotspots(std::ostream& out, size_t limit = 20) const;
+
+    /**
+     * Trace Event JSON: one complete ("X") event per sample
+     */
+    void writeChromeTrace(std::ostream& out) const;
+
+    /**
+     * Folded stacks: self time per distinct stack, in microseconds
+     */
+    void writeFoldedStacks(std::ostream& out) const;
+
+    struct ThreadBuffer;
+
+private:
+    friend class ProfileScope;
+
+    // Calling thread's buffer, registered on first use
+    ThreadBuffer& threadBuffer();
+
+    static std::atomic<bool> active_;
+
+    mutable std::mutex mutex_;  // Guards buffers_ (not their contents)
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    uint32_t nextThreadId_ = 1;
+};
+
+Profiler& getProfiler();
+
+/**
+ * Times its own lifetime as one sample of `site`
+ *
+ * `site` identifies the call site (an AST node, a string literal) and
+ * must stay valid while profiling; the label is `kind`, plus " " and
+ * `detail` when given, built only the first time a site is seen.
+ */
+class ProfileScope {
+public:
+    ProfileScope(const void* site, const char* kind, std::string_view detail = {},
+                 size_t line = 0, size_t column = 0) {
+        if (Profiler::active()) {
+            begin(site, kind, detail, line, column);
+        }
+    }
+
+    ~ProfileScope() {
+        if (buffer_) {
+            end();
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    void begin(const void* site, const char* kind, std::string_view detail,
+               size_t line, size_t column);
+    void end();
+
+    Profiler::ThreadBuffer* buffer_ = nullptr;
+    size_t sample_ = 0;
+    uint64_t generation_ = 0;
+};
+
+} // namespace job
+} // namespace ariash
+
+#endif // ARIASH_PROFILER_HPP
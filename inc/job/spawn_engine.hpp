@@ -0,0 +1,90 @@
+/**
+ * AriaSH Spawn Engine
+ *
+ * Starts a child with the hex-stream FD layout already in place.
+ *
+ * On Linux the child is created with clone(CLONE_VM | CLONE_VFORK |
+ * CLONE_PIDFD) on a private stack, the same technique glibc uses behind
+ * posix_spawn(): no page tables are copied, so spawn latency does not grow
+ * with the shell's resident memory, and the pidfd is handed back by the
+ * kernel together with the PID instead of racing a later pidfd_open().
+ * Kernels without CLONE_PIDFD (< 5.2) and non-Linux systems fall back to
+ * fork() followed by the same child setup.
+ *
+ * Everything the child needs (argv, envp, FD map, placement) is prepared
+ * by the parent; the child only issues syscalls before exec.
+ */
+
+#ifndef ARIASH_SPAWN_ENGINE_HPP
+#define ARIASH_SPAWN_ENGINE_HPP
+
+#include <cstddef>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+namespace ariash {
+namespace job {
+
+#ifndef _WIN32
+
+class PlacementPlan;  // job/placement.hpp
+
+/**
+ * What to start and how to lay out its descriptors
+ */
+struct SpawnRequest {
+    static constexpr int kMaxFds = 6;  // Hex-stream range: FDs 0-5
+
+    const char* path = nullptr;      // Executable (or bare name with searchPath)
+    char* const* argv = nullptr;     // nullptr-terminated, argv[0] included
+    char* const* envp = nullptr;     // nullptr-terminated (nullptr = inherit)
+    bool searchPath = false;         // Resolve `path` through $PATH (execvp)
+
+    // Child FD i is dup2()'d from fdMap[i] (-1 = leave FD i untouched)
+    int fdMap[kMaxFds] = {-1, -1, -1, -1, -1, -1};
+
+    // Extra FDs (above the hex-stream range) the child keeps under the same
+    // number: close-on-exec is cleared in the child only (-1 = unused)
+    static constexpr int kMaxInheritFds = 6;
+    int inheritFds[kMaxInheritFds] = {-1, -1, -1, -1, -1, -1};
+
+    bool setProcessGroup = false;    // setpgid(0, pgid) in the child
+    pid_t pgid = 0;                  // 0 = lead a new group
+    int ttyFd = -1;                  // tcsetpgrp() onto this TTY (-1 = no)
+    bool resetSignals = false;       // Job-control signals back to SIG_DFL
+
+    // CPUs, memory node, priorities and cgroup to take before exec
+    // (nullptr = inherit the shell's)
+    const PlacementPlan* placement = nullptr;
+};
+
+/**
+ * Outcome of spawnProcess()
+ */
+struct SpawnResult {
+    pid_t pid = -1;     // -1 if no child was created
+    int pidfd = -1;     // Owned by the caller; -1 if unavailable
+    int error = 0;      // errno of the failed clone/fork, or of exec
+};
+
+/**
+ * Start a child process
+ *
+ * A child whose exec fails still exits with status 127 (shell
+ * semantics); on the vfork path its errno is reported in `error`.
+ */
+SpawnResult spawnProcess(const SpawnRequest& request);
+
+/**
+ * Name of the mechanism spawnProcess() uses ("clone-vfork" or "fork")
+ */
+const char* spawnEngineName();
+
+#endif // !_WIN32
+
+} // namespace job
+} // namespace ariash
+
+#endif // ARIASH_SPAWN_ENGINE_HPP
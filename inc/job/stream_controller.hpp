@@ -11,13 +11,19 @@
  * - stddati(4): Data Input (binary/wild)
  * - stddato(5): Data Output (binary/wild)
  *
- * Implements the Threaded Draining Model to prevent pipe deadlock.
+ * Implements the Threaded Draining Model to prevent pipe deadlock
+ * (one shared reactor thread drains every stream, see job/io_reactor.hpp).
  */
 
 #ifndef ARIASH_STREAM_CONTROLLER_HPP
 #define ARIASH_STREAM_CONTROLLER_HPP
 
+#include "job/io_reactor.hpp"
+#include "job/job_stats.hpp"
+#include "job/telemetry.hpp"
+#include <array>
 #include <atomic>
+#include <span>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -26,6 +32,7 @@
 #include <functional>
 #include <memory>
 #include <cstdint>
+#include <chrono>
 
 namespace ariash {
 namespace job {
@@ -44,16 +51,63 @@ enum class StreamIndex : uint8_t {
     COUNT   = 6
 };
 
+/**
+ * Get the conventional name of a stream ("stdout", "stddbg", ...)
+ */
+inline const char* streamIndexName(StreamIndex stream) {
+    switch (stream) {
+        case StreamIndex::STDIN:    return "stdin";
+        case StreamIndex::STDOUT:   return "stdout";
+        case StreamIndex::STDERR:   return "stderr";
+        case StreamIndex::STDDBG:   return "stddbg";
+        case StreamIndex::STDDATI:  return "stddati";
+        case StreamIndex::STDDATO:  return "stddato";
+        case StreamIndex::COUNT:    break;
+    }
+    return "unknown";
+}
+
 /**
  * Ring buffer for stream data
  *
- * Lock-free single-producer single-consumer queue.
+ * Single-producer single-consumer queue. Capacity is a power of two and
+ * positions are free-running counters masked into the storage, so no
+ * division happens per access and the whole capacity is usable.
+ *
+ * Besides the copying write()/read(), spans expose ring storage directly:
+ * a producer can read(2) into acquireWrite() and commitWrite() the count,
+ * and a consumer can hand acquireRead() to a callback and release() it.
+ * A mirrored buffer maps its storage twice back to back, so spans are
+ * never split by the wrap-around.
+ *
+ * Writes are lock-free; a growable buffer briefly excludes the consumer
+ * while the producer reallocates. A consumer holding an acquireRead()
+ * span holds no lock: growing while it is out keeps the old storage
+ * until release(), so a slow callback never stalls the producer.
  */
 class RingBuffer {
 public:
+    /**
+     * Fixed-size buffer, allocated up front (rounded up to a power of two)
+     */
     explicit RingBuffer(size_t capacity = 64 * 1024);
+
+    /**
+     * Growable buffer: nothing is allocated until the first write, which
+     * allocates `initialCapacity`; it then doubles on demand up to
+     * `maxCapacity` (both rounded up to powers of two)
+     *
+     * @param mirrored Double-map the storage (Linux, page-sized and up;
+     *                 falls back to plain memory)
+     */
+    RingBuffer(size_t initialCapacity, size_t maxCapacity, bool mirrored = false);
+
     ~RingBuffer();
 
+    // Non-copyable (spans point into our storage)
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
     /**
      * Write data to buffer
      *
@@ -72,6 +126,33 @@ public:
      */
     size_t read(void* data, size_t maxSize);
 
+    /**
+     * Contiguous free space at the write position (producer only)
+     *
+     * @param minSize Grow (if allowed) when less than this is contiguous;
+     *                0 never allocates
+     */
+    std::span<uint8_t> acquireWrite(size_t minSize = 0);
+
+    /**
+     * Publish `n` bytes written into the last acquireWrite() span
+     */
+    void commitWrite(size_t n);
+
+    /**
+     * Contiguous readable data at the read position (consumer only)
+     *
+     * The storage stays pinned until the matching release(), which must
+     * follow on the same thread (release(0) if nothing was consumed). No
+     * lock is held in between.
+     */
+    std::span<const uint8_t> acquireRead();
+
+    /**
+     * Consume `n` bytes of the acquireRead() span and unpin the storage
+     */
+    void release(size_t n);
+
     /**
      * Peek at data without consuming
      */
@@ -102,16 +183,95 @@ public:
      */
     void clear();
 
+    /**
+     * Bytes of storage currently allocated
+     */
+    size_t allocated() const;
+
+    /**
+     * True if the storage is double-mapped
+     */
+    bool isMirrored() const { return mirroredStorage; }
+
+    /**
+     * Ask to be told once `bytes` are free (producer only; clamped to
+     * half the capacity so a slow consumer still wakes us early)
+     *
+     * The notifier runs on the consumer thread that freed the space.
+     *
+     * @return true if the space is already there (nothing armed)
+     */
+    bool requestSpace(size_t bytes);
+
+    /**
+     * Set the callback that requestSpace() arms (nullptr to clear)
+     */
+    void setSpaceNotifier(std::function<void()> notifier);
+
 private:
-    std::vector<uint8_t> buffer;
+    bool grow(size_t needed);
+    bool allocate(size_t cap, uint8_t*& data, bool& mirrored);
+    void freeStorage(uint8_t* data, size_t cap, bool mirrored);
+    size_t contiguous(size_t pos, size_t len) const;
+    void signalSpace();
+
+    uint8_t* storage = nullptr;
+    bool mirroredStorage = false;
     
-    // Cache-line aligned atomics to prevent false sharing
+    // Cache-line aligned atomics to prevent false sharing; both count
+    // bytes ever read/written and are masked into the storage
     alignas(64) std::atomic<size_t> readPos{0};
     alignas(64) std::atomic<size_t> writePos{0};
     
-    size_t capacity;
+    std::atomic<size_t> capacity{0};   // Current ring size (0 until first write)
+    size_t initialCapacity;
+    size_t maxCapacity;
+    bool wantMirror = false;
+
+    // Held by grow() and by the consumer while it touches storage
+    mutable std::mutex resizeMutex;
+
+    // An acquireRead() span is out: grow() retires the storage it points
+    // into instead of freeing it, and release() frees it (both under
+    // resizeMutex)
+    struct RetiredStorage {
+        uint8_t* data;
+        size_t capacity;
+        bool mirrored;
+    };
+    bool readPinned = false;
+    std::vector<RetiredStorage> retired;
+
+    // Backpressure doorbell: free bytes the stalled producer waits for
+    std::atomic<size_t> spaceWanted{0};
+    std::mutex notifierMutex;
+    std::function<void()> spaceNotifier;
 };
 
+/**
+ * Per-stream buffering settings
+ *
+ * Ring buffers are allocated on first data and grow up to maxCapacity;
+ * beyond that the drainer's overflow policy applies. A stream with
+ * maxCapacity 0 gets no ring buffer: stdin and stddati flow the other
+ * way and are never drained, and an output stream configured that way
+ * is discarded.
+ */
+struct StreamOptions {
+    size_t initialCapacity = 4 * 1024;
+    size_t maxCapacity = 1024 * 1024;
+    size_t readChunk = 64 * 1024;       // Max bytes per read from the pipe
+    bool mirrored = false;              // Double-mapped ring (whole spans)
+};
+
+using StreamOptionSet = std::array<StreamOptions, static_cast<size_t>(StreamIndex::COUNT)>;
+
+/**
+ * Default settings: 4KB growing to 1MB for output streams (mirrored for
+ * the bulk stdout/stddato streams), no buffer for input streams
+ */
+StreamOptionSet defaultStreamOptions();
+
 /**
  * Stream callback for data events
  *
@@ -140,39 +300,97 @@ struct HexStreamPipes {
 };
 
 /**
- * Stream Drainer Worker
+ * Drainer readiness hook
+ *
+ * Called on the reactor thread when buffered data is due for delivery
+ * (coalescing window elapsed, byte threshold reached or buffer full),
+ * and once more with eof = true when the stream reaches end of file.
+ */
+using DrainHook = std::function<void(StreamIndex stream, bool eof)>;
+
+/**
+ * Coalescing window for streaming delivery
+ *
+ * Pending data is delivered once `bytes` have accumulated or the oldest
+ * pending byte is `micros` old, whichever comes first (0 disables a
+ * trigger). With both 0 every read is delivered immediately.
+ */
+struct CoalesceWindow {
+    size_t bytes = 0;
+    uint32_t micros = 0;
+};
+
+/**
+ * Stream Drainer
  *
- * C++20 jthread-based worker that continuously drains a single FD.
+ * Drains a single FD into its ring buffer from the shared IoReactor
+ * thread (see job/io_reactor.hpp); no thread of its own.
+ *
+ * Overflow policy when the ring buffer is full:
+ * - drop:  the excess is discarded (telemetry)
+ * - block: the drainer stops reading, so the pipe fills and the kernel
+ *          throttles the writer; the consumer's next read wakes it
+ *          through the reactor (no polling, no CPU while stalled)
  */
 class StreamDrainer {
 public:
-    StreamDrainer(StreamIndex stream, int fd, RingBuffer* buffer, bool dropOnOverflow);
-    ~StreamDrainer() = default;  // jthread joins automatically
+    StreamDrainer(StreamIndex stream, IoHandle fd, RingBuffer* buffer, bool dropOnOverflow,
+                  DrainHook hook = nullptr, CoalesceWindow window = {},
+                  size_t readChunk = 0);
+    ~StreamDrainer();  // Unregisters; the handler never runs afterwards
+
+    // Non-copyable (the reactor holds a pointer to us)
+    StreamDrainer(const StreamDrainer&) = delete;
+    StreamDrainer& operator=(const StreamDrainer&) = delete;
 
     // Statistics
     size_t bytesTransferred() const { return bytesTransferred_.load(); }
+    size_t bytesDropped() const { return bytesDropped_.load(); }
+    int64_t firstDataNs() const { return firstDataNs_.load(); }  // steadyNanos(); 0 = none yet
     bool isActive() const { return active_.load(); }
     StreamIndex getStream() const { return stream_; }
 
 private:
-    void drainLoop(std::stop_token stoken);
+    using Clock = std::chrono::steady_clock;
+
+    IoInterest onEvent(const IoEvent& event);
+    std::span<uint8_t> readTarget();
+
+    bool flushCarry();
+    bool dueNow() const;
+    void fire();
+    void finish();
 
-    std::jthread worker_;
     StreamIndex stream_;
-    int fd_;
+    IoHandle fd_;
     RingBuffer* buffer_;
     bool dropOnOverflow_;
+    DrainHook hook_;
+    CoalesceWindow window_;
     std::atomic<size_t> bytesTransferred_{0};
+    std::atomic<size_t> bytesDropped_{0};
+    std::atomic<int64_t> firstDataNs_{0};
     std::atomic<bool> active_{false};
+
+    // Reactor-thread state
+    std::vector<uint8_t> carry_;         // Read but not yet buffered (block mode)
+    bool eof_ = false;                   // END seen; finish once carry_ drains
+    size_t pending_ = 0;                 // Buffered since the last hook call
+    Clock::time_point firstPending_;
+
+    uint64_t token_ = 0;                 // IoReactor registration
 };
 
 /**
  * Stream Controller
  *
- * Manages I/O for a single job using the Threaded Draining Model.
+ * Manages I/O for a single job.
  *
- * Worker threads continuously drain output pipes into ring buffers,
- * preventing the kernel buffer from filling and causing deadlock.
+ * The shared reactor thread continuously drains output pipes into ring
+ * buffers, preventing the kernel buffer from filling and causing deadlock.
+ * Callbacks (and stddbg telemetry) run on a shared delivery pool, one
+ * delivery at a time per controller, so a slow consumer backs up its own
+ * job and never the reactor.
  */
 class StreamController {
 public:
@@ -197,6 +415,22 @@ public:
      */
     bool setupChild();
 
+    /**
+     * Child-side FD of every stream, for a spawn engine that lays out
+     * FDs 0-5 itself (see spawnProcess())
+     *
+     * @return false if a stream has no child-side FD (createPipes() first)
+     */
+    bool getChildFds(int (&fds)[static_cast<int>(StreamIndex::COUNT)]) const;
+
+    /**
+     * Child-side handle of every stream, for a Windows launcher that
+     * passes them to CreateProcess (see platform::WindowsBootstrap)
+     *
+     * @return false off Windows, or if a stream has no child-side handle
+     */
+    bool getChildHandles(IoHandle (&handles)[static_cast<int>(StreamIndex::COUNT)]) const;
+
     /**
      * Setup parent-side of pipes (call after fork)
      *
@@ -216,6 +450,74 @@ public:
      */
     void stopDraining();
 
+    /**
+     * Wait until every drainer has reached EOF
+     *
+     * Deterministic replacement for "sleep and hope": once this returns
+     * true, all output the child wrote is in the ring buffers (or has
+     * already been delivered to callbacks).
+     *
+     * @param timeout_ms Max wait time (0 = infinite)
+     * @return true if all streams hit EOF, false on timeout
+     */
+    bool waitForDrain(uint32_t timeout_ms = 0);
+
+    /**
+     * Configure streaming delivery (call before startDraining)
+     *
+     * Once a callback is registered, drainers deliver data to it as it
+     * arrives instead of waiting for flushBuffers().
+     */
+    void setCoalescing(CoalesceWindow window) { coalesce = window; }
+
+    /**
+     * Set per-stream buffer capacities and read sizes
+     *
+     * Must be called before startDraining(); discards buffered data.
+     */
+    void configureStreams(const StreamOptionSet& options);
+
+    /**
+     * Attach an external FD as the child side of a stream
+     *
+     * Must be called before createPipes(). No pipe is created for the
+     * stream; the child receives `fd` directly and nothing is drained.
+     * The controller takes ownership of `fd`.
+     *
+     * @return true if the stream was free to attach
+     */
+    bool attachChildFd(StreamIndex stream, int fd);
+
+    /**
+     * Relay an output stream into an external FD (Linux: splice/tee)
+     *
+     * Must be called before startDraining(). Instead of draining the stream
+     * into its ring buffer, a worker moves the data kernel-side into `outFd`.
+     * With `mirror` set, tee(2) duplicates the data into the ring buffer for
+     * inspection (dropped when full, never stalls the relay).
+     * The controller takes ownership of `outFd` and closes it on EOF.
+     *
+     * @return true if the relay was registered
+     */
+    bool relayTo(StreamIndex stream, int outFd, bool mirror = false);
+
+    /**
+     * Run this controller's relay threads on `cpus` (call before
+     * startDraining; empty = wherever the shell runs)
+     *
+     * Set to the CPUs of a placed job's node (job/placement.hpp).
+     */
+    void setServiceCpus(std::vector<int> cpus) { serviceCpus = std::move(cpus); }
+
+    /**
+     * Parse stddbg into `metrics` as it arrives (see job/telemetry.hpp)
+     *
+     * Must be called before startDraining(). Stream 3 is then consumed by
+     * the parser instead of waiting in its ring buffer; callbacks still
+     * see the raw bytes, but readBuffer() does not.
+     */
+    void parseTelemetry(std::shared_ptr<TelemetryMetrics> metrics);
+
     /**
      * Write to stdin pipe
      *
@@ -225,6 +527,15 @@ public:
      */
     ssize_t writeStdin(const void* data, size_t size);
 
+    /**
+     * Write to stddati pipe (stream 4)
+     *
+     * @param data Data to write
+     * @param size Size in bytes
+     * @return Bytes written
+     */
+    ssize_t writeStdDatI(const void* data, size_t size);
+
     /**
      * Close stdin pipe (signals EOF to child process)
      *
@@ -233,6 +544,11 @@ public:
      */
     void closeStdin();
 
+    /**
+     * Close stddati pipe (signals EOF on stream 4)
+     */
+    void closeStdDatI();
+
     /**
      * Read from output buffer
      *
@@ -248,6 +564,30 @@ public:
      */
     size_t availableData(StreamIndex stream) const;
 
+    /**
+     * Wait until an output stream has buffered data or reaches EOF
+     *
+     * For a consumer that pulls data itself instead of registering a
+     * callback. A stream that is not drained counts as at EOF.
+     *
+     * @param timeout_ms Max wait time (0 = infinite)
+     * @return true if data is buffered; false at EOF with nothing left,
+     *         or on timeout
+     */
+    bool waitForData(StreamIndex stream, uint32_t timeout_ms = 0);
+
+    /**
+     * Hand buffered data to `consumer` in place, one contiguous span at a
+     * time, until it takes less than offered or the buffer is empty
+     *
+     * The consumer returns how many bytes it took; their ring space is
+     * released, which resumes a drainer stalled on a full buffer.
+     *
+     * @return Bytes consumed
+     */
+    size_t consumeBuffer(StreamIndex stream,
+                         const std::function<size_t(std::span<const uint8_t>)>& consumer);
+
     /**
      * Check if stream has pending data
      */
@@ -255,6 +595,9 @@ public:
 
     /**
      * Register callback for stream data
+     *
+     * Drained data reaches callbacks on a delivery pool thread (in
+     * order); flushBuffers() calls them on the caller's thread.
      */
     void onData(StreamCallback callback);
 
@@ -282,32 +625,108 @@ public:
 
     /**
      * Get performance statistics
+     *
+     * getActiveThreadCount() reports streams still being drained; they all
+     * share the reactor thread.
      */
     size_t getTotalBytesTransferred() const;
     size_t getActiveThreadCount() const;
 
+    /**
+     * Bytes read and dropped on one stream (drained or relayed)
+     */
+    StreamStats getStreamStats(StreamIndex stream) const;
+
+    /**
+     * When the first output byte reached the shell, on any stream
+     * (steadyNanos(); 0 if none yet)
+     */
+    int64_t getFirstDataTime() const;
+
+    /**
+     * Ring buffer storage currently allocated across all streams
+     */
+    size_t getBufferMemory() const;
+
 private:
     HexStreamPipes pipes;
 
-    // Ring buffers for each output stream (1MB each for high throughput)
+    // Ring buffers for each output stream (lazily allocated; null for
+    // unbuffered streams)
     std::unique_ptr<RingBuffer> buffers[static_cast<int>(StreamIndex::COUNT)];
+    StreamOptionSet streamOptions = defaultStreamOptions();
 
-    // C++20 jthread-based drainers (auto-join on destruction)
+    // Reactor-driven drainers (unregister on destruction)
     std::unique_ptr<StreamDrainer> drainers[4];  // stdout, stderr, stddbg, stddato
 
+    // Kernel-side relays (replace the drainer of a relayed stream)
+    struct Relay {
+        int outFd = -1;
+        bool mirror = false;
+        std::atomic<size_t> bytes{0};
+        std::atomic<size_t> dropped{0};       // Mirror overflow
+        std::atomic<int64_t> firstNs{0};
+        std::jthread worker;
+    };
+    std::unique_ptr<Relay> relays[static_cast<int>(StreamIndex::COUNT)];
+    std::vector<int> serviceCpus;  // Relay thread affinity (empty = inherit)
+
+    // stddbg pipeline stage (parseTelemetry)
+    std::unique_ptr<TelemetryParser> telemetry;
+
     // Callbacks
     std::vector<StreamCallback> callbacks;
     std::mutex callbackMutex;
+    std::atomic<bool> hasCallbacks{false};  // Read by the reactor without the mutex
+
+    // Serializes consumers of each ring buffer (drainer-side delivery,
+    // flushBuffers() and readBuffer() may run on different threads)
+    std::mutex consumeMutex[static_cast<int>(StreamIndex::COUNT)];
+
+    // EOF barrier
+    CoalesceWindow coalesce;
+    std::mutex drainMutex;
+    std::condition_variable drainCv;
+    int openDrainers = 0;
+
+    // Pull consumers (waitForData): streams still being drained, and a
+    // doorbell rung on every drainer delivery; both under drainMutex
+    bool draining[static_cast<int>(StreamIndex::COUNT)] = {};
+    std::condition_variable dataCv;
+
+    // Callback delivery, queued from the reactor to the delivery pool:
+    // streams with data (and eof) due, and whether a runDeliveries() is
+    // queued or running (on deliveryThread); all under deliveryMutex
+    std::mutex deliveryMutex;
+    std::condition_variable deliveryCv;
+    uint32_t pendingData = 0;
+    uint32_t pendingEof = 0;
+    bool deliveryScheduled = false;
+    std::thread::id deliveryThread;
 
     // Mode
     std::atomic<bool> foregroundMode{true};
 
     // Helper functions
     void notifyData(StreamIndex stream, const void* data, size_t size);
+    void deliver(StreamIndex stream);
+    void consumeToCallbacks(StreamIndex stream);
+    void onDrainerEvent(StreamIndex stream, bool eof);
+    void runDeliveries();
+    void finishEvent(StreamIndex stream, bool eof);  // EOF bookkeeping and doorbells
+    void stopRelays();
+
+    // Pipe slot owned by the child / parent for a stream
+    static int childSlot(StreamIndex stream);
+    static int parentSlot(StreamIndex stream);
 
 #ifdef __linux__
     // Zero-copy optimization using splice()
-    ssize_t splicePipeToPipe(int fdIn, int fdOut, std::stop_token stoken);
+    ssize_t splicePipeToPipe(int fdIn, int fdOut, Relay& relay, std::stop_token stoken);
+
+    // splice() plus tee(2) mirror into a ring buffer
+    ssize_t teePipeToPipe(int fdIn, int fdOut, RingBuffer* mirror, Relay& relay,
+                          std::stop_token stoken);
 #endif
 };
 
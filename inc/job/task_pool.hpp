@@ -0,0 +1,94 @@
+/**
+ * AriaSH Task Pool - bounded fan-out of independent jobs
+ *
+ * Backs the `parallel` statement. Tasks are queued and started as jobs
+ * (JobManager::spawnPipeline) until `concurrency` of them are running;
+ * each time one terminates the next queued task starts, so throughput is
+ * that of `xargs -P N` without starting everything at once.
+ *
+ * - Concurrency defaults to the CPUs this process may run on
+ *   (sched_getaffinity), not the machine's total
+ * - Every task's stdout and stderr are collected separately. The shared
+ *   I/O reactor drains all of them: a pool of hundreds of tasks needs no
+ *   thread per task
+ * - Tasks run as background jobs: none of them takes the terminal
+ */
+
+#ifndef ARIASH_TASK_POOL_HPP
+#define ARIASH_TASK_POOL_HPP
+
+#include "job/job_control.hpp"
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ariash {
+namespace job {
+
+/**
+ * Outcome of one task
+ */
+struct TaskResult {
+    int exitCode = -1;      // 127 if the task could not be started
+    std::string output;     // stdout
+    std::string errors;     // stderr
+};
+
+class TaskPool {
+public:
+    /**
+     * Called on the thread running run(), in completion order
+     */
+    using CompletionCallback = std::function<void(size_t task, const TaskResult& result)>;
+
+    /**
+     * @param concurrency Tasks running at once (0 = onlineCpus())
+     */
+    explicit TaskPool(size_t concurrency = 0);
+
+    // Non-copyable (running jobs point into results_)
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /**
+     * Queue a task: one command, or the stages of a pipeline
+     *
+     * @return Task index (into results())
+     */
+    size_t add(std::vector<SpawnOptions> stages);
+
+    void onComplete(CompletionCallback callback) { onComplete_ = std::move(callback); }
+
+    /**
+     * Run every queued task; blocks until the last one finishes
+     *
+     * @return Number of tasks that exited non-zero
+     */
+    size_t run();
+
+    const std::vector<TaskResult>& results() const { return results_; }
+    size_t concurrency() const { return concurrency_; }
+    size_t peakRunning() const { return peakRunning_; }  // Most tasks seen running at once
+
+private:
+    bool start(size_t task, uint32_t& jobId);
+
+    size_t concurrency_;
+    std::vector<std::vector<SpawnOptions>> tasks_;
+    std::vector<TaskResult> results_;
+    std::mutex outputMutex_;  // Reactor callbacks append to results_
+    CompletionCallback onComplete_;
+    size_t peakRunning_ = 0;
+};
+
+/**
+ * Number of CPUs this process may run on (at least 1)
+ */
+size_t onlineCpus();
+
+} // namespace job
+} // namespace ariash
+
+#endif // ARIASH_TASK_POOL_HPP
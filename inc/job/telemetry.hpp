@@ -0,0 +1,215 @@
+/**
+ * AriaSH Telemetry - stddbg (stream 3) parsing and aggregation
+ *
+ * Jobs report metrics on stddbg, one record per line, as JSON objects or
+ * logfmt pairs:
+ *
+ *   {"metric":"requests","type":"counter","value":1}
+ *   metric=latency_ms type=histogram value=12.5
+ *
+ * - metric (or name): what is measured; records without one are only
+ *   counted
+ * - type: counter (default), gauge or histogram
+ * - value: a number (counters default to 1)
+ *
+ * The parser runs as a pipeline stage of the job's StreamController: it
+ * scans records where they lie in the ring buffer (only a record split
+ * by the end of a delivery is copied) and feeds TelemetryMetrics, which
+ * keeps the per-job aggregates. Updates are lock-free: each thread writes
+ * to its own shard of atomics, and snapshot() merges the shards.
+ */
+
+#ifndef ARIASH_TELEMETRY_HPP
+#define ARIASH_TELEMETRY_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ariash {
+namespace job {
+
+enum class MetricKind : uint8_t {
+    COUNTER,    // Sum of values
+    GAUGE,      // Latest value
+    HISTOGRAM   // Distribution of values
+};
+
+const char* metricKindName(MetricKind kind);
+
+/**
+ * One metric as merged by TelemetryMetrics::snapshot()
+ */
+struct MetricSnapshot {
+    // Histogram buckets: 4 per power of two from 2^-16 up to 2^48
+    static constexpr size_t kBuckets = 256;
+
+    std::string name;
+    MetricKind kind = MetricKind::COUNTER;
+    uint64_t count = 0;      // Records
+    double sum = 0;          // Counter total / histogram sum
+    double last = 0;         // Most recent value (gauges)
+    double min = 0;
+    double max = 0;
+    std::vector<uint64_t> buckets;  // Histograms only
+
+    /**
+     * Approximate quantile (0..1) of a histogram: the middle of its
+     * bucket (within 12.5%), clamped to [min, max]
+     */
+    double quantile(double q) const;
+};
+
+/**
+ * A job's aggregates at one point in time
+ */
+struct TelemetrySnapshot {
+    uint64_t records = 0;     // Lines parsed
+    uint64_t malformed = 0;   // Lines that were not a valid record
+    uint64_t dropped = 0;     // Records for metrics beyond the table size
+    double seconds = 0;       // From the first delivery of records to the last
+    std::vector<MetricSnapshot> metrics;  // Sorted by name
+};
+
+/**
+ * Per-job metric aggregates
+ */
+class TelemetryMetrics {
+public:
+    // Distinct metric names per shard
+    static constexpr size_t kMaxMetrics = 256;
+    static constexpr size_t kShards = 8;
+
+    TelemetryMetrics();
+    ~TelemetryMetrics();
+
+    // Non-copyable (shards hold atomics)
+    TelemetryMetrics(const TelemetryMetrics&) = delete;
+    TelemetryMetrics& operator=(const TelemetryMetrics&) = delete;
+
+    /**
+     * Account one record (any thread, lock-free)
+     *
+     * @param name Empty for a record without a metric
+     */
+    void record(std::string_view name, MetricKind kind, double value);
+
+    /**
+     * Count a line that did not parse
+     */
+    void recordMalformed();
+
+    /**
+     * Note that records are arriving now (once per delivery; sets the
+     * span rates are computed over)
+     */
+    void touch();
+
+    /**
+     * Merge every shard
+     */
+    TelemetrySnapshot snapshot() const;
+
+private:
+    struct Metric;
+    struct Shard;
+
+    Shard& localShard();
+
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<int64_t> firstNs_{0};
+    std::atomic<int64_t> lastNs_{0};
+};
+
+/**
+ * Record scanner for one stream
+ *
+ * Not thread-safe: the StreamController serialises consumers of a stream.
+ */
+class TelemetryParser {
+public:
+    // Longer lines are counted as malformed and skipped
+    static constexpr size_t kMaxRecord = 64 * 1024;
+
+    explicit TelemetryParser(std::shared_ptr<TelemetryMetrics> metrics);
+
+    /**
+     * Parse every complete line in `data`; a trailing partial line is
+     * kept for the next call
+     */
+    void feed(const void* data, size_t size);
+
+    /**
+     * End of stream: parse a last line without its newline
+     */
+    void finish();
+
+    /**
+     * Parse one record (no newline)
+     *
+     * @return false if the line is malformed
+     */
+    static bool parseRecord(std::string_view line, std::string_view& name,
+                            MetricKind& kind, double& value);
+
+private:
+    void parseLine(std::string_view line);
+
+    std::shared_ptr<TelemetryMetrics> metrics_;
+    std::string carry_;       // Partial line from the previous call
+    bool overlong_ = false;   // Discarding a line beyond kMaxRecord
+};
+
+/**
+ * Telemetry of recent jobs, by job ID
+ *
+ * Jobs are removed from the JobManager once they finish; their metrics
+ * stay here (for the last kRetained jobs) so `telemetry <job>` still
+ * answers afterwards.
+ */
+class TelemetryRegistry {
+public:
+    static constexpr size_t kRetained = 32;
+
+    struct Entry {
+        uint32_t jobId = 0;
+        std::string command;
+        std::shared_ptr<TelemetryMetrics> metrics;
+    };
+
+    /**
+     * New aggregates for a job (evicts the oldest beyond kRetained)
+     */
+    std::shared_ptr<TelemetryMetrics> attach(uint32_t jobId, const std::string& command);
+
+    /**
+     * @return The job's entry, or nullptr metrics if unknown
+     */
+    Entry find(uint32_t jobId) const;
+
+    /**
+     * Retained jobs, oldest first
+     */
+    std::vector<Entry> entries() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+};
+
+/**
+ * Get the shell's telemetry registry (singleton)
+ */
+TelemetryRegistry& getTelemetryRegistry();
+
+} // namespace job
+} // namespace ariash
+
+#endif // ARIASH_TELEMETRY_HPP
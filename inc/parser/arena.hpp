@@ -0,0 +1,75 @@
+/**
+ * Arena - bump allocator for AST nodes
+ *
+ * A Program owns one Arena and every node the parser creates for it is
+ * carved out of the arena's blocks. Nodes are still destroyed in the
+ * usual order (their strings and child vectors own heap memory), but the
+ * node storage itself is returned in one go when the Program goes away
+ * instead of one free() per node.
+ */
+
+#ifndef ARIASH_ARENA_HPP
+#define ARIASH_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace ariash {
+namespace parser {
+
+class Arena {
+public:
+    static constexpr size_t kFirstBlockSize = 4 * 1024;
+    static constexpr size_t kMaxBlockSize = 64 * 1024;
+
+    Arena() = default;
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * Allocate `size` bytes aligned to `align` (a power of two)
+     */
+    void* allocate(size_t size, size_t align) {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cursor_) + align - 1) & ~(align - 1);
+        if (p + size <= reinterpret_cast<uintptr_t>(end_)) {
+            cursor_ = reinterpret_cast<char*>(p + size);
+            bytesUsed_ += size;
+            return reinterpret_cast<void*>(p);
+        }
+        return allocateSlow(size, align);
+    }
+
+    /**
+     * Construct a T in the arena; the caller runs its destructor
+     */
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    size_t bytesUsed() const { return bytesUsed_; }
+    size_t blockCount() const { return blockCount_; }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    void* allocateSlow(size_t size, size_t align);
+
+    Block* head_ = nullptr;
+    char* cursor_ = nullptr;
+    char* end_ = nullptr;
+    size_t nextBlockSize_ = kFirstBlockSize;
+    size_t bytesUsed_ = 0;
+    size_t blockCount_ = 0;
+};
+
+} // namespace parser
+} // namespace ariash
+
+#endif // ARIASH_ARENA_HPP
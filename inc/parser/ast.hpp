@@ -8,6 +8,8 @@
 #pragma once
 
 #include "parser/token.hpp"
+#include "parser/arena.hpp"
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
@@ -17,6 +19,19 @@ namespace parser {
 
 // Forward declarations
 class ASTVisitor;
+class ASTNode;
+
+/**
+ * Owning pointer to an arena-allocated node
+ * 
+ * Destroys the node but leaves its storage to the Program's Arena.
+ */
+struct NodeDeleter {
+    void operator()(ASTNode* node) const;
+};
+
+template <typename T>
+using NodePtr = std::unique_ptr<T, NodeDeleter>;
 
 /**
  * Base AST Node
@@ -32,11 +47,29 @@ protected:
     ASTNode(SourceLocation loc) : location(loc) {}
 };
 
+inline void NodeDeleter::operator()(ASTNode* node) const {
+    node->~ASTNode();
+}
+
 // =============================================================================
 // Expressions
 // =============================================================================
 
+/**
+ * Type an expression is known to produce, if it produces a value at all
+ * (set by the optimizer; UNKNOWN means "check at run time")
+ */
+enum class StaticType : uint8_t {
+    UNKNOWN,
+    INT,      // int64_t
+    STRING,
+    BOOL
+};
+
 class ExprNode : public ASTNode {
+public:
+    StaticType staticType = StaticType::UNKNOWN;
+    
 protected:
     ExprNode(SourceLocation loc) : ASTNode(loc) {}
 };
@@ -83,12 +116,12 @@ public:
 class BinaryOpExpr : public ExprNode {
 public:
     TokenType op;
-    std::unique_ptr<ExprNode> left;
-    std::unique_ptr<ExprNode> right;
+    NodePtr<ExprNode> left;
+    NodePtr<ExprNode> right;
     
     BinaryOpExpr(TokenType operation, 
-                 std::unique_ptr<ExprNode> l,
-                 std::unique_ptr<ExprNode> r,
+                 NodePtr<ExprNode> l,
+                 NodePtr<ExprNode> r,
                  SourceLocation loc)
         : ExprNode(loc), op(operation), left(std::move(l)), right(std::move(r)) {}
     
@@ -101,10 +134,10 @@ public:
 class UnaryOpExpr : public ExprNode {
 public:
     TokenType op;
-    std::unique_ptr<ExprNode> operand;
+    NodePtr<ExprNode> operand;
     
     UnaryOpExpr(TokenType operation,
-                std::unique_ptr<ExprNode> expr,
+                NodePtr<ExprNode> expr,
                 SourceLocation loc)
         : ExprNode(loc), op(operation), operand(std::move(expr)) {}
     
@@ -117,7 +150,7 @@ public:
 class CallExpr : public ExprNode {
 public:
     std::string function;
-    std::vector<std::unique_ptr<ExprNode>> arguments;
+    std::vector<NodePtr<ExprNode>> arguments;
     
     CallExpr(const std::string& fn, SourceLocation loc)
         : ExprNode(loc), function(fn) {}
@@ -139,7 +172,7 @@ protected:
  */
 class BlockStmt : public StmtNode {
 public:
-    std::vector<std::unique_ptr<StmtNode>> statements;
+    std::vector<NodePtr<StmtNode>> statements;
     
     BlockStmt(SourceLocation loc) : StmtNode(loc) {}
     
@@ -153,7 +186,7 @@ class VarDeclStmt : public StmtNode {
 public:
     std::string type;  // Type name (string instead of TokenType)
     std::string name;
-    std::unique_ptr<ExprNode> initializer;
+    NodePtr<ExprNode> initializer;
     
     VarDeclStmt(const std::string& t, const std::string& n, SourceLocation loc)
         : StmtNode(loc), type(t), name(n) {}
@@ -167,9 +200,9 @@ public:
 class AssignStmt : public StmtNode {
 public:
     std::string variable;
-    std::unique_ptr<ExprNode> value;
+    NodePtr<ExprNode> value;
     
-    AssignStmt(const std::string& var, std::unique_ptr<ExprNode> val, SourceLocation loc)
+    AssignStmt(const std::string& var, NodePtr<ExprNode> val, SourceLocation loc)
         : StmtNode(loc), variable(var), value(std::move(val)) {}
     
     void accept(ASTVisitor& visitor) override;
@@ -180,11 +213,11 @@ public:
  */
 class IfStmt : public StmtNode {
 public:
-    std::unique_ptr<ExprNode> condition;
-    std::unique_ptr<StmtNode> thenBranch;
-    std::unique_ptr<StmtNode> elseBranch;  // Optional
+    NodePtr<ExprNode> condition;
+    NodePtr<StmtNode> thenBranch;
+    NodePtr<StmtNode> elseBranch;  // Optional
     
-    IfStmt(std::unique_ptr<ExprNode> cond, std::unique_ptr<StmtNode> then, SourceLocation loc)
+    IfStmt(NodePtr<ExprNode> cond, NodePtr<StmtNode> then, SourceLocation loc)
         : StmtNode(loc), condition(std::move(cond)), thenBranch(std::move(then)) {}
     
     void accept(ASTVisitor& visitor) override;
@@ -195,10 +228,10 @@ public:
  */
 class WhileStmt : public StmtNode {
 public:
-    std::unique_ptr<ExprNode> condition;
-    std::unique_ptr<StmtNode> body;
+    NodePtr<ExprNode> condition;
+    NodePtr<StmtNode> body;
     
-    WhileStmt(std::unique_ptr<ExprNode> cond, std::unique_ptr<StmtNode> bod, SourceLocation loc)
+    WhileStmt(NodePtr<ExprNode> cond, NodePtr<StmtNode> bod, SourceLocation loc)
         : StmtNode(loc), condition(std::move(cond)), body(std::move(bod)) {}
     
     void accept(ASTVisitor& visitor) override;
@@ -210,10 +243,10 @@ public:
 class ForStmt : public StmtNode {
 public:
     std::string variable;
-    std::unique_ptr<ExprNode> iterable;
-    std::unique_ptr<StmtNode> body;
+    NodePtr<ExprNode> iterable;
+    NodePtr<StmtNode> body;
     
-    ForStmt(const std::string& var, std::unique_ptr<ExprNode> iter, std::unique_ptr<StmtNode> bod, SourceLocation loc)
+    ForStmt(const std::string& var, NodePtr<ExprNode> iter, NodePtr<StmtNode> bod, SourceLocation loc)
         : StmtNode(loc), variable(var), iterable(std::move(iter)), body(std::move(bod)) {}
     
     void accept(ASTVisitor& visitor) override;
@@ -224,7 +257,7 @@ public:
  */
 class ReturnStmt : public StmtNode {
 public:
-    std::unique_ptr<ExprNode> value;  // Optional
+    NodePtr<ExprNode> value;  // Optional
     
     ReturnStmt(SourceLocation loc) : StmtNode(loc) {}
     
@@ -236,9 +269,9 @@ public:
  */
 class ExprStmt : public StmtNode {
 public:
-    std::unique_ptr<ExprNode> expression;
+    NodePtr<ExprNode> expression;
     
-    ExprStmt(std::unique_ptr<ExprNode> expr, SourceLocation loc) 
+    ExprStmt(NodePtr<ExprNode> expr, SourceLocation loc) 
         : StmtNode(loc), expression(std::move(expr)) {}
     
     void accept(ASTVisitor& visitor) override;
@@ -259,10 +292,18 @@ enum class RedirectionType {
 
 /**
  * Redirection specification
+ *
+ * `fd` is the child stream the file replaces, written as a prefix
+ * (2>, 4<, 5>>); without one it is 0 for < and 1 for > and >>.
  */
 struct Redirection {
     RedirectionType type;
     std::string target;
+    int fd = -1;  // Hex-stream FD 0-5 (-1 = the operator's default)
+    
+    int targetFd() const {
+        return fd >= 0 ? fd : (type == RedirectionType::INPUT ? 0 : 1);
+    }
 };
 
 /**
@@ -286,23 +327,59 @@ public:
  */
 class PipelineStmt : public StmtNode {
 public:
-    std::vector<std::unique_ptr<CommandStmt>> commands;
+    std::vector<NodePtr<CommandStmt>> commands;
     
     PipelineStmt(SourceLocation loc) : StmtNode(loc) {}
     
     void accept(ASTVisitor& visitor) override;
 };
 
+/**
+ * Command substitution: $(cmd | cmd ...)
+ * 
+ * Evaluates to the pipeline's standard output, minus trailing newlines;
+ * as a for-loop iterable it yields the output line by line.
+ */
+class CommandSubstExpr : public ExprNode {
+public:
+    NodePtr<PipelineStmt> pipeline;
+    
+    CommandSubstExpr(NodePtr<PipelineStmt> pipe, SourceLocation loc)
+        : ExprNode(loc), pipeline(std::move(pipe)) {}
+    
+    void accept(ASTVisitor& visitor) override;
+};
+
+/**
+ * Parallel fan-out: parallel (limit) { cmd; cmd | cmd; ... }
+ * 
+ * Every task is started as its own job, at most `limit` at a time
+ * (default: online CPUs); the next one starts as each finishes.
+ */
+class ParallelStmt : public StmtNode {
+public:
+    NodePtr<ExprNode> limit;  // Optional
+    std::vector<NodePtr<PipelineStmt>> tasks;
+    
+    ParallelStmt(SourceLocation loc) : StmtNode(loc) {}
+    
+    void accept(ASTVisitor& visitor) override;
+};
+
 // =============================================================================
 // Program (top-level)
 // =============================================================================
 
 /**
  * Complete program (list of statements)
+ * 
+ * Owns the arena its nodes live in; declared first so it outlives them.
  */
 class Program : public ASTNode {
 public:
-    std::vector<std::unique_ptr<StmtNode>> statements;
+    Arena arena;
+    std::vector<NodePtr<StmtNode>> statements;
+    bool optimized = false;  // Optimizer has run over it
     
     Program(SourceLocation loc = SourceLocation()) : ASTNode(loc) {}
     
@@ -324,6 +401,7 @@ public:
     virtual void visit(BinaryOpExpr& node) = 0;
     virtual void visit(UnaryOpExpr& node) = 0;
     virtual void visit(CallExpr& node) = 0;
+    virtual void visit(CommandSubstExpr& node) = 0;
     
     // Statements
     virtual void visit(BlockStmt& node) = 0;
@@ -336,6 +414,7 @@ public:
     virtual void visit(ExprStmt& node) = 0;
     virtual void visit(CommandStmt& node) = 0;
     virtual void visit(PipelineStmt& node) = 0;
+    virtual void visit(ParallelStmt& node) = 0;
     virtual void visit(Program& node) = 0;
 };
 
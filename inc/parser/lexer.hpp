@@ -5,15 +5,22 @@
  * - String interpolation (&{...})
  * - Whitespace insensitivity (outside strings)
  * - Shell operators (|, >, <, &)
+ * 
+ * Tokens do not own their text: a lexeme views the source buffer (or,
+ * for a string literal with escapes, the decoded copy kept by the lexer),
+ * so the source and the lexer must outlive the tokens. Keywords are
+ * found through a constexpr perfect hash, and whitespace/identifier runs
+ * are scanned 16 bytes at a time where SSE2 is available.
  */
 
 #pragma once
 
 #include "parser/token.hpp"
+#include <deque>
 #include <vector>
 #include <stack>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace ariash {
 namespace parser {
@@ -33,7 +40,9 @@ enum class LexerState {
  */
 class ShellLexer {
 public:
-    explicit ShellLexer(const std::string& source);
+    explicit ShellLexer(std::string_view source);
+    explicit ShellLexer(const char* source) : ShellLexer(std::string_view(source)) {}
+    ShellLexer(std::string&&) = delete;  // Tokens would view a dead buffer
     
     /**
      * Tokenize entire source
@@ -41,7 +50,7 @@ public:
     std::vector<Token> tokenize();
     
     /**
-     * Get next token
+     * Get next token (streaming; END_OF_FILE repeats at the end)
      */
     Token nextToken();
     
@@ -51,22 +60,23 @@ public:
     bool isAtEnd() const { return current_ >= source_.length(); }
     
 private:
-    std::string source_;
+    std::string_view source_;
     size_t current_;
     size_t line_;
     size_t column_;
     
     std::stack<LexerState> stateStack_;
-    std::unordered_map<std::string, TokenType> keywords_;
+    std::deque<std::string> decoded_;  // String literals with escapes
     
     // Character access
     char peek() const;
     char peekNext() const;
     char advance();
     bool match(char expected);
+    void advanceBy(size_t count);  // Skip a run, tracking line/column
     
     // Token creation
-    Token makeToken(TokenType type, const std::string& lexeme);
+    Token makeToken(TokenType type, std::string_view lexeme);
     SourceLocation currentLocation() const;
     
     // Whitespace handling
@@ -75,14 +85,13 @@ private:
     
     // Token scanning
     Token scanString(char quote);
-    std::string scanTemplateString();
+    std::string_view scanTemplateString();
     Token scanNumber();
     Token scanIdentifier();
     Token scanOperator();
     
     // Keyword lookup
-    void initKeywords();
-    TokenType identifierType(const std::string& text);
+    static TokenType identifierType(std::string_view text);
 };
 
 } // namespace parser
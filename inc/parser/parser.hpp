@@ -16,6 +16,7 @@
 #define ARIASH_PARSER_HPP
 
 #include "parser/token.hpp"
+#include "parser/lexer.hpp"
 #include "parser/ast.hpp"
 #include <vector>
 #include <memory>
@@ -42,57 +43,81 @@ private:
 class ShellParser {
 public:
     explicit ShellParser(const std::vector<Token>& tokens)
-        : tokens_(tokens), current_(0) {}
+        : tokens_(&tokens), current_(0) {}
+    
+    // Streaming: tokens are pulled from the lexer as the parser needs them
+    explicit ShellParser(ShellLexer& lexer)
+        : lexer_(&lexer), current_(0) {}
     
     // Entry point - parses complete program
     std::unique_ptr<Program> parseProgram();
     
+    // Statements dropped by error recovery in the last parseProgram()
+    size_t errorCount() const { return errorCount_; }
+    
 private:
     // Token stream management
     const Token& peek(int offset = 0) const;
     const Token& consume();
+    const Token& previous() const;  // Last consumed token
     bool match(TokenType type);
     bool check(TokenType type) const;
     void expect(TokenType type, const std::string& message);
     bool isAtEnd() const;
     
     // Top-level parsing
-    std::unique_ptr<StmtNode> parseStatement();
+    NodePtr<StmtNode> parseStatement();
     
     // Expression parsing (precedence climbing)
-    std::unique_ptr<ExprNode> parseExpression();
-    std::unique_ptr<ExprNode> parseLogicalOr();
-    std::unique_ptr<ExprNode> parseLogicalAnd();
-    std::unique_ptr<ExprNode> parseEquality();
-    std::unique_ptr<ExprNode> parseComparison();
-    std::unique_ptr<ExprNode> parseAdditive();
-    std::unique_ptr<ExprNode> parseMultiplicative();
-    std::unique_ptr<ExprNode> parseUnary();
-    std::unique_ptr<ExprNode> parsePrimary();
-    std::unique_ptr<ExprNode> parseCallOrVariable();
+    NodePtr<ExprNode> parseExpression();
+    NodePtr<ExprNode> parseLogicalOr();
+    NodePtr<ExprNode> parseLogicalAnd();
+    NodePtr<ExprNode> parseEquality();
+    NodePtr<ExprNode> parseComparison();
+    NodePtr<ExprNode> parseAdditive();
+    NodePtr<ExprNode> parseMultiplicative();
+    NodePtr<ExprNode> parseUnary();
+    NodePtr<ExprNode> parsePrimary();
+    NodePtr<ExprNode> parseCallOrVariable();
     
     // Statement parsing
-    std::unique_ptr<BlockStmt> parseBlock();
-    std::unique_ptr<VarDeclStmt> parseVarDecl();
-    std::unique_ptr<AssignStmt> parseAssignment(const std::string& varName);
-    std::unique_ptr<IfStmt> parseIf();
-    std::unique_ptr<WhileStmt> parseWhile();
-    std::unique_ptr<ForStmt> parseFor();
-    std::unique_ptr<ReturnStmt> parseReturn();
+    NodePtr<BlockStmt> parseBlock();
+    NodePtr<VarDeclStmt> parseVarDecl();
+    NodePtr<AssignStmt> parseAssignment(const std::string& varName);
+    NodePtr<IfStmt> parseIf();
+    NodePtr<WhileStmt> parseWhile();
+    NodePtr<ForStmt> parseFor();
+    NodePtr<ParallelStmt> parseParallel();
+    NodePtr<ReturnStmt> parseReturn();
     
     // Command parsing (shell mode)
-    std::unique_ptr<CommandStmt> parseCommand();
-    std::unique_ptr<PipelineStmt> parsePipeline();
+    NodePtr<CommandStmt> parseCommand();
+    NodePtr<PipelineStmt> parsePipeline();
     std::vector<Redirection> parseRedirections();
     
+    // Nodes are allocated in the Program's arena
+    template <typename T, typename... Args>
+    NodePtr<T> make(Args&&... args) {
+        return NodePtr<T>(arena_->create<T>(std::forward<Args>(args)...));
+    }
+    
     // Helpers
     bool isKeywordStart() const;
     bool isTypeKeyword() const;
     bool isAssignmentAhead() const;  // IDENTIFIER followed by =
+    bool isRedirectionAhead() const; // <, >, >> (with or without an FD prefix)
+    bool isFdPrefixAhead() const;    // INTEGER 0-5 written against <, >, >>
     
-    // State
-    const std::vector<Token>& tokens_;
+    // State: a token vector, or a lexer plus a lookahead window
+    static constexpr size_t kMaxLookahead = 3;  // peek(2) tells cmd < "file" from a < b
+    const std::vector<Token>* tokens_ = nullptr;
+    ShellLexer* lexer_ = nullptr;
     size_t current_;
+    mutable Token lookahead_[kMaxLookahead];
+    mutable size_t buffered_ = 0;
+    Token previous_;
+    Arena* arena_ = nullptr;
+    size_t errorCount_ = 0;
 };
 
 } // namespace parser
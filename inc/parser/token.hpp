@@ -8,6 +8,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstdint>
 
 namespace ariash {
@@ -34,6 +35,7 @@ enum class TokenType {
     KW_BREAK,
     KW_CONTINUE,
     KW_SPAWN,
+    KW_PARALLEL,
     
     // Type keywords
     KW_INT8,
@@ -94,6 +96,7 @@ enum class TokenType {
     REDIRECT_IN,    // <
     BACKGROUND,     // &
     INTERP_START,   // &{
+    SUBST_START,    // $(
     NEWLINE,        // \n (in interactive mode)
     
     // Special
@@ -117,7 +120,7 @@ struct SourceLocation {
  */
 struct Token {
     TokenType type;
-    std::string lexeme;      // Raw text
+    std::string_view lexeme; // Text, viewing the lexer's source (see ShellLexer)
     SourceLocation location;
     
     // Type-specific values
@@ -130,7 +133,7 @@ struct Token {
         , floatValue(0.0)
     {}
     
-    Token(TokenType t, const std::string& lex, SourceLocation loc)
+    Token(TokenType t, std::string_view lex, SourceLocation loc)
         : type(t)
         , lexeme(lex)
         , location(loc)
@@ -60,6 +60,20 @@ struct WindowsHandleMap {
     bool validateHandles() const;
 };
 
+/**
+ * Create a pipe whose read end supports overlapped I/O
+ *
+ * CreatePipe() handles are synchronous and cannot join an I/O completion
+ * port. This makes a uniquely named, single-instance, local-only byte
+ * pipe instead: the read end is FILE_FLAG_OVERLAPPED and not inheritable
+ * (the parent drains it through the IoReactor), the write end is an
+ * ordinary inheritable handle, so the child sees a plain pipe.
+ *
+ * @param bufferSize Pipe buffer size hint (0 = 64 KiB)
+ * @return true if both ends were created
+ */
+bool createOverlappedPipe(HANDLE& readEnd, HANDLE& writeEnd, DWORD bufferSize = 0);
+
 /**
  * Windows Process Launcher with Handle Mapping
  * 
@@ -73,10 +87,19 @@ public:
     /**
      * Create pipes for all six streams
      * 
+     * Output streams (1, 2, 3, 5) are overlapped named pipes the parent
+     * reads through a completion port; input streams stay anonymous.
+     * 
      * @return true if successful
      */
     bool createPipes();
     
+    /**
+     * Launch with another owner's child-side handles instead of
+     * createPipes() (a StreamController's); they are never closed here
+     */
+    void useChildHandles(const WindowsHandleMap& handles);
+    
     /**
      * Get handle map for child process
      */
@@ -109,6 +132,7 @@ public:
 private:
     WindowsHandleMap childHandles_;   // Child's ends of pipes
     WindowsHandleMap parentHandles_;  // Parent's ends of pipes
+    bool ownsChildHandles_ = true;    // False after useChildHandles()
     
     PROCESS_INFORMATION processInfo_;
     LPPROC_THREAD_ATTRIBUTE_LIST attributeList_;
@@ -0,0 +1,102 @@
+/**
+ * Completion Index - names TAB can complete, without touching PATH
+ *
+ * Listing PATH directories is slow on network filesystems, so it never
+ * happens on a keypress. A worker thread builds a sorted array of every
+ * executable in PATH plus the builtins; complete() binary-searches the
+ * latest published array and never waits for a scan.
+ *
+ * - Built once at startup; refresh() asks the worker to revalidate
+ * - Revalidation goes through CommandCache::directories(), so it sees
+ *   the same inotify/mtime invalidation as command lookup, and only the
+ *   directories whose version changed are listed again
+ * - Variable names come from the Environment, which belongs to the input
+ *   thread: setVariables() hands them over and complete() merges them in
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ariash {
+namespace repl {
+
+class CompletionIndex {
+public:
+    /**
+     * Start the worker, which builds the index straight away
+     */
+    CompletionIndex();
+    ~CompletionIndex();
+
+    // Non-copyable (the worker points at this)
+    CompletionIndex(const CompletionIndex&) = delete;
+    CompletionIndex& operator=(const CompletionIndex&) = delete;
+
+    /**
+     * Ask the worker to pick up PATH changes (returns immediately)
+     */
+    void refresh();
+
+    /**
+     * Variable names offered along with commands (sorted or not)
+     */
+    void setVariables(std::vector<std::string> names);
+
+    /**
+     * Names starting with `prefix`, sorted, from the index as it is now
+     *
+     * @param limit Stop after this many (0 = all)
+     */
+    std::vector<std::string> complete(std::string_view prefix, size_t limit = 0) const;
+
+    /**
+     * Whether the first build has been published
+     */
+    bool ready() const;
+
+    /**
+     * Block until every refresh requested so far is published (tests)
+     */
+    void waitForRefresh();
+
+    /**
+     * Directories listed so far, initial build included
+     */
+    uint64_t directoryScans() const;
+
+private:
+    using Names = std::vector<std::string>;
+
+    struct Listing {
+        uint64_t version = 0;
+        Names names;
+    };
+
+    void worker();
+    bool rebuild();  // Worker only; true if anything changed
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable published_;
+    std::shared_ptr<const Names> commands_;  // Published: sorted, unique
+    uint64_t requested_ = 1;                 // Refreshes asked for (the first is the build)
+    uint64_t completed_ = 0;
+    uint64_t scans_ = 0;
+    bool stop_ = false;
+
+    std::unordered_map<std::string, Listing> listings_;  // Worker only: per PATH directory
+    Names variables_;                                    // Input thread only
+    std::thread worker_;
+};
+
+} // namespace repl
+} // namespace ariash
@@ -0,0 +1,118 @@
+/**
+ * History - persistent command history shared between sessions
+ *
+ * Entries live in an append-only log (~/.ariash_history, or
+ * $ARIASH_HISTFILE): each entry is its text followed by a NUL byte, so
+ * multi-line entries need no escaping. Every session maps the file
+ * read-only and appends with O_APPEND under flock(), one write() per
+ * entry, so concurrent sessions interleave whole entries and see each
+ * other's as soon as they are written.
+ *
+ * - Opening maps the file and returns; nothing is parsed up front
+ * - Entries are identified by their byte offset, so stepping back to
+ *   the previous entry is a memrchr(), whatever the file size
+ * - A background thread indexes the entries present at open, newest
+ *   first, by the trigrams they contain. Substring and prefix searches
+ *   of 3+ bytes intersect posting lists instead of scanning; entries
+ *   written after open (and any part the indexer has not reached yet)
+ *   are scanned directly
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ariash {
+namespace repl {
+
+class History {
+public:
+    /**
+     * Open (creating if needed) the log at `path`
+     */
+    explicit History(std::string path);
+    ~History();
+
+    // Non-copyable (the indexer thread points at this)
+    History(const History&) = delete;
+    History& operator=(const History&) = delete;
+
+    bool isOpen() const { return fd_ >= 0; }
+
+    /**
+     * Append an entry (skipped if empty or equal to the newest one)
+     *
+     * @return true if it was written
+     */
+    bool add(const std::string& entry);
+
+    /**
+     * Newest entry older than `before` that starts with `prefix`
+     *
+     * @param before Offset of an entry, or npos for the newest
+     * @return Offset of the entry found
+     */
+    std::optional<size_t> findPrefix(std::string_view prefix, size_t before = std::string::npos);
+
+    /**
+     * Newest entry older than `before` that contains `text`
+     */
+    std::optional<size_t> findSubstring(std::string_view text, size_t before = std::string::npos);
+
+    /**
+     * Text of the entry at `offset`
+     */
+    std::string entryAt(size_t offset);
+
+    /**
+     * Whether every entry present at open is indexed
+     */
+    bool indexReady() const { return indexDone_.load(std::memory_order_acquire); }
+    void waitForIndex();
+
+private:
+    struct Mapping {
+        const char* data = nullptr;
+        size_t size = 0;
+        ~Mapping();
+    };
+
+    std::optional<size_t> find(std::string_view text, bool prefix, size_t before);
+    std::optional<size_t> findIndexed(std::string_view text, bool prefix,
+                                      const Mapping& map, size_t limit);
+    void refresh();
+    void buildIndex(std::shared_ptr<const Mapping> map, size_t end);
+
+    std::string path_;
+    int fd_ = -1;
+    std::shared_ptr<const Mapping> map_;  // Current view of the file
+    size_t end_ = 0;                      // End of the last complete entry in map_
+    size_t base_ = 0;                     // End of the entries present at open
+
+    // Trigram index over [indexedFrom_, base_), shared with the indexer
+    std::mutex indexMutex_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;  // Trigram -> entry ids
+    std::vector<size_t> offsets_;         // Entry id -> offset (newest first)
+    size_t indexedFrom_ = 0;
+    std::atomic<bool> indexDone_{false};
+    std::atomic<bool> stop_{false};
+    std::thread indexer_;
+};
+
+/**
+ * $ARIASH_HISTFILE, else ~/.ariash_history ("" if there is no HOME)
+ */
+std::string defaultHistoryPath();
+
+} // namespace repl
+} // namespace ariash
@@ -13,9 +13,13 @@
 #pragma once
 
 #include "repl/terminal.hpp"
+#include "repl/renderer.hpp"
+#include "repl/history.hpp"
+#include "repl/completion.hpp"
 #include <string>
 #include <vector>
 #include <functional>
+#include <optional>
 
 namespace ariash {
 namespace repl {
@@ -51,6 +55,7 @@ public:
     // Content manipulation
     void insertChar(char32_t ch);
     void insertNewline();
+    void insertText(const std::string& text);  // A paste, newlines included, in one step
     void deleteChar();       // Delete at cursor
     void backspace();        // Delete before cursor
     void clear();
@@ -67,12 +72,12 @@ public:
     
     // Query
     std::string getContent() const;
-    std::vector<std::string> getLines() const { return lines_; }
+    const std::vector<std::string>& getLines() const { return lines_; }
     BufferPosition getCursor() const { return cursor_; }
     bool isEmpty() const { return lines_.size() == 1 && lines_[0].empty(); }
     size_t lineCount() const { return lines_.size(); }
     
-    // Syntactic analysis
+    // Syntactic analysis (depth is kept per line: only edited lines are rescanned)
     int getBraceDepth() const;
     bool hasSyntaxError() const;
     bool isBalanced() const;
@@ -80,11 +85,21 @@ public:
     bool endsWithDoubleSemicolon() const;  // Check for ;; pattern
     
 private:
+    /**
+     * Lexical state at the end of a line
+     */
+    struct LineState {
+        int depth = 0;    // Open braces, brackets and parentheses
+        char quote = 0;   // Quote of a string still open (0: none)
+    };
+    
     std::vector<std::string> lines_;
     BufferPosition cursor_;
+    mutable std::vector<LineState> lineStates_;  // Up to date for the first size() lines
     
     void ensureCursorValid();
-    int calculateBraceDepth(const std::string& content) const;
+    void invalidateFrom(size_t line);
+    static LineState scanLine(const std::string& line, LineState state);
 };
 
 /**
@@ -118,10 +133,18 @@ public:
     }
     
     /**
-     * Get current prompt string
+     * Get the prompt of the cursor's line
      */
     std::string getPrompt() const;
     
+    /**
+     * Input area as it should be displayed: prompt + text per buffer line
+     *
+     * @param maxRows Lines to show at most (0 = all); the window follows
+     *                the cursor
+     */
+    Frame composeFrame(size_t maxRows = 0);
+    
     /**
      * Get current input mode
      */
@@ -137,10 +160,30 @@ public:
      */
     void requestExit() { running_ = false; }
     
+    /**
+     * Record submissions in `history` and browse it with Up/Down and
+     * Ctrl+R (nullptr: no history)
+     */
+    void setHistory(History* history) { history_ = history; }
+    
+    /**
+     * Complete the word before the cursor from `index` on TAB
+     * (nullptr: TAB does nothing)
+     */
+    void setCompletion(CompletionIndex* index) { completion_ = index; }
+    
+    /**
+     * Feed one key event, as run() does for each one it reads
+     */
+    void handleEvent(const KeyEvent& event);
+    
 private:
     PlatformTerminal& terminal_;
     EditBuffer buffer_;
     InputState state_;
+    FrameRenderer renderer_;
+    bool dirty_;             // Buffer or prompt changed since the last frame
+    size_t viewTop_;         // First buffer line shown (buffers taller than the screen)
     
     SubmissionCallback submissionCallback_;
     ExitCallback exitCallback_;
@@ -149,16 +192,42 @@ private:
     bool continuationMode_;  // Multi-line continuation prompt active
     bool editMode_;          // Edit mode (Ctrl+E) vs Run mode (Ctrl+R)
     
+    // History: Up/Down step through entries starting with the draft,
+    // Ctrl+R searches for entries containing the query
+    History* history_ = nullptr;
+    std::string draft_;              // Buffer before browsing or searching
+    std::vector<size_t> browsed_;    // Entries shown by Up, newest first
+    bool searching_ = false;
+    std::string query_;
+    std::optional<size_t> match_;
+    std::string matchText_;
+    
+    // Completion: candidates are listed under the input until the next key
+    CompletionIndex* completion_ = nullptr;
+    std::vector<std::string> candidates_;
+    
     // State handlers
     void handleIdle(const KeyEvent& event);
     void handleBufferManipulation(const KeyEvent& event);
     void handleChordAnalysis(const KeyEvent& event);
     void handleSubmission();
+    void handleSearch(const KeyEvent& event);
+    
+    // History
+    bool historyPrevious();
+    bool historyNext();
+    void searchHistory(size_t before);
+    void loadBuffer(const std::string& text);
+    
+    // Completion
+    void completeWord();
+    std::string candidateRow() const;
     
     // Actions
-    void renderPrompt();
-    void renderBuffer();
-    void renderCursor();
+    std::string linePrompt(size_t line) const;
+    void requestRender() { dirty_ = true; }
+    void render();                                   // Present the frame now
+    void endFrame(const std::string& trailer = "");  // Move below the input area
     void clearScreen();
     void showError(const std::string& message);
     
@@ -0,0 +1,110 @@
+/**
+ * Frame Renderer - diff-based redraw of the input area
+ *
+ * The InputEngine describes what the input area should look like (one
+ * row per buffer line, prompt included, plus the cursor) and hands it to
+ * present(). The renderer compares it with the frame on screen and emits
+ * only what changed: the differing tail of each changed row, clears for
+ * rows that went away, and the cursor moves between them. Everything for
+ * one frame goes out in a single write().
+ *
+ * - Rows longer than the terminal are wrapped into physical rows, so
+ *   cursor arithmetic matches what the terminal displays
+ * - frameDue() paces redraws to the refresh rate: while input is still
+ *   arriving (a paste, key repeat) keystrokes are applied to the buffer
+ *   but collapse into one frame per refresh interval
+ * - Text written around the renderer (command output, messages) is not
+ *   tracked: finish() moves below the frame first, and the next frame
+ *   starts afresh on the line after it
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ariash {
+namespace repl {
+
+/**
+ * Desired state of the input area
+ */
+struct Frame {
+    std::vector<std::string> rows;  // Printable text only (no escapes)
+    size_t cursorRow = 0;           // Into rows
+    size_t cursorColumn = 0;        // Into rows[cursorRow]
+};
+
+class FrameRenderer {
+public:
+    static constexpr unsigned int kDefaultRefreshRate = 60;  // Hz
+
+    /**
+     * @param fd Terminal output (-1: build output without writing it)
+     */
+    explicit FrameRenderer(int fd = 1);
+
+    /**
+     * Bring the screen up to date with `frame` (one write)
+     */
+    void present(const Frame& frame);
+
+    /**
+     * Escape sequences that turn the current screen into `frame`;
+     * present() is render() plus the write
+     */
+    std::string render(const Frame& frame);
+
+    /**
+     * Leave the frame: park the cursor after its last row, writing
+     * `trailer` there first (e.g. "^C"), and start a new frame below
+     */
+    void finish(const std::string& trailer = "");
+
+    /**
+     * Clear the screen with the next frame (which is then drawn in full)
+     */
+    void clearScreen();
+
+    /**
+     * Forget what is on screen: the next frame is drawn in full, starting
+     * at the cursor's current line
+     */
+    void reset();
+
+    /**
+     * Whether a refresh interval has passed since the last frame
+     */
+    bool frameDue() const;
+
+    void setWidth(size_t columns) { width_ = columns > 0 ? columns : 80; }  // 0: unknown
+    void setRefreshRate(unsigned int hz);
+
+    size_t framesPresented() const { return frames_; }
+    size_t bytesWritten() const { return bytes_; }
+
+private:
+    void layout(const Frame& frame, std::vector<std::string>& rows,
+                size_t& cursorRow, size_t& cursorColumn) const;
+    void moveTo(std::string& out, size_t row, size_t column);
+    void write(const std::string& data);
+
+    int fd_;
+    size_t width_ = 80;
+    std::chrono::steady_clock::duration interval_;
+    std::chrono::steady_clock::time_point lastFrame_;
+
+    std::vector<std::string> screen_;  // Physical rows as last drawn
+    size_t rowsUsed_ = 0;              // Rows the frame has occupied (>= screen_.size())
+    size_t row_ = 0;                   // Cursor, relative to the frame's first row
+    size_t column_ = 0;
+    std::string pending_;              // Prefix for the next frame (clearScreen)
+
+    size_t frames_ = 0;
+    size_t bytes_ = 0;
+};
+
+} // namespace repl
+} // namespace ariash
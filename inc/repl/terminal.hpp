@@ -10,12 +10,17 @@
  * - Virtual Terminal Sequence support
  * - Kitty Keyboard Protocol negotiation
  * - XTerm modifyOtherKeys support
+ * - Bracketed paste: a paste arrives as one PASTE event, not as keys
+ *
+ * Input is read in blocks and every complete event in a block is decoded
+ * at once; readEvent() hands them out one by one without further reads.
  */
 
 #pragma once
 
 #include <string>
 #include <cstdint>
+#include <deque>
 #include <optional>
 
 #ifndef _WIN32
@@ -50,7 +55,9 @@ enum class KeyType {
     CTRL_D,         // EOF/Exit
     CTRL_Z,         // Suspend
     CTRL_L,         // Clear screen
+    CTRL_R,         // Reverse history search
     ESCAPE,         // Standalone Esc key
+    PASTE,          // Bracketed paste (text in KeyEvent::text)
     F1, F2, F3, F4, F5, F6, F7, F8, F9, F10, F11, F12,
     UNKNOWN
 };
@@ -83,6 +90,7 @@ struct KeyEvent {
     KeyType type;
     KeyModifiers modifiers;
     char32_t codepoint;  // UTF-32 for Unicode support
+    std::string text;    // PASTE: the pasted text (newlines as \n)
     
     KeyEvent() 
         : type(KeyType::UNKNOWN)
@@ -143,13 +151,19 @@ public:
     /**
      * Read next key event (blocking)
      * 
-     * POSIX: Parses ANSI escape sequences with VTIME timeout
+     * POSIX: Decodes everything one read() returned (VTIME timeout);
+     *        later calls are served from the decoded batch
      * Windows: Uses ReadConsoleInput with KEY_EVENT_RECORD
      * 
      * @return KeyEvent, or std::nullopt on error/timeout
      */
     std::optional<KeyEvent> readEvent();
     
+    /**
+     * Check whether input is waiting to be read or decoded (does not block)
+     */
+    bool hasPendingInput() const;
+    
     /**
      * Get terminal dimensions
      */
@@ -170,8 +184,15 @@ private:
 #ifndef _WIN32
     struct termios originalTermios_;
     bool termiosValid_;
+    bool bracketedPaste_ = false;   // Enabled by enterRawMode()
+    
+    std::string input_;             // Bytes read but not yet decoded
+    std::deque<KeyEvent> events_;   // Decoded, not yet returned
     
-    std::optional<KeyEvent> parseEscapeSequence();
+    bool fillInput(int timeout_ms);
+    void decodeInput();
+    size_t decodeEvent(size_t pos, bool final);
+    std::optional<KeyEvent> decodeSequence(const std::string& seq);
     std::optional<KeyEvent> parseKittySequence(const std::string& seq);
     std::optional<KeyEvent> parseXTermSequence(const std::string& seq);
     std::optional<KeyEvent> parseAnsiSequence(const std::string& seq);
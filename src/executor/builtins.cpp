@@ -0,0 +1,764 @@
+/**
+ * Builtins Implementation
+ */
+
+#include "executor/builtins.hpp"
+#include "executor/command_cache.hpp"
+#include "job/job_control.hpp"
+#include "job/telemetry.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <thread>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace ariash {
+namespace executor {
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+static bool parseInteger(const std::string& text, long long& value) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    if (begin != end && *begin == '+') {
+        ++begin;
+    }
+    auto [ptr, ec] = std::from_chars(begin, end, value);
+    return ec == std::errc() && ptr == end && begin != end;
+}
+
+// Backslash escapes shared by echo -e and printf formats; returns the
+// index of the last character consumed. `stop` is set by \c
+static size_t appendEscape(const std::string& text, size_t i, std::string& out, bool& stop) {
+    if (i + 1 >= text.size()) {
+        out += '\\';
+        return i;
+    }
+    char c = text[++i];
+    switch (c) {
+        case 'n':  out += '\n'; break;
+        case 't':  out += '\t'; break;
+        case 'r':  out += '\r'; break;
+        case 'a':  out += '\a'; break;
+        case 'b':  out += '\b'; break;
+        case 'f':  out += '\f'; break;
+        case 'v':  out += '\v'; break;
+        case 'e':  out += '\033'; break;
+        case '\\': out += '\\'; break;
+        case 'c':  stop = true; break;
+        case '0': {
+            int value = 0;
+            int digits = 0;
+            while (digits < 3 && i + 1 < text.size() && text[i + 1] >= '0' && text[i + 1] <= '7') {
+                value = value * 8 + (text[++i] - '0');
+                ++digits;
+            }
+            out += static_cast<char>(value);
+            break;
+        }
+        default:
+            out += '\\';
+            out += c;
+            break;
+    }
+    return i;
+}
+
+// =============================================================================
+// true / false / exit
+// =============================================================================
+
+static int builtinTrue(BuiltinContext&) {
+    return 0;
+}
+
+static int builtinFalse(BuiltinContext&) {
+    return 1;
+}
+
+static int builtinExit(BuiltinContext& ctx) {
+    int status = ctx.lastStatus;
+    if (ctx.args.size() > 1) {
+        ctx.err << "exit: too many arguments" << std::endl;
+        return 1;
+    }
+    if (!ctx.args.empty()) {
+        long long value;
+        if (parseInteger(ctx.args[0], value)) {
+            status = static_cast<int>(value & 0xFF);
+        } else {
+            ctx.err << "exit: " << ctx.args[0] << ": numeric argument required" << std::endl;
+            status = 2;
+        }
+    }
+    // A pipeline stage would only have left its own subshell
+    ctx.exitRequested = !ctx.inPipeline;
+    return status;
+}
+
+// =============================================================================
+// echo / printf
+// =============================================================================
+
+static int builtinEcho(BuiltinContext& ctx) {
+    const auto& args = ctx.args;
+    bool newline = true;
+    bool escapes = false;
+
+    // Leading -n / -e / -E (and combinations such as -ne)
+    size_t first = 0;
+    for (; first < args.size(); ++first) {
+        const std::string& arg = args[first];
+        if (arg.size() < 2 || arg[0] != '-' ||
+            arg.find_first_not_of("neE", 1) != std::string::npos) {
+            break;
+        }
+        for (size_t i = 1; i < arg.size(); ++i) {
+            if (arg[i] == 'n') newline = false;
+            else if (arg[i] == 'e') escapes = true;
+            else escapes = false;
+        }
+    }
+
+    std::string line;
+    bool stop = false;
+    for (size_t i = first; i < args.size() && !stop; ++i) {
+        if (i > first) {
+            line += ' ';
+        }
+        if (!escapes) {
+            line += args[i];
+            continue;
+        }
+        const std::string& arg = args[i];
+        for (size_t j = 0; j < arg.size() && !stop; ++j) {
+            if (arg[j] == '\\') {
+                j = appendEscape(arg, j, line, stop);
+            } else {
+                line += arg[j];
+            }
+        }
+    }
+    if (newline && !stop) {
+        line += '\n';
+    }
+    ctx.out.write(line.data(), static_cast<std::streamsize>(line.size()));
+    return 0;
+}
+
+static int builtinPrintf(BuiltinContext& ctx) {
+    const auto& args = ctx.args;
+    if (args.empty()) {
+        ctx.err << "printf: usage: printf FORMAT [ARGUMENT...]" << std::endl;
+        return 2;
+    }
+
+    const std::string& format = args[0];
+    std::string out;
+    int status = 0;
+    size_t next = 1;
+    bool stop = false;
+
+    // The format is reused until every argument is consumed
+    do {
+        bool consumed = false;
+        for (size_t i = 0; i < format.size() && !stop; ++i) {
+            char c = format[i];
+            if (c == '\\') {
+                i = appendEscape(format, i, out, stop);
+                continue;
+            }
+            if (c != '%') {
+                out += c;
+                continue;
+            }
+            if (i + 1 < format.size() && format[i + 1] == '%') {
+                out += '%';
+                ++i;
+                continue;
+            }
+
+            // %[flags][width][.precision]conversion
+            size_t start = i++;
+            while (i < format.size() && std::strchr("-+ #0", format[i])) ++i;
+            while (i < format.size() && std::isdigit(static_cast<unsigned char>(format[i]))) ++i;
+            if (i < format.size() && format[i] == '.') {
+                ++i;
+                while (i < format.size() && std::isdigit(static_cast<unsigned char>(format[i]))) ++i;
+            }
+            if (i >= format.size()) {
+                out.append(format, start, std::string::npos);
+                break;
+            }
+
+            char conversion = format[i];
+            std::string spec = format.substr(start, i - start);
+            const std::string* arg = next < args.size() ? &args[next++] : nullptr;
+            consumed = consumed || arg;
+            char buffer[512];
+            int length;
+
+            switch (conversion) {
+                case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c': {
+                    long long value = 0;
+                    if (conversion == 'c') {
+                        spec += 'c';
+                        length = std::snprintf(buffer, sizeof(buffer), spec.c_str(),
+                                               arg && !arg->empty() ? (*arg)[0] : '\0');
+                        break;
+                    }
+                    if (arg && !parseInteger(*arg, value)) {
+                        ctx.err << "printf: " << *arg << ": invalid number" << std::endl;
+                        status = 1;
+                    }
+                    spec += "ll";
+                    spec += conversion;
+                    length = std::snprintf(buffer, sizeof(buffer), spec.c_str(), value);
+                    break;
+                }
+                case 's':
+                    spec += 's';
+                    length = std::snprintf(buffer, sizeof(buffer), spec.c_str(),
+                                           arg ? arg->c_str() : "");
+                    if (length >= static_cast<int>(sizeof(buffer)) && spec == "%s") {
+                        out += *arg;  // Too long for the buffer, and nothing to pad
+                        length = 0;
+                    }
+                    break;
+                default:
+                    ctx.err << "printf: %" << conversion << ": invalid directive" << std::endl;
+                    return 1;
+            }
+            if (length > 0) {
+                out.append(buffer, std::min(static_cast<size_t>(length), sizeof(buffer) - 1));
+            }
+        }
+        if (!consumed) {
+            break;  // Format without conversions: print it once
+        }
+    } while (next < args.size() && !stop);
+
+    ctx.out.write(out.data(), static_cast<std::streamsize>(out.size()));
+    return status;
+}
+
+// =============================================================================
+// test / [
+// =============================================================================
+
+static bool isUnaryTest(const std::string& op) {
+    return op.size() == 2 && op[0] == '-' && std::strchr("nzefdrwxsLh", op[1]);
+}
+
+static bool isBinaryTest(const std::string& op) {
+    return op == "=" || op == "==" || op == "!=" ||
+           op == "-eq" || op == "-ne" || op == "-lt" ||
+           op == "-le" || op == "-gt" || op == "-ge";
+}
+
+static bool unaryTest(const std::string& op, const std::string& operand) {
+    struct stat st;
+    switch (op[1]) {
+        case 'n': return !operand.empty();
+        case 'z': return operand.empty();
+        case 'e': return stat(operand.c_str(), &st) == 0;
+        case 'f': return stat(operand.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+        case 'd': return stat(operand.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+        case 's': return stat(operand.c_str(), &st) == 0 && st.st_size > 0;
+        case 'r': return access(operand.c_str(), R_OK) == 0;
+        case 'w': return access(operand.c_str(), W_OK) == 0;
+        case 'x': return access(operand.c_str(), X_OK) == 0;
+        default:  return lstat(operand.c_str(), &st) == 0 && S_ISLNK(st.st_mode);  // -L, -h
+    }
+}
+
+// 0 true, 1 false, 2 error
+static int binaryTest(BuiltinContext& ctx, const std::string& l,
+                      const std::string& op, const std::string& r) {
+    if (op == "=" || op == "==") return l == r ? 0 : 1;
+    if (op == "!=") return l != r ? 0 : 1;
+
+    long long a, b;
+    if (!parseInteger(l, a) || !parseInteger(r, b)) {
+        ctx.err << "test: " << (parseInteger(l, a) ? r : l)
+                << ": integer expression expected" << std::endl;
+        return 2;
+    }
+    bool holds;
+    if (op == "-eq") holds = a == b;
+    else if (op == "-ne") holds = a != b;
+    else if (op == "-lt") holds = a < b;
+    else if (op == "-le") holds = a <= b;
+    else if (op == "-gt") holds = a > b;
+    else holds = a >= b;
+    return holds ? 0 : 1;
+}
+
+// POSIX rules: the meaning is decided by the number of arguments
+static int evaluateTest(BuiltinContext& ctx, size_t begin, size_t end) {
+    const auto& args = ctx.args;
+    size_t count = end - begin;
+    auto negate = [](int result) { return result == 2 ? 2 : 1 - result; };
+
+    switch (count) {
+        case 0:
+            return 1;
+        case 1:
+            return args[begin].empty() ? 1 : 0;
+        case 2:
+            if (args[begin] == "!") return negate(evaluateTest(ctx, begin + 1, end));
+            if (isUnaryTest(args[begin])) return unaryTest(args[begin], args[begin + 1]) ? 0 : 1;
+            ctx.err << "test: " << args[begin] << ": unary operator expected" << std::endl;
+            return 2;
+        case 3:
+            if (isBinaryTest(args[begin + 1])) {
+                return binaryTest(ctx, args[begin], args[begin + 1], args[begin + 2]);
+            }
+            if (args[begin] == "!") return negate(evaluateTest(ctx, begin + 1, end));
+            if (args[begin] == "(" && args[end - 1] == ")") return evaluateTest(ctx, begin + 1, end - 1);
+            ctx.err << "test: " << args[begin + 1] << ": binary operator expected" << std::endl;
+            return 2;
+        case 4:
+            if (args[begin] == "!") return negate(evaluateTest(ctx, begin + 1, end));
+            if (args[begin] == "(" && args[end - 1] == ")") return evaluateTest(ctx, begin + 1, end - 1);
+            [[fallthrough]];
+        default:
+            ctx.err << "test: too many arguments" << std::endl;
+            return 2;
+    }
+}
+
+static int builtinTest(BuiltinContext& ctx) {
+    return evaluateTest(ctx, 0, ctx.args.size());
+}
+
+static int builtinBracket(BuiltinContext& ctx) {
+    if (ctx.args.empty() || ctx.args.back() != "]") {
+        ctx.err << "[: missing ']'" << std::endl;
+        return 2;
+    }
+    return evaluateTest(ctx, 0, ctx.args.size() - 1);
+}
+
+// =============================================================================
+// pwd / cd / sleep
+// =============================================================================
+
+static std::string currentDirectory() {
+    std::string path(256, '\0');
+    while (!getcwd(path.data(), path.size())) {
+        if (errno != ERANGE) {
+            return std::string();
+        }
+        path.resize(path.size() * 2);
+    }
+    path.resize(std::strlen(path.c_str()));
+    return path;
+}
+
+static int builtinPwd(BuiltinContext& ctx) {
+    std::string cwd = currentDirectory();
+    if (cwd.empty()) {
+        ctx.err << "pwd: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    cwd += '\n';
+    ctx.out.write(cwd.data(), static_cast<std::streamsize>(cwd.size()));
+    return 0;
+}
+
+static int builtinCd(BuiltinContext& ctx) {
+    if (ctx.args.size() > 1) {
+        ctx.err << "cd: too many arguments" << std::endl;
+        return 1;
+    }
+
+    std::string target;
+    bool announce = false;
+    if (ctx.args.empty()) {
+        const char* home = std::getenv("HOME");
+        if (!home || !*home) {
+            ctx.err << "cd: HOME not set" << std::endl;
+            return 1;
+        }
+        target = home;
+    } else if (ctx.args[0] == "-") {
+        const char* previous = std::getenv("OLDPWD");
+        if (!previous || !*previous) {
+            ctx.err << "cd: OLDPWD not set" << std::endl;
+            return 1;
+        }
+        target = previous;
+        announce = true;
+    } else {
+        target = ctx.args[0];
+    }
+
+    // In a pipeline only the stage's own subshell would have moved
+    if (ctx.inPipeline) {
+        struct stat st;
+        if (stat(target.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+            ctx.err << "cd: " << target << ": No such file or directory" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    std::string previous = currentDirectory();
+    if (chdir(target.c_str()) != 0) {
+        ctx.err << "cd: " << target << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    std::string now = currentDirectory();
+    if (!previous.empty()) {
+        setenv("OLDPWD", previous.c_str(), 1);
+    }
+    setenv("PWD", now.c_str(), 1);
+    if (announce) {
+        ctx.out << now << '\n';
+    }
+    return 0;
+}
+
+static int builtinSleep(BuiltinContext& ctx) {
+    if (ctx.args.empty()) {
+        ctx.err << "sleep: missing operand" << std::endl;
+        return 1;
+    }
+
+    // NUMBER[smhd], summed over all operands
+    double seconds = 0;
+    for (const auto& arg : ctx.args) {
+        char* end = nullptr;
+        errno = 0;
+        double value = std::strtod(arg.c_str(), &end);
+        double scale = 1;
+        if (end && *end && end[1] == '\0') {
+            switch (*end) {
+                case 's': scale = 1; ++end; break;
+                case 'm': scale = 60; ++end; break;
+                case 'h': scale = 3600; ++end; break;
+                case 'd': scale = 86400; ++end; break;
+                default: break;
+            }
+        }
+        if (arg.empty() || errno != 0 || *end != '\0' || !(value >= 0)) {
+            ctx.err << "sleep: invalid time interval '" << arg << "'" << std::endl;
+            return 1;
+        }
+        seconds += value * scale;
+    }
+
+    ctx.out.flush();  // Show what came before while we wait
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    return 0;
+}
+
+// =============================================================================
+// hash
+// =============================================================================
+
+static int builtinHash(BuiltinContext& ctx) {
+    CommandCache& cache = getCommandCache();
+    const auto& args = ctx.args;
+
+    // hash / hash -l: list remembered commands
+    if (args.empty() || (args.size() == 1 && args[0] == "-l")) {
+        auto entries = cache.entries();
+        if (entries.empty()) {
+            ctx.out << "hash: hash table empty" << std::endl;
+        } else {
+            ctx.out << "hits\tcommand" << std::endl;
+            for (const auto& entry : entries) {
+                ctx.out << "   " << entry.hits << "\t" << entry.path << std::endl;
+            }
+        }
+        return 0;
+    }
+
+    // hash -r: forget everything; hash NAME...: look names up now
+    int status = 0;
+    for (const auto& arg : args) {
+        if (arg == "-r") {
+            cache.clear();
+        } else if (!arg.empty() && arg[0] == '-') {
+            ctx.err << "hash: " << arg << ": invalid option" << std::endl;
+            status = 2;
+        } else if (!cache.found(arg)) {
+            ctx.err << "hash: " << arg << ": not found" << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
+
+// =============================================================================
+// telemetry
+// =============================================================================
+
+static std::string formatNumber(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.6g", value);
+    return text;
+}
+
+// JOB as 3 or %3
+static bool parseJobSpec(const std::string& arg, uint32_t& jobId) {
+    long long id = 0;
+    std::string text = !arg.empty() && arg[0] == '%' ? arg.substr(1) : arg;
+    if (!parseInteger(text, id) || id <= 0 || id > UINT32_MAX) return false;
+    jobId = static_cast<uint32_t>(id);
+    return true;
+}
+
+static int builtinTelemetry(BuiltinContext& ctx) {
+    job::TelemetryRegistry& registry = job::getTelemetryRegistry();
+    const auto& args = ctx.args;
+
+    // telemetry: recent jobs and how much they reported
+    if (args.empty()) {
+        for (const auto& entry : registry.entries()) {
+            job::TelemetrySnapshot snap = entry.metrics->snapshot();
+            ctx.out << "[" << entry.jobId << "]\t" << snap.records << " records\t"
+                    << entry.command << std::endl;
+        }
+        return 0;
+    }
+
+    // telemetry JOB...: the job's metrics (JOB as 3 or %3)
+    int status = 0;
+    for (const auto& arg : args) {
+        uint32_t id = 0;
+        job::TelemetryRegistry::Entry entry;
+        if (parseJobSpec(arg, id)) {
+            entry = registry.find(id);
+        }
+        if (!entry.metrics) {
+            ctx.err << "telemetry: " << arg << ": no such job" << std::endl;
+            status = 1;
+            continue;
+        }
+
+        // The rate needs records spread over more than one delivery
+        job::TelemetrySnapshot snap = entry.metrics->snapshot();
+        ctx.out << "[" << entry.jobId << "] " << entry.command << ": " << snap.records << " records";
+        if (snap.seconds > 0) {
+            ctx.out << " (" << formatNumber(static_cast<double>(snap.records) / snap.seconds) << "/s)";
+        }
+        ctx.out << ", " << snap.malformed << " malformed, " << snap.dropped << " dropped" << std::endl;
+
+        for (const auto& metric : snap.metrics) {
+            ctx.out << "  " << job::metricKindName(metric.kind) << "\t" << metric.name << "\t";
+            switch (metric.kind) {
+                case job::MetricKind::COUNTER:
+                    ctx.out << "total " << formatNumber(metric.sum) << "  count " << metric.count;
+                    break;
+                case job::MetricKind::GAUGE:
+                    ctx.out << "last " << formatNumber(metric.last) << "  min "
+                            << formatNumber(metric.min) << "  max " << formatNumber(metric.max);
+                    break;
+                case job::MetricKind::HISTOGRAM:
+                    ctx.out << "count " << metric.count << "  mean "
+                            << formatNumber(metric.sum / static_cast<double>(metric.count))
+                            << "  p50 " << formatNumber(metric.quantile(0.5))
+                            << "  p90 " << formatNumber(metric.quantile(0.9))
+                            << "  p99 " << formatNumber(metric.quantile(0.99))
+                            << "  max " << formatNumber(metric.max);
+                    break;
+            }
+            ctx.out << std::endl;
+        }
+    }
+    return status;
+}
+
+// =============================================================================
+// jobs
+// =============================================================================
+
+// Three significant digits in the largest unit below the value
+static std::string formatDuration(double seconds) {
+    const char* unit = "s";
+    if (seconds < 1e-3) {
+        seconds *= 1e6;
+        unit = "us";
+    } else if (seconds < 1) {
+        seconds *= 1e3;
+        unit = "ms";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3g%s", seconds, unit);
+    return text;
+}
+
+static void printJobStats(std::ostream& out, const job::JobStats& stats) {
+    out << "[" << stats.jobId << "] " << stats.command << ": " << job::jobStateName(stats.state);
+    if (stats.state == job::JobState::TERMINATED) {
+        out << ", exit " << stats.exitCode;
+    }
+    out << ", " << stats.processes << (stats.processes == 1 ? " process" : " processes") << std::endl;
+
+    // Wall time against what the child itself used and what the shell took
+    out << "  wall " << formatDuration(stats.wallSeconds)
+        << "  spawn " << formatDuration(stats.spawnSeconds)
+        << "  first byte " << (stats.firstByteSeconds < 0 ? "-" : formatDuration(stats.firstByteSeconds))
+        << std::endl;
+    out << "  user " << formatDuration(stats.usage.userSeconds)
+        << "  sys " << formatDuration(stats.usage.systemSeconds)
+        << "  max rss " << stats.usage.maxRssKb << " KiB"
+        << "  switches " << stats.usage.voluntarySwitches << " voluntary, "
+        << stats.usage.involuntarySwitches << " involuntary" << std::endl;
+
+    for (job::StreamIndex stream : {job::StreamIndex::STDOUT, job::StreamIndex::STDERR,
+                                    job::StreamIndex::STDDBG, job::StreamIndex::STDDATO}) {
+        const job::StreamStats& s = stats.streams[static_cast<size_t>(stream)];
+        out << "  " << job::streamIndexName(stream) << " " << s.bytes << " B";
+        if (s.dropped > 0) {
+            out << " (" << s.dropped << " dropped)";
+        }
+    }
+    out << std::endl;
+}
+
+static void printLatency(std::ostream& out, const job::TelemetrySnapshot& latency,
+                         const char* name, const char* label) {
+    out << label << " latency: ";
+    for (const auto& metric : latency.metrics) {
+        if (metric.name != name || metric.count == 0) continue;
+        out << "count " << metric.count
+            << "  mean " << formatDuration(metric.sum / static_cast<double>(metric.count) / 1e6)
+            << "  p50 " << formatDuration(metric.quantile(0.5) / 1e6)
+            << "  p90 " << formatDuration(metric.quantile(0.9) / 1e6)
+            << "  p99 " << formatDuration(metric.quantile(0.99) / 1e6)
+            << "  max " << formatDuration(metric.max / 1e6) << std::endl;
+        return;
+    }
+    out << "no samples" << std::endl;
+}
+
+static int builtinJobs(BuiltinContext& ctx) {
+    job::JobManager& manager = job::getJobManager();
+
+    bool stats = false;
+    bool json = false;
+    std::vector<uint32_t> ids;
+    int status = 0;
+    for (const auto& arg : ctx.args) {
+        uint32_t id = 0;
+        if (arg == "--stats" || arg == "-s") {
+            stats = true;
+        } else if (arg == "--json") {
+            json = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            ctx.err << "jobs: " << arg << ": invalid option" << std::endl;
+            return 2;
+        } else if (parseJobSpec(arg, id)) {
+            ids.push_back(id);
+        } else {
+            ctx.err << "jobs: " << arg << ": no such job" << std::endl;
+            status = 1;
+        }
+    }
+
+    // jobs: what is still running or stopped
+    if (!stats && !json) {
+        std::vector<uint32_t> active = manager.getActiveJobs();
+        std::sort(active.begin(), active.end());
+        for (uint32_t id : active) {
+            job::JobStats job;
+            if (!manager.getStats(id, job)) continue;  // Finished meanwhile
+            if (!ids.empty() && std::find(ids.begin(), ids.end(), id) == ids.end()) continue;
+            ctx.out << "[" << id << "]	" << job::jobStateName(job.state) << "	" << job.command << std::endl;
+        }
+        return status;
+    }
+
+    // jobs --stats / --json [JOB...]: live and recently removed jobs
+    std::vector<job::JobStats> selected;
+    if (ids.empty()) {
+        selected = manager.getAllStats();
+    }
+    for (uint32_t id : ids) {
+        job::JobStats job;
+        if (manager.getStats(id, job)) {
+            selected.push_back(std::move(job));
+        } else {
+            ctx.err << "jobs: %" << id << ": no such job" << std::endl;
+            status = 1;
+        }
+    }
+
+    job::TelemetrySnapshot latency = job::getLatencyMetrics().snapshot();
+    if (json) {
+        job::writeJobStatsJson(ctx.out, selected, latency);
+        return status;
+    }
+    for (const auto& job : selected) {
+        printJobStats(ctx.out, job);
+    }
+    printLatency(ctx.out, latency, job::kSpawnLatencyMetric, "spawn");
+    printLatency(ctx.out, latency, job::kFirstByteLatencyMetric, "first byte");
+    return status;
+}
+
+// =============================================================================
+// BuiltinRegistry Implementation
+// =============================================================================
+
+BuiltinRegistry::BuiltinRegistry() {
+    add("true", builtinTrue);
+    add("false", builtinFalse);
+    add("echo", builtinEcho);
+    add("printf", builtinPrintf);
+    add("test", builtinTest);
+    add("[", builtinBracket);
+    add("pwd", builtinPwd);
+    add("cd", builtinCd);
+    add("sleep", builtinSleep);
+    add("exit", builtinExit);
+    add("quit", builtinExit);
+    add("hash", builtinHash);
+    add("telemetry", builtinTelemetry);
+    add("jobs", builtinJobs);
+}
+
+void BuiltinRegistry::add(const std::string& name, BuiltinFunction function) {
+    builtins_[name] = function;
+}
+
+void BuiltinRegistry::remove(const std::string& name) {
+    builtins_.erase(name);
+}
+
+BuiltinFunction BuiltinRegistry::find(const std::string& name) const {
+    auto it = builtins_.find(name);
+    return it != builtins_.end() ? it->second : nullptr;
+}
+
+std::vector<std::string> BuiltinRegistry::names() const {
+    std::vector<std::string> result;
+    result.reserve(builtins_.size());
+    for (const auto& entry : builtins_) {
+        result.push_back(entry.first);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+BuiltinRegistry& getBuiltins() {
+    static BuiltinRegistry registry;
+    return registry;
+}
+
+} // namespace executor
+} // namespace ariash
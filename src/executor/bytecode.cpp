@@ -0,0 +1,493 @@
+/**
+ * Bytecode Compiler Implementation
+ */
+
+#include "executor/bytecode.hpp"
+
+namespace ariash {
+namespace executor {
+
+using parser::TokenType;
+
+static bool isLeaf(const parser::ExprNode& expr) {
+    return dynamic_cast<const parser::IntegerLiteral*>(&expr) ||
+           dynamic_cast<const parser::StringLiteral*>(&expr) ||
+           dynamic_cast<const parser::VariableExpr*>(&expr);
+}
+
+static bool binaryOpCode(TokenType op, OpCode& out) {
+    switch (op) {
+        case TokenType::PLUS:  out = OpCode::ADD; return true;
+        case TokenType::MINUS: out = OpCode::SUB; return true;
+        case TokenType::STAR:  out = OpCode::MUL; return true;
+        case TokenType::SLASH: out = OpCode::DIV; return true;
+        case TokenType::LT:    out = OpCode::LT;  return true;
+        case TokenType::LE:    out = OpCode::LE;  return true;
+        case TokenType::GT:    out = OpCode::GT;  return true;
+        case TokenType::GE:    out = OpCode::GE;  return true;
+        case TokenType::EQ:    out = OpCode::EQ;  return true;
+        case TokenType::NE:    out = OpCode::NE;  return true;
+        case TokenType::AND:   out = OpCode::AND; return true;
+        case TokenType::OR:    out = OpCode::OR;  return true;
+        default:               return false;
+    }
+}
+
+static bool isComparison(OpCode op) {
+    return op >= OpCode::LT && op <= OpCode::NE;
+}
+
+static bool bothInt(const parser::ExprNode& left, const parser::ExprNode& right) {
+    return left.staticType == parser::StaticType::INT &&
+           right.staticType == parser::StaticType::INT;
+}
+
+// Int-specialised form of a generic arithmetic or comparison opcode
+static OpCode intOpCode(OpCode op) {
+    switch (op) {
+        case OpCode::ADD: return OpCode::ADD_INT;
+        case OpCode::SUB: return OpCode::SUB_INT;
+        case OpCode::MUL: return OpCode::MUL_INT;
+        case OpCode::DIV: return OpCode::DIV_INT;
+        default:          return isComparison(op) ? OpCode::CMP_INT : op;
+    }
+}
+
+// =============================================================================
+// Compiler
+// =============================================================================
+
+Chunk Compiler::compile(parser::Program& program) {
+    chunk_ = Chunk();
+    constantIndex_.clear();
+    variableIndex_.clear();
+    scopes_.clear();
+    nextTemp_ = 0;
+    maxTemps_ = 0;
+
+    program.accept(*this);
+
+    // Temporaries live right behind the constants
+    for (auto& in : chunk_.code) {
+        switch (in.op) {
+            case OpCode::JUMP:
+            case OpCode::COMMAND:
+            case OpCode::PIPELINE:
+            case OpCode::ITER_CAPTURE:
+            case OpCode::ITER_END:
+            case OpCode::FAIL:
+            case OpCode::HALT:
+                break;
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE:
+            case OpCode::JUMP_UNLESS:
+            case OpCode::JUMP_WHEN:
+            case OpCode::JUMP_UNLESS_INT:
+            case OpCode::JUMP_WHEN_INT:
+                relocate(in.a);
+                relocate(in.b);
+                break;
+            case OpCode::PARALLEL:
+                relocate(in.b);
+                break;
+            case OpCode::DEFINE:
+            case OpCode::CAPTURE:
+                relocate(in.dst);
+                relocate(in.a);
+                break;
+            case OpCode::ITER_STRING:
+            case OpCode::ITER_NEXT:
+                relocate(in.a);
+                break;
+            default:
+                relocate(in.dst);
+                relocate(in.a);
+                relocate(in.b);
+                break;
+        }
+    }
+    chunk_.registerCount = static_cast<int32_t>(chunk_.constants.size()) + maxTemps_;
+
+    return std::move(chunk_);
+}
+
+void Compiler::relocate(int32_t& operand) const {
+    if (operand >= kTempBase) {
+        operand = static_cast<int32_t>(chunk_.constants.size()) + (operand - kTempBase);
+    }
+}
+
+int32_t Compiler::compileExpr(parser::ExprNode& expr, int32_t target) {
+    int32_t savedTarget = target_;
+    target_ = target;
+    expr.accept(*this);
+    target_ = savedTarget;
+
+    int32_t operand = result_;
+    if (target != kNoTarget && operand != target) {
+        emit({OpCode::MOVE, OpCode::LT, target, operand, 0});
+        operand = target;
+    }
+    return operand;
+}
+
+size_t Compiler::emitBranch(parser::ExprNode& condition, bool whenTrue) {
+    int32_t mark = nextTemp_;
+    size_t index;
+
+    // Comparison conditions test and branch in one instruction
+    auto* binary = dynamic_cast<parser::BinaryOpExpr*>(&condition);
+    OpCode op;
+    if (binary && binaryOpCode(binary->op, op) && isComparison(op)) {
+        int32_t left = compileExpr(*binary->left);
+        if (isVariableOperand(left) && !isLeaf(*binary->right)) {
+            int32_t temp = allocTemp();
+            emit({OpCode::MOVE, OpCode::LT, temp, left, 0});
+            left = temp;
+        }
+        int32_t right = compileExpr(*binary->right);
+        OpCode branch = bothInt(*binary->left, *binary->right)
+            ? (whenTrue ? OpCode::JUMP_WHEN_INT : OpCode::JUMP_UNLESS_INT)
+            : (whenTrue ? OpCode::JUMP_WHEN : OpCode::JUMP_UNLESS);
+        index = emit({branch, op, 0, left, right});
+    } else {
+        int32_t value = compileExpr(condition);
+        index = emit({whenTrue ? OpCode::JUMP_IF_TRUE : OpCode::JUMP_IF_FALSE,
+                      OpCode::LT, 0, value, 0});
+    }
+
+    nextTemp_ = mark;
+    return index;
+}
+
+void Compiler::patchJump(size_t index) {
+    chunk_.code[index].dst = static_cast<int32_t>(chunk_.code.size());
+}
+
+size_t Compiler::emit(const Instruction& instruction) {
+    chunk_.code.push_back(instruction);
+    return chunk_.code.size() - 1;
+}
+
+int32_t Compiler::constant(const Value& value) {
+    auto it = constantIndex_.find(value);
+    if (it != constantIndex_.end()) {
+        return it->second;
+    }
+    int32_t index = static_cast<int32_t>(chunk_.constants.size());
+    chunk_.constants.push_back(value);
+    constantIndex_.emplace(value, index);
+    return index;
+}
+
+int32_t Compiler::variable(const std::string& name) {
+    auto it = variableIndex_.find(name);
+    if (it != variableIndex_.end()) {
+        return variableOperand(it->second);
+    }
+    int32_t slot = static_cast<int32_t>(chunk_.variables.size());
+    chunk_.variables.push_back(name);
+    variableIndex_.emplace(name, slot);
+    return variableOperand(slot);
+}
+
+int32_t Compiler::resolve(const std::string& name) {
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        auto it = scope->find(name);
+        if (it != scope->end()) {
+            return it->second;
+        }
+    }
+    return variable(name);
+}
+
+int32_t Compiler::message(const std::string& text) {
+    chunk_.messages.push_back(text);
+    return static_cast<int32_t>(chunk_.messages.size() - 1);
+}
+
+int32_t Compiler::substitution(parser::CommandSubstExpr& node) {
+    chunk_.substitutions.push_back(&node);
+    return static_cast<int32_t>(chunk_.substitutions.size() - 1);
+}
+
+int32_t Compiler::allocTemp() {
+    int32_t temp = kTempBase + nextTemp_++;
+    if (nextTemp_ > maxTemps_) {
+        maxTemps_ = nextTemp_;
+    }
+    return temp;
+}
+
+int32_t Compiler::destination(int32_t mark) {
+    if (target_ != kNoTarget) {
+        return target_;
+    }
+    nextTemp_ = mark;
+    return allocTemp();
+}
+
+// =============================================================================
+// Expressions
+// =============================================================================
+
+void Compiler::visit(parser::IntegerLiteral& node) {
+    result_ = constant(node.value);
+}
+
+void Compiler::visit(parser::StringLiteral& node) {
+    result_ = constant(SharedString::intern(node.value));
+}
+
+void Compiler::visit(parser::VariableExpr& node) {
+    result_ = resolve(node.name);
+}
+
+void Compiler::visit(parser::BinaryOpExpr& node) {
+    int32_t mark = nextTemp_;
+    int32_t target = target_;
+
+    int32_t left = compileExpr(*node.left);
+    // A variable is read when the instruction runs: snapshot it if the
+    // right side has work (and errors) of its own to run first
+    if (isVariableOperand(left) && !isLeaf(*node.right)) {
+        int32_t temp = allocTemp();
+        emit({OpCode::MOVE, OpCode::LT, temp, left, 0});
+        left = temp;
+    }
+    int32_t right = compileExpr(*node.right);
+
+    OpCode op;
+    if (!binaryOpCode(node.op, op)) {
+        emit({OpCode::FAIL, OpCode::LT, 0, message("Unknown binary operator"), 0});
+        result_ = left;
+        return;
+    }
+
+    target_ = target;
+    int32_t dst = destination(mark);
+    if (bothInt(*node.left, *node.right) && intOpCode(op) != op) {
+        emit({intOpCode(op), op, dst, left, right});
+    } else {
+        emit({op, OpCode::LT, dst, left, right});
+    }
+    result_ = dst;
+}
+
+void Compiler::visit(parser::UnaryOpExpr& node) {
+    int32_t mark = nextTemp_;
+    int32_t target = target_;
+
+    int32_t operand = compileExpr(*node.operand);
+
+    OpCode op;
+    if (node.op == TokenType::MINUS) {
+        op = node.operand->staticType == parser::StaticType::INT ? OpCode::NEG_INT : OpCode::NEG;
+    } else if (node.op == TokenType::NOT) {
+        op = OpCode::NOT;
+    } else {
+        emit({OpCode::FAIL, OpCode::LT, 0, message("Unknown unary operator"), 0});
+        result_ = operand;
+        return;
+    }
+
+    target_ = target;
+    int32_t dst = destination(mark);
+    emit({op, OpCode::LT, dst, operand, 0});
+    result_ = dst;
+}
+
+void Compiler::visit(parser::CallExpr& node) {
+    int32_t mark = nextTemp_;
+    int32_t target = target_;
+
+    if (node.function == "print") {
+        // Each argument is printed as soon as it is evaluated
+        for (auto& arg : node.arguments) {
+            int32_t value = compileExpr(*arg);
+            emit({OpCode::PRINT, OpCode::LT, 0, value, 0});
+            nextTemp_ = mark;
+        }
+        target_ = target;
+        int32_t dst = destination(mark);
+        emit({OpCode::PRINT_END, OpCode::LT, dst, 0, 0});
+        result_ = dst;
+    }
+    else if (node.function == "len" && node.arguments.size() == 1) {
+        int32_t value = compileExpr(*node.arguments[0]);
+        target_ = target;
+        int32_t dst = destination(mark);
+        emit({OpCode::LEN, OpCode::LT, dst, value, 0});
+        result_ = dst;
+    }
+    else {
+        std::string error = node.function == "len"
+            ? "len() expects 1 argument"
+            : "Unknown function: " + node.function;
+        emit({OpCode::FAIL, OpCode::LT, 0, message(error), 0});
+        result_ = constant(static_cast<int64_t>(0));  // Never reached
+    }
+}
+
+void Compiler::visit(parser::CommandSubstExpr& node) {
+    int32_t dst = destination(nextTemp_);
+    emit({OpCode::CAPTURE, OpCode::LT, dst, substitution(node), 0});
+    result_ = dst;
+}
+
+// =============================================================================
+// Statements
+// =============================================================================
+
+void Compiler::visit(parser::BlockStmt& node) {
+    // Locals keep their registers until the block ends
+    int32_t mark = nextTemp_;
+    scopes_.emplace_back();
+    for (auto& stmt : node.statements) {
+        stmt->accept(*this);
+    }
+    scopes_.pop_back();
+    nextTemp_ = mark;
+}
+
+void Compiler::visit(parser::VarDeclStmt& node) {
+    int32_t mark = nextTemp_;
+    // A local is computed into its register; it comes into scope after
+    // the initializer, which still sees any outer variable of that name
+    int32_t local = kNoTarget;
+    if (!scopes_.empty()) {
+        local = allocTemp();
+        mark = nextTemp_;
+    }
+
+    int32_t value;
+    bool temporary = false;  // The initializer's own result
+    if (node.initializer) {
+        value = compileExpr(*node.initializer, local);
+        temporary = value >= kTempBase + mark;
+    } else if (node.type == "string") {
+        value = constant(SharedString());
+    } else if (node.type == "bool") {
+        value = constant(false);
+    } else {
+        value = constant(static_cast<int64_t>(0));  // intN and default
+    }
+
+    if (local != kNoTarget) {
+        if (value != local) {
+            emit({OpCode::MOVE, OpCode::LT, local, value, 0});
+        }
+        scopes_.back()[node.name] = local;
+    } else {
+        emit({OpCode::DEFINE, OpCode::LT, variable(node.name), value, temporary});
+    }
+    nextTemp_ = mark;
+}
+
+void Compiler::visit(parser::AssignStmt& node) {
+    int32_t mark = nextTemp_;
+    // The value is computed straight into the variable
+    compileExpr(*node.value, resolve(node.variable));
+    nextTemp_ = mark;
+}
+
+void Compiler::visit(parser::IfStmt& node) {
+    size_t skipThen = emitBranch(*node.condition, false);
+    node.thenBranch->accept(*this);
+
+    if (node.elseBranch) {
+        size_t skipElse = emit({OpCode::JUMP, OpCode::LT, 0, 0, 0});
+        patchJump(skipThen);
+        node.elseBranch->accept(*this);
+        patchJump(skipElse);
+    } else {
+        patchJump(skipThen);
+    }
+}
+
+void Compiler::visit(parser::WhileStmt& node) {
+    // Condition at the bottom: one branch per iteration
+    size_t toCondition = emit({OpCode::JUMP, OpCode::LT, 0, 0, 0});
+    int32_t body = static_cast<int32_t>(chunk_.code.size());
+    node.body->accept(*this);
+    patchJump(toCondition);
+    size_t loop = emitBranch(*node.condition, true);
+    chunk_.code[loop].dst = body;
+}
+
+void Compiler::visit(parser::ForStmt& node) {
+    int32_t loop = chunk_.loopCount++;
+    int32_t mark = nextTemp_;
+
+    // A substitution is streamed: the body runs while it still writes
+    if (auto* subst = dynamic_cast<parser::CommandSubstExpr*>(node.iterable.get())) {
+        emit({OpCode::ITER_CAPTURE, OpCode::LT, loop, substitution(*subst), 0});
+    } else {
+        int32_t value = compileExpr(*node.iterable);
+        emit({OpCode::ITER_STRING, OpCode::LT, loop, value, value >= kTempBase + mark});
+    }
+    nextTemp_ = mark;
+
+    // The loop variable is local to the loop
+    int32_t variable = allocTemp();
+    scopes_.emplace_back();
+    scopes_.back()[node.variable] = variable;
+
+    // Next line fetched at the bottom, as while tests its condition
+    size_t toNext = emit({OpCode::JUMP, OpCode::LT, 0, 0, 0});
+    int32_t body = static_cast<int32_t>(chunk_.code.size());
+    node.body->accept(*this);
+    patchJump(toNext);
+    emit({OpCode::ITER_NEXT, OpCode::LT, body, variable, loop});
+    emit({OpCode::ITER_END, OpCode::LT, 0, loop, 0});
+
+    scopes_.pop_back();
+    nextTemp_ = mark;
+}
+
+void Compiler::visit(parser::ReturnStmt& node) {
+    if (node.value) {
+        int32_t mark = nextTemp_;
+        int32_t value = compileExpr(*node.value);
+        emit({OpCode::RESULT, OpCode::LT, 0, value, 0});
+        nextTemp_ = mark;
+    }
+    emit({OpCode::HALT, OpCode::LT, 0, 0, 0});
+}
+
+void Compiler::visit(parser::ExprStmt& node) {
+    int32_t mark = nextTemp_;
+    int32_t value = compileExpr(*node.expression);
+    emit({OpCode::RESULT, OpCode::LT, 0, value, 0});
+    nextTemp_ = mark;
+}
+
+void Compiler::visit(parser::CommandStmt& node) {
+    chunk_.commands.push_back(&node);
+    int32_t index = static_cast<int32_t>(chunk_.commands.size() - 1);
+    emit({OpCode::COMMAND, OpCode::LT, 0, index, 0});
+}
+
+void Compiler::visit(parser::PipelineStmt& node) {
+    chunk_.pipelines.push_back(&node);
+    int32_t index = static_cast<int32_t>(chunk_.pipelines.size() - 1);
+    emit({OpCode::PIPELINE, OpCode::LT, 0, index, 0});
+}
+
+void Compiler::visit(parser::ParallelStmt& node) {
+    chunk_.parallels.push_back(&node);
+    int32_t index = static_cast<int32_t>(chunk_.parallels.size() - 1);
+    int32_t mark = nextTemp_;
+    int32_t limit = node.limit ? compileExpr(*node.limit) : constant(static_cast<int64_t>(0));
+    emit({OpCode::PARALLEL, OpCode::LT, 0, index, limit});
+    nextTemp_ = mark;
+}
+
+void Compiler::visit(parser::Program& node) {
+    for (auto& stmt : node.statements) {
+        stmt->accept(*this);
+    }
+}
+
+} // namespace executor
+} // namespace ariash
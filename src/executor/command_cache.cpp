@@ -0,0 +1,292 @@
+/**
+ * Command Cache Implementation
+ */
+
+#include "executor/command_cache.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace ariash {
+namespace executor {
+
+// Fallback revalidation interval when directories cannot be watched
+static constexpr auto kMtimeCheckInterval = std::chrono::seconds(1);
+
+static bool isExecutable(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && (st.st_mode & S_IXUSR);
+}
+
+static int64_t directoryMtime(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return -1;
+    }
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+// =============================================================================
+// CommandCache Implementation
+// =============================================================================
+
+CommandCache::CommandCache() = default;
+
+CommandCache::~CommandCache() {
+    if (inotifyFd_ >= 0) {
+        ::close(inotifyFd_);
+    }
+}
+
+std::string CommandCache::resolve(const std::string& command) {
+    // If command contains a slash, it's a path - use as-is
+    if (command.find('/') != std::string::npos) {
+        return command;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Slot& slot = lookup(command);
+    return slot.path.empty() ? command : slot.path;
+}
+
+bool CommandCache::found(const std::string& command) {
+    if (command.find('/') != std::string::npos) {
+        return isExecutable(command);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !lookup(command).path.empty();
+}
+
+void CommandCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    table_.clear();
+    bumpVersions();
+}
+
+std::vector<CommandCache::Entry> CommandCache::entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Entry> result;
+    for (const auto& pair : table_) {
+        if (!pair.second.path.empty()) {
+            result.push_back({pair.first, pair.second.path, pair.second.hits});
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const Entry& a, const Entry& b) { return a.name < b.name; });
+    return result;
+}
+
+std::vector<CommandCache::DirectoryVersion> CommandCache::directories() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    syncPath();
+    drainWatches();
+    checkMtimes();
+
+    std::vector<DirectoryVersion> result;
+    result.reserve(directories_.size());
+    for (const auto& dir : directories_) {
+        result.push_back({dir.path, dir.version});
+    }
+    return result;
+}
+
+CommandCache::Stats CommandCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void CommandCache::setWatchesEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (enabled == watchesEnabled_) {
+        return;
+    }
+    watchesEnabled_ = enabled;
+
+    closeWatches();
+    if (inotifyFd_ >= 0) {
+        ::close(inotifyFd_);
+        inotifyFd_ = -1;
+    }
+    pathKnown_ = false;  // Next lookup re-splits PATH in the new mode
+}
+
+const CommandCache::Slot& CommandCache::lookup(const std::string& command) {
+    syncPath();
+    drainWatches();
+    checkMtimes();
+
+    auto it = table_.find(command);
+    if (it != table_.end()) {
+        // "Not found" is only trusted while every directory is watched:
+        // a watch event drops it the moment the file appears, an mtime
+        // check only up to a second later, when a script that has just
+        // installed the command would already have failed
+        if (!it->second.path.empty() || watchesComplete_) {
+            ++it->second.hits;
+            ++stats_.hits;
+            return it->second;
+        }
+    } else {
+        it = table_.emplace(command, Slot()).first;
+    }
+
+    // Miss: search PATH in order
+    ++stats_.misses;
+    Slot& slot = it->second;
+    ++slot.hits;
+    for (const auto& dir : directories_) {
+        std::string fullPath = dir.path + "/" + command;
+        if (isExecutable(fullPath)) {
+            slot.path = std::move(fullPath);
+            break;
+        }
+    }
+    return slot;
+}
+
+void CommandCache::syncPath() {
+    const char* pathEnv = std::getenv("PATH");
+    bool set = pathEnv != nullptr;
+    if (pathKnown_ && set == pathSet_ && (!set || pathValue_ == pathEnv)) {
+        return;
+    }
+
+    pathSet_ = set;
+    pathValue_ = set ? pathEnv : "";
+    rebuildDirectories();
+}
+
+void CommandCache::rebuildDirectories() {
+    closeWatches();
+    stats_.invalidations += table_.size();
+    table_.clear();
+    directories_.clear();
+    pathKnown_ = true;
+
+    // No PATH: commands are tried as given
+    if (pathSet_) {
+        size_t start = 0;
+        for (;;) {
+            size_t end = pathValue_.find(':', start);
+            Directory dir;
+            dir.path = pathValue_.substr(start, end == std::string::npos
+                                                    ? std::string::npos : end - start);
+            directories_.push_back(std::move(dir));
+            if (end == std::string::npos) break;
+            start = end + 1;
+        }
+    }
+
+#ifdef __linux__
+    if (watchesEnabled_ && inotifyFd_ < 0) {
+        inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    }
+#endif
+
+    watchesComplete_ = inotifyFd_ >= 0;
+    for (auto& dir : directories_) {
+#ifdef __linux__
+        if (inotifyFd_ >= 0) {
+            dir.watch = inotify_add_watch(inotifyFd_, dir.path.c_str(),
+                                          IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                          IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF |
+                                          IN_MOVE_SELF | IN_ONLYDIR);
+        }
+#endif
+        // Missing or unwatchable directories are caught by their mtime
+        if (dir.watch < 0) {
+            watchesComplete_ = false;
+        }
+        dir.mtimeNs = directoryMtime(dir.path);
+        dir.version = ++lastVersion_;
+    }
+    lastMtimeCheck_ = std::chrono::steady_clock::now();
+}
+
+void CommandCache::bumpVersions() {
+    for (auto& dir : directories_) {
+        dir.version = ++lastVersion_;
+    }
+}
+
+void CommandCache::closeWatches() {
+#ifdef __linux__
+    for (auto& dir : directories_) {
+        if (dir.watch >= 0) {
+            inotify_rm_watch(inotifyFd_, dir.watch);
+            dir.watch = -1;
+        }
+    }
+#endif
+}
+
+void CommandCache::drainWatches() {
+#ifdef __linux__
+    if (inotifyFd_ < 0) {
+        return;
+    }
+
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t n = ::read(inotifyFd_, buffer, sizeof(buffer));
+        if (n <= 0) {
+            return;  // EAGAIN: nothing changed
+        }
+
+        for (char* p = buffer; p < buffer + n; ) {
+            auto* event = reinterpret_cast<struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_Q_OVERFLOW)) {
+                // A PATH directory itself went away (or events were lost):
+                // start over on the next lookup
+                pathKnown_ = false;
+            } else if (event->len > 0) {
+                // Only this name can resolve differently now
+                stats_.invalidations += table_.erase(event->name);
+                for (auto& dir : directories_) {
+                    if (dir.watch == event->wd) {
+                        dir.version = ++lastVersion_;
+                    }
+                }
+            }
+        }
+    }
+#endif
+}
+
+void CommandCache::checkMtimes() {
+    if (!pathKnown_) {
+        syncPath();  // Forced by drainWatches()
+        return;
+    }
+    if (watchesComplete_) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastMtimeCheck_ < kMtimeCheckInterval) {
+        return;
+    }
+    lastMtimeCheck_ = now;
+
+    for (const auto& dir : directories_) {
+        if (directoryMtime(dir.path) != dir.mtimeNs) {
+            rebuildDirectories();
+            return;
+        }
+    }
+}
+
+CommandCache& getCommandCache() {
+    static CommandCache cache;
+    return cache;
+}
+
+} // namespace executor
+} // namespace ariash
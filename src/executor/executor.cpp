@@ -3,98 +3,89 @@
  */
 
 #include "executor/executor.hpp"
+#include "executor/command_cache.hpp"
+#include "executor/program_cache.hpp"
+#include "executor/optimizer.hpp"
+#include "executor/builtins.hpp"
+#include "job/task_pool.hpp"
+#include "job/profiler.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
 #include <iostream>
 #include <stdexcept>
 #include <sstream>
 #include <thread>
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <mutex>
+#include <cstring>
+#include <fcntl.h>
 #include <unistd.h>
-#include <sys/stat.h>
 
 namespace ariash {
 namespace executor {
 
 // =============================================================================
-// Path Resolution
+// Value Utilities
 // =============================================================================
 
-static std::string resolveExecutablePath(const std::string& command) {
-    // If command contains a slash, it's a path - use as-is
-    if (command.find('/') != std::string::npos) {
-        return command;
-    }
-    
-    // Search PATH
-    const char* pathEnv = std::getenv("PATH");
-    if (!pathEnv) {
-        return command;  // No PATH, try command as-is
+std::string_view valueText(const Value& val, ValueTextBuffer& buffer) {
+    char* first = buffer.data;
+    char* last = buffer.data + sizeof(buffer.data);
+    if (const auto* text = std::get_if<SharedString>(&val)) {
+        return text->view();
+    } else if (const auto* i = std::get_if<int64_t>(&val)) {
+        return std::string_view(first, static_cast<size_t>(std::to_chars(first, last, *i).ptr - first));
+    } else if (const auto* d = std::get_if<double>(&val)) {
+        // Same digits as std::to_string() ("%f")
+        auto result = std::to_chars(first, last, *d, std::chars_format::fixed, 6);
+        return std::string_view(first, static_cast<size_t>(result.ptr - first));
     }
-    
-    std::string path(pathEnv);
-    size_t start = 0;
-    size_t end;
-    
-    while ((end = path.find(':', start)) != std::string::npos) {
-        std::string dir = path.substr(start, end - start);
-        std::string fullPath = dir + "/" + command;
-        
-        // Check if file exists and is executable
-        struct stat st;
-        if (stat(fullPath.c_str(), &st) == 0 && (st.st_mode & S_IXUSR)) {
-            return fullPath;
-        }
-        
-        start = end + 1;
-    }
-    
-    // Check last directory
-    std::string dir = path.substr(start);
-    std::string fullPath = dir + "/" + command;
-    struct stat st;
-    if (stat(fullPath.c_str(), &st) == 0 && (st.st_mode & S_IXUSR)) {
-        return fullPath;
-    }
-    
-    // Not found in PATH, return original command
-    return command;
+    return std::get<bool>(val) ? "true" : "false";
 }
 
-// =============================================================================
-// Value Utilities
-// =============================================================================
-
 std::string valueToString(const Value& val) {
-    return std::visit([](auto&& arg) -> std::string {
-        using T = std::decay_t<decltype(arg)>;
-        if constexpr (std::is_same_v<T, int64_t>) {
-            return std::to_string(arg);
-        } else if constexpr (std::is_same_v<T, double>) {
-            return std::to_string(arg);
-        } else if constexpr (std::is_same_v<T, std::string>) {
-            return arg;
-        } else if constexpr (std::is_same_v<T, bool>) {
-            return arg ? "true" : "false";
-        }
-    }, val);
+    ValueTextBuffer buffer;
+    return std::string(valueText(val, buffer));
 }
 
 // =============================================================================
 // Environment
 // =============================================================================
 
-void Environment::define(const std::string& name, const Value& value) {
-    bindings_[name] = value;
+Value& Environment::define(const std::string& name, const Value& value) {
+    Value& slot = bindings_[name];
+    slot = value;
+    return slot;
+}
+
+Value& Environment::define(const std::string& name, Value&& value) {
+    Value& slot = bindings_[name];
+    slot = std::move(value);
+    return slot;
 }
 
 void Environment::assign(const std::string& name, const Value& value) {
-    if (!exists(name)) {
+    auto it = bindings_.find(name);
+    if (it == bindings_.end()) {
+        throw std::runtime_error("Undefined variable: " + name);
+    }
+    it->second = value;
+}
+
+void Environment::assign(const std::string& name, Value&& value) {
+    auto it = bindings_.find(name);
+    if (it == bindings_.end()) {
         throw std::runtime_error("Undefined variable: " + name);
     }
-    bindings_[name] = value;
+    it->second = std::move(value);
 }
 
-Value Environment::get(const std::string& name) const {
+const Value& Environment::get(const std::string& name) const {
     auto it = bindings_.find(name);
     if (it == bindings_.end()) {
         throw std::runtime_error("Undefined variable: " + name);
@@ -106,12 +97,60 @@ bool Environment::exists(const std::string& name) const {
     return bindings_.find(name) != bindings_.end();
 }
 
+Value* Environment::find(const std::string& name) {
+    auto it = bindings_.find(name);
+    return it == bindings_.end() ? nullptr : &it->second;
+}
+
+std::vector<std::string> Environment::names() const {
+    std::vector<std::string> result;
+    result.reserve(bindings_.size());
+    for (const auto& pair : bindings_) {
+        result.push_back(pair.first);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
 // =============================================================================
 // Executor
 // =============================================================================
 
 void Executor::execute(parser::Program& program) {
-    program.accept(*this);
+    Optimizer optimizer;
+    optimizer.optimize(program);
+    optimizer.reportWarnings();
+
+    // Statements are timed where the AST is still there to name them
+    if (job::Profiler::active()) {
+        program.accept(*this);
+        return;
+    }
+
+    Compiler compiler;
+    Chunk chunk = compiler.compile(program);
+    run(chunk);
+}
+
+void Executor::executeSource(const std::string& source) {
+    // Holds the entry even if it is evicted while running
+    std::shared_ptr<const CompiledProgram> compiled = getProgramCache().get(source);
+    run(compiled->chunk);
+}
+
+void Executor::setStatus(int status) {
+    lastStatus_ = status;
+    lastResult_ = static_cast<int64_t>(status);
+}
+
+Value* Executor::findLocal(const std::string& name) {
+    // Innermost declaration wins
+    for (auto it = locals_.rbegin(); it != locals_.rend(); ++it) {
+        if (it->first == name) {
+            return &it->second;
+        }
+    }
+    return nullptr;
 }
 
 Value Executor::evaluateExpr(parser::ExprNode& expr) {
@@ -119,7 +158,7 @@ Value Executor::evaluateExpr(parser::ExprNode& expr) {
     if (!exprResult_) {
         throw std::runtime_error("Expression did not produce a value");
     }
-    Value result = *exprResult_;
+    Value result = std::move(*exprResult_);
     exprResult_.reset();
     return result;
 }
@@ -133,7 +172,7 @@ bool Executor::isTruthy(const Value& val) {
             return arg != 0;
         } else if constexpr (std::is_same_v<T, double>) {
             return arg != 0.0;
-        } else if constexpr (std::is_same_v<T, std::string>) {
+        } else if constexpr (std::is_same_v<T, SharedString>) {
             return !arg.empty();
         }
     }, val);
@@ -148,11 +187,15 @@ void Executor::visit(parser::IntegerLiteral& node) {
 }
 
 void Executor::visit(parser::StringLiteral& node) {
-    exprResult_ = node.value;
+    exprResult_ = SharedString::intern(node.value);  // As the Compiler does
 }
 
 void Executor::visit(parser::VariableExpr& node) {
-    exprResult_ = env_.get(node.name);
+    if (Value* local = findLocal(node.name)) {
+        exprResult_ = *local;
+    } else {
+        exprResult_ = env_.get(node.name);
+    }
 }
 
 void Executor::visit(parser::BinaryOpExpr& node) {
@@ -161,6 +204,25 @@ void Executor::visit(parser::BinaryOpExpr& node) {
     
     using parser::TokenType;
     
+    // Both sides statically int64_t (Optimizer): no type dispatch
+    if (node.left->staticType == parser::StaticType::INT &&
+        node.right->staticType == parser::StaticType::INT) {
+        int64_t l = *std::get_if<int64_t>(&left);
+        int64_t r = *std::get_if<int64_t>(&right);
+        switch (node.op) {
+            case TokenType::PLUS:  exprResult_ = l + r; return;
+            case TokenType::MINUS: exprResult_ = l - r; return;
+            case TokenType::STAR:  exprResult_ = l * r; return;
+            case TokenType::LT:    exprResult_ = l < r; return;
+            case TokenType::LE:    exprResult_ = l <= r; return;
+            case TokenType::GT:    exprResult_ = l > r; return;
+            case TokenType::GE:    exprResult_ = l >= r; return;
+            case TokenType::EQ:    exprResult_ = l == r; return;
+            case TokenType::NE:    exprResult_ = l != r; return;
+            default: break;  // Division (zero check) and logical operators
+        }
+    }
+    
     // Arithmetic
     if (node.op == TokenType::PLUS || node.op == TokenType::MINUS ||
         node.op == TokenType::STAR || node.op == TokenType::SLASH) {
@@ -206,9 +268,10 @@ void Executor::visit(parser::UnaryOpExpr& node) {
 void Executor::visit(parser::CallExpr& node) {
     // Built-in functions
     if (node.function == "print") {
+        ValueTextBuffer buffer;
         for (auto& arg : node.arguments) {
             Value val = evaluateExpr(*arg);
-            std::cout << valueToString(val);
+            std::cout << valueText(val, buffer);
         }
         std::cout << std::endl;
         exprResult_ = static_cast<int64_t>(0);  // Return 0
@@ -218,8 +281,8 @@ void Executor::visit(parser::CallExpr& node) {
             throw std::runtime_error("len() expects 1 argument");
         }
         Value arg = evaluateExpr(*node.arguments[0]);
-        if (std::holds_alternative<std::string>(arg)) {
-            exprResult_ = static_cast<int64_t>(std::get<std::string>(arg).length());
+        if (const auto* text = std::get_if<SharedString>(&arg)) {
+            exprResult_ = static_cast<int64_t>(text->length());
         } else {
             throw std::runtime_error("len() expects string argument");
         }
@@ -229,6 +292,10 @@ void Executor::visit(parser::CallExpr& node) {
     }
 }
 
+void Executor::visit(parser::CommandSubstExpr& node) {
+    exprResult_ = captureOutput(*node.pipeline);
+}
+
 // =============================================================================
 // Binary Operations
 // =============================================================================
@@ -238,13 +305,17 @@ Value Executor::applyArithmetic(parser::TokenType op, const Value& left, const V
     if (std::holds_alternative<int64_t>(left) && std::holds_alternative<int64_t>(right)) {
         int64_t l = std::get<int64_t>(left);
         int64_t r = std::get<int64_t>(right);
+        uint64_t ul = static_cast<uint64_t>(l);
+        uint64_t ur = static_cast<uint64_t>(r);
         
+        // Two's complement wrap, as in the VM and the optimizer
         switch (op) {
-            case parser::TokenType::PLUS:  return l + r;
-            case parser::TokenType::MINUS: return l - r;
-            case parser::TokenType::STAR:  return l * r;
+            case parser::TokenType::PLUS:  return static_cast<int64_t>(ul + ur);
+            case parser::TokenType::MINUS: return static_cast<int64_t>(ul - ur);
+            case parser::TokenType::STAR:  return static_cast<int64_t>(ul * ur);
             case parser::TokenType::SLASH:
                 if (r == 0) throw std::runtime_error("Division by zero");
+                if (l == INT64_MIN && r == -1) throw std::runtime_error("Integer overflow in division");
                 return l / r;
             default: throw std::runtime_error("Unknown arithmetic operator");
         }
@@ -252,8 +323,16 @@ Value Executor::applyArithmetic(parser::TokenType op, const Value& left, const V
     
     // String concatenation
     if (op == parser::TokenType::PLUS) {
-        if (std::holds_alternative<std::string>(left) || std::holds_alternative<std::string>(right)) {
-            return valueToString(left) + valueToString(right);
+        if (std::holds_alternative<SharedString>(left) || std::holds_alternative<SharedString>(right)) {
+            // One allocation, of the final size
+            ValueTextBuffer leftBuffer, rightBuffer;
+            std::string_view l = valueText(left, leftBuffer);
+            std::string_view r = valueText(right, rightBuffer);
+            SharedString result;
+            result.reserve(l.size() + r.size());
+            result.append(l);
+            result.append(r);
+            return result;
         }
     }
     
@@ -278,9 +357,11 @@ Value Executor::applyComparison(parser::TokenType op, const Value& left, const V
     }
     
     // String comparison
-    if (std::holds_alternative<std::string>(left) && std::holds_alternative<std::string>(right)) {
-        std::string l = std::get<std::string>(left);
-        std::string r = std::get<std::string>(right);
+    const auto* ls = std::get_if<SharedString>(&left);
+    const auto* rs = std::get_if<SharedString>(&right);
+    if (ls && rs) {
+        const SharedString& l = *ls;
+        const SharedString& r = *rs;
         
         switch (op) {
             case parser::TokenType::EQ: return l == r;
@@ -311,14 +392,37 @@ Value Executor::applyLogical(parser::TokenType op, const Value& left, const Valu
 // Statement Visitors
 // =============================================================================
 
+// Declarations made while it is alive go out of scope with it
+struct Executor::LocalScope {
+    Executor& self;
+    size_t mark;
+    explicit LocalScope(Executor& executor)
+        : self(executor), mark(executor.locals_.size()) {
+        ++self.blockDepth_;
+    }
+    ~LocalScope() {
+        self.locals_.resize(mark);
+        --self.blockDepth_;
+    }
+};
+
 void Executor::visit(parser::BlockStmt& node) {
+    LocalScope scope(*this);
+
     for (auto& stmt : node.statements) {
         if (hasReturned_) break;
         stmt->accept(*this);
     }
 }
 
+// Profiler sample of one statement (job/profiler.hpp)
+static job::ProfileScope profileStatement(parser::ASTNode& node, const char* kind,
+                                          std::string_view detail = {}) {
+    return job::ProfileScope(&node, kind, detail, node.location.line, node.location.column);
+}
+
 void Executor::visit(parser::VarDeclStmt& node) {
+    auto profile = profileStatement(node, "declare", node.name);
     Value initialValue;
     
     if (node.initializer) {
@@ -328,7 +432,7 @@ void Executor::visit(parser::VarDeclStmt& node) {
         if (node.type == "int8" || node.type == "int16" || node.type == "int32" || node.type == "int64") {
             initialValue = static_cast<int64_t>(0);
         } else if (node.type == "string") {
-            initialValue = std::string("");
+            initialValue = SharedString();
         } else if (node.type == "bool") {
             initialValue = false;
         } else {
@@ -336,15 +440,52 @@ void Executor::visit(parser::VarDeclStmt& node) {
         }
     }
     
-    env_.define(node.name, initialValue);
+    if (blockDepth_ > 0) {
+        locals_.emplace_back(node.name, std::move(initialValue));
+    } else {
+        env_.define(node.name, std::move(initialValue));
+    }
+}
+
+// `s = s + x` with s a string: x's text appended to s's own buffer, as
+// the VM does, instead of a copy of s per statement
+bool Executor::appendInPlace(parser::AssignStmt& node) {
+    auto* sum = dynamic_cast<parser::BinaryOpExpr*>(node.value.get());
+    if (!sum || sum->op != parser::TokenType::PLUS) {
+        return false;
+    }
+    auto* self = dynamic_cast<parser::VariableExpr*>(sum->left.get());
+    if (!self || self->name != node.variable) {
+        return false;
+    }
+    Value* target = findLocal(node.variable);
+    if (!target) {
+        target = env_.find(node.variable);
+    }
+    if (!target || !std::holds_alternative<SharedString>(*target)) {
+        return false;
+    }
+    Value right = evaluateExpr(*sum->right);  // Cannot rebind variables
+    ValueTextBuffer buffer;
+    std::get_if<SharedString>(target)->append(valueText(right, buffer));
+    return true;
 }
 
 void Executor::visit(parser::AssignStmt& node) {
+    auto profile = profileStatement(node, "assign", node.variable);
+    if (appendInPlace(node)) {
+        return;
+    }
     Value value = evaluateExpr(*node.value);
-    env_.assign(node.variable, value);
+    if (Value* local = findLocal(node.variable)) {
+        *local = std::move(value);
+    } else {
+        env_.assign(node.variable, std::move(value));
+    }
 }
 
 void Executor::visit(parser::IfStmt& node) {
+    auto profile = profileStatement(node, "if");
     Value condition = evaluateExpr(*node.condition);
     
     if (isTruthy(condition)) {
@@ -355,6 +496,7 @@ void Executor::visit(parser::IfStmt& node) {
 }
 
 void Executor::visit(parser::WhileStmt& node) {
+    auto profile = profileStatement(node, "while");
     while (true) {
         Value condition = evaluateExpr(*node.condition);
         if (!isTruthy(condition)) break;
@@ -366,12 +508,36 @@ void Executor::visit(parser::WhileStmt& node) {
 }
 
 void Executor::visit(parser::ForStmt& node) {
-    // For now, implement simple range iteration
-    // TODO: Implement iterable protocol
-    throw std::runtime_error("For loops not yet implemented");
+    auto profile = profileStatement(node, "for", node.variable);
+    // Lines are pulled one at a time; a substitution is still running
+    // while the body handles the first ones
+    LineSource lines = linesOf(*node.iterable);
+    
+    // The loop variable is local to the loop
+    LocalScope scope(*this);
+    locals_.emplace_back(node.variable, SharedString());
+    size_t slot = locals_.size() - 1;  // The body may grow locals_
+    
+    while (!hasReturned_) {
+        // The line is read straight into the variable's string
+        Value& variable = locals_[slot].second;
+        if (!std::holds_alternative<SharedString>(variable)) {
+            variable = SharedString();
+        }
+        if (!lines.next(*std::get_if<SharedString>(&variable))) {
+            break;
+        }
+        node.body->accept(*this);
+    }
+    
+    // On exit the capture is killed instead (~OutputCapture)
+    if (lines.capturing() && !hasReturned_) {
+        setStatus(lines.finish());
+    }
 }
 
 void Executor::visit(parser::ReturnStmt& node) {
+    auto profile = profileStatement(node, "return");
     if (node.value) {
         lastResult_ = evaluateExpr(*node.value);
     }
@@ -379,18 +545,34 @@ void Executor::visit(parser::ReturnStmt& node) {
 }
 
 void Executor::visit(parser::ExprStmt& node) {
+    auto profile = profileStatement(node, "expr");
     // Evaluate expression and store result for REPL display
     lastResult_ = evaluateExpr(*node.expression);
 }
 
 void Executor::visit(parser::CommandStmt& node) {
+    auto profile = profileStatement(node, "command", node.executable);
     executeCommand(node);
 }
 
 void Executor::visit(parser::PipelineStmt& node) {
+    // "a | b | c" is only built when profiling
+    std::string stages;
+    if (job::Profiler::active()) {
+        for (auto& cmd : node.commands) {
+            stages += (stages.empty() ? "" : " | ") + cmd->executable;
+        }
+    }
+    auto profile = profileStatement(node, node.commands.size() == 1 ? "command" : "pipeline", stages);
     executePipeline(node);
 }
 
+void Executor::visit(parser::ParallelStmt& node) {
+    auto profile = profileStatement(node, "parallel");
+    Value limit = node.limit ? evaluateExpr(*node.limit) : Value(static_cast<int64_t>(0));
+    executeParallel(node, limit);
+}
+
 void Executor::visit(parser::Program& node) {
     for (auto& stmt : node.statements) {
         if (hasReturned_) break;
@@ -402,22 +584,149 @@ void Executor::visit(parser::Program& node) {
 // Process Execution
 // =============================================================================
 
+// Upper bound on the post-exit EOF barrier: a detached grandchild that
+// inherited stdout must not be able to hang the prompt
+static constexpr uint32_t kStreamDrainTimeoutMs = 1000;
+
+/**
+ * Files opened for the redirections of a command (or of every stage of a
+ * pipeline). Children get them by dup2(), so nothing is copied through
+ * the shell; the shell's copies close when the statement is done.
+ */
+class RedirectFiles {
+public:
+    RedirectFiles() = default;
+    ~RedirectFiles() {
+        for (int fd : fds_) {
+            ::close(fd);
+        }
+    }
+    
+    RedirectFiles(const RedirectFiles&) = delete;
+    RedirectFiles& operator=(const RedirectFiles&) = delete;
+    
+    // Open the files of `redirects` onto `streams` (a later redirection
+    // of the same stream wins); reports and returns false on failure
+    bool open(const std::vector<parser::Redirection>& redirects,
+              std::vector<job::StreamRedirect>& streams) {
+        for (const auto& redir : redirects) {
+            int flags = O_CLOEXEC;
+            switch (redir.type) {
+                case parser::RedirectionType::INPUT:
+                    flags |= O_RDONLY;
+                    break;
+                case parser::RedirectionType::OUTPUT:
+                    flags |= O_WRONLY | O_CREAT | O_TRUNC;
+                    break;
+                case parser::RedirectionType::APPEND:
+                    flags |= O_WRONLY | O_CREAT | O_APPEND;
+                    break;
+            }
+            
+            int fd = ::open(redir.target.c_str(), flags, 0666);
+            if (fd < 0) {
+                std::cerr << "ariash: " << redir.target << ": " << std::strerror(errno) << std::endl;
+                return false;
+            }
+            fds_.push_back(fd);
+            
+            auto stream = static_cast<job::StreamIndex>(redir.targetFd());
+            auto it = std::find_if(streams.begin(), streams.end(),
+                                   [stream](const job::StreamRedirect& r) { return r.stream == stream; });
+            if (it != streams.end()) {
+                it->fd = fd;
+            } else {
+                streams.push_back({stream, fd});
+            }
+        }
+        return true;
+    }
+    
+    // `fd` now belongs to someone else (HexStreamProcess::attachStream)
+    void release(int fd) {
+        fds_.erase(std::remove(fds_.begin(), fds_.end(), fd), fds_.end());
+    }
+    
+private:
+    std::vector<int> fds_;
+};
+
+static int redirectedFd(const std::vector<job::StreamRedirect>& streams, job::StreamIndex stream) {
+    for (const auto& redirect : streams) {
+        if (redirect.stream == stream) return redirect.fd;
+    }
+    return -1;
+}
+
+static bool writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
 void Executor::executeCommand(parser::CommandStmt& cmd) {
     using namespace hexstream;
     using namespace job;
     
+    // Builtins run in-process; in the background the external program
+    // runs instead, so the shell does not block
+    if (!cmd.background) {
+        if (BuiltinFunction builtin = getBuiltins().find(cmd.executable)) {
+            setStatus(runBuiltin(builtin, cmd, -1, std::cout, false));
+            return;
+        }
+    }
+    
+    RedirectFiles files;
+    std::vector<StreamRedirect> redirects;
+    if (!files.open(cmd.redirections, redirects)) {
+        setStatus(1);
+        return;
+    }
+    
+    if (cmd.background) {
+        // A background command is a job, like a background pipeline: it
+        // outlives this call and gets an ID (and telemetry)
+        SpawnOptions options;
+        options.command = getCommandCache().resolve(cmd.executable);
+        options.args = cmd.arguments;
+        options.background = true;
+        options.redirects = redirects;
+        
+        JobManager& jobs = getJobManager();
+        uint32_t jobId = jobs.spawn(options);
+        JobControlBlock* job = jobId ? jobs.getJob(jobId) : nullptr;
+        if (!job) {
+            std::cerr << "Failed to spawn process: " << cmd.executable << std::endl;
+            setStatus(-1);
+            return;
+        }
+        job->streams->closeStdin();
+        std::cout << "[" << jobId << "] Started PID " << job->pgid << std::endl;
+        setStatus(0);
+        return;
+    }
+    
     ProcessConfig config;
     
-    // Resolve executable path from PATH
-    config.executable = resolveExecutablePath(cmd.executable);
+    // Resolve executable path from PATH (hashed)
+    config.executable = getCommandCache().resolve(cmd.executable);
     config.arguments = cmd.arguments;
     config.foregroundMode = false;  // Capture output via callbacks
     
-    // Setup redirections
-    setupRedirections(cmd.redirections, config);
-    
-    // Create process
+    // Create process; redirected streams go straight to their files
     HexStreamProcess process(config);
+    for (const auto& redirect : redirects) {
+        if (process.attachStream(redirect.stream, redirect.fd)) {
+            files.release(redirect.fd);
+        }
+    }
     
     // Register callback to display output in real-time
     process.onData([](StreamIndex stream, const void* data, size_t size) {
@@ -436,30 +745,25 @@ void Executor::executeCommand(parser::CommandStmt& cmd) {
     // Spawn the process
     if (!process.spawn()) {
         std::cerr << "Failed to spawn process: " << cmd.executable << std::endl;
-        lastResult_ = static_cast<int64_t>(-1);
+        setStatus(-1);
         return;
     }
     
-    if (cmd.background) {
-        // Background execution - don't wait
-        std::cout << "[Background] Started PID " << process.getPid() << std::endl;
-        lastResult_ = static_cast<int64_t>(0);
-    } else {
-        // Foreground execution - wait for completion
-        int exitCode = process.wait();
-        
-        // Give drainers a moment to finish reading
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        
-        // Flush buffers and invoke callbacks with remaining data
-        process.flushBuffers();
-        
-        // Store exit code as last result
-        lastResult_ = static_cast<int64_t>(exitCode);
-    }
+    // Foreground execution - wait for completion
+    int exitCode = process.wait();
+    
+    // Output streams to the terminal as it arrives; wait for every
+    // stream to hit EOF, then flush whatever a timeout left behind
+    process.waitForStreams(kStreamDrainTimeoutMs);
+    process.flushBuffers();
+    
+    // Store exit code as last result
+    setStatus(exitCode);
 }
 
 void Executor::executePipeline(parser::PipelineStmt& pipeline) {
+    using namespace job;
+    
     if (pipeline.commands.empty()) {
         return;
     }
@@ -470,78 +774,421 @@ void Executor::executePipeline(parser::PipelineStmt& pipeline) {
         return;
     }
     
-    // Multi-command pipeline - still disabled due to FD chaining issues
-    std::cerr << "[WARNING] Multi-command pipelines not yet supported\n";
-    std::cerr << "[DEBUG] Pipeline has " << pipeline.commands.size() << " commands\n";
-    return;
+    // Multi-command pipeline: one job, one process group, stages chained
+    // through kernel pipes (the shell only sees the last stage's stdout)
+    bool background = pipeline.commands.back()->background;
     
-    /* DISABLED - Multi-command pipeline
-    if (pipeline.commands.empty()) {
+    if (!background) {
+        for (auto& cmd : pipeline.commands) {
+            if (getBuiltins().find(cmd->executable)) {
+                executeStages(pipeline);
+                return;
+            }
+        }
+    }
+    
+    RedirectFiles files;
+    std::vector<SpawnOptions> stages;
+    stages.reserve(pipeline.commands.size());
+    for (auto& cmd : pipeline.commands) {
+        SpawnOptions options;
+        options.command = getCommandCache().resolve(cmd->executable);
+        options.args = cmd->arguments;
+        options.background = background;
+        if (!files.open(cmd->redirections, options.redirects)) {
+            setStatus(1);
+            return;
+        }
+        stages.push_back(std::move(options));
+    }
+    
+    JobManager& jobs = getJobManager();
+    uint32_t jobId = jobs.spawnPipeline(stages);
+    JobControlBlock* job = jobId ? jobs.getJob(jobId) : nullptr;
+    if (!job) {
+        std::cerr << "Failed to spawn pipeline: " << pipeline.commands[0]->executable
+                  << " | ..." << std::endl;
+        setStatus(-1);
         return;
     }
     
-    // Single command - execute directly
-    if (pipeline.commands.size() == 1) {
-        executeCommand(*pipeline.commands[0]);
+    // The shell has nothing to feed the first stage
+    job->streams->closeStdin();
+    
+    if (background) {
+        std::cout << "[" << jobId << "] Started PID " << job->pgid << std::endl;
+        setStatus(0);
         return;
     }
     
-    // Multi-command pipeline
-    std::vector<std::unique_ptr<hexstream::HexStreamProcess>> processes;
-    */
+    job->streams->onData([](StreamIndex stream, const void* data, size_t size) {
+        if (stream == StreamIndex::STDOUT) {
+            std::cout.write(static_cast<const char*>(data), size);
+            std::cout.flush();
+        } else if (stream == StreamIndex::STDERR) {
+            std::cerr.write(static_cast<const char*>(data), size);
+            std::cerr.flush();
+        }
+    });
+    
+    // Drainers stream output through the callback while we wait
+    // (anything buffered before it was registered goes out with the
+    // next delivery)
+    jobs.wait(jobId);
+    job->streams->waitForDrain(kStreamDrainTimeoutMs);
+    job->streams->flushBuffers();
+    
+    setStatus(job->exitCode);
+    jobs.removeJob(jobId);
+}
+
+void Executor::executeParallel(parser::ParallelStmt& parallel, const Value& limit) {
+    using namespace job;
+    
+    const int64_t* count = std::get_if<int64_t>(&limit);
+    if (!count || *count < 0) {
+        throw std::runtime_error("parallel limit must be a non-negative integer");
+    }
+    
+    // Every task is spawned, builtins included: in-process builtins would
+    // serialise the fan-out on the shell's own thread
+    TaskPool pool(static_cast<size_t>(*count));
+    RedirectFiles files;  // Open until every task has been spawned
+    for (auto& task : parallel.tasks) {
+        std::vector<SpawnOptions> stages;
+        stages.reserve(task->commands.size());
+        for (auto& cmd : task->commands) {
+            SpawnOptions options;
+            options.command = getCommandCache().resolve(cmd->executable);
+            options.args = cmd->arguments;
+            if (!files.open(cmd->redirections, options.redirects)) {
+                setStatus(1);
+                return;
+            }
+            stages.push_back(std::move(options));
+        }
+        pool.add(std::move(stages));
+    }
     
-    /* DISABLED - REST OF FUNCTION
-    for (size_t i = 0; i < pipeline.commands.size(); i++) {
-        auto& cmd = pipeline.commands[i];
-        
-        hexstream::ProcessConfig config;
-        config.executable = cmd->executable;
-        config.arguments = cmd->arguments;  // Direct assignment
-        
-        // TODO: Connect stdout of process i to stdin of process i+1
-        // This requires pipe file descriptor management
+    // Output is grouped per task (never interleaved), in completion order
+    pool.onComplete([](size_t, const TaskResult& result) {
+        std::cout << result.output;
+        std::cout.flush();
+        std::cerr << result.errors;
+        std::cerr.flush();
+    });
+    
+    size_t failed = pool.run();
+    setStatus(static_cast<int>(std::min<size_t>(failed, 255)));
+}
+
+int Executor::runBuiltin(BuiltinFunction builtin, parser::CommandStmt& cmd,
+                         int pipeFd, std::ostream& out, bool inPipeline) {
+    using job::StreamIndex;
+    
+    // In-process, so redirected output is written here; a `<` file is
+    // opened (and so checked) but never read for the builtin
+    RedirectFiles files;
+    std::vector<job::StreamRedirect> redirects;
+    if (!files.open(cmd.redirections, redirects)) {
+        return 1;
+    }
+    int inFd = redirectedFd(redirects, StreamIndex::STDIN);
+    int outFd = redirectedFd(redirects, StreamIndex::STDOUT);
+    int errFd = redirectedFd(redirects, StreamIndex::STDERR);
+    
+    std::ostringstream fileOut, fileErr;
+    
+    BuiltinContext ctx{cmd.arguments,
+                       outFd >= 0 ? static_cast<std::ostream&>(fileOut) : out,
+                       errFd >= 0 ? static_cast<std::ostream&>(fileErr) : std::cerr,
+                       lastStatus_, inPipeline};
+    ctx.inFd = inFd >= 0 ? inFd : pipeFd;
+    int status = builtin(ctx);
+    if ((outFd >= 0 && !writeAll(outFd, fileOut.str())) ||
+        (errFd >= 0 && !writeAll(errFd, fileErr.str()))) {
+        std::cerr << "ariash: write error: " << std::strerror(errno) << std::endl;
+        status = 1;
+    }
+    if (ctx.exitRequested) {
+        exitRequested_ = true;
+        hasReturned_ = true;  // Stops the VM and the tree-walker alike
+    }
+    return status;
+}
+
+// A builtin stage's stdout: the pipe to the next stage
+class PipeOutput : public std::streambuf {
+public:
+    explicit PipeOutput(int fd) : fd_(fd) { setp(buffer_, buffer_ + sizeof(buffer_)); }
+    ~PipeOutput() override { sync(); }
+    
+protected:
+    int overflow(int c) override {
+        if (sync() < 0) return traits_type::eof();
+        if (c != traits_type::eof()) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    
+    int sync() override {
+        // EPIPE once the reader is gone; the rest is dropped
+        bool written = writeAll(fd_, std::string_view(pbase(), static_cast<size_t>(pptr() - pbase())));
+        setp(buffer_, buffer_ + sizeof(buffer_));
+        return written ? 0 : -1;
+    }
+    
+private:
+    int fd_;
+    char buffer_[4096];
+};
+
+void Executor::executeStages(parser::PipelineStmt& pipeline, std::string* capture) {
+    using namespace job;
+    
+    // All stages run at once, chained through kernel pipes: each run of
+    // external stages is one job, each builtin reads and writes its pipe
+    // ends in-process (on a thread of its own unless it is the last
+    // stage). The last stage's output goes to the terminal (or to
+    // `capture`); nothing in between is collected.
+    const auto& commands = pipeline.commands;
+    const size_t count = commands.size();
+    auto isBuiltin = [&commands](size_t i) {
+        return getBuiltins().find(commands[i]->executable) != nullptr;
+    };
+    
+    // links[i] carries stage i's stdout to stage i + 1 where either side
+    // is a builtin (spawnPipeline() chains adjacent external stages)
+    std::vector<std::array<int, 2>> links(count - 1, {-1, -1});
+    auto closeEnd = [](int& fd) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    };
+    auto closeLinks = [&links, &closeEnd]() {
+        for (auto& link : links) {
+            closeEnd(link[0]);
+            closeEnd(link[1]);
+        }
+    };
+    for (size_t i = 0; i + 1 < count; ++i) {
+        if ((isBuiltin(i) || isBuiltin(i + 1)) && pipe2(links[i].data(), O_CLOEXEC) < 0) {
+            std::cerr << "ariash: pipe: " << std::strerror(errno) << std::endl;
+            closeLinks();
+            setStatus(1);
+            return;
+        }
+    }
+    
+    std::vector<int> statuses(count, 0);
+    std::mutex outputMutex;
+    std::string output;
+    auto onOutput = [&](bool last) {
+        return [&, last](StreamIndex stream, const void* bytes, size_t size) {
+            if (stream == StreamIndex::STDOUT && last && capture) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                output.append(static_cast<const char*>(bytes), size);
+            } else if (stream == StreamIndex::STDOUT) {
+                std::cout.write(static_cast<const char*>(bytes), size);
+                std::cout.flush();
+            } else if (stream == StreamIndex::STDERR) {
+                std::cerr.write(static_cast<const char*>(bytes), size);
+                std::cerr.flush();
+            }
+        };
+    };
+    
+    // Spawn every external run first, so builtins never wait on a stage
+    // that has not started
+    JobManager& jobs = getJobManager();
+    std::vector<std::pair<uint32_t, size_t>> runs;  // Job, index of its last stage
+    bool spawned = true;
+    for (size_t i = 0; i < count && spawned;) {
+        if (isBuiltin(i)) {
+            ++i;
+            continue;
+        }
+        size_t end = i;
+        RedirectFiles files;
+        std::vector<SpawnOptions> stages;
+        for (; end < count && !isBuiltin(end); ++end) {
+            SpawnOptions options;
+            options.command = getCommandCache().resolve(commands[end]->executable);
+            options.args = commands[end]->arguments;
+            // The link pipes first: an explicit redirection beats them
+            if (end == i && i > 0) {
+                options.redirects.push_back({StreamIndex::STDIN, links[i - 1][0]});
+            }
+            if (end + 1 < count && isBuiltin(end + 1)) {
+                options.redirects.push_back({StreamIndex::STDOUT, links[end][1]});
+            }
+            if (!files.open(commands[end]->redirections, options.redirects)) {
+                statuses[end] = 1;
+                spawned = false;
+                break;
+            }
+            stages.push_back(std::move(options));
+        }
+        if (!spawned) break;
         
-        setupRedirections(cmd->redirections, config);
+        uint32_t jobId = jobs.spawnPipeline(stages);
+        JobControlBlock* job = jobId ? jobs.getJob(jobId) : nullptr;
+        if (!job) {
+            std::cerr << "Failed to spawn pipeline: " << commands[i]->executable
+                      << " | ..." << std::endl;
+            statuses[end - 1] = -1;
+            spawned = false;
+            break;
+        }
+        job->streams->closeStdin();  // The shell feeds no stage
+        job->streams->onData(onOutput(end == count));
+        runs.emplace_back(jobId, end - 1);
         
-        processes.push_back(std::make_unique<hexstream::HexStreamProcess>(config));
+        // Only the stages hold their ends now
+        if (i > 0) closeEnd(links[i - 1][0]);
+        if (end < count) closeEnd(links[end - 1][1]);
+        i = end;
+    }
+    
+    // Builtins: each stage owns its ends and closes them when done, so
+    // the next stage sees EOF and the previous one EPIPE
+    std::vector<std::thread> builtinStages;
+    std::ostringstream captured;
+    auto runStage = [&](size_t i) {
+        BuiltinFunction builtin = getBuiltins().find(commands[i]->executable);
+        int inFd = i > 0 ? links[i - 1][0] : -1;
+        if (i + 1 == count) {
+            statuses[i] = runBuiltin(builtin, *commands[i], inFd,
+                                     capture ? static_cast<std::ostream&>(captured) : std::cout, true);
+        } else {
+            // A reader that went away must surface as EPIPE, not SIGPIPE
+            sigset_t pipeMask;
+            sigemptyset(&pipeMask);
+            sigaddset(&pipeMask, SIGPIPE);
+            pthread_sigmask(SIG_BLOCK, &pipeMask, nullptr);
+            
+            PipeOutput pipeOut(links[i][1]);
+            std::ostream out(&pipeOut);
+            statuses[i] = runBuiltin(builtin, *commands[i], inFd, out, true);
+            out.flush();
+        }
+        if (i > 0) closeEnd(links[i - 1][0]);
+        if (i + 1 < count) closeEnd(links[i][1]);
+    };
+    if (spawned) {
+        for (size_t i = 0; i + 1 < count; ++i) {
+            if (isBuiltin(i)) {
+                builtinStages.emplace_back(runStage, i);
+            }
+        }
+        if (isBuiltin(count - 1)) {
+            runStage(count - 1);
+        }
+    }
+    for (auto& stage : builtinStages) {
+        stage.join();
     }
+    closeLinks();  // Ends of stages that never ran
     
-    // Wait for all processes
-    // TODO: Fix process hanging - temporarily disabled
-    std::cerr << "[WARNING] Command execution disabled - would hang\n";
-    std::cerr << "[DEBUG] Pipeline had " << processes.size() << " processes\n";
+    for (const auto& [jobId, last] : runs) {
+        JobControlBlock* job = jobs.getJob(jobId);
+        jobs.wait(jobId);
+        job->streams->waitForDrain(kStreamDrainTimeoutMs);
+        job->streams->flushBuffers();
+        statuses[last] = job->exitCode;
+        jobs.removeJob(jobId);
+    }
     
-    // for (auto& proc : processes) {
-    //     proc->wait();
-    // }
+    // Pipefail: the rightmost failing stage decides
+    int status = 0;
+    for (int stageStatus : statuses) {
+        if (stageStatus != 0) {
+            status = stageStatus;
+        }
+    }
     
-    // Return exit code of last process
-    // if (!processes.empty()) {
-    //     int exitCode = processes.back()->wait();
-    //     lastResult_ = static_cast<int64_t>(exitCode);
-    // }
-    END OF DISABLED CODE */
+    if (capture) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        *capture = isBuiltin(count - 1) ? std::move(captured).str() : std::move(output);
+    }
+    setStatus(status);
 }
 
-void Executor::setupRedirections(const std::vector<parser::Redirection>& redirects,
-                                 hexstream::ProcessConfig& config) {
-    for (const auto& redir : redirects) {
-        // TODO: Implement file descriptor redirection
-        // This requires opening files and setting up ProcessConfig streams
-        
-        switch (redir.type) {
-            case parser::RedirectionType::INPUT:
-                // config.stdinFile = redir.target;
-                break;
-            case parser::RedirectionType::OUTPUT:
-                // config.stdoutFile = redir.target;
-                break;
-            case parser::RedirectionType::APPEND:
-                // config.stdoutFile = redir.target;
-                // config.stdoutAppend = true;
-                break;
+// =============================================================================
+// Command Substitution
+// =============================================================================
+
+static bool hasBuiltinStage(const parser::PipelineStmt& pipeline) {
+    return std::any_of(pipeline.commands.begin(), pipeline.commands.end(),
+                       [](const auto& cmd) { return getBuiltins().find(cmd->executable) != nullptr; });
+}
+
+std::unique_ptr<OutputCapture> Executor::startCapture(parser::PipelineStmt& pipeline) {
+    using namespace job;
+    
+    // Always in the foreground: the value is needed before going on
+    RedirectFiles files;  // Open until the job has been spawned
+    std::vector<SpawnOptions> stages;
+    stages.reserve(pipeline.commands.size());
+    for (auto& cmd : pipeline.commands) {
+        SpawnOptions options;
+        options.command = getCommandCache().resolve(cmd->executable);
+        options.args = cmd->arguments;
+        if (!files.open(cmd->redirections, options.redirects)) {
+            setStatus(1);
+            return nullptr;
         }
+        stages.push_back(std::move(options));
+    }
+    
+    auto capture = std::make_unique<OutputCapture>();
+    if (!capture->start(std::move(stages))) {
+        std::cerr << "Failed to spawn pipeline: " << pipeline.commands[0]->executable
+                  << (pipeline.commands.size() > 1 ? " | ..." : "") << std::endl;
+        setStatus(-1);
+        return nullptr;
+    }
+    return capture;
+}
+
+SharedString Executor::captureOutput(parser::PipelineStmt& pipeline) {
+    SharedString output;
+    
+    // Builtins write in-process, so such pipelines collect their output
+    // the way executeStages() passes it between segments
+    if (hasBuiltinStage(pipeline)) {
+        std::string stages;
+        executeStages(pipeline, &stages);
+        output.assign(stages);
+    } else if (auto capture = startCapture(pipeline)) {
+        capture->readAll(output);
+        setStatus(capture->finish());
+    }
+    
+    trimTrailingNewlines(output);
+    return output;
+}
+
+LineSource Executor::linesOf(parser::CommandSubstExpr& subst) {
+    parser::PipelineStmt& pipeline = *subst.pipeline;
+    if (hasBuiltinStage(pipeline)) {
+        return LineSource(captureOutput(pipeline));
+    }
+    return LineSource(startCapture(pipeline));  // No lines if it failed to start
+}
+
+LineSource Executor::linesOf(parser::ExprNode& iterable) {
+    if (auto* subst = dynamic_cast<parser::CommandSubstExpr*>(&iterable)) {
+        return linesOf(*subst);
+    }
+    Value value = evaluateExpr(iterable);
+    if (auto* text = std::get_if<SharedString>(&value)) {
+        return LineSource(std::move(*text));
     }
+    throw std::runtime_error("for loop expects a string or $(...) to iterate over");
 }
 
 } // namespace executor
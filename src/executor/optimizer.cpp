@@ -0,0 +1,559 @@
+/**
+ * Optimizer Implementation
+ */
+
+#include "executor/optimizer.hpp"
+#include <climits>
+#include <cstdint>
+#include <iostream>
+
+namespace ariash {
+namespace executor {
+
+using parser::NodePtr;
+using parser::StaticType;
+using parser::TokenType;
+
+static StaticType declaredType(const std::string& type) {
+    if (type == "int8" || type == "int16" || type == "int32" || type == "int64" ||
+        type == "tbb8" || type == "tbb16" || type == "tbb32" || type == "tbb64") {
+        return StaticType::INT;
+    }
+    if (type == "string") return StaticType::STRING;
+    if (type == "bool") return StaticType::BOOL;
+    return StaticType::UNKNOWN;  // buffer, gc, wild
+}
+
+static const char* typeLabel(StaticType type) {
+    switch (type) {
+        case StaticType::INT:    return "int";
+        case StaticType::STRING: return "string";
+        case StaticType::BOOL:   return "bool";
+        default:                 return "unknown";
+    }
+}
+
+// Range of a declared integer type; tbbN keeps its minimum as the error value
+static bool integerRange(const std::string& type, int64_t& min, int64_t& max) {
+    int bits;
+    if (type == "int8" || type == "tbb8") bits = 8;
+    else if (type == "int16" || type == "tbb16") bits = 16;
+    else if (type == "int32" || type == "tbb32") bits = 32;
+    else return false;  // 64-bit types hold any literal
+
+    max = (int64_t(1) << (bits - 1)) - 1;
+    min = type[0] == 't' ? -max : -max - 1;
+    return true;
+}
+
+static bool isArithmetic(TokenType op) {
+    return op == TokenType::PLUS || op == TokenType::MINUS ||
+           op == TokenType::STAR || op == TokenType::SLASH;
+}
+
+static bool isComparison(TokenType op) {
+    return op == TokenType::LT || op == TokenType::LE || op == TokenType::GT ||
+           op == TokenType::GE || op == TokenType::EQ || op == TokenType::NE;
+}
+
+template <typename T>
+static bool compare(TokenType op, const T& l, const T& r) {
+    switch (op) {
+        case TokenType::LT: return l < r;
+        case TokenType::LE: return l <= r;
+        case TokenType::GT: return l > r;
+        case TokenType::GE: return l >= r;
+        case TokenType::EQ: return l == r;
+        default:            return l != r;
+    }
+}
+
+// Integer arithmetic as the runtime does it (two's complement wrap);
+// false for what must stay a run-time error
+static bool foldIntegers(TokenType op, int64_t l, int64_t r, int64_t& out) {
+    uint64_t ul = static_cast<uint64_t>(l);
+    uint64_t ur = static_cast<uint64_t>(r);
+    switch (op) {
+        case TokenType::PLUS:  out = static_cast<int64_t>(ul + ur); return true;
+        case TokenType::MINUS: out = static_cast<int64_t>(ul - ur); return true;
+        case TokenType::STAR:  out = static_cast<int64_t>(ul * ur); return true;
+        case TokenType::SLASH:
+            if (r == 0 || (l == INT64_MIN && r == -1)) {
+                return false;
+            }
+            out = l / r;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Truth value of a condition made of literals only
+ */
+static bool constantTruth(const parser::ExprNode& expr, bool& truth) {
+    if (auto* i = dynamic_cast<const parser::IntegerLiteral*>(&expr)) {
+        truth = i->value != 0;
+        return true;
+    }
+    if (auto* s = dynamic_cast<const parser::StringLiteral*>(&expr)) {
+        truth = !s->value.empty();
+        return true;
+    }
+    if (auto* unary = dynamic_cast<const parser::UnaryOpExpr*>(&expr)) {
+        bool operand;
+        if (unary->op == TokenType::NOT && constantTruth(*unary->operand, operand)) {
+            truth = !operand;
+            return true;
+        }
+        return false;
+    }
+    auto* binary = dynamic_cast<const parser::BinaryOpExpr*>(&expr);
+    if (!binary) {
+        return false;
+    }
+    if (binary->op == TokenType::AND || binary->op == TokenType::OR) {
+        bool l, r;
+        if (!constantTruth(*binary->left, l) || !constantTruth(*binary->right, r)) {
+            return false;
+        }
+        truth = binary->op == TokenType::AND ? l && r : l || r;
+        return true;
+    }
+    if (!isComparison(binary->op)) {
+        return false;
+    }
+    auto* li = dynamic_cast<const parser::IntegerLiteral*>(binary->left.get());
+    auto* ri = dynamic_cast<const parser::IntegerLiteral*>(binary->right.get());
+    if (li && ri) {
+        truth = compare(binary->op, li->value, ri->value);
+        return true;
+    }
+    auto* ls = dynamic_cast<const parser::StringLiteral*>(binary->left.get());
+    auto* rs = dynamic_cast<const parser::StringLiteral*>(binary->right.get());
+    if (ls && rs) {
+        truth = compare(binary->op, ls->value, rs->value);
+        return true;
+    }
+    return false;  // Mixed types throw at run time
+}
+
+static size_t countTyped(const parser::ExprNode& expr) {
+    if (dynamic_cast<const parser::IntegerLiteral*>(&expr) ||
+        dynamic_cast<const parser::StringLiteral*>(&expr)) {
+        return 0;
+    }
+    size_t count = expr.staticType != StaticType::UNKNOWN ? 1 : 0;
+    if (auto* binary = dynamic_cast<const parser::BinaryOpExpr*>(&expr)) {
+        count += countTyped(*binary->left) + countTyped(*binary->right);
+    } else if (auto* unary = dynamic_cast<const parser::UnaryOpExpr*>(&expr)) {
+        count += countTyped(*unary->operand);
+    } else if (auto* call = dynamic_cast<const parser::CallExpr*>(&expr)) {
+        for (const auto& arg : call->arguments) {
+            count += countTyped(*arg);
+        }
+    }
+    return count;
+}
+
+// =============================================================================
+// Optimizer
+// =============================================================================
+
+void Optimizer::optimize(parser::Program& program) {
+    stats_ = Stats();
+    warnings_.clear();
+    if (program.optimized) {
+        return;
+    }
+    program.optimized = true;
+    program_ = &program;
+
+    for (auto& stmt : program.statements) {
+        foldStmt(stmt);
+    }
+
+    variables_.clear();
+    scopes_.clear();
+    globals_.clear();
+    reads_.clear();
+    stores_.clear();
+    roots_.clear();
+    conditional_ = 0;
+    for (auto& stmt : program.statements) {
+        collectStmt(*stmt);
+    }
+
+    // Assume every variable has its declared type, then drop the ones a
+    // store disproves until nothing changes (types only ever get dropped,
+    // so this terminates)
+    for (auto& variable : variables_) {
+        variable.type = variable.declared;
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto& store : stores_) {
+            Variable* variable = store.variable;
+            if (variable->type == StaticType::UNKNOWN) {
+                continue;
+            }
+            StaticType type = store.value ? infer(*store.value) : variable->declared;
+            if (type != variable->type) {
+                variable->type = StaticType::UNKNOWN;
+                changed = true;
+            }
+        }
+    }
+
+    for (auto* root : roots_) {
+        infer(*root);
+        stats_.typedExpressions += countTyped(*root);
+    }
+    for (const auto& store : stores_) {
+        checkStore(store);
+    }
+    for (const auto& variable : variables_) {
+        if (variable.type != StaticType::UNKNOWN) {
+            ++stats_.typedVariables;
+        }
+    }
+    program_ = nullptr;
+}
+
+void Optimizer::reportWarnings() const {
+    for (const auto& warning : warnings_) {
+        std::cerr << "Warning at " << warning << std::endl;
+    }
+}
+
+// =============================================================================
+// Folding
+// =============================================================================
+
+NodePtr<parser::StmtNode> Optimizer::emptyBlock(parser::SourceLocation location) {
+    return NodePtr<parser::StmtNode>(program_->arena.create<parser::BlockStmt>(location));
+}
+
+void Optimizer::foldStmt(NodePtr<parser::StmtNode>& stmt) {
+    parser::StmtNode* node = stmt.get();
+
+    if (auto* block = dynamic_cast<parser::BlockStmt*>(node)) {
+        for (auto& inner : block->statements) {
+            foldStmt(inner);
+        }
+    }
+    else if (auto* decl = dynamic_cast<parser::VarDeclStmt*>(node)) {
+        if (decl->initializer) {
+            foldExpr(decl->initializer);
+        }
+    }
+    else if (auto* assign = dynamic_cast<parser::AssignStmt*>(node)) {
+        foldExpr(assign->value);
+    }
+    else if (auto* ifStmt = dynamic_cast<parser::IfStmt*>(node)) {
+        foldExpr(ifStmt->condition);
+        foldStmt(ifStmt->thenBranch);
+        if (ifStmt->elseBranch) {
+            foldStmt(ifStmt->elseBranch);
+        }
+        bool truth;
+        if (constantTruth(*ifStmt->condition, truth)) {
+            ++stats_.branchesRemoved;
+            NodePtr<parser::StmtNode> taken = truth ? std::move(ifStmt->thenBranch)
+                                                    : std::move(ifStmt->elseBranch);
+            stmt = taken ? std::move(taken) : emptyBlock(ifStmt->location);
+        }
+    }
+    else if (auto* loop = dynamic_cast<parser::WhileStmt*>(node)) {
+        foldExpr(loop->condition);
+        foldStmt(loop->body);
+        bool truth;
+        if (constantTruth(*loop->condition, truth) && !truth) {
+            ++stats_.branchesRemoved;
+            stmt = emptyBlock(loop->location);
+        }
+    }
+    else if (auto* forStmt = dynamic_cast<parser::ForStmt*>(node)) {
+        foldExpr(forStmt->iterable);
+        foldStmt(forStmt->body);
+    }
+    else if (auto* ret = dynamic_cast<parser::ReturnStmt*>(node)) {
+        if (ret->value) {
+            foldExpr(ret->value);
+        }
+    }
+    else if (auto* exprStmt = dynamic_cast<parser::ExprStmt*>(node)) {
+        foldExpr(exprStmt->expression);
+    }
+    else if (auto* parallel = dynamic_cast<parser::ParallelStmt*>(node)) {
+        if (parallel->limit) {
+            foldExpr(parallel->limit);
+        }
+    }
+    // Commands and pipelines hold no expressions
+}
+
+void Optimizer::foldExpr(NodePtr<parser::ExprNode>& expr) {
+    parser::ExprNode* node = expr.get();
+    parser::Arena& arena = program_->arena;
+
+    auto replaceInt = [&](int64_t value) {
+        ++stats_.folded;
+        expr = NodePtr<parser::ExprNode>(
+            arena.create<parser::IntegerLiteral>(value, node->location));
+    };
+    auto replaceString = [&](std::string value) {
+        ++stats_.folded;
+        expr = NodePtr<parser::ExprNode>(
+            arena.create<parser::StringLiteral>(value, node->location));
+    };
+
+    if (auto* binary = dynamic_cast<parser::BinaryOpExpr*>(node)) {
+        foldExpr(binary->left);
+        foldExpr(binary->right);
+        if (!isArithmetic(binary->op)) {
+            return;  // No bool literals to fold comparisons into
+        }
+
+        auto* li = dynamic_cast<parser::IntegerLiteral*>(binary->left.get());
+        auto* ri = dynamic_cast<parser::IntegerLiteral*>(binary->right.get());
+        auto* ls = dynamic_cast<parser::StringLiteral*>(binary->left.get());
+        auto* rs = dynamic_cast<parser::StringLiteral*>(binary->right.get());
+        int64_t value;
+        if (li && ri && foldIntegers(binary->op, li->value, ri->value, value)) {
+            replaceInt(value);
+        } else if (binary->op == TokenType::PLUS && (ls || rs) && (li || ls) && (ri || rs)) {
+            // valueToString() of an int64_t is std::to_string()
+            std::string l = ls ? ls->value : std::to_string(li->value);
+            std::string r = rs ? rs->value : std::to_string(ri->value);
+            replaceString(l + r);
+        }
+    }
+    else if (auto* unary = dynamic_cast<parser::UnaryOpExpr*>(node)) {
+        foldExpr(unary->operand);
+        auto* i = dynamic_cast<parser::IntegerLiteral*>(unary->operand.get());
+        if (unary->op == TokenType::MINUS && i) {
+            replaceInt(static_cast<int64_t>(0 - static_cast<uint64_t>(i->value)));
+        }
+    }
+    else if (auto* call = dynamic_cast<parser::CallExpr*>(node)) {
+        for (auto& arg : call->arguments) {
+            foldExpr(arg);
+        }
+        if (call->function == "len" && call->arguments.size() == 1) {
+            if (auto* s = dynamic_cast<parser::StringLiteral*>(call->arguments[0].get())) {
+                replaceInt(static_cast<int64_t>(s->value.length()));
+            }
+        }
+    }
+}
+
+// =============================================================================
+// Typing
+// =============================================================================
+
+Optimizer::Variable* Optimizer::lookup(const std::string& name) {
+    // Same resolution as the Compiler: innermost block first, then globals
+    // (only those declared earlier in this program; anything else may hold
+    // a value of any type)
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        auto it = scope->find(name);
+        if (it != scope->end()) {
+            return it->second;
+        }
+    }
+    auto it = globals_.find(name);
+    return it != globals_.end() ? it->second : nullptr;
+}
+
+void Optimizer::collectStmt(parser::StmtNode& stmt) {
+    if (auto* block = dynamic_cast<parser::BlockStmt*>(&stmt)) {
+        scopes_.emplace_back();
+        for (auto& inner : block->statements) {
+            collectStmt(*inner);
+        }
+        scopes_.pop_back();
+    }
+    else if (auto* decl = dynamic_cast<parser::VarDeclStmt*>(&stmt)) {
+        // The initializer still sees the outer binding
+        if (decl->initializer) {
+            collectExpr(*decl->initializer);
+        }
+
+        Variable* variable;
+        StaticType declared = declaredType(decl->type);
+        if (!scopes_.empty()) {
+            variables_.push_back({decl->name, decl->type, declared, declared});
+            variable = &variables_.back();
+            scopes_.back()[decl->name] = variable;
+        } else {
+            auto it = globals_.find(decl->name);
+            if (it == globals_.end()) {
+                variables_.push_back({decl->name, decl->type, declared, declared});
+                variable = &variables_.back();
+                globals_.emplace(decl->name, variable);
+            } else {
+                variable = it->second;
+                if (declaredType(variable->typeName) != declared) {
+                    variable->declared = StaticType::UNKNOWN;
+                }
+            }
+            // A global defined only on some paths may hold anything later
+            if (conditional_ > 0) {
+                variable->declared = StaticType::UNKNOWN;
+            }
+        }
+        stores_.push_back({variable, decl->initializer.get(), &decl->type, decl->location});
+    }
+    else if (auto* assign = dynamic_cast<parser::AssignStmt*>(&stmt)) {
+        collectExpr(*assign->value);
+        if (Variable* variable = lookup(assign->variable)) {
+            stores_.push_back({variable, assign->value.get(), &variable->typeName,
+                               assign->location});
+        }
+    }
+    else if (auto* ifStmt = dynamic_cast<parser::IfStmt*>(&stmt)) {
+        collectExpr(*ifStmt->condition);
+        ++conditional_;
+        collectStmt(*ifStmt->thenBranch);
+        if (ifStmt->elseBranch) {
+            collectStmt(*ifStmt->elseBranch);
+        }
+        --conditional_;
+    }
+    else if (auto* loop = dynamic_cast<parser::WhileStmt*>(&stmt)) {
+        collectExpr(*loop->condition);
+        ++conditional_;
+        collectStmt(*loop->body);
+        --conditional_;
+    }
+    else if (auto* forStmt = dynamic_cast<parser::ForStmt*>(&stmt)) {
+        collectExpr(*forStmt->iterable);
+        // The loop variable is local to the loop and holds one line
+        scopes_.emplace_back();
+        variables_.push_back({forStmt->variable, "string", StaticType::STRING, StaticType::STRING});
+        scopes_.back()[forStmt->variable] = &variables_.back();
+        ++conditional_;
+        collectStmt(*forStmt->body);
+        --conditional_;
+        scopes_.pop_back();
+    }
+    else if (auto* ret = dynamic_cast<parser::ReturnStmt*>(&stmt)) {
+        if (ret->value) {
+            collectExpr(*ret->value);
+        }
+    }
+    else if (auto* exprStmt = dynamic_cast<parser::ExprStmt*>(&stmt)) {
+        collectExpr(*exprStmt->expression);
+    }
+    else if (auto* parallel = dynamic_cast<parser::ParallelStmt*>(&stmt)) {
+        if (parallel->limit) {
+            collectExpr(*parallel->limit);
+        }
+    }
+}
+
+void Optimizer::collectExpr(parser::ExprNode& expr) {
+    // Walk the tree once to bind every variable read at its position
+    struct Reads {
+        Optimizer& self;
+        void walk(parser::ExprNode& node) {
+            if (auto* var = dynamic_cast<parser::VariableExpr*>(&node)) {
+                self.reads_[var] = self.lookup(var->name);
+            } else if (auto* binary = dynamic_cast<parser::BinaryOpExpr*>(&node)) {
+                walk(*binary->left);
+                walk(*binary->right);
+            } else if (auto* unary = dynamic_cast<parser::UnaryOpExpr*>(&node)) {
+                walk(*unary->operand);
+            } else if (auto* call = dynamic_cast<parser::CallExpr*>(&node)) {
+                for (auto& arg : call->arguments) {
+                    walk(*arg);
+                }
+            }
+        }
+    };
+    Reads{*this}.walk(expr);
+    roots_.push_back(&expr);
+}
+
+StaticType Optimizer::infer(parser::ExprNode& expr) {
+    StaticType type = StaticType::UNKNOWN;
+
+    if (dynamic_cast<parser::IntegerLiteral*>(&expr)) {
+        type = StaticType::INT;
+    }
+    else if (dynamic_cast<parser::StringLiteral*>(&expr)) {
+        type = StaticType::STRING;
+    }
+    else if (auto* var = dynamic_cast<parser::VariableExpr*>(&expr)) {
+        auto it = reads_.find(var);
+        if (it != reads_.end() && it->second) {
+            type = it->second->type;
+        }
+    }
+    else if (auto* binary = dynamic_cast<parser::BinaryOpExpr*>(&expr)) {
+        StaticType l = infer(*binary->left);
+        StaticType r = infer(*binary->right);
+        if (isArithmetic(binary->op)) {
+            if (l == StaticType::INT && r == StaticType::INT) {
+                type = StaticType::INT;
+            } else if (binary->op == TokenType::PLUS &&
+                       (l == StaticType::STRING || r == StaticType::STRING)) {
+                type = StaticType::STRING;
+            }
+        } else if (isComparison(binary->op) || binary->op == TokenType::AND ||
+                   binary->op == TokenType::OR) {
+            type = StaticType::BOOL;  // Or a run-time error
+        }
+    }
+    else if (auto* unary = dynamic_cast<parser::UnaryOpExpr*>(&expr)) {
+        StaticType operand = infer(*unary->operand);
+        if (unary->op == TokenType::MINUS && operand == StaticType::INT) {
+            type = StaticType::INT;
+        } else if (unary->op == TokenType::NOT) {
+            type = StaticType::BOOL;
+        }
+    }
+    else if (dynamic_cast<parser::CommandSubstExpr*>(&expr)) {
+        type = StaticType::STRING;
+    }
+    else if (auto* call = dynamic_cast<parser::CallExpr*>(&expr)) {
+        for (auto& arg : call->arguments) {
+            infer(*arg);
+        }
+        if (call->function == "print" ||
+            (call->function == "len" && call->arguments.size() == 1)) {
+            type = StaticType::INT;
+        }
+    }
+
+    expr.staticType = type;
+    return type;
+}
+
+void Optimizer::checkStore(const Store& store) {
+    if (!store.value) {
+        return;
+    }
+    StaticType declared = declaredType(*store.typeName);
+    StaticType actual = store.value->staticType;
+    std::string where = "line " + std::to_string(store.location.line) + ": ";
+
+    if (declared != StaticType::UNKNOWN && actual != StaticType::UNKNOWN && actual != declared) {
+        warnings_.push_back(where + "storing " + typeLabel(actual) + " in " +
+                            *store.typeName + " '" + store.variable->name + "'");
+        return;
+    }
+
+    int64_t min, max;
+    auto* literal = dynamic_cast<const parser::IntegerLiteral*>(store.value);
+    if (literal && integerRange(*store.typeName, min, max) &&
+        (literal->value < min || literal->value > max)) {
+        warnings_.push_back(where + std::to_string(literal->value) + " does not fit in " +
+                            *store.typeName + " '" + store.variable->name + "'");
+    }
+}
+
+} // namespace executor
+} // namespace ariash
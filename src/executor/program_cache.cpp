@@ -0,0 +1,105 @@
+/**
+ * Program Cache Implementation
+ */
+
+#include "executor/program_cache.hpp"
+#include "executor/optimizer.hpp"
+#include "parser/lexer.hpp"
+#include "parser/parser.hpp"
+
+namespace ariash {
+namespace executor {
+
+// =============================================================================
+// ProgramCache Implementation
+// =============================================================================
+
+ProgramCache::ProgramCache(size_t capacity) : capacity_(capacity) {}
+
+std::shared_ptr<const CompiledProgram> ProgramCache::get(const std::string& source) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(source);
+        if (it != index_.end()) {
+            ++stats_.hits;
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return *it->second;
+        }
+        ++stats_.misses;
+    }
+
+    // Build outside the lock: parse errors are printed as they are found
+    bool cacheable = false;
+    auto compiled = build(source, cacheable);
+    if (!cacheable) {
+        return compiled;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0 || index_.count(compiled->source)) {
+        return compiled;  // Disabled, or another thread got there first
+    }
+    lru_.push_front(compiled);
+    index_.emplace(compiled->source, lru_.begin());
+    evict();
+    return compiled;
+}
+
+std::shared_ptr<const CompiledProgram> ProgramCache::build(const std::string& source,
+                                                           bool& cacheable) {
+    auto compiled = std::make_shared<CompiledProgram>();
+    compiled->source = source;
+
+    // Tokens are pulled as the parser goes; they view compiled->source
+    parser::ShellLexer lexer(compiled->source);
+    parser::ShellParser parser(lexer);
+    compiled->program = parser.parseProgram();
+
+    Optimizer optimizer;
+    optimizer.optimize(*compiled->program);
+    optimizer.reportWarnings();
+
+    Compiler compiler;
+    compiled->chunk = compiler.compile(*compiled->program);
+
+    cacheable = parser.errorCount() == 0;
+    return compiled;
+}
+
+void ProgramCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    evict();
+}
+
+size_t ProgramCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+}
+
+void ProgramCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    lru_.clear();
+}
+
+ProgramCache::Stats ProgramCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void ProgramCache::evict() {
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back()->source);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+}
+
+ProgramCache& getProgramCache() {
+    static ProgramCache cache;
+    return cache;
+}
+
+} // namespace executor
+} // namespace ariash
@@ -0,0 +1,132 @@
+/**
+ * Script Runner Implementation
+ */
+
+#include "executor/script.hpp"
+#include "parser/lexer.hpp"
+#include "parser/parser.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <fstream>
+#include <sstream>
+#endif
+
+namespace ariash {
+namespace executor {
+
+// =============================================================================
+// SourceFile Implementation
+// =============================================================================
+
+SourceFile::~SourceFile() {
+#ifndef _WIN32
+    if (mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+bool SourceFile::open(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return false;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        ::close(fd);
+        errno = EISDIR;
+        return false;
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) {
+        ::close(fd);
+        data_ = "";
+        return true;  // mmap() refuses empty mappings
+    }
+
+    void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    int saved = errno;
+    ::close(fd);  // The mapping keeps the file referenced
+    if (map == MAP_FAILED) {
+        size_ = 0;
+        errno = saved;
+        return false;
+    }
+    madvise(map, size_, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const char*>(map);
+    mapped_ = true;
+    return true;
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        errno = ENOENT;
+        return false;
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    fallback_ = contents.str();
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+    return true;
+#endif
+}
+
+// =============================================================================
+// Script Execution
+// =============================================================================
+
+int runScript(std::string_view source, const std::string& name, Environment& env) {
+    // Skip "#!/usr/bin/env ariash" but keep its newline so lines still count
+    if (source.substr(0, 2) == "#!") {
+        size_t newline = source.find('\n');
+        source = newline == std::string_view::npos ? std::string_view() : source.substr(newline);
+    }
+
+    try {
+        parser::ShellLexer lexer(source);
+        parser::ShellParser parser(lexer);
+        auto program = parser.parseProgram();
+
+        // Errors were reported as they were found; run none of it
+        if (parser.errorCount() > 0) {
+            return 2;
+        }
+
+        Executor exec(env);
+        exec.execute(*program);
+        return exec.getLastStatus() & 0xFF;
+    } catch (const std::exception& e) {
+        std::cerr << "ariash: " << name << ": " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+int runScriptFile(const std::string& path, Environment& env) {
+    SourceFile file;
+    if (!file.open(path)) {
+        std::cerr << "ariash: " << path << ": " << std::strerror(errno) << std::endl;
+        return 127;
+    }
+    return runScript(file.text(), path, env);
+}
+
+} // namespace executor
+} // namespace ariash
@@ -0,0 +1,256 @@
+/**
+ * Shared Strings Implementation
+ */
+
+#include "executor/shared_string.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+namespace ariash {
+namespace executor {
+
+// Smallest buffer a growing string gets (with the header, 64 bytes)
+static constexpr size_t kMinCapacity = 64 - 24 - 1;
+
+SharedString::SharedString(std::string_view text) {
+    if (!text.empty()) {
+        rep_ = allocate(text.size());
+        std::memcpy(rep_->chars(), text.data(), text.size());
+        rep_->chars()[text.size()] = '\0';
+        rep_->size = text.size();
+    }
+}
+
+SharedString& SharedString::operator=(const SharedString& other) noexcept {
+    if (rep_ != other.rep_) {
+        other.retain();
+        release();
+        rep_ = other.rep_;
+    }
+    return *this;
+}
+
+SharedString& SharedString::operator=(SharedString&& other) noexcept {
+    if (this != &other) {
+        release();
+        rep_ = other.rep_;
+        other.rep_ = nullptr;
+    }
+    return *this;
+}
+
+SharedString::Rep* SharedString::allocate(size_t capacity) {
+    void* memory = std::malloc(sizeof(Rep) + capacity + 1);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    Rep* rep = new (memory) Rep;
+    rep->refs.store(1, std::memory_order_relaxed);
+    rep->interned = false;
+    rep->size = 0;
+    rep->capacity = capacity;
+    return rep;
+}
+
+namespace {
+
+// Keys view the interned buffers themselves
+struct InternTable {
+    std::mutex mutex;
+    std::unordered_map<std::string_view, void*> reps;
+};
+
+InternTable& internTable() {
+    static auto* table = new InternTable();  // Immortal: strings may outlive main()
+    return *table;
+}
+
+} // namespace
+
+void SharedString::release() {
+    if (!rep_) {
+        return;
+    }
+    // The last owner's reads of the text happen before the free
+    if (rep_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (rep_->interned) {
+            releaseInterned(rep_);
+        } else {
+            rep_->~Rep();
+            std::free(rep_);
+        }
+    }
+    rep_ = nullptr;
+}
+
+void SharedString::releaseInterned(Rep* rep) {
+    // Nothing can revive it (intern() never takes a count of 0), but
+    // intern() may already have put a fresh copy in its place
+    {
+        InternTable& table = internTable();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto found = table.reps.find(std::string_view(rep->chars(), rep->size));
+        if (found != table.reps.end() && found->second == rep) {
+            table.reps.erase(found);
+        }
+    }
+    rep->~Rep();
+    std::free(rep);
+}
+
+bool SharedString::unique() const {
+    return rep_ && !rep_->interned && rep_->refs.load(std::memory_order_acquire) == 1;
+}
+
+SharedString SharedString::intern(std::string_view text) {
+    if (text.empty()) {
+        return SharedString();
+    }
+
+    InternTable& table = internTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto found = table.reps.find(text);
+    SharedString result;
+    if (found != table.reps.end()) {
+        // Shared unless its last reference is on the way out
+        Rep* rep = static_cast<Rep*>(found->second);
+        uint32_t refs = rep->refs.load(std::memory_order_relaxed);
+        while (refs != 0) {
+            if (rep->refs.compare_exchange_weak(refs, refs + 1, std::memory_order_relaxed)) {
+                result.rep_ = rep;
+                return result;
+            }
+        }
+        table.reps.erase(found);
+    }
+    result = SharedString(text);
+    result.rep_->interned = true;
+    table.reps.emplace(result.view(), result.rep_);
+    return result;
+}
+
+size_t SharedString::internedCount() {
+    InternTable& table = internTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.reps.size();
+}
+
+void SharedString::reallocate(size_t capacity, size_t keep) {
+    if (unique()) {
+        // Ours alone: realloc() moves big buffers by remapping, so the
+        // old and new copies are never resident at once
+        Rep* rep = static_cast<Rep*>(std::realloc(rep_, sizeof(Rep) + capacity + 1));
+        if (!rep) {
+            throw std::bad_alloc();
+        }
+        rep->capacity = capacity;
+        rep->size = keep;
+        rep->chars()[keep] = '\0';
+        rep_ = rep;
+        return;
+    }
+    Rep* rep = allocate(capacity);
+    if (keep > 0) {
+        std::memcpy(rep->chars(), rep_->chars(), keep);
+    }
+    rep->chars()[keep] = '\0';
+    rep->size = keep;
+    release();
+    rep_ = rep;
+}
+
+void SharedString::makeUnique(size_t wanted) {
+    if (unique() && rep_->capacity >= wanted) {
+        return;
+    }
+    // Growing: at least half as much again, so appending is amortised O(1)
+    size_t current = capacity();
+    if (wanted > current) {
+        wanted = std::max({wanted, current + current / 2, kMinCapacity});
+    }
+    reallocate(wanted, size());
+}
+
+void SharedString::reserve(size_t wanted) {
+    if (wanted > capacity() || (rep_ && !unique())) {
+        makeUnique(std::max(wanted, size()));
+    }
+}
+
+void SharedString::append(std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    size_t size = this->size();
+    size_t wanted = size + text.size();
+    if (unique() && rep_->capacity >= wanted) {
+        // In place: `text` may be (part of) this buffer, which stays put
+        std::memmove(rep_->chars() + size, text.data(), text.size());
+    } else {
+        // The old buffer lives until the copy is made if `text` is in it
+        Rep* old = rep_;
+        if (old && (text.data() < old->chars() || text.data() > old->chars() + old->capacity)) {
+            old = nullptr;
+        }
+        if (old) {
+            old->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        makeUnique(wanted);
+        std::memcpy(rep_->chars() + size, text.data(), text.size());
+        SharedString hold;
+        hold.rep_ = old;  // Dropped on return
+    }
+    rep_->size = wanted;
+    rep_->chars()[wanted] = '\0';
+}
+
+void SharedString::assign(std::string_view text) {
+    if (text.empty()) {
+        clear();
+        return;
+    }
+    if (unique() && rep_->capacity >= text.size()) {
+        std::memmove(rep_->chars(), text.data(), text.size());
+        rep_->size = text.size();
+        rep_->chars()[text.size()] = '\0';
+        return;
+    }
+    *this = SharedString(text);  // Copied before the old buffer goes
+}
+
+void SharedString::resize(size_t size) {
+    size_t current = this->size();
+    if (size == current) {
+        return;
+    }
+    if (size == 0) {
+        clear();
+        return;
+    }
+    if (size < current && !unique()) {
+        reallocate(size, size);
+        return;
+    }
+    makeUnique(size);
+    if (size > current) {
+        std::memset(rep_->chars() + current, 0, size - current);
+    }
+    rep_->size = size;
+    rep_->chars()[size] = '\0';
+}
+
+void SharedString::clear() {
+    if (unique()) {
+        rep_->size = 0;
+        rep_->chars()[0] = '\0';
+    } else {
+        release();
+    }
+}
+
+} // namespace executor
+} // namespace ariash
@@ -0,0 +1,167 @@
+/**
+ * Command Substitution Implementation
+ */
+
+#include "executor/substitution.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+
+namespace ariash {
+namespace executor {
+
+using job::StreamIndex;
+
+// Upper bound on the post-exit EOF barrier of the other streams (stdout
+// itself has been read to EOF by then)
+static constexpr uint32_t kStreamDrainTimeoutMs = 1000;
+
+// First reservation when nothing is buffered yet
+static constexpr size_t kMinReserve = 4 * 1024;
+
+// =============================================================================
+// OutputCapture
+// =============================================================================
+
+OutputCapture::~OutputCapture() {
+    if (jobId_ == 0) {
+        return;
+    }
+    job::JobManager& jobs = job::getJobManager();
+    jobs.terminate(jobId_, true);
+    jobs.wait(jobId_);
+    streams_->waitForDrain(kStreamDrainTimeoutMs);
+    jobs.removeJob(jobId_);
+}
+
+bool OutputCapture::start(std::vector<job::SpawnOptions> stages) {
+    if (stages.empty()) {
+        return false;
+    }
+
+    for (auto& stage : stages) {
+        stage.background = false;
+        // Errors are not part of the value: each stage writes them to
+        // the shell's stderr unless it redirects them itself
+        bool redirected = std::any_of(stage.redirects.begin(), stage.redirects.end(),
+                                      [](const job::StreamRedirect& r) {
+                                          return r.stream == StreamIndex::STDERR;
+                                      });
+        if (!redirected) {
+            stage.redirects.push_back({StreamIndex::STDERR, STDERR_FILENO});
+        }
+    }
+    // Nobody reads stddato: no buffer, so it can never stall the job
+    stages.front().streamOptions[static_cast<size_t>(StreamIndex::STDDATO)].maxCapacity = 0;
+
+    job::JobManager& jobs = job::getJobManager();
+    uint32_t jobId = jobs.spawnPipeline(stages);
+    job::JobControlBlock* job = jobId ? jobs.getJob(jobId) : nullptr;
+    if (!job) {
+        return false;
+    }
+    jobId_ = jobId;
+    streams_ = job->streams.get();
+
+    // The shell has nothing to feed the first stage
+    streams_->closeStdin();
+    return true;
+}
+
+void OutputCapture::readAll(SharedString& out) {
+    while (streams_->waitForData(StreamIndex::STDOUT)) {
+        size_t wanted = out.size() + streams_->availableData(StreamIndex::STDOUT);
+        if (wanted > out.capacity()) {
+            out.reserve(std::max({wanted, out.capacity() + out.capacity() / 2, kMinReserve}));
+        }
+        streams_->consumeBuffer(StreamIndex::STDOUT, [&out](std::span<const uint8_t> span) {
+            out.append(reinterpret_cast<const char*>(span.data()), span.size());
+            return span.size();
+        });
+    }
+}
+
+bool OutputCapture::nextLine(SharedString& line) {
+    line.clear();
+    bool complete = false;
+
+    while (!complete && streams_->waitForData(StreamIndex::STDOUT)) {
+        streams_->consumeBuffer(StreamIndex::STDOUT, [&](std::span<const uint8_t> span) {
+            const auto* data = reinterpret_cast<const char*>(span.data());
+            const void* newline = std::memchr(data, '\n', span.size());
+            if (!newline) {
+                line.append(data, span.size());
+                return span.size();
+            }
+            size_t length = static_cast<size_t>(static_cast<const char*>(newline) - data);
+            line.append(data, length);
+            complete = true;
+            return length + 1;  // The newline is consumed, not kept
+        });
+    }
+    return complete || !line.empty();  // A last line may lack its newline
+}
+
+int OutputCapture::finish() {
+    if (jobId_ == 0) {
+        return -1;
+    }
+
+    // Output nobody asked for is discarded, so the job can run to its end
+    while (streams_->waitForData(StreamIndex::STDOUT)) {
+        streams_->consumeBuffer(StreamIndex::STDOUT,
+                                [](std::span<const uint8_t> span) { return span.size(); });
+    }
+
+    job::JobManager& jobs = job::getJobManager();
+    jobs.wait(jobId_);
+    streams_->waitForDrain(kStreamDrainTimeoutMs);
+    int status = jobs.getJob(jobId_)->exitCode;
+    jobs.removeJob(jobId_);
+    jobId_ = 0;
+    streams_ = nullptr;
+    return status;
+}
+
+void trimTrailingNewlines(SharedString& text) {
+    size_t end = text.view().find_last_not_of('\n');
+    text.resize(end == std::string_view::npos ? 0 : end + 1);
+}
+
+// =============================================================================
+// LineSource
+// =============================================================================
+
+LineSource::LineSource(std::unique_ptr<OutputCapture> capture)
+    : capture_(std::move(capture)) {}
+
+LineSource::LineSource(SharedString text)
+    : text_(std::move(text)) {}
+
+bool LineSource::next(SharedString& line) {
+    if (capture_) {
+        return capture_->nextLine(line);
+    }
+    std::string_view text = text_.view();
+    if (pos_ >= text.size()) {
+        return false;
+    }
+    size_t end = text.find('\n', pos_);
+    if (end == std::string_view::npos) {
+        end = text.size();
+    }
+    line.assign(text.substr(pos_, end - pos_));
+    pos_ = end + 1;
+    return true;
+}
+
+int LineSource::finish() {
+    int status = capture_ ? capture_->finish() : 0;
+    capture_.reset();
+    text_.clear();
+    pos_ = 0;
+    return status;
+}
+
+} // namespace executor
+} // namespace ariash
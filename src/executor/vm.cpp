@@ -0,0 +1,421 @@
+/**
+ * Bytecode VM - Executor::run()
+ *
+ * Register machine for Chunks produced by the Compiler (bytecode.hpp).
+ */
+
+#include "executor/executor.hpp"
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+namespace ariash {
+namespace executor {
+
+using parser::TokenType;
+
+static TokenType comparisonToken(OpCode op) {
+    switch (op) {
+        case OpCode::LT: return TokenType::LT;
+        case OpCode::LE: return TokenType::LE;
+        case OpCode::GT: return TokenType::GT;
+        case OpCode::GE: return TokenType::GE;
+        case OpCode::EQ: return TokenType::EQ;
+        default:         return TokenType::NE;
+    }
+}
+
+// Table lookup instead of a switch: an indirect jump per comparison
+// would cost as much as the instruction dispatch itself
+static inline bool compareInts(OpCode op, int64_t l, int64_t r) {
+    constexpr unsigned kLess = 1, kEqual = 2, kGreater = 4;
+    static constexpr unsigned char accepts[] = {
+        kLess,                 // LT
+        kLess | kEqual,        // LE
+        kGreater,              // GT
+        kGreater | kEqual,     // GE
+        kEqual,                // EQ
+        kLess | kGreater       // NE
+    };
+    unsigned relation = l < r ? kLess : (l == r ? kEqual : kGreater);
+    return (accepts[static_cast<int>(op) - static_cast<int>(OpCode::LT)] & relation) != 0;
+}
+
+// Overwrite in place when the slot already holds the same type
+static inline void storeInt(Value& dst, int64_t value) {
+    if (auto* slot = std::get_if<int64_t>(&dst)) {
+        *slot = value;
+    } else {
+        dst = value;
+    }
+}
+
+static inline void storeBool(Value& dst, bool value) {
+    if (auto* slot = std::get_if<bool>(&dst)) {
+        *slot = value;
+    } else {
+        dst = value;
+    }
+}
+
+// `dst = l + r` for strings, building in dst's own buffer: appended to
+// when dst is l (`s = s + x`), overwritten when nothing else shares it.
+// False when a new value has to be made.
+static bool concatInPlace(Value& dst, const Value& l, const Value& r) {
+    auto* out = std::get_if<SharedString>(&dst);
+    if (!out) {
+        return false;
+    }
+    ValueTextBuffer buffer;
+    if (&dst == &l) {
+        out->append(valueText(r, buffer));  // r may be dst itself: append() allows it
+        return true;
+    }
+    bool concatenates = std::holds_alternative<SharedString>(l) || std::holds_alternative<SharedString>(r);
+    if (&dst == &r || !concatenates || !out->unique()) {
+        return false;
+    }
+    ValueTextBuffer rightBuffer;
+    out->assign(valueText(l, buffer));
+    out->append(valueText(r, rightBuffer));
+    return true;
+}
+
+// Operand the Optimizer proved to hold an int64_t: dereferencing get_if()
+// unchecked lets the compiler drop the variant's type test
+static inline int64_t intOf(const Value& value) {
+    assert(std::holds_alternative<int64_t>(value));
+    return *std::get_if<int64_t>(&value);
+}
+
+Value& Executor::bindVariable(const Chunk& chunk, Value** bindings, int32_t slot) {
+    const std::string& name = chunk.variables[slot];
+    Value* binding = env_.find(name);
+    if (!binding) {
+        throw std::runtime_error("Undefined variable: " + name);
+    }
+    bindings[slot] = binding;
+    return *binding;
+}
+
+void Executor::run(const Chunk& chunk) {
+    if (hasReturned_) {
+        return;
+    }
+
+    std::vector<Value> registers(chunk.registerCount);
+    std::copy(chunk.constants.begin(), chunk.constants.end(), registers.begin());
+
+    // Environment bindings, resolved on first use
+    std::vector<Value*> bindings(chunk.variables.size(), nullptr);
+
+    // For loops in progress; a capture still running when the program
+    // stops (return, exit, error) is killed with it
+    std::vector<LineSource> loops(chunk.loopCount);
+
+    Value* const regs = registers.data();
+    Value** const vars = bindings.data();
+
+    // Kept tiny so it inlines; the first touch of a variable goes out of line
+    auto operand = [&](int32_t op) -> Value& {
+        if (!isVariableOperand(op)) {
+            return regs[op];
+        }
+        Value* binding = vars[variableSlot(op)];
+        if (binding) [[likely]] {
+            return *binding;
+        }
+        return bindVariable(chunk, vars, variableSlot(op));
+    };
+
+    // One case per opcode keeps the dispatch to a single indirect jump
+    auto arithmetic = [&](const Instruction& in, TokenType token, auto intOp) {
+        const Value& l = operand(in.a);
+        const Value& r = operand(in.b);
+        const int64_t* li = std::get_if<int64_t>(&l);
+        const int64_t* ri = std::get_if<int64_t>(&r);
+        if (li && ri) [[likely]] {
+            storeInt(operand(in.dst), intOp(*li, *ri));
+        } else if (token == TokenType::PLUS && concatInPlace(operand(in.dst), l, r)) {
+            // Built in place
+        } else {
+            Value result = applyArithmetic(token, l, r);
+            operand(in.dst) = std::move(result);
+        }
+    };
+
+    const Instruction* const code = chunk.code.data();
+    const size_t codeSize = chunk.code.size();
+    size_t pc = 0;
+
+    while (pc < codeSize) {
+        const Instruction& in = code[pc++];
+
+        switch (in.op) {
+            case OpCode::MOVE: {
+                const Value& value = operand(in.a);
+                Value& dst = operand(in.dst);
+                if (&dst != &value) {
+                    dst = value;
+                }
+                break;
+            }
+
+            case OpCode::DEFINE: {
+                const std::string& name = chunk.variables[variableSlot(in.dst)];
+                Value& value = operand(in.a);
+                vars[variableSlot(in.dst)] = in.b ? &env_.define(name, std::move(value))
+                                                  : &env_.define(name, value);
+                break;
+            }
+
+            // Arithmetic: int64_t fast path (two's complement wrap, as in
+            // the _INT variants), everything else as before
+            case OpCode::ADD:
+                arithmetic(in, TokenType::PLUS, [](int64_t l, int64_t r) {
+                    return static_cast<int64_t>(static_cast<uint64_t>(l) + static_cast<uint64_t>(r));
+                });
+                break;
+
+            case OpCode::SUB:
+                arithmetic(in, TokenType::MINUS, [](int64_t l, int64_t r) {
+                    return static_cast<int64_t>(static_cast<uint64_t>(l) - static_cast<uint64_t>(r));
+                });
+                break;
+
+            case OpCode::MUL:
+                arithmetic(in, TokenType::STAR, [](int64_t l, int64_t r) {
+                    return static_cast<int64_t>(static_cast<uint64_t>(l) * static_cast<uint64_t>(r));
+                });
+                break;
+
+            case OpCode::DIV:
+                arithmetic(in, TokenType::SLASH, [](int64_t l, int64_t r) {
+                    if (r == 0) throw std::runtime_error("Division by zero");
+                    if (l == INT64_MIN && r == -1) throw std::runtime_error("Integer overflow in division");
+                    return l / r;
+                });
+                break;
+
+            case OpCode::LT:
+            case OpCode::LE:
+            case OpCode::GT:
+            case OpCode::GE:
+            case OpCode::EQ:
+            case OpCode::NE: {
+                const Value& l = operand(in.a);
+                const Value& r = operand(in.b);
+                const int64_t* li = std::get_if<int64_t>(&l);
+                const int64_t* ri = std::get_if<int64_t>(&r);
+                if (li && ri) {
+                    storeBool(operand(in.dst), compareInts(in.op, *li, *ri));
+                } else {
+                    Value result = applyComparison(comparisonToken(in.op), l, r);
+                    operand(in.dst) = std::move(result);
+                }
+                break;
+            }
+
+            case OpCode::AND:
+            case OpCode::OR: {
+                Value result = applyLogical(in.op == OpCode::AND ? TokenType::AND : TokenType::OR,
+                                            operand(in.a), operand(in.b));
+                operand(in.dst) = std::move(result);
+                break;
+            }
+
+            case OpCode::NEG: {
+                const Value& value = operand(in.a);
+                if (const int64_t* i = std::get_if<int64_t>(&value)) {
+                    storeInt(operand(in.dst), -*i);
+                } else if (const double* d = std::get_if<double>(&value)) {
+                    double negated = -*d;
+                    operand(in.dst) = negated;
+                } else {
+                    throw std::runtime_error("Cannot negate non-numeric value");
+                }
+                break;
+            }
+
+            case OpCode::NOT: {
+                bool result = !isTruthy(operand(in.a));
+                storeBool(operand(in.dst), result);
+                break;
+            }
+
+            case OpCode::JUMP:
+                pc = static_cast<size_t>(in.dst);
+                break;
+
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE: {
+                const Value& value = operand(in.a);
+                const bool* b = std::get_if<bool>(&value);
+                bool truthy = b ? *b : isTruthy(value);
+                if (truthy == (in.op == OpCode::JUMP_IF_TRUE)) {
+                    pc = static_cast<size_t>(in.dst);
+                }
+                break;
+            }
+
+            case OpCode::JUMP_UNLESS:
+            case OpCode::JUMP_WHEN: {
+                const Value& l = operand(in.a);
+                const Value& r = operand(in.b);
+                const int64_t* li = std::get_if<int64_t>(&l);
+                const int64_t* ri = std::get_if<int64_t>(&r);
+                bool holds = li && ri
+                    ? compareInts(in.cmp, *li, *ri)
+                    : isTruthy(applyComparison(comparisonToken(in.cmp), l, r));
+                if (holds == (in.op == OpCode::JUMP_WHEN)) {
+                    pc = static_cast<size_t>(in.dst);
+                }
+                break;
+            }
+
+            // Statically typed: both operands are int64_t
+            case OpCode::ADD_INT:
+                storeInt(operand(in.dst), static_cast<int64_t>(
+                    static_cast<uint64_t>(intOf(operand(in.a))) +
+                    static_cast<uint64_t>(intOf(operand(in.b)))));
+                break;
+
+            case OpCode::SUB_INT:
+                storeInt(operand(in.dst), static_cast<int64_t>(
+                    static_cast<uint64_t>(intOf(operand(in.a))) -
+                    static_cast<uint64_t>(intOf(operand(in.b)))));
+                break;
+
+            case OpCode::MUL_INT:
+                storeInt(operand(in.dst), static_cast<int64_t>(
+                    static_cast<uint64_t>(intOf(operand(in.a))) *
+                    static_cast<uint64_t>(intOf(operand(in.b)))));
+                break;
+
+            case OpCode::DIV_INT: {
+                int64_t r = intOf(operand(in.b));
+                int64_t l = intOf(operand(in.a));
+                if (r == 0) {
+                    throw std::runtime_error("Division by zero");
+                }
+                if (l == INT64_MIN && r == -1) {
+                    throw std::runtime_error("Integer overflow in division");
+                }
+                storeInt(operand(in.dst), l / r);
+                break;
+            }
+
+            case OpCode::CMP_INT:
+                storeBool(operand(in.dst),
+                          compareInts(in.cmp, intOf(operand(in.a)), intOf(operand(in.b))));
+                break;
+
+            case OpCode::NEG_INT:
+                storeInt(operand(in.dst),
+                         static_cast<int64_t>(0 - static_cast<uint64_t>(intOf(operand(in.a)))));
+                break;
+
+            case OpCode::JUMP_UNLESS_INT:
+            case OpCode::JUMP_WHEN_INT: {
+                bool holds = compareInts(in.cmp, intOf(operand(in.a)), intOf(operand(in.b)));
+                if (holds == (in.op == OpCode::JUMP_WHEN_INT)) {
+                    pc = static_cast<size_t>(in.dst);
+                }
+                break;
+            }
+
+            case OpCode::PRINT: {
+                ValueTextBuffer buffer;
+                std::cout << valueText(operand(in.a), buffer);
+                break;
+            }
+
+            case OpCode::PRINT_END:
+                std::cout << std::endl;
+                storeInt(operand(in.dst), 0);  // Return 0
+                break;
+
+            case OpCode::LEN: {
+                const Value& value = operand(in.a);
+                const SharedString* str = std::get_if<SharedString>(&value);
+                if (!str) {
+                    throw std::runtime_error("len() expects string argument");
+                }
+                storeInt(operand(in.dst), static_cast<int64_t>(str->length()));
+                break;
+            }
+
+            case OpCode::RESULT:
+                lastResult_ = operand(in.a);
+                break;
+
+            case OpCode::COMMAND:
+                executeCommand(*chunk.commands[in.a]);
+                if (hasReturned_) {
+                    return;  // exit
+                }
+                break;
+
+            case OpCode::PIPELINE:
+                executePipeline(*chunk.pipelines[in.a]);
+                if (hasReturned_) {
+                    return;
+                }
+                break;
+
+            case OpCode::PARALLEL:
+                executeParallel(*chunk.parallels[in.a], operand(in.b));
+                break;
+
+            case OpCode::CAPTURE: {
+                SharedString output = captureOutput(*chunk.substitutions[in.a]->pipeline);
+                operand(in.dst) = std::move(output);
+                break;
+            }
+
+            case OpCode::ITER_CAPTURE:
+                loops[in.dst] = linesOf(*chunk.substitutions[in.a]);
+                break;
+
+            case OpCode::ITER_STRING: {
+                Value& value = operand(in.a);
+                SharedString* text = std::get_if<SharedString>(&value);
+                if (!text) {
+                    throw std::runtime_error("for loop expects a string or $(...) to iterate over");
+                }
+                loops[in.dst] = in.b ? LineSource(std::move(*text)) : LineSource(*text);
+                break;
+            }
+
+            case OpCode::ITER_NEXT: {
+                // The line is read straight into the variable's string
+                Value& variable = operand(in.a);
+                if (!std::holds_alternative<SharedString>(variable)) {
+                    variable = SharedString();
+                }
+                if (loops[in.b].next(*std::get_if<SharedString>(&variable))) {
+                    pc = static_cast<size_t>(in.dst);
+                }
+                break;
+            }
+
+            case OpCode::ITER_END:
+                if (loops[in.a].capturing()) {
+                    setStatus(loops[in.a].finish());
+                }
+                loops[in.a] = LineSource();
+                break;
+
+            case OpCode::FAIL:
+                throw std::runtime_error(chunk.messages[in.a]);
+
+            case OpCode::HALT:
+                hasReturned_ = true;
+                return;
+        }
+    }
+}
+
+} // namespace executor
+} // namespace ariash
@@ -5,17 +5,19 @@
  */
 
 #include "hexstream/process.hpp"
+#include "job/spawn_engine.hpp"
+#include "job/profiler.hpp"
+#include <cerrno>
 #include <cstring>
 #include <sstream>
 
 #ifndef _WIN32
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <poll.h>
-#ifdef __linux__
-#include <sys/syscall.h>
-#endif
+extern char** environ;
 #else
 #include <windows.h>
 #endif
@@ -23,6 +25,11 @@
 namespace ariash {
 namespace hexstream {
 
+// Profiler sites of the lifecycle (job/profiler.hpp)
+static constexpr char kSpawnSite[] = "spawn";
+static constexpr char kWaitSite[] = "wait";
+static constexpr char kDrainSite[] = "drain";
+
 // =============================================================================
 // HexStreamProcess Implementation
 // =============================================================================
@@ -54,66 +61,128 @@ HexStreamProcess::~HexStreamProcess() {
 #endif
 }
 
+bool HexStreamProcess::attachStream(job::StreamIndex stream, int fd) {
+    if (running_) return false;
+    return streamController_.attachChildFd(stream, fd);
+}
+
+bool HexStreamProcess::relayStream(job::StreamIndex stream, int outFd, bool mirror) {
+    if (running_) return false;
+    return streamController_.relayTo(stream, outFd, mirror);
+}
+
+bool HexStreamProcess::offerSharedRing(job::StreamIndex stream, std::shared_ptr<SharedRing> ring) {
+    if (running_ || !ring) return false;
+    if (stream != job::StreamIndex::STDDATI && stream != job::StreamIndex::STDDATO) {
+        return false;
+    }
+    sharedRings_[stream == job::StreamIndex::STDDATI ? 0 : 1] = std::move(ring);
+    return true;
+}
+
 bool HexStreamProcess::spawn() {
+    job::ProfileScope profile(kSpawnSite, kSpawnSite);
+    launchNs_ = job::steadyNanos();
+    streamController_.configureStreams(config_.streamOptions);
+
 #ifdef _WIN32
-    return spawnWindows();
+    bool spawned = spawnWindows();
 #else
-    return spawnLinux();
+    bool spawned = spawnLinux();
 #endif
+    if (spawned) {
+        job::getLatencyMetrics().record(job::kSpawnLatencyMetric, job::MetricKind::HISTOGRAM,
+                                        static_cast<double>(job::steadyNanos() - launchNs_) / 1e3);
+    }
+    return spawned;
 }
 
 #ifndef _WIN32
 bool HexStreamProcess::spawnLinux() {
+    // Resolved before anything is created: a placement that cannot be
+    // honoured leaves nothing to clean up
+    job::PlacementPlan placement;
+    if (!placement.prepare(config_.placement)) {
+        return false;
+    }
+    
     // Create pipes for all six streams
     if (!streamController_.createPipes()) {
         return false;
     }
     
-    // Fork
-    pid_ = fork();
-    if (pid_ < 0) {
-        return false;  // Fork failed
+    // argv/envp are built up front: the child shares this memory until
+    // it execs and must not allocate
+    // Offered shared rings are advertised like the Windows FD map
+    SharedRingMap ringMap;
+    if (sharedRings_[0]) ringMap.stdDatI = sharedRings_[0]->fds();
+    if (sharedRings_[1]) ringMap.stdDatO = sharedRings_[1]->fds();
+    std::string ringBootstrap = ringMap.serialize();
+    if (!ringBootstrap.empty()) {
+        ringBootstrap = (config_.useEnvBootstrap ? "__ARIA_SHM_RING=" : "--aria-shm-ring=") +
+                        ringBootstrap;
     }
+    bool ringInEnv = !ringBootstrap.empty() && config_.useEnvBootstrap;
     
-    if (pid_ == 0) {
-        // Child process
-        
-        // Setup child-side pipes (redirect FD 0-5)
-        if (!streamController_.setupChild()) {
-            _exit(1);
-        }
-        
-        // Build argv
-        std::vector<char*> argv;
-        argv.push_back(const_cast<char*>(config_.executable.c_str()));
-        for (const auto& arg : config_.arguments) {
-            argv.push_back(const_cast<char*>(arg.c_str()));
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(config_.executable.c_str()));
+    for (const auto& arg : config_.arguments) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    if (!ringBootstrap.empty() && !ringInEnv) {
+        argv.push_back(const_cast<char*>(ringBootstrap.c_str()));
+    }
+    argv.push_back(nullptr);
+    
+    std::vector<char*> envp;
+    if (!config_.environment.empty()) {
+        for (const auto& env : config_.environment) {
+            envp.push_back(const_cast<char*>(env.c_str()));
         }
-        argv.push_back(nullptr);
-        
-        // Build envp (if provided)
-        char** envp = nullptr;
-        if (!config_.environment.empty()) {
-            std::vector<char*> envVec;
-            for (const auto& env : config_.environment) {
-                envVec.push_back(const_cast<char*>(env.c_str()));
-            }
-            envVec.push_back(nullptr);
-            envp = envVec.data();
+    } else if (ringInEnv) {
+        // Inherit our environment, minus a map meant for us
+        for (char** env = environ; *env; ++env) {
+            if (std::strncmp(*env, "__ARIA_SHM_RING=", 16) != 0) envp.push_back(*env);
         }
-        
-        // Exec
-        if (envp) {
-            execve(config_.executable.c_str(), argv.data(), envp);
-        } else {
-            execv(config_.executable.c_str(), argv.data());
+    }
+    if (ringInEnv) {
+        envp.push_back(const_cast<char*>(ringBootstrap.c_str()));
+    }
+    if (!envp.empty()) {
+        envp.push_back(nullptr);
+    }
+    
+    job::SpawnRequest request;
+    request.path = config_.executable.c_str();
+    request.argv = argv.data();
+    request.envp = envp.empty() ? nullptr : envp.data();
+    if (!config_.placement.empty()) {
+        request.placement = &placement;
+    }
+    if (!streamController_.getChildFds(request.fdMap)) {
+        return false;
+    }
+    int inherited = 0;
+    for (const SharedRingFds* fds : {&ringMap.stdDatI, &ringMap.stdDatO}) {
+        if (!fds->valid()) continue;
+        for (int fd : {fds->memFd, fds->dataFd, fds->spaceFd}) {
+            request.inheritFds[inherited++] = fd;
         }
-        
-        // If exec fails
-        _exit(127);
     }
     
-    // Parent process
+    // Spawn with FDs 0-5 wired to the pipes; the pidfd comes back with
+    // the PID (race-free management, Linux 5.3+)
+    job::SpawnResult child = job::spawnProcess(request);
+    if (child.pid < 0) {
+        return false;  // Spawn failed
+    }
+    pid_ = child.pid;
+    pidfd_ = child.pidfd;
+    cgroupLease_ = placement.takeCgroupLease();
+    
+    // The child holds its own copies of the ring FDs now
+    sharedRings_[0].reset();
+    sharedRings_[1].reset();
     
     // Setup parent-side pipes (close child ends)
     if (!streamController_.setupParent()) {
@@ -124,6 +193,13 @@ bool HexStreamProcess::spawnLinux() {
     
     // Set foreground mode
     streamController_.setForegroundMode(config_.foregroundMode);
+    streamController_.setCoalescing(config_.coalesce);
+    
+    // The shell's side of the streams runs on the child's node too
+    if (placement.serviceNode() >= 0) {
+        streamController_.setServiceCpus(placement.serviceCpus());
+        serviceLease_ = std::make_unique<job::ServiceNodeLease>(placement.serviceNode());
+    }
     
     // Start draining threads
     if (!streamController_.startDraining()) {
@@ -132,15 +208,6 @@ bool HexStreamProcess::spawnLinux() {
         return false;
     }
     
-#ifdef __linux__
-    // Open pidfd for race-free management (Linux 5.3+)
-    pidfd_ = syscall(SYS_pidfd_open, pid_, 0);
-    if (pidfd_ < 0) {
-        // Fallback: pidfd not available, use traditional waitpid
-        // This is fine, just slightly less race-free
-    }
-#endif
-    
     running_ = true;
     return true;
 }
@@ -148,13 +215,31 @@ bool HexStreamProcess::spawnLinux() {
 
 #ifdef _WIN32
 bool HexStreamProcess::spawnWindows() {
-    // Create Windows bootstrap
-    windowsBootstrap_ = std::make_unique<platform::WindowsBootstrap>();
+    if (!config_.placement.empty()) {
+        errno = ENOSYS;  // Placement is Linux only
+        return false;
+    }
     
-    // Create pipes
-    if (!windowsBootstrap_->createPipes()) {
+    // Create pipes: overlapped read ends for the output streams, which
+    // the IoReactor's completion port drains
+    if (!streamController_.createPipes()) {
+        return false;
+    }
+    job::IoHandle child[static_cast<int>(job::StreamIndex::COUNT)];
+    if (!streamController_.getChildHandles(child)) {
         return false;
     }
+    platform::WindowsHandleMap handles;
+    handles.hStdIn = child[static_cast<int>(job::StreamIndex::STDIN)];
+    handles.hStdOut = child[static_cast<int>(job::StreamIndex::STDOUT)];
+    handles.hStdErr = child[static_cast<int>(job::StreamIndex::STDERR)];
+    handles.hStdDbg = child[static_cast<int>(job::StreamIndex::STDDBG)];
+    handles.hStdDatI = child[static_cast<int>(job::StreamIndex::STDDATI)];
+    handles.hStdDatO = child[static_cast<int>(job::StreamIndex::STDDATO)];
+    
+    // The bootstrap only maps and passes the handles
+    windowsBootstrap_ = std::make_unique<platform::WindowsBootstrap>();
+    windowsBootstrap_->useChildHandles(handles);
     
     // Build command line
     std::wostringstream cmdLine;
@@ -172,8 +257,18 @@ bool HexStreamProcess::spawnWindows() {
     // Get PID (for compatibility)
     pid_ = GetProcessId(processHandle_);
     
-    // TODO: Setup stream controller with Windows handles
-    // This would require extending StreamController to work with Windows HANDLEs
+    // Close our copies of the child ends so the output pipes report EOF
+    streamController_.setupParent();
+    
+    streamController_.setForegroundMode(config_.foregroundMode);
+    streamController_.setCoalescing(config_.coalesce);
+    
+    // Register the overlapped read ends with the reactor
+    if (!streamController_.startDraining()) {
+        TerminateProcess(processHandle_, 1);
+        WaitForSingleObject(processHandle_, INFINITE);
+        return false;
+    }
     
     running_ = true;
     return true;
@@ -184,6 +279,7 @@ int HexStreamProcess::wait() {
     if (!running_) {
         return exitCode_;
     }
+    job::ProfileScope profile(kWaitSite, kWaitSite);
     
 #ifdef _WIN32
     if (processHandle_ != INVALID_HANDLE_VALUE) {
@@ -195,7 +291,7 @@ int HexStreamProcess::wait() {
         }
     }
 #else
-    int status;
+    int status = -1;
     
 #ifdef __linux__
     if (pidfd_ >= 0) {
@@ -208,12 +304,18 @@ int HexStreamProcess::wait() {
         poll(&pfd, 1, -1);  // Wait indefinitely
         
         // Process is ready to reap
-        waitpid(pid_, &status, WNOHANG);
+        struct rusage usage;
+        if (wait4(pid_, &status, WNOHANG, &usage) > 0) {
+            usage_.add(usage);
+        }
     } else
 #endif
     {
-        // Traditional waitpid
-        waitpid(pid_, &status, 0);
+        // Traditional waitpid (wait4 also reports resource usage)
+        struct rusage usage;
+        if (wait4(pid_, &status, 0, &usage) > 0) {
+            usage_.add(usage);
+        }
     }
     
     if (WIFEXITED(status)) {
@@ -226,6 +328,7 @@ int HexStreamProcess::wait() {
 #endif
     
     running_ = false;
+    cgroupLease_.release();  // Nothing of the child is left in it
     
     // Call exit callback
     if (exitCallback_) {
@@ -263,11 +366,7 @@ ssize_t HexStreamProcess::writeToStdin(const std::string& str) {
 }
 
 ssize_t HexStreamProcess::writeToStdDatI(const void* data, size_t size) {
-    // TODO: Implement stddati write
-    // Would use similar pattern to writeStdin but for FD 4 / stream 4
-    (void)data;
-    (void)size;
-    return -1;
+    return streamController_.writeStdDatI(data, size);
 }
 
 size_t HexStreamProcess::readFromStdout(void* buffer, size_t maxSize) {
@@ -298,6 +397,19 @@ void HexStreamProcess::flushBuffers() {
     streamController_.flushBuffers();
 }
 
+bool HexStreamProcess::waitForStreams(uint32_t timeout_ms) {
+    job::ProfileScope profile(kDrainSite, kDrainSite);
+    bool drained = streamController_.waitForDrain(timeout_ms);
+
+    int64_t first = streamController_.getFirstDataTime();
+    if (!firstByteRecorded_ && first != 0) {
+        firstByteRecorded_ = true;
+        job::getLatencyMetrics().record(job::kFirstByteLatencyMetric, job::MetricKind::HISTOGRAM,
+                                        static_cast<double>(first - launchNs_) / 1e3);
+    }
+    return drained;
+}
+
 void HexStreamProcess::onExit(ExitCallback callback) {
     exitCallback_ = callback;
 }
@@ -306,6 +418,10 @@ size_t HexStreamProcess::getTotalBytesTransferred() const {
     return streamController_.getTotalBytesTransferred();
 }
 
+job::StreamStats HexStreamProcess::getStreamStats(job::StreamIndex stream) const {
+    return streamController_.getStreamStats(stream);
+}
+
 size_t HexStreamProcess::getActiveThreadCount() const {
     return streamController_.getActiveThreadCount();
 }
@@ -320,18 +436,103 @@ size_t HexStreamPipeline::addProcess(const ProcessConfig& config) {
     return idx;
 }
 
-void HexStreamPipeline::connect(size_t srcIdx, size_t dstIdx, job::StreamIndex stream) {
-    connections_.push_back({srcIdx, dstIdx, stream});
+void HexStreamPipeline::connect(size_t srcIdx, size_t dstIdx, job::StreamIndex stream,
+                                ConnectionMode mode) {
+    connections_.push_back({srcIdx, dstIdx, stream, mode});
+}
+
+// Input stream on the consumer side that pairs with a producer's output
+static bool peerInputStream(job::StreamIndex output, job::StreamIndex& input) {
+    switch (output) {
+        case job::StreamIndex::STDOUT:
+        case job::StreamIndex::STDERR:
+        case job::StreamIndex::STDDBG:
+            input = job::StreamIndex::STDIN;
+            return true;
+        case job::StreamIndex::STDDATO:
+            input = job::StreamIndex::STDDATI;
+            return true;
+        default:
+            return false;  // Input streams cannot be a connection source
+    }
+}
+
+bool HexStreamPipeline::wireConnections() {
+#ifndef _WIN32
+    for (const auto& conn : connections_) {
+        job::StreamIndex input;
+        if (conn.srcIdx >= processes_.size() || conn.dstIdx >= processes_.size() ||
+            conn.srcIdx == conn.dstIdx || !peerInputStream(conn.stream, input)) {
+            errno = EINVAL;
+            return false;
+        }
+
+        int pipefd[2];
+#ifdef __linux__
+        if (pipe2(pipefd, O_CLOEXEC) < 0) {
+            return false;
+        }
+        // Bigger pipe = fewer context switches per MB (best effort, capped
+        // by /proc/sys/fs/pipe-max-size)
+        fcntl(pipefd[1], F_SETPIPE_SZ, 1024 * 1024);
+#else
+        if (pipe(pipefd) < 0) {
+            return false;
+        }
+        fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+        fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+        // Consumer always reads the shared pipe directly
+        if (!processes_[conn.dstIdx]->attachStream(input, pipefd[0])) {
+            close(pipefd[0]);
+            close(pipefd[1]);
+            return false;
+        }
+
+        bool wired;
+        if (conn.mode == ConnectionMode::DIRECT) {
+            // Producer writes straight into the same pipe
+            wired = processes_[conn.srcIdx]->attachStream(conn.stream, pipefd[1]);
+        } else if (conn.mode == ConnectionMode::SHARED_RING) {
+            // The pipe is wired as for DIRECT; both ends are offered the
+            // ring on top (none where it cannot be created)
+            wired = conn.stream == job::StreamIndex::STDDATO &&
+                    processes_[conn.srcIdx]->attachStream(conn.stream, pipefd[1]);
+            std::shared_ptr<SharedRing> ring = wired ? SharedRing::create() : nullptr;
+            if (ring) {
+                processes_[conn.srcIdx]->offerSharedRing(conn.stream, ring);
+                processes_[conn.dstIdx]->offerSharedRing(input, ring);
+            }
+        } else {
+            // Producer keeps its own pipe; the shell splices it across
+            wired = processes_[conn.srcIdx]->relayStream(conn.stream, pipefd[1],
+                                                         conn.mode == ConnectionMode::TEE);
+        }
+        if (!wired) {
+            close(pipefd[1]);
+            return false;
+        }
+    }
+    return true;
+#else
+    // Children are not spawned with inherited pipe handles here yet: a
+    // connected pipeline is refused rather than run unwired
+    if (!connections_.empty()) {
+        errno = ENOSYS;
+        return false;
+    }
+    return true;
+#endif
 }
 
 bool HexStreamPipeline::spawn() {
-    // TODO: Implement pipeline connections
-    // This would involve:
-    // 1. Creating shared pipes between processes
-    // 2. On Linux: Using splice() for zero-copy
-    // 3. On Windows: Direct handle passing
-    
-    // For now, spawn all processes independently
+    // All pipes must be wired before the first fork so that every child
+    // inherits exactly its own ends
+    if (!wireConnections()) {
+        return false;
+    }
+
     for (auto& proc : processes_) {
         if (!proc->spawn()) {
             return false;
@@ -0,0 +1,514 @@
+/**
+ * Shared-Memory Ring Channel Implementation
+ */
+
+#include "hexstream/shared_ring.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace ariash {
+namespace hexstream {
+
+static constexpr const char* kEnvName = "__ARIA_SHM_RING";
+static constexpr const char* kFlagPrefix = "--aria-shm-ring=";
+
+// =============================================================================
+// SharedRingMap Implementation
+// =============================================================================
+
+std::string SharedRingMap::serialize() const {
+    std::string out;
+    auto add = [&out](int stream, const SharedRingFds& fds) {
+        if (!fds.valid()) return;
+        if (!out.empty()) out += ';';
+        out += std::to_string(stream) + ':' + std::to_string(fds.memFd) + ',' +
+               std::to_string(fds.dataFd) + ',' + std::to_string(fds.spaceFd);
+    };
+    add(4, stdDatI);
+    add(5, stdDatO);
+    return out;
+}
+
+bool SharedRingMap::parse(const std::string& mapString) {
+    *this = SharedRingMap();
+
+    size_t pos = 0;
+    while (pos < mapString.size()) {
+        size_t end = mapString.find(';', pos);
+        if (end == std::string::npos) end = mapString.size();
+        std::string entry = mapString.substr(pos, end - pos);
+        pos = end + 1;
+
+        // Parse "stream:memfd,data,space"
+        int stream, memFd, dataFd, spaceFd;
+        char tail;
+        if (std::sscanf(entry.c_str(), "%d:%d,%d,%d%c", &stream, &memFd, &dataFd,
+                        &spaceFd, &tail) != 4) {
+            return false;
+        }
+        SharedRingFds fds{memFd, dataFd, spaceFd};
+        if (!fds.valid()) return false;
+
+        if (stream == 4) {
+            stdDatI = fds;
+        } else if (stream == 5) {
+            stdDatO = fds;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef __linux__
+
+// =============================================================================
+// Ring Layout
+// =============================================================================
+
+static constexpr uint32_t kMagic = 0x41524e47;  // "ARNG"
+static constexpr uint32_t kVersion = 1;
+static constexpr uint64_t kNotSwitched = UINT64_MAX;
+
+// Ring FDs are moved here so the children's dup2() onto 0-5 cannot hit them
+static constexpr int kMinRingFd = 10;
+
+/**
+ * First page of the memfd; data starts at the next page
+ *
+ * Each side writes only its own lines: positions and wait flags are
+ * separated like RingBuffer's so the two processes do not false-share.
+ */
+struct SharedRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+
+    alignas(64) std::atomic<uint64_t> writePos{0};        // Producer
+    std::atomic<uint32_t> producerWaiting{0};             // Asleep on spaceFd
+    std::atomic<uint32_t> producerClosed{0};
+    std::atomic<uint64_t> pipePrefix{kNotSwitched};       // Pipe bytes before the ring
+
+    alignas(64) std::atomic<uint64_t> readPos{0};         // Consumer
+    std::atomic<uint32_t> consumerWaiting{0};             // Asleep on dataFd
+    std::atomic<uint32_t> consumerAttached{0};
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "ring positions are shared between processes");
+
+static size_t pageSize() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+static size_t roundUpPow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static int moveAbove(int fd) {
+    if (fd < 0 || fd >= kMinRingFd) return fd;
+    int moved = fcntl(fd, F_DUPFD_CLOEXEC, kMinRingFd);
+    ::close(fd);
+    return moved;
+}
+
+static void closeFds(SharedRingFds& fds) {
+    for (int* fd : {&fds.memFd, &fds.dataFd, &fds.spaceFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+// =============================================================================
+// SharedRing Implementation
+// =============================================================================
+
+std::shared_ptr<SharedRing> SharedRing::create(size_t capacity) {
+    size_t cap = std::max(roundUpPow2(capacity), pageSize());
+    size_t headerSize = pageSize();
+
+    std::shared_ptr<SharedRing> ring(new SharedRing());
+    ring->capacity_ = cap;
+    ring->fds_.memFd = moveAbove(memfd_create("ariash-shm-ring", MFD_CLOEXEC));
+    ring->fds_.dataFd = moveAbove(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    ring->fds_.spaceFd = moveAbove(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    if (!ring->fds_.valid() ||
+        ftruncate(ring->fds_.memFd, static_cast<off_t>(headerSize + cap)) < 0) {
+        return nullptr;
+    }
+
+    void* page = mmap(nullptr, headerSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      ring->fds_.memFd, 0);
+    if (page == MAP_FAILED) {
+        return nullptr;
+    }
+    auto* header = new (page) SharedRingHeader();
+    header->capacity = cap;
+    header->version = kVersion;
+    header->magic = kMagic;
+    munmap(page, headerSize);
+    return ring;
+}
+
+SharedRing::~SharedRing() {
+    closeFds(fds_);
+}
+
+// =============================================================================
+// SharedRingEndpoint Implementation
+// =============================================================================
+
+std::unique_ptr<SharedRingEndpoint> SharedRingEndpoint::open(job::StreamIndex stream,
+                                                             int argc, char** argv) {
+    std::string mapString;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], kFlagPrefix, std::strlen(kFlagPrefix)) == 0) {
+            mapString = argv[i] + std::strlen(kFlagPrefix);
+            break;
+        }
+    }
+    if (mapString.empty()) {
+        const char* env = std::getenv(kEnvName);
+        if (!env) return nullptr;
+        mapString = env;
+    }
+
+    SharedRingMap map;
+    if (!map.parse(mapString)) return nullptr;
+
+    bool input = stream == job::StreamIndex::STDDATI;
+    const SharedRingFds& fds = input ? map.stdDatI : map.stdDatO;
+    if (!fds.valid()) return nullptr;
+    return attach(stream, fds, static_cast<int>(stream));
+}
+
+std::unique_ptr<SharedRingEndpoint> SharedRingEndpoint::attach(job::StreamIndex stream,
+                                                               const SharedRingFds& fds,
+                                                               int pipeFd) {
+    if (stream != job::StreamIndex::STDDATI && stream != job::StreamIndex::STDDATO) {
+        return nullptr;
+    }
+
+    std::unique_ptr<SharedRingEndpoint> endpoint(new SharedRingEndpoint());
+    endpoint->stream_ = stream;
+    endpoint->fds_ = fds;  // Owned from here on, even on failure
+    endpoint->pipeFd_ = pipeFd;
+
+    // The advertised FDs must not leak into our own children
+    for (int fd : {fds.memFd, fds.dataFd, fds.spaceFd}) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    struct stat st;
+    size_t headerSize = pageSize();
+    if (fstat(fds.memFd, &st) < 0 || static_cast<size_t>(st.st_size) <= headerSize) {
+        return nullptr;
+    }
+    size_t cap = static_cast<size_t>(st.st_size) - headerSize;
+    if ((cap & (cap - 1)) != 0 || cap % headerSize != 0) {
+        return nullptr;
+    }
+
+    // [header][data][data again]: the second data view aliases the first
+    size_t total = headerSize + 2 * cap;
+    void* reserve = mmap(nullptr, total, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserve == MAP_FAILED) {
+        return nullptr;
+    }
+    auto* base = static_cast<uint8_t*>(reserve);
+    void* lo = mmap(base, headerSize + cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                    fds.memFd, 0);
+    void* hi = mmap(base + headerSize + cap, cap, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_FIXED, fds.memFd, static_cast<off_t>(headerSize));
+    if (lo == MAP_FAILED || hi == MAP_FAILED) {
+        munmap(reserve, total);
+        return nullptr;
+    }
+    endpoint->mappedSize_ = total;
+    endpoint->header_ = reinterpret_cast<SharedRingHeader*>(base);
+    endpoint->data_ = base + headerSize;
+    endpoint->capacity_ = cap;
+
+    if (endpoint->header_->magic != kMagic || endpoint->header_->version != kVersion ||
+        endpoint->header_->capacity != cap) {
+        return nullptr;
+    }
+
+    if (stream == job::StreamIndex::STDDATI) {
+        // From now on the producer may move over to the ring
+        endpoint->header_->consumerAttached.store(1, std::memory_order_release);
+    }
+    return endpoint;
+}
+
+SharedRingEndpoint::~SharedRingEndpoint() {
+    if (stream_ == job::StreamIndex::STDDATO && header_ && !closed_) {
+        close();
+    }
+    if (header_) {
+        munmap(header_, mappedSize_);
+    }
+    closeFds(fds_);
+}
+
+bool SharedRingEndpoint::usingRing() const {
+    if (!header_) return false;
+    if (stream_ == job::StreamIndex::STDDATO) return switched_;
+    uint64_t prefix = header_->pipePrefix.load(std::memory_order_acquire);
+    return prefix != kNotSwitched && pipeBytes_ >= prefix;
+}
+
+void SharedRingEndpoint::ring(int doorbell) {
+    uint64_t one = 1;
+    ssize_t ignored = ::write(doorbell, &one, sizeof(one));
+    (void)ignored;
+}
+
+bool SharedRingEndpoint::waitFor(int doorbell, short pipeEvents) {
+    // The pipe also reports the peer's exit: POLLERR for a writer whose
+    // reader is gone, POLLHUP for a reader whose writer is
+    struct pollfd fds[2] = {{doorbell, POLLIN, 0}, {pipeFd_, pipeEvents, 0}};
+    int n = poll(fds, pipeFd_ >= 0 ? 2 : 1, -1);
+    if (n < 0) {
+        return errno == EINTR;
+    }
+    if (fds[0].revents & POLLIN) {
+        uint64_t drained;
+        ssize_t ignored = ::read(doorbell, &drained, sizeof(drained));
+        (void)ignored;
+    }
+    if (fds[1].revents & (POLLERR | POLLHUP)) {
+        if (stream_ == job::StreamIndex::STDDATO) {
+            errno = EPIPE;
+            return false;
+        }
+        pipeEnded_ = true;
+    }
+    return true;
+}
+
+bool SharedRingEndpoint::switchToRing() {
+    if (!header_->consumerAttached.load(std::memory_order_acquire)) {
+        return false;
+    }
+    // Everything written so far is in the pipe (write() has returned)
+    header_->pipePrefix.store(pipeBytes_, std::memory_order_seq_cst);
+    switched_ = true;
+    ring(fds_.dataFd);  // A consumer asleep on the pipe re-checks
+    return true;
+}
+
+ssize_t SharedRingEndpoint::write(const void* data, size_t size) {
+    if (stream_ != job::StreamIndex::STDDATO || closed_) {
+        errno = EBADF;
+        return -1;
+    }
+    const auto* src = static_cast<const uint8_t*>(data);
+
+    if (!switched_ && !switchToRing()) {
+        // Consumer not attached (yet, or not Aria-aware): use the pipe
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = ::write(pipeFd_, src + done, size - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            done += static_cast<size_t>(n);
+            pipeBytes_ += static_cast<uint64_t>(n);
+        }
+        return static_cast<ssize_t>(size);
+    }
+
+    size_t done = 0;
+    while (done < size) {
+        uint64_t wpos = header_->writePos.load(std::memory_order_relaxed);
+        uint64_t rpos = header_->readPos.load(std::memory_order_acquire);
+        size_t space = capacity_ - static_cast<size_t>(wpos - rpos);
+
+        if (space == 0) {
+            // Full: sleep until the consumer frees some (re-checked after
+            // raising the flag so its doorbell cannot be missed)
+            header_->producerWaiting.store(1, std::memory_order_seq_cst);
+            if (header_->readPos.load(std::memory_order_seq_cst) == rpos &&
+                !waitFor(fds_.spaceFd, 0)) {
+                header_->producerWaiting.store(0, std::memory_order_relaxed);
+                return -1;
+            }
+            header_->producerWaiting.store(0, std::memory_order_relaxed);
+            continue;
+        }
+
+        // Mirrored storage: one copy even across the wrap-around
+        size_t chunk = std::min(space, size - done);
+        std::memcpy(data_ + (wpos & (capacity_ - 1)), src + done, chunk);
+        header_->writePos.store(wpos + chunk, std::memory_order_seq_cst);
+        done += chunk;
+
+        if (header_->consumerWaiting.load(std::memory_order_seq_cst) &&
+            header_->consumerWaiting.exchange(0, std::memory_order_seq_cst)) {
+            ring(fds_.dataFd);
+        }
+    }
+    return static_cast<ssize_t>(size);
+}
+
+ssize_t SharedRingEndpoint::read(void* data, size_t maxSize) {
+    if (stream_ != job::StreamIndex::STDDATI) {
+        errno = EBADF;
+        return -1;
+    }
+    auto* dst = static_cast<uint8_t*>(data);
+
+    while (maxSize > 0) {
+        uint64_t prefix = header_->pipePrefix.load(std::memory_order_acquire);
+
+        if (prefix == kNotSwitched || pipeBytes_ < prefix) {
+            size_t chunk = maxSize;
+            if (prefix == kNotSwitched) {
+                // Pipe data, or the doorbell announcing the switch
+                if (!pipeEnded_ && !waitFor(fds_.dataFd, POLLIN)) return -1;
+                struct pollfd pfd = {pipeFd_, POLLIN, 0};
+                if (poll(&pfd, 1, 0) <= 0) continue;
+            } else {
+                // Bytes written before the switch: they are in the pipe
+                chunk = static_cast<size_t>(std::min<uint64_t>(chunk, prefix - pipeBytes_));
+            }
+
+            ssize_t n = ::read(pipeFd_, dst, chunk);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            if (n == 0) {
+                // Writer gone; the ring may still hold its last bytes
+                pipeEnded_ = true;
+                if (header_->pipePrefix.load(std::memory_order_acquire) == kNotSwitched) {
+                    return 0;
+                }
+                continue;
+            }
+            pipeBytes_ += static_cast<uint64_t>(n);
+            return n;
+        }
+
+        uint64_t rpos = header_->readPos.load(std::memory_order_relaxed);
+        uint64_t wpos = header_->writePos.load(std::memory_order_acquire);
+        if (wpos != rpos) {
+            size_t chunk = std::min(static_cast<size_t>(wpos - rpos), maxSize);
+            std::memcpy(dst, data_ + (rpos & (capacity_ - 1)), chunk);
+            header_->readPos.store(rpos + chunk, std::memory_order_seq_cst);
+
+            if (header_->producerWaiting.load(std::memory_order_seq_cst) &&
+                header_->producerWaiting.exchange(0, std::memory_order_seq_cst)) {
+                ring(fds_.spaceFd);
+            }
+            return static_cast<ssize_t>(chunk);
+        }
+
+        // Empty: the producer is done if it said so or its process is gone
+        // (closed is published after its last write)
+        if (header_->producerClosed.load(std::memory_order_acquire) || pipeEnded_) {
+            if (header_->writePos.load(std::memory_order_acquire) == rpos) return 0;
+            continue;
+        }
+
+        header_->consumerWaiting.store(1, std::memory_order_seq_cst);
+        if (header_->writePos.load(std::memory_order_seq_cst) == rpos &&
+            !header_->producerClosed.load(std::memory_order_seq_cst) &&
+            !waitFor(fds_.dataFd, 0)) {
+            header_->consumerWaiting.store(0, std::memory_order_relaxed);
+            return -1;
+        }
+        header_->consumerWaiting.store(0, std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+void SharedRingEndpoint::close() {
+    if (stream_ != job::StreamIndex::STDDATO || closed_) return;
+    closed_ = true;
+
+    if (header_) {
+        header_->producerClosed.store(1, std::memory_order_seq_cst);
+        if (header_->consumerWaiting.exchange(0, std::memory_order_seq_cst)) {
+            ring(fds_.dataFd);
+        }
+    }
+    if (pipeFd_ >= 0) {
+        ::close(pipeFd_);
+        pipeFd_ = -1;
+    }
+}
+
+#else // !__linux__
+
+std::shared_ptr<SharedRing> SharedRing::create(size_t capacity) {
+    (void)capacity;
+    return nullptr;
+}
+
+SharedRing::~SharedRing() {}
+
+std::unique_ptr<SharedRingEndpoint> SharedRingEndpoint::open(job::StreamIndex stream,
+                                                             int argc, char** argv) {
+    (void)stream;
+    (void)argc;
+    (void)argv;
+    return nullptr;
+}
+
+std::unique_ptr<SharedRingEndpoint> SharedRingEndpoint::attach(job::StreamIndex stream,
+                                                               const SharedRingFds& fds,
+                                                               int pipeFd) {
+    (void)stream;
+    (void)fds;
+    (void)pipeFd;
+    return nullptr;
+}
+
+SharedRingEndpoint::~SharedRingEndpoint() {}
+
+ssize_t SharedRingEndpoint::write(const void* data, size_t size) {
+    (void)data;
+    (void)size;
+    errno = ENOSYS;
+    return -1;
+}
+
+ssize_t SharedRingEndpoint::read(void* data, size_t maxSize) {
+    (void)data;
+    (void)maxSize;
+    errno = ENOSYS;
+    return -1;
+}
+
+void SharedRingEndpoint::close() {}
+
+bool SharedRingEndpoint::usingRing() const {
+    return false;
+}
+
+#endif // __linux__
+
+} // namespace hexstream
+} // namespace ariash
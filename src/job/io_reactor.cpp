@@ -0,0 +1,741 @@
+/**
+ * AriaSH I/O Reactor Implementation
+ *
+ * Linux: io_uring (multishot reads on 6.7+, single-shot reads re-armed per
+ * completion before that) when available, else epoll + eventfd.
+ * Windows: I/O completion port, one overlapped ReadFile per handle.
+ * Other POSIX systems: poll() + self-pipe.
+ */
+
+#include "job/io_reactor.hpp"
+#include "job/placement.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+#endif
+
+namespace ariash {
+namespace job {
+
+static constexpr size_t kScratchSize = 64 * 1024;
+
+
+#ifdef __linux__
+// io_uring user_data values that are not registration tokens
+static constexpr uint64_t kWakeTag = 0;
+static constexpr uint64_t kCancelTag = UINT64_MAX;
+#endif
+
+#ifdef _WIN32
+// Completion keys: every handle shares one (reads carry their token)
+static constexpr ULONG_PTR kWakeKey = 0;
+static constexpr ULONG_PTR kReadKey = 1;
+
+/**
+ * One outstanding ReadFile: the OVERLAPPED the kernel completes and the
+ * buffer it fills, kept alive until the completion is dequeued
+ */
+struct IoReactor::OverlappedRead {
+    OVERLAPPED ov{};
+    uint64_t token = 0;
+    DWORD error = 0;  // Failed synchronously: posted by hand
+    std::vector<uint8_t> buffer;
+};
+#else
+// Reads per readiness event before yielding the reactor to other FDs
+static constexpr int kReadsPerEvent = 16;
+
+static void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0 && !(flags & O_NONBLOCK)) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+#endif
+
+static bool validHandle(IoHandle fd) {
+#ifdef _WIN32
+    return fd != nullptr && fd != INVALID_HANDLE_VALUE;
+#else
+    return fd >= 0;
+#endif
+}
+
+// =============================================================================
+// Setup / Teardown
+// =============================================================================
+
+// Set by preferReadinessBackend() before the shared reactor starts
+static std::atomic<bool> readinessPreferred{false};
+
+IoReactor::IoReactor() {
+#ifdef __linux__
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    const char* forced = std::getenv("ARIASH_IO_BACKEND");
+    bool allowUring = (!forced || std::strcmp(forced, "epoll") != 0) &&
+                      !readinessPreferred.load(std::memory_order_relaxed);
+    bool oneshot = forced && std::strcmp(forced, "io_uring-oneshot") == 0;
+    if (allowUring && wakeFd >= 0) {
+        uring = UringEngine::create(256, 256, 16 * 1024, !oneshot);
+        if (uring && !uring->armPoll(wakeFd, kWakeTag)) {
+            uring.reset();
+        }
+    }
+
+    if (!uring) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd >= 0 && wakeFd >= 0) {
+            struct epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = 0;  // Token 0 is the wakeup channel
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+        }
+        scratch.resize(kScratchSize);
+    }
+#elif defined(_WIN32)
+    // One thread dequeues; reads land in per-registration buffers
+    port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+#else
+    if (pipe(wakePipe) == 0) {
+        for (int fd : wakePipe) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+        }
+    }
+    scratch.resize(kScratchSize);
+#endif
+
+    worker = std::thread([this] { loop(); });
+}
+
+IoReactor::~IoReactor() {
+    running.store(false, std::memory_order_release);
+    wake();
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+#ifdef __linux__
+    uring.reset();
+    if (wakeFd >= 0) ::close(wakeFd);
+    if (epollFd >= 0) ::close(epollFd);
+#elif defined(_WIN32)
+    if (port) CloseHandle(port);
+#else
+    for (int fd : wakePipe) {
+        if (fd >= 0) ::close(fd);
+    }
+#endif
+}
+
+void IoReactor::wake() {
+#ifdef __linux__
+    uint64_t one = 1;
+    if (wakeFd >= 0) {
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+#elif defined(_WIN32)
+    if (port) PostQueuedCompletionStatus(port, 0, kWakeKey, nullptr);
+#else
+    char c = 0;
+    if (wakePipe[1] >= 0) {
+        ssize_t ignored = ::write(wakePipe[1], &c, 1);
+        (void)ignored;
+    }
+#endif
+}
+
+const char* IoReactor::backendName() const {
+#ifdef __linux__
+    if (!uring) return "epoll";
+    return uring->multishotReads() ? "io_uring" : "io_uring-oneshot";
+#elif defined(_WIN32)
+    return "iocp";
+#else
+    return "poll";
+#endif
+}
+
+bool IoReactor::setAffinity(const std::vector<int>& cpus) {
+    return pinThread(worker, cpus);
+}
+
+// =============================================================================
+// Registration
+// =============================================================================
+
+uint64_t IoReactor::add(IoHandle fd, IoHandler handler, size_t readChunk, IoReadTarget target) {
+    if (!validHandle(fd) || !handler) return 0;
+
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    uint64_t token = nextToken++;
+
+#ifdef __linux__
+    if (!uring) {
+        // Readiness backends must never block on a read
+        setNonBlocking(fd);
+        struct epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = token;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            return 0;
+        }
+    }
+#elif defined(_WIN32)
+    // Fails for handles not opened FILE_FLAG_OVERLAPPED, which would
+    // block the loop inside ReadFile
+    if (!port || !CreateIoCompletionPort(fd, port, kReadKey, 0)) {
+        return 0;
+    }
+#else
+    setNonBlocking(fd);
+#endif
+
+    Registration reg;
+    reg.fd = fd;
+    reg.readChunk = readChunk;
+    reg.target = std::move(target);
+    reg.handler = std::make_shared<IoHandler>(std::move(handler));
+#ifdef _WIN32
+    reg.overlapped = std::make_shared<OverlappedRead>();
+    reg.overlapped->token = token;
+    reg.overlapped->buffer.resize(readChunk > 0 ? readChunk : kScratchSize);
+#endif
+    auto it = registrations.emplace(token, std::move(reg)).first;
+
+#ifdef __linux__
+    if (uring) {
+        armBackend(token, it->second);
+        wake();  // Only the loop submits
+    }
+#elif defined(_WIN32)
+    armBackend(token, it->second);  // ReadFile may be issued from any thread
+#else
+    (void)it;
+    wake();  // poll() set changed
+#endif
+    return token;
+}
+
+bool IoReactor::remove(uint64_t token) {
+    // Blocks while the loop is inside a handler (unless we are that handler)
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    if (registrations.find(token) == registrations.end()) return false;
+    unregister(token);
+
+#ifdef __linux__
+    if (uring) wake();
+#elif defined(_WIN32)
+    // Completions alone drive the port: nothing to rebuild
+#else
+    wake();
+#endif
+    return true;
+}
+
+void IoReactor::notify(uint64_t token) {
+    {
+        std::lock_guard<std::mutex> lock(notifyMutex);
+        notified.push_back(token);
+    }
+    wake();
+}
+
+void IoReactor::unregister(uint64_t token) {
+    auto it = registrations.find(token);
+    if (it == registrations.end()) return;
+
+    disarmBackend(token, it->second);
+#ifdef _WIN32
+    if (it->second.inFlight) {
+        retired.push_back(std::move(it->second.overlapped));
+    }
+#endif
+    registrations.erase(it);
+}
+
+size_t IoReactor::size() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return registrations.size();
+}
+
+void IoReactor::armBackend(uint64_t token, Registration& reg) {
+#ifdef __linux__
+    if (uring) {
+        // A still-outstanding read keeps delivering; re-arm only once the
+        // kernel has terminated it
+        if (!reg.inFlight) pendingArms.push_back(token);
+        return;
+    }
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = token;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, reg.fd, &ev);
+#elif defined(_WIN32)
+    // Like io_uring: a read still outstanding (being cancelled) re-arms
+    // when it completes
+    if (!reg.inFlight) startRead(token, reg);
+#else
+    (void)token;
+    (void)reg;
+#endif
+}
+
+void IoReactor::disarmBackend(uint64_t token, Registration& reg) {
+#ifdef __linux__
+    if (uring) {
+        if (reg.inFlight) pendingCancels.push_back(token);
+        return;
+    }
+    // Disarm by removing the FD outright: a hung-up pipe keeps reporting
+    // EPOLLHUP even with an empty event mask
+    if (reg.armed) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, reg.fd, nullptr);
+    }
+#elif defined(_WIN32)
+    // A pending read would keep taking bytes out of the pipe; whatever it
+    // already got still arrives as DATA
+    (void)token;
+    if (reg.inFlight) {
+        CancelIoEx(reg.fd, &reg.overlapped->ov);
+    }
+#else
+    (void)token;
+    (void)reg;
+#endif
+}
+
+// =============================================================================
+// Dispatch
+// =============================================================================
+
+void IoReactor::apply(uint64_t token, Registration& reg, const IoInterest& next) {
+    if (next.done) {
+        unregister(token);
+        return;
+    }
+
+    if (next.armed != reg.armed) {
+        if (next.armed) {
+            armBackend(token, reg);
+        } else {
+            disarmBackend(token, reg);
+        }
+        reg.armed = next.armed;
+    }
+
+    reg.hasDeadline = next.timerUs >= 0;
+    if (reg.hasDeadline) {
+        reg.deadline = Clock::now() + std::chrono::microseconds(next.timerUs);
+    }
+}
+
+std::optional<IoInterest> IoReactor::deliver(uint64_t token, const IoEvent& event) {
+    // Caller holds the mutex
+    auto it = registrations.find(token);
+    if (it == registrations.end()) return std::nullopt;  // Removed meanwhile
+
+    // Hold a reference: the handler may remove (and so destroy) its own
+    // registration
+    std::shared_ptr<IoHandler> handler = it->second.handler;
+    IoInterest next = (*handler)(event);
+
+    it = registrations.find(token);
+    if (it == registrations.end()) return std::nullopt;
+    apply(token, it->second, next);
+    return next;
+}
+
+#ifndef _WIN32
+
+void IoReactor::readReady(uint64_t token) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    for (int i = 0; i < kReadsPerEvent; ++i) {
+        auto it = registrations.find(token);
+        if (it == registrations.end() || !it->second.armed) return;
+
+        std::span<uint8_t> dst(scratch);
+        if (it->second.target) {
+            std::span<uint8_t> direct = it->second.target();
+            if (!direct.empty()) dst = direct;
+        }
+        bool inPlace = dst.data() != scratch.data();
+
+        size_t chunk = dst.size();
+        if (it->second.readChunk > 0) chunk = std::min(chunk, it->second.readChunk);
+        ssize_t n = ::read(it->second.fd, dst.data(), chunk);
+        IoEvent event;
+
+        if (n > 0) {
+            event.kind = IoEvent::Kind::DATA;
+            event.data = dst.data();
+            event.size = static_cast<size_t>(n);
+            event.inPlace = inPlace;
+            auto next = deliver(token, event);
+            if (!next || next->done || !next->armed) return;
+        } else if (n == 0) {
+            event.kind = IoEvent::Kind::END;  // EOF: writer closed the pipe
+            deliver(token, event);
+            return;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;  // Drained for now
+        } else {
+            event.kind = IoEvent::Kind::END;
+            event.error = errno;
+            deliver(token, event);
+            return;
+        }
+    }
+}
+
+#endif // !_WIN32
+
+void IoReactor::runNotifications() {
+    std::vector<uint64_t> tokens;
+    {
+        std::lock_guard<std::mutex> lock(notifyMutex);
+        tokens.swap(notified);
+    }
+
+    IoEvent event;
+    event.kind = IoEvent::Kind::NOTIFY;
+    for (uint64_t token : tokens) {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        deliver(token, event);
+    }
+}
+
+void IoReactor::runTimers() {
+    // Timers that are due (a dispatch above may have rescheduled or
+    // cleared them)
+    std::vector<uint64_t> due;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        auto now = Clock::now();
+        for (auto& pair : registrations) {
+            if (pair.second.hasDeadline && pair.second.deadline <= now) {
+                pair.second.hasDeadline = false;
+                due.push_back(pair.first);
+            }
+        }
+    }
+
+    IoEvent timer;
+    timer.kind = IoEvent::Kind::TIMER;
+    for (uint64_t token : due) {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        deliver(token, timer);
+    }
+}
+
+int IoReactor::nextTimeoutMs() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    bool any = false;
+    Clock::time_point earliest;
+    for (const auto& pair : registrations) {
+        if (pair.second.hasDeadline && (!any || pair.second.deadline < earliest)) {
+            earliest = pair.second.deadline;
+            any = true;
+        }
+    }
+    if (!any) return -1;  // Nothing scheduled: sleep until I/O
+
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(earliest - Clock::now());
+    return static_cast<int>(std::max<int64_t>(left.count(), 0));
+}
+
+// =============================================================================
+// Event Loop
+// =============================================================================
+
+void IoReactor::loop() {
+#ifdef _WIN32
+    loopCompletionPort();
+#else
+#ifdef __linux__
+    if (uring) {
+        loopUring();
+        return;
+    }
+#endif
+    loopReadiness();
+#endif
+}
+
+#ifndef _WIN32
+
+void IoReactor::loopReadiness() {
+    while (running.load(std::memory_order_acquire)) {
+        int timeout = nextTimeoutMs();
+
+        std::vector<uint64_t> ready;
+
+#ifdef __linux__
+        struct epoll_event events[64];
+        int n = epoll_wait(epollFd, events, 64, timeout);
+        if (n < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < n; ++i) {
+            uint64_t token = events[i].data.u64;
+            if (token == 0) {
+                uint64_t drained;
+                ssize_t ignored = ::read(wakeFd, &drained, sizeof(drained));
+                (void)ignored;
+                continue;
+            }
+            ready.push_back(token);
+        }
+#else
+        std::vector<struct pollfd> pfds;
+        std::vector<uint64_t> tokens;
+        pfds.push_back({wakePipe[0], POLLIN, 0});
+        tokens.push_back(0);
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            for (const auto& pair : registrations) {
+                if (!pair.second.armed) continue;
+                pfds.push_back({pair.second.fd, POLLIN, 0});
+                tokens.push_back(pair.first);
+            }
+        }
+
+        int n = poll(pfds.data(), pfds.size(), timeout);
+        if (n < 0 && errno != EINTR) break;
+
+        for (size_t i = 0; n > 0 && i < pfds.size(); ++i) {
+            if (!pfds[i].revents) continue;
+            if (tokens[i] == 0) {
+                char buf[64];
+                while (::read(wakePipe[0], buf, sizeof(buf)) > 0) {}
+                continue;
+            }
+            ready.push_back(tokens[i]);
+        }
+#endif
+
+        for (uint64_t token : ready) {
+            readReady(token);
+        }
+        runNotifications();
+        runTimers();
+    }
+}
+
+#endif // !_WIN32
+
+#ifdef __linux__
+
+void IoReactor::submitPending() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    for (uint64_t token : pendingCancels) {
+        uring->cancel(token, kCancelTag);
+    }
+    pendingCancels.clear();
+
+    for (uint64_t token : pendingArms) {
+        auto it = registrations.find(token);
+        if (it == registrations.end()) continue;
+        Registration& reg = it->second;
+        if (reg.armed && !reg.inFlight && uring->armRead(reg.fd, token)) {
+            reg.inFlight = true;
+        }
+    }
+    pendingArms.clear();
+}
+
+void IoReactor::onCompletion(const UringEngine::Completion& completion) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    auto it = registrations.find(completion.tag);
+    if (it == registrations.end()) return;  // Late completion after remove()
+    if (!completion.more) it->second.inFlight = false;
+
+    IoEvent event;
+    if (completion.res > 0 && completion.data) {
+        // Delivered even when disarmed: the bytes are already consumed
+        event.kind = IoEvent::Kind::DATA;
+        event.data = completion.data;
+        event.size = static_cast<size_t>(completion.res);
+        deliver(completion.tag, event);
+    } else if (completion.res == 0) {
+        event.kind = IoEvent::Kind::END;  // EOF: writer closed the pipe
+        deliver(completion.tag, event);
+        return;
+    } else if (completion.res != -ENOBUFS && completion.res != -ECANCELED &&
+               completion.res != -EINTR && completion.res != -EAGAIN) {
+        event.kind = IoEvent::Kind::END;
+        event.error = -completion.res;
+        deliver(completion.tag, event);
+        return;
+    }
+
+    // The kernel ended the multishot (buffers ran out, cancelled, ...):
+    // start another if the handler still wants data
+    it = registrations.find(completion.tag);
+    if (it != registrations.end() && it->second.armed && !it->second.inFlight) {
+        pendingArms.push_back(completion.tag);
+    }
+}
+
+void IoReactor::loopUring() {
+    while (running.load(std::memory_order_acquire)) {
+        submitPending();
+
+        int timeout = nextTimeoutMs();
+        if (!uring->submitAndWait(timeout)) break;
+
+        UringEngine::Completion completion;
+        while (uring->popCompletion(completion)) {
+            if (completion.tag == kWakeTag) {
+                uint64_t drained;
+                ssize_t ignored = ::read(wakeFd, &drained, sizeof(drained));
+                (void)ignored;
+                if (!completion.more) uring->armPoll(wakeFd, kWakeTag);
+                continue;
+            }
+            if (completion.tag == kCancelTag) continue;
+
+            onCompletion(completion);
+            if (completion.hasBuffer) {
+                uring->recycle(completion.bufferId);
+            }
+        }
+
+        runNotifications();
+        runTimers();
+    }
+}
+
+#endif // __linux__
+
+#ifdef _WIN32
+
+void IoReactor::startRead(uint64_t token, Registration& reg) {
+    // Caller holds the mutex
+    (void)token;
+    OverlappedRead& read = *reg.overlapped;
+    read.ov = OVERLAPPED{};
+    read.error = 0;
+    reg.inFlight = true;
+
+    // Immediate success still queues a completion packet
+    DWORD size = static_cast<DWORD>(read.buffer.size());
+    if (ReadFile(reg.fd, read.buffer.data(), size, nullptr, &read.ov) ||
+        GetLastError() == ERROR_IO_PENDING) {
+        return;
+    }
+
+    // Failed up front (typically a broken pipe: the child is gone). Handlers
+    // only ever run from the loop, so report it through the port too
+    read.error = GetLastError();
+    PostQueuedCompletionStatus(port, 0, kReadKey, &read.ov);
+}
+
+void IoReactor::onCompletion(OverlappedRead* read) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    uint64_t token = read->token;
+    auto it = registrations.find(token);
+    if (it == registrations.end() || it->second.overlapped.get() != read) {
+        // Late completion of a read cancelled by remove(): let it go
+        retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                     [read](const auto& r) { return r.get() == read; }),
+                      retired.end());
+        return;
+    }
+    it->second.inFlight = false;
+
+    DWORD bytes = 0;
+    DWORD error = read->error;
+    if (error == 0 && !GetOverlappedResult(it->second.fd, &read->ov, &bytes, FALSE)) {
+        error = GetLastError();
+    }
+
+    IoEvent event;
+    if (error == 0 && bytes > 0) {
+        // Delivered even when disarmed: the bytes are already consumed
+        event.kind = IoEvent::Kind::DATA;
+        event.data = read->buffer.data();
+        event.size = bytes;
+        deliver(token, event);
+    } else if (error == ERROR_BROKEN_PIPE || error == ERROR_HANDLE_EOF ||
+               error == ERROR_PIPE_NOT_CONNECTED) {
+        event.kind = IoEvent::Kind::END;  // EOF: writer closed the pipe
+        deliver(token, event);
+        return;
+    } else if (error != 0 && error != ERROR_OPERATION_ABORTED) {
+        event.kind = IoEvent::Kind::END;
+        event.error = EIO;
+        deliver(token, event);
+        return;
+    }
+
+    // One read at a time: start the next if the handler still wants data
+    it = registrations.find(token);
+    if (it != registrations.end() && it->second.armed && !it->second.inFlight) {
+        startRead(token, it->second);
+    }
+}
+
+void IoReactor::loopCompletionPort() {
+    OVERLAPPED_ENTRY entries[64];
+
+    while (running.load(std::memory_order_acquire)) {
+        int timeout = nextTimeoutMs();
+        ULONG n = 0;
+        if (!GetQueuedCompletionStatusEx(port, entries, 64, &n,
+                                         timeout < 0 ? INFINITE : static_cast<DWORD>(timeout),
+                                         FALSE)) {
+            if (GetLastError() != WAIT_TIMEOUT) break;
+            n = 0;
+        }
+
+        for (ULONG i = 0; i < n; ++i) {
+            if (entries[i].lpCompletionKey == kWakeKey || !entries[i].lpOverlapped) continue;
+            onCompletion(CONTAINING_RECORD(entries[i].lpOverlapped, OverlappedRead, ov));
+        }
+
+        runNotifications();
+        runTimers();
+    }
+}
+
+#endif // _WIN32
+
+// =============================================================================
+// Shared Reactor
+// =============================================================================
+
+IoReactor& getIoReactor() {
+    // Intentionally leaked: drainers owned by other static objects (the
+    // global JobManager's jobs) may unregister during static destruction
+    static IoReactor* reactor = new IoReactor();
+    return *reactor;
+}
+
+void preferReadinessBackend() {
+    readinessPreferred.store(true, std::memory_order_relaxed);
+}
+
+} // namespace job
+} // namespace ariash
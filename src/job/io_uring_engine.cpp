@@ -0,0 +1,433 @@
+/**
+ * AriaSH io_uring Engine Implementation
+ *
+ * Raw io_uring_setup/io_uring_enter/io_uring_register syscalls against the
+ * kernel UAPI header. Built only with ARIASH_HAVE_IO_URING; otherwise
+ * create() reports the engine as unavailable.
+ */
+
+#include "job/io_uring_engine.hpp"
+
+#if defined(__linux__) && defined(ARIASH_HAVE_IO_URING)
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <poll.h>
+
+namespace ariash {
+namespace job {
+
+// Added in Linux 6.7; older UAPI headers lack the enumerator
+static constexpr uint8_t kOpReadMultishot = 49;
+
+// Buffer group shared by every read
+static constexpr uint16_t kBufferGroup = 0;
+
+// user_data of the engine's own requests (never reported to the caller)
+static constexpr uint64_t kInternalTag = UINT64_MAX - 1;
+
+static int uringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags,
+                      const void* arg, size_t argSize) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+                                    flags, arg, argSize));
+}
+
+static int uringRegister(int fd, unsigned opcode, const void* arg, unsigned nrArgs) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+struct UringEngine::Ring {
+    int fd = -1;
+
+    // Submission queue
+    void* sqMap = MAP_FAILED;
+    size_t sqMapSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned toSubmit = 0;
+
+    // IORING_OP_READ_MULTISHOT, else one IORING_OP_READ per completion
+    bool multishot = false;
+
+    // Completion queue (shares sqMap: IORING_FEAT_SINGLE_MMAP is required)
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    // Provided buffers: a mapped buffer ring, or IORING_OP_PROVIDE_BUFFERS
+    // requests where the ring is unusable
+    bool legacyBuffers = false;
+    io_uring_buf_ring* bufRing = static_cast<io_uring_buf_ring*>(MAP_FAILED);
+    size_t bufRingSize = 0;
+    std::vector<uint8_t> buffers;
+    unsigned bufCount = 0;
+    unsigned bufSize = 0;
+    uint16_t bufTail = 0;
+
+    ~Ring() {
+        if (bufRing != MAP_FAILED) munmap(bufRing, bufRingSize);
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (sqMap != MAP_FAILED) munmap(sqMap, sqMapSize);
+        if (fd >= 0) ::close(fd);
+    }
+
+    void addBuffer(uint16_t bid) {
+        if (legacyBuffers) {
+            provideBuffers(bid, 1);
+            return;
+        }
+        io_uring_buf* buf = &bufRing->bufs[bufTail & (bufCount - 1)];
+        buf->addr = reinterpret_cast<uint64_t>(buffers.data() + size_t(bid) * bufSize);
+        buf->len = bufSize;
+        buf->bid = bid;
+        ++bufTail;
+    }
+
+    void publishBuffers() {
+        __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+    }
+
+    bool submit(unsigned minComplete, unsigned flags, const void* arg, size_t argSize) {
+        int ret = uringEnter(fd, toSubmit, minComplete, flags, arg, argSize);
+        if (ret < 0) {
+            // Timeouts and interruptions are normal wakeups
+            return errno == ETIME || errno == EINTR || errno == EAGAIN || errno == EBUSY;
+        }
+        toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(ret));
+        return true;
+    }
+
+    io_uring_sqe* nextSqe() {
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        unsigned tail = *sqTail;
+        if (tail - head >= sqEntries) {
+            // SQ full: push what we have to the kernel first
+            if (!submit(0, 0, nullptr, 0)) return nullptr;
+            head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+            if (tail - head >= sqEntries) return nullptr;
+        }
+
+        unsigned idx = tail & sqMask;
+        io_uring_sqe* sqe = &sqes[idx];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqArray[idx] = idx;
+        return sqe;
+    }
+
+    void commitSqe() {
+        __atomic_store_n(sqTail, *sqTail + 1, __ATOMIC_RELEASE);
+        ++toSubmit;
+    }
+
+    bool provideBuffers(uint16_t firstBid, unsigned count) {
+        io_uring_sqe* sqe = nextSqe();
+        if (!sqe) return false;
+
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = static_cast<int>(count);
+        sqe->addr = reinterpret_cast<uint64_t>(buffers.data() + size_t(firstBid) * bufSize);
+        sqe->len = bufSize;
+        sqe->off = firstBid;
+        sqe->buf_group = kBufferGroup;
+        sqe->user_data = kInternalTag;
+        commitSqe();
+        return true;
+    }
+
+    /**
+     * Read one byte through the buffer ring
+     *
+     * Some kernels accept IORING_REGISTER_PBUF_RING yet never hand out
+     * its buffers (every read fails with ENOBUFS).
+     */
+    bool bufferRingWorks() {
+        int probe[2];
+        if (pipe2(probe, O_CLOEXEC) < 0) return false;
+
+        bool works = false;
+        io_uring_sqe* sqe = nextSqe();
+        if (sqe && ::write(probe[1], "", 1) == 1) {
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = probe[0];
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = kBufferGroup;
+            sqe->user_data = kInternalTag;
+            commitSqe();
+
+            if (submit(1, IORING_ENTER_GETEVENTS, nullptr, _NSIG / 8)) {
+                unsigned head = *cqHead;
+                if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                    const io_uring_cqe& cqe = cqes[head & cqMask];
+                    works = cqe.res == 1 && (cqe.flags & IORING_CQE_F_BUFFER);
+                    if (works) {
+                        addBuffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+                        publishBuffers();
+                    }
+                    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+                }
+            }
+        }
+
+        ::close(probe[0]);
+        ::close(probe[1]);
+        return works;
+    }
+};
+
+std::unique_ptr<UringEngine> UringEngine::create(unsigned entries, unsigned bufferCount,
+                                                 unsigned bufferSize, bool multishot) {
+    if (bufferCount == 0 || (bufferCount & (bufferCount - 1)) != 0 || bufferCount > 32768) {
+        return nullptr;
+    }
+
+    auto ring = std::make_unique<Ring>();
+
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CLAMP;
+    ring->fd = uringSetup(entries, &params);
+    if (ring->fd < 0) {
+        return nullptr;  // ENOSYS, EPERM (seccomp/sysctl), ...
+    }
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) ||
+        !(params.features & IORING_FEAT_EXT_ARG)) {
+        return nullptr;
+    }
+
+    // Multishot reads (6.7+) where possible, else single-shot reads; both
+    // select provided buffers
+    std::vector<uint8_t> probeBuf(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+    auto* probe = reinterpret_cast<io_uring_probe*>(probeBuf.data());
+    if (uringRegister(ring->fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+        return nullptr;
+    }
+    auto supported = [probe](unsigned op) {
+        return probe->last_op >= op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    };
+    if (!supported(IORING_OP_READ) || !supported(IORING_OP_PROVIDE_BUFFERS)) {
+        return nullptr;
+    }
+    ring->multishot = multishot && supported(kOpReadMultishot);
+
+    // Map SQ + CQ rings (single mapping) and the SQE array
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ring->sqMapSize = std::max(sqSize, cqSize);
+    ring->sqMap = mmap(nullptr, ring->sqMapSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sqMap == MAP_FAILED) {
+        return nullptr;
+    }
+
+    ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return nullptr;
+    }
+    ring->sqes = static_cast<io_uring_sqe*>(sqes);
+
+    auto* base = static_cast<uint8_t*>(ring->sqMap);
+    ring->sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    ring->sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    ring->sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    ring->sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    ring->sqEntries = params.sq_entries;
+    ring->cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    ring->cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    ring->cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    ring->cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+    // Provided buffer ring (page-aligned, shared with the kernel)
+    ring->bufCount = bufferCount;
+    ring->bufSize = bufferSize;
+    ring->bufRingSize = bufferCount * sizeof(io_uring_buf);
+    void* bufRing = mmap(nullptr, ring->bufRingSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufRing == MAP_FAILED) {
+        return nullptr;
+    }
+    ring->bufRing = static_cast<io_uring_buf_ring*>(bufRing);
+    // Fault the pages in first: registering untouched memory would pin the
+    // shared zero page and the kernel would never see our tail updates
+    std::memset(bufRing, 0, ring->bufRingSize);
+
+    ring->buffers.resize(size_t(bufferCount) * bufferSize);
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring->bufRing);
+    reg.ring_entries = bufferCount;
+    reg.bgid = kBufferGroup;
+    bool registered = uringRegister(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0;
+
+    if (registered) {
+        for (unsigned bid = 0; bid < bufferCount; ++bid) {
+            ring->addBuffer(static_cast<uint16_t>(bid));
+        }
+        ring->publishBuffers();
+    }
+
+    if (!registered || !ring->bufferRingWorks()) {
+        // Pre-5.19 kernel or unusable ring: provide the buffers by request
+        if (registered) {
+            uringRegister(ring->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        }
+        ring->legacyBuffers = true;
+        if (!ring->provideBuffers(0, bufferCount) || !ring->submit(0, 0, nullptr, 0)) {
+            return nullptr;
+        }
+    }
+
+    std::unique_ptr<UringEngine> engine(new UringEngine());
+    engine->ring = std::move(ring);
+    return engine;
+}
+
+UringEngine::~UringEngine() = default;
+
+bool UringEngine::armRead(int fd, uint64_t tag) {
+    io_uring_sqe* sqe = ring->nextSqe();
+    if (!sqe) return false;
+
+    sqe->fd = fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    if (ring->multishot) {
+        sqe->opcode = kOpReadMultishot;
+        sqe->len = 0;   // Whole provided buffer (multishot rejects a length)
+    } else {
+        sqe->opcode = IORING_OP_READ;
+        sqe->len = ring->bufSize;
+    }
+    sqe->off = 0;   // Pipes are not seekable
+    sqe->user_data = tag;
+    ring->commitSqe();
+    return true;
+}
+
+bool UringEngine::multishotReads() const {
+    return ring->multishot;
+}
+
+bool UringEngine::armPoll(int fd, uint64_t tag) {
+    io_uring_sqe* sqe = ring->nextSqe();
+    if (!sqe) return false;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = tag;
+    ring->commitSqe();
+    return true;
+}
+
+bool UringEngine::cancel(uint64_t tag, uint64_t cancelTag) {
+    io_uring_sqe* sqe = ring->nextSqe();
+    if (!sqe) return false;
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = tag;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = cancelTag;
+    ring->commitSqe();
+    return true;
+}
+
+bool UringEngine::submitAndWait(int timeout_ms) {
+    // Completions already waiting: just submit
+    bool ready = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE) != *ring->cqHead;
+    if (ready || timeout_ms == 0) {
+        return ring->toSubmit == 0 || ring->submit(0, 0, nullptr, 0);
+    }
+
+    unsigned flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    __kernel_timespec ts{};
+    io_uring_getevents_arg arg{};
+    arg.sigmask = 0;
+    arg.sigmask_sz = _NSIG / 8;
+    if (timeout_ms > 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+    return ring->submit(1, flags, &arg, sizeof(arg));
+}
+
+bool UringEngine::popCompletion(Completion& out) {
+    unsigned head = *ring->cqHead;
+    while (head != __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE) &&
+           ring->cqes[head & ring->cqMask].user_data == kInternalTag) {
+        // Buffer hand-back completions
+        __atomic_store_n(ring->cqHead, ++head, __ATOMIC_RELEASE);
+    }
+    if (head == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    const io_uring_cqe* cqe = &ring->cqes[head & ring->cqMask];
+    out.tag = cqe->user_data;
+    out.res = cqe->res;
+    out.more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+    out.hasBuffer = (cqe->flags & IORING_CQE_F_BUFFER) != 0;
+    out.bufferId = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    out.data = out.hasBuffer
+        ? ring->buffers.data() + size_t(out.bufferId) * ring->bufSize
+        : nullptr;
+
+    __atomic_store_n(ring->cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void UringEngine::recycle(uint16_t bufferId) {
+    ring->addBuffer(bufferId);
+    if (!ring->legacyBuffers) ring->publishBuffers();
+}
+
+} // namespace job
+} // namespace ariash
+
+#else  // !(__linux__ && ARIASH_HAVE_IO_URING)
+
+namespace ariash {
+namespace job {
+
+struct UringEngine::Ring {};
+
+std::unique_ptr<UringEngine> UringEngine::create(unsigned, unsigned, unsigned, bool) {
+    return nullptr;
+}
+
+UringEngine::~UringEngine() = default;
+bool UringEngine::armRead(int, uint64_t) { return false; }
+bool UringEngine::multishotReads() const { return false; }
+bool UringEngine::armPoll(int, uint64_t) { return false; }
+bool UringEngine::cancel(uint64_t, uint64_t) { return false; }
+bool UringEngine::submitAndWait(int) { return false; }
+bool UringEngine::popCompletion(Completion&) { return false; }
+void UringEngine::recycle(uint16_t) {}
+
+} // namespace job
+} // namespace ariash
+
+#endif
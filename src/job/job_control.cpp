@@ -8,7 +8,11 @@
 
 #include "job/job_control.hpp"
 #include "job/stream_controller.hpp"
+#include "job/spawn_engine.hpp"
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -19,8 +23,9 @@
 #include <sys/ioctl.h>
 #include <termios.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
 #ifdef __linux__
-#include <sys/syscall.h>
 #include <sys/epoll.h>
 #endif
 #endif
@@ -133,15 +138,24 @@ bool JobManager::initialize() {
 
 void JobManager::shutdown() {
     // Terminate all jobs
-    std::lock_guard<std::mutex> lock(jobsMutex);
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
 
-    for (auto& pair : jobs) {
-        if (pair.second->state != JobState::TERMINATED) {
-            terminate(pair.first, true);  // Force kill
+        for (auto& pair : shard.jobs) {
+            if (pair.second->state != JobState::TERMINATED) {
+                // Force kill (not terminate(): it would re-lock the shard)
+#ifndef _WIN32
+                sendSignal(pair.second.get(), SIGKILL);
+#else
+                if (pair.second->jobObject != INVALID_HANDLE_VALUE) {
+                    TerminateJobObject(pair.second->jobObject, 1);
+                }
+#endif
+            }
         }
-    }
 
-    jobs.clear();
+        shard.jobs.clear();
+    }
 
 #ifndef _WIN32
     // Restore terminal modes (only if we have a TTY)
@@ -159,130 +173,253 @@ void JobManager::shutdown() {
 }
 
 uint32_t JobManager::spawn(const SpawnOptions& options) {
-    std::lock_guard<std::mutex> lock(jobsMutex);
+    return spawnPipeline({options});
+}
 
-    uint32_t jobId = nextJobId++;
+uint32_t JobManager::spawnPipeline(const std::vector<SpawnOptions>& stages) {
+    if (stages.empty()) {
+        return 0;
+    }
 
-    auto jcb = std::make_unique<JobControlBlock>();
+    // No lock while spawning: the job is private to this call until it
+    // is published in its shard below
+    const SpawnOptions& lead = stages.front();
+    uint32_t jobId = nextJobId.fetch_add(1, std::memory_order_relaxed);
+
+    auto jcb = std::make_shared<JobControlBlock>();
     jcb->jobId = jobId;
-    jcb->command = options.command;
-    jcb->state = options.background ? JobState::BACKGROUND : JobState::FOREGROUND;
+    jcb->launchNs = steadyNanos();
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (i > 0) jcb->command += " | ";
+        jcb->command += stages[i].command;
+    }
+    jcb->state = lead.background ? JobState::BACKGROUND : JobState::FOREGROUND;
     jcb->startTime = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()
     ).count();
 
+    // Placements are resolved before anything is created; the first
+    // stage confined to a NUMA node decides where the shell serves the job
+    std::vector<std::unique_ptr<PlacementPlan>> placements;
+    placements.reserve(stages.size());
+    const PlacementPlan* servicePlan = nullptr;
+    for (const auto& stage : stages) {
+        auto plan = std::make_unique<PlacementPlan>();
+        if (!plan->prepare(stage.placement)) {
+            return 0;
+        }
+        if (!servicePlan && plan->serviceNode() >= 0) {
+            servicePlan = plan.get();
+        }
+        placements.push_back(std::move(plan));
+    }
+
     // Create stream controller
     jcb->streams = std::make_unique<StreamController>();
+    jcb->streams->configureStreams(lead.streamOptions);
     if (!jcb->streams->createPipes()) {
         return 0;
     }
-
-#ifndef _WIN32
-    pid_t pid = fork();
-    if (pid < 0) {
-        return 0;  // Fork failed
+    if (lead.parseTelemetry) {
+        jcb->telemetry = getTelemetryRegistry().attach(jobId, jcb->command);
+        jcb->streams->parseTelemetry(jcb->telemetry);
     }
 
-    if (pid == 0) {
-        // Child process
-
-        // Create new process group
-        if (options.createPipeGroup) {
-            setpgid(0, 0);
+#ifndef _WIN32
+    // Inter-stage pipes: links[i] carries stage i's stdout to stage i+1's
+    // stdin. O_CLOEXEC keeps every stage from holding the other ends open.
+    std::vector<std::array<int, 2>> links(stages.size() - 1, {-1, -1});
+    auto closeLinks = [&links]() {
+        for (auto& link : links) {
+            for (int& fd : link) {
+                if (fd >= 0) {
+                    ::close(fd);
+                    fd = -1;
+                }
+            }
         }
+    };
 
-        // If foreground, take control of TTY
-        if (!options.background) {
-            tcsetpgrp(ttyFd, getpid());
+    for (auto& link : links) {
+#ifdef __linux__
+        if (pipe2(link.data(), O_CLOEXEC) < 0) {
+#else
+        if (pipe(link.data()) < 0 ||
+            fcntl(link[0], F_SETFD, FD_CLOEXEC) < 0 ||
+            fcntl(link[1], F_SETFD, FD_CLOEXEC) < 0) {
+#endif
+            closeLinks();
+            return 0;
         }
+    }
 
-        // Restore default signal handlers
-        signal(SIGINT, SIG_DFL);
-        signal(SIGQUIT, SIG_DFL);
-        signal(SIGTSTP, SIG_DFL);
-        signal(SIGTTIN, SIG_DFL);
-        signal(SIGTTOU, SIG_DFL);
-        signal(SIGCHLD, SIG_DFL);
+    pid_t pgid = 0;  // Set by the first stage
 
-        // Setup pipes for child
-        jcb->streams->setupChild();
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const SpawnOptions& options = stages[i];
 
-        // Build argv
-        std::vector<const char*> argv;
-        argv.push_back(options.command.c_str());
+        // argv is built up front: the child shares this memory until it
+        // execs and must not allocate
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(options.command.c_str()));
         for (const auto& arg : options.args) {
-            argv.push_back(arg.c_str());
+            argv.push_back(const_cast<char*>(arg.c_str()));
         }
         argv.push_back(nullptr);
 
-        // Execute
-        execvp(options.command.c_str(), const_cast<char**>(argv.data()));
+        SpawnRequest request;
+        request.path = options.command.c_str();
+        request.argv = argv.data();
+        request.searchPath = true;
+        request.resetSignals = true;
+        if (!options.placement.empty()) {
+            request.placement = placements[i].get();
+        }
 
-        // If exec fails
-        _exit(127);
-    }
+        // Join the pipeline's process group (the first stage leads it)
+        request.setProcessGroup = lead.createPipeGroup;
+        request.pgid = pgid;
 
-    // Parent process
-    ProcessHandle ph;
-    ph.pid = pid;
+        // If foreground, take control of TTY
+        if (!lead.background) {
+            request.ttyFd = ttyFd;
+        }
 
-#ifdef __linux__
-    // Get pidfd for race-free process management
-    ph.pidfd = syscall(SYS_pidfd_open, pid, 0);
+        // Six-stream layout, then splice this stage into the chain
+        jcb->streams->getChildFds(request.fdMap);
+        if (i > 0) {
+            request.fdMap[STDIN_FILENO] = links[i - 1][0];
+        }
+        if (i + 1 < stages.size()) {
+            request.fdMap[STDOUT_FILENO] = links[i][1];
+        }
+        // An explicit redirection beats the pipe, as in sh
+        for (const auto& redirect : options.redirects) {
+            request.fdMap[static_cast<int>(redirect.stream)] = redirect.fd;
+        }
+
+        SpawnResult child = spawnProcess(request);
+        pid_t pid = child.pid;
+        if (pid < 0) {
+            // Spawn failed - tear down the stages already running
+            for (auto& proc : jcb->processes) {
+                kill(proc.pid, SIGKILL);
+                waitpid(proc.pid, nullptr, 0);
+                proc.close();
+            }
+            closeLinks();
+            return 0;
+        }
 
-    // Register with epoll
-    if (ph.pidfd >= 0 && impl->epollFd >= 0) {
-        struct epoll_event ev;
-        ev.events = EPOLLIN;
-        ev.data.u32 = jobId;
-        epoll_ctl(impl->epollFd, EPOLL_CTL_ADD, ph.pidfd, &ev);
+        // Parent process
+        if (pgid == 0) {
+            pgid = pid;
+        }
+        // Also set from the parent so the group exists before we signal it
+        if (lead.createPipeGroup) {
+            setpgid(pid, pgid);
+        }
+
+        ProcessHandle ph;
+        ph.pid = pid;
+        ph.pidfd = child.pidfd;  // Race-free process management
+        jcb->processes.push_back(ph);
     }
-#endif
 
-    jcb->processes.push_back(ph);
-    jcb->pgid = pid;
+    // Only the stages hold the inter-stage pipes now
+    closeLinks();
+    for (auto& plan : placements) {
+        CgroupLease lease = plan->takeCgroupLease();
+        if (!lease.empty()) {
+            jcb->cgroupLeases.push_back(std::move(lease));
+        }
+    }
+    jcb->pgid = pgid;
 
     // Setup parent side of pipes
     jcb->streams->setupParent();
+    if (servicePlan) {
+        jcb->streams->setServiceCpus(servicePlan->serviceCpus());
+        jcb->serviceLease = std::make_unique<ServiceNodeLease>(servicePlan->serviceNode());
+    }
     jcb->streams->startDraining();
 
     // If foreground and we have a TTY, save terminal modes
-    if (!options.background && hasTty) {
+    if (!lead.background && hasTty) {
         tcgetattr(ttyFd, &jcb->savedModes);
         jcb->hasSavedModes = true;
-        tcsetpgrp(ttyFd, pid);
+        tcsetpgrp(ttyFd, pgid);
     }
 
-    jcb->streams->setForegroundMode(!options.background);
+    jcb->streams->setForegroundMode(!lead.background);
 
 #endif  // !_WIN32
 
-    jobs[jobId] = std::move(jcb);
+    // Everything up to here is the shell's share of the job's latency
+    jcb->spawnSeconds = static_cast<double>(steadyNanos() - jcb->launchNs) / 1e9;
+    getLatencyMetrics().record(kSpawnLatencyMetric, MetricKind::HISTOGRAM, jcb->spawnSeconds * 1e6);
+
+    JobControlBlock* job = jcb.get();
+    {
+        JobShard& shard = shardFor(jobId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.jobs[jobId] = std::move(jcb);
+    }
+
+#ifdef __linux__
+    // Register with epoll once the job can be looked up (every stage
+    // reports under the same job)
+    if (impl->epollFd >= 0) {
+        for (const auto& proc : job->processes) {
+            if (proc.pidfd < 0) continue;
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.u32 = jobId;
+            epoll_ctl(impl->epollFd, EPOLL_CTL_ADD, proc.pidfd, &ev);
+        }
+    }
+#else
+    (void)job;
+#endif
     return jobId;
 }
 
 JobControlBlock* JobManager::getJob(uint32_t jobId) {
-    std::lock_guard<std::mutex> lock(jobsMutex);
-    auto it = jobs.find(jobId);
-    return (it != jobs.end()) ? it->second.get() : nullptr;
+    return holdJob(jobId).get();
+}
+
+std::shared_ptr<JobControlBlock> JobManager::holdJob(uint32_t jobId) const {
+    const JobShard& shard = shardFor(jobId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.jobs.find(jobId);
+    return (it != shard.jobs.end()) ? it->second : nullptr;
+}
+
+std::vector<std::shared_ptr<JobControlBlock>> JobManager::snapshotJobs() const {
+    std::vector<std::shared_ptr<JobControlBlock>> result;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& pair : shard.jobs) {
+            result.push_back(pair.second);
+        }
+    }
+    return result;
 }
 
 std::vector<uint32_t> JobManager::getActiveJobs() const {
-    std::lock_guard<std::mutex> lock(jobsMutex);
     std::vector<uint32_t> result;
-    for (const auto& pair : jobs) {
-        if (pair.second->state != JobState::TERMINATED) {
-            result.push_back(pair.first);
+    for (const auto& job : snapshotJobs()) {
+        if (job->state != JobState::TERMINATED) {
+            result.push_back(job->jobId);
         }
     }
     return result;
 }
 
 JobControlBlock* JobManager::getForegroundJob() {
-    std::lock_guard<std::mutex> lock(jobsMutex);
-    for (auto& pair : jobs) {
-        if (pair.second->state == JobState::FOREGROUND) {
-            return pair.second.get();
+    for (const auto& job : snapshotJobs()) {
+        if (job->state == JobState::FOREGROUND) {
+            return job.get();
         }
     }
     return nullptr;
@@ -378,25 +515,191 @@ bool JobManager::terminate(uint32_t jobId, bool force) {
 }
 
 int JobManager::wait(uint32_t jobId, uint32_t timeout_ms) {
-    auto* job = getJob(jobId);
-    if (!job) return -1;
+    int exitCode = -1;
+    if (waitJobs({jobId}, timeout_ms, &exitCode) != jobId) {
+        return -1;  // Unknown job or timeout
+    }
+    return exitCode;
+}
+
+uint32_t JobManager::waitAny(const std::vector<uint32_t>& jobIds, uint32_t timeout_ms) {
+    return waitJobs(jobIds, timeout_ms);
+}
 
+uint32_t JobManager::waitJobs(const std::vector<uint32_t>& jobIds, uint32_t timeout_ms,
+                              int* exitCode) {
     auto start = std::chrono::steady_clock::now();
 
-    while (job->state != JobState::TERMINATED) {
-        processEvents(100);
+    while (true) {
+        // Reap what has exited; sleep on the pidfds of what has not. The
+        // jobs are held until the next round, whoever removes them.
+        std::vector<std::shared_ptr<JobControlBlock>> live;
+        for (uint32_t jobId : jobIds) {
+            std::shared_ptr<JobControlBlock> job = holdJob(jobId);
+            if (!job) continue;
+            reapJob(job.get());
+            {
+                std::lock_guard<std::mutex> lock(job->reapMutex);
+                if (job->state == JobState::TERMINATED) {
+                    if (exitCode) {
+                        *exitCode = job->exitCode;
+                    }
+                    return jobId;
+                }
+            }
+            live.push_back(std::move(job));
+        }
+        if (live.empty()) {
+            return 0;
+        }
 
+        int interval = -1;
         if (timeout_ms > 0) {
             auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::steady_clock::now() - start
             ).count();
             if (elapsed >= timeout_ms) {
-                return -1;  // Timeout
+                return 0;  // Timeout
+            }
+            interval = static_cast<int>(timeout_ms - elapsed);
+        }
+
+#ifndef _WIN32
+        // pidfds stay open until the JCB goes, so another thread reaping
+        // the same process cannot pull one from under the poll
+        std::vector<struct pollfd> pidfds;
+        bool allPidfds = true;
+        for (const auto& job : live) {
+            std::lock_guard<std::mutex> lock(job->reapMutex);
+            for (const auto& proc : job->processes) {
+                if (proc.reaped) continue;
+                if (proc.pidfd < 0) {
+                    allPidfds = false;
+                } else {
+                    pidfds.push_back({proc.pidfd, POLLIN, 0});
+                }
             }
         }
+        if (!allPidfds || pidfds.empty()) {
+            // Plain PIDs only tell us anything when asked
+            interval = interval < 0 ? 10 : std::min(interval, 10);
+        }
+        if (pidfds.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+        } else {
+            poll(pidfds.data(), pidfds.size(), interval);
+        }
+#else
+        processEvents(interval < 0 ? 100 : std::min(interval, 100));
+#endif
+    }
+}
+
+bool JobManager::removeJob(uint32_t jobId) {
+    JobShard& shard = shardFor(jobId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.jobs.find(jobId);
+    if (it == shard.jobs.end() || it->second->state != JobState::TERMINATED) {
+        return false;
+    }
+    retire(*it->second);
+    shard.jobs.erase(it);
+    return true;
+}
+
+bool JobManager::getStats(uint32_t jobId, JobStats& stats) const {
+    {
+        // A job is retired before it leaves its shard: never in neither
+        const JobShard& shard = shardFor(jobId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.jobs.find(jobId);
+        if (it != shard.jobs.end()) {
+            stats = collectStats(*it->second);
+            return true;
+        }
+    }
+    std::lock_guard<std::mutex> lock(statsMutex);
+    for (const auto& retired : retiredStats) {
+        if (retired.jobId == jobId) {
+            stats = retired;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<JobStats> JobManager::getAllStats() const {
+    // Live jobs first, then the retired ones: a job removed in between
+    // shows up twice (the retired copy wins), never not at all
+    std::vector<JobStats> result;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& pair : shard.jobs) {
+            result.push_back(collectStats(*pair.second));
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        result.insert(result.end(), retiredStats.begin(), retiredStats.end());
+    }
+
+    std::stable_sort(result.begin(), result.end(),
+                     [](const JobStats& a, const JobStats& b) { return a.jobId < b.jobId; });
+    std::vector<JobStats> unique;
+    for (auto& stats : result) {
+        if (!unique.empty() && unique.back().jobId == stats.jobId) {
+            unique.back() = std::move(stats);
+        } else {
+            unique.push_back(std::move(stats));
+        }
     }
+    return unique;
+}
 
-    return job->exitCode;
+JobStats JobManager::collectStats(const JobControlBlock& job) {
+    JobStats stats;
+    stats.jobId = job.jobId;
+    stats.command = job.command;
+    stats.state = job.state.load();
+    stats.exitCode = job.exitCode;
+    stats.processes = job.processes.size();
+    stats.usage = job.usage;
+    stats.spawnSeconds = job.spawnSeconds;
+
+    int64_t end = job.exitNs != 0 ? job.exitNs : steadyNanos();
+    stats.wallSeconds = static_cast<double>(end - job.launchNs) / 1e9;
+
+    if (job.streams) {
+        for (size_t i = 0; i < stats.streams.size(); ++i) {
+            stats.streams[i] = job.streams->getStreamStats(static_cast<StreamIndex>(i));
+        }
+        int64_t first = job.streams->getFirstDataTime();
+        if (first != 0) {
+            stats.firstByteSeconds = static_cast<double>(first - job.launchNs) / 1e9;
+        }
+    }
+    return stats;
+}
+
+void JobManager::recordFirstByte(JobControlBlock* job) {
+    if (job->firstByteRecorded || !job->streams) return;
+
+    int64_t first = job->streams->getFirstDataTime();
+    if (first == 0) return;  // Nothing yet; checked again on removal
+    job->firstByteRecorded = true;
+    getLatencyMetrics().record(kFirstByteLatencyMetric, MetricKind::HISTOGRAM,
+                               static_cast<double>(first - job->launchNs) / 1e3);
+}
+
+void JobManager::retire(JobControlBlock& job) {
+    recordFirstByte(&job);
+    JobStats stats = collectStats(job);
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    retiredStats.push_back(std::move(stats));
+    if (retiredStats.size() > kRetainedStats) {
+        retiredStats.erase(retiredStats.begin());
+    }
 }
 
 void JobManager::handleCtrlC() {
@@ -442,52 +745,67 @@ int JobManager::processEvents(uint32_t timeout_ms) {
 
 #ifdef __linux__
     if (impl->epollFd >= 0) {
-        struct epoll_event events[16];
-        int n = epoll_wait(impl->epollFd, events, 16, timeout_ms);
-
-        for (int i = 0; i < n; ++i) {
-            uint32_t jobId = events[i].data.u32;
-            auto* job = getJob(jobId);
-            if (job) {
-                reapJob(job);
-                ++count;
+        // Drain everything that is ready: a full batch means there may be
+        // more behind it, fetched without blocking
+        std::array<struct epoll_event, kEventBatch> events;
+        int timeout = static_cast<int>(timeout_ms);
+        int n;
+        do {
+            n = epoll_wait(impl->epollFd, events.data(), static_cast<int>(events.size()), timeout);
+            timeout = 0;
+
+            for (int i = 0; i < n; ++i) {
+                uint32_t jobId = events[i].data.u32;
+                if (std::shared_ptr<JobControlBlock> job = holdJob(jobId)) {
+                    reapJob(job.get());
+                    ++count;
+                }
             }
-        }
+        } while (n == static_cast<int>(events.size()));
+        return count;
     }
-#else
-    // Fallback: poll all jobs with waitpid
-    std::lock_guard<std::mutex> lock(jobsMutex);
+#endif
 
-    for (auto& pair : jobs) {
-        auto* job = pair.second.get();
+#ifndef _WIN32
+    // Fallback (no epoll, or initialize() not called): poll all jobs.
+    // Reaping runs outside the shard locks, so status callbacks may use
+    // the manager freely.
+    std::vector<std::shared_ptr<JobControlBlock>> live;
+    for (auto& job : snapshotJobs()) {
         if (job->state == JobState::TERMINATED) continue;
+        live.push_back(job);
 
-#ifndef _WIN32
-        for (auto& proc : job->processes) {
-            if (proc.pid > 0) {
-                int status;
-                pid_t result = waitpid(proc.pid, &status, WNOHANG | WUNTRACED);
-
-                if (result > 0) {
-                    if (WIFEXITED(status)) {
-                        job->exitCode = WEXITSTATUS(status);
-                        job->exitedNormally = true;
-
-                        JobState oldState = job->state.exchange(JobState::TERMINATED);
-                        notifyStatusChange(job->jobId, oldState, JobState::TERMINATED);
-                        ++count;
-                    } else if (WIFSTOPPED(status)) {
-                        job->stopSignal = WSTOPSIG(status);
-                        job->stoppedBySignal = true;
-
-                        JobState oldState = job->state.exchange(JobState::STOPPED);
-                        notifyStatusChange(job->jobId, oldState, JobState::STOPPED);
-                        ++count;
-                    }
+        JobState before = job->state.load();
+        reapJob(job.get());
+        if (job->state.load() != before) {
+            ++count;
+        }
+    }
+
+    // Nothing happened - don't spin the caller's wait loop. With a pidfd
+    // for every live process, sleep until one of them exits instead of
+    // for the whole interval.
+    if (count == 0 && timeout_ms > 0) {
+        int interval = static_cast<int>(std::min<uint32_t>(timeout_ms, 10));
+        std::vector<struct pollfd> pidfds;
+        bool allPidfds = true;
+        for (const auto& job : live) {
+            std::lock_guard<std::mutex> lock(job->reapMutex);
+            for (const auto& proc : job->processes) {
+                if (proc.reaped) continue;
+                if (proc.pidfd < 0) {
+                    allPidfds = false;
+                } else {
+                    pidfds.push_back({proc.pidfd, POLLIN, 0});
                 }
             }
         }
-#endif
+
+        if (allPidfds && !pidfds.empty()) {
+            poll(pidfds.data(), pidfds.size(), interval);
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+        }
     }
 #endif
 
@@ -570,33 +888,96 @@ bool JobManager::sendSignal(JobControlBlock* job, int signal) {
 
 void JobManager::reapJob(JobControlBlock* job) {
 #ifndef _WIN32
-    for (auto& proc : job->processes) {
-        if (proc.pid > 0) {
+    // Transitions are announced once the lock is dropped: a callback may
+    // well look at (or wait on) the job again
+    std::vector<std::pair<JobState, JobState>> changes;
+    {
+        std::lock_guard<std::mutex> lock(job->reapMutex);
+        if (job->state == JobState::TERMINATED) return;
+
+        bool allReaped = true;
+
+        for (auto& proc : job->processes) {
+            if (proc.reaped) continue;
+
+            // wait4() also hands over what the process used
             int status;
-            if (waitpid(proc.pid, &status, WNOHANG) > 0) {
-                if (WIFEXITED(status)) {
-                    job->exitCode = WEXITSTATUS(status);
-                    job->exitedNormally = true;
-                } else if (WIFSIGNALED(status)) {
-                    job->exitCode = 128 + WTERMSIG(status);
+            struct rusage usage;
+            pid_t result = proc.pid > 0 ? wait4(proc.pid, &status, WNOHANG | WUNTRACED, &usage) : -1;
+
+            if (result > 0 && WIFSTOPPED(status)) {
+                job->stopSignal = WSTOPSIG(status);
+                job->stoppedBySignal = true;
+
+                JobState oldState = job->state.exchange(JobState::STOPPED);
+                if (oldState != JobState::STOPPED) {
+                    changes.emplace_back(oldState, JobState::STOPPED);
+                }
+                allReaped = false;
+                continue;
+            }
+
+            if (result > 0 && WIFEXITED(status)) {
+                proc.status = WEXITSTATUS(status);
+                job->usage.add(usage);
+            } else if (result > 0 && WIFSIGNALED(status)) {
+                proc.status = 128 + WTERMSIG(status);
+                job->usage.add(usage);
+            } else if (result == 0 || (result < 0 && errno == EINTR)) {
+                allReaped = false;  // Still running
+                continue;
+            } else {
+                proc.status = -1;   // Not our child any more (ECHILD)
+            }
+
+            proc.reaped = true;
+
+#ifdef __linux__
+            // Stop the exited pidfd from waking epoll again (the fd itself
+            // stays open: a waiter may be polling it right now)
+            if (proc.pidfd >= 0 && impl->epollFd >= 0) {
+                epoll_ctl(impl->epollFd, EPOLL_CTL_DEL, proc.pidfd, nullptr);
+            }
+#endif
+        }
+
+        if (allReaped) {
+            // Pipefail: the rightmost failing stage decides the job's status
+            job->exitCode = 0;
+            job->exitedNormally = true;
+            for (const auto& proc : job->processes) {
+                if (proc.status != 0) {
+                    job->exitCode = proc.status;
+                }
+                if (proc.status > 128 || proc.status < 0) {
                     job->exitedNormally = false;
                 }
             }
+
+            job->endTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()
+            ).count();
+            job->exitNs = steadyNanos();
+            recordFirstByte(job);
+
+            JobState oldState = job->state.exchange(JobState::TERMINATED);
+            changes.emplace_back(oldState, JobState::TERMINATED);
         }
     }
 
-    job->endTime = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()
-    ).count();
-
-    JobState oldState = job->state.exchange(JobState::TERMINATED);
-    notifyStatusChange(job->jobId, oldState, JobState::TERMINATED);
+    for (const auto& change : changes) {
+        notifyStatusChange(job->jobId, change.first, change.second);
+    }
 #endif
 }
 
 void JobManager::cleanupJob(uint32_t jobId) {
-    std::lock_guard<std::mutex> lock(jobsMutex);
-    jobs.erase(jobId);
+    JobShard& shard = shardFor(jobId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.jobs.find(jobId);
+    if (it == shard.jobs.end()) return;
+    retire(*it->second);
+    shard.jobs.erase(it);
 }
 
 // =============================================================================
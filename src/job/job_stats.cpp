@@ -0,0 +1,137 @@
+/**
+ * AriaSH Job Statistics Implementation
+ */
+
+#include "job/job_stats.hpp"
+#include "job/stream_controller.hpp"
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+namespace ariash {
+namespace job {
+
+#ifndef _WIN32
+void ResourceUsage::add(const struct rusage& usage) {
+    userSeconds += static_cast<double>(usage.ru_utime.tv_sec) + usage.ru_utime.tv_usec / 1e6;
+    systemSeconds += static_cast<double>(usage.ru_stime.tv_sec) + usage.ru_stime.tv_usec / 1e6;
+    if (static_cast<uint64_t>(usage.ru_maxrss) > maxRssKb) {
+        maxRssKb = static_cast<uint64_t>(usage.ru_maxrss);  // KiB on Linux
+    }
+    voluntarySwitches += static_cast<uint64_t>(usage.ru_nvcsw);
+    involuntarySwitches += static_cast<uint64_t>(usage.ru_nivcsw);
+}
+#endif
+
+int64_t steadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TelemetryMetrics& getLatencyMetrics() {
+    static TelemetryMetrics metrics;
+    return metrics;
+}
+
+// =============================================================================
+// JSON dump
+// =============================================================================
+
+static void writeString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (byte < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", byte);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+static void writeNumber(std::ostream& out, double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", value);
+    out << text;
+}
+
+static void writeJob(std::ostream& out, const JobStats& stats) {
+    out << "{\"id\":" << stats.jobId << ",\"command\":";
+    writeString(out, stats.command);
+    out << ",\"state\":\"" << jobStateName(stats.state) << "\""
+        << ",\"exit\":" << stats.exitCode
+        << ",\"processes\":" << stats.processes
+        << ",\"wall_s\":";
+    writeNumber(out, stats.wallSeconds);
+    out << ",\"spawn_s\":";
+    writeNumber(out, stats.spawnSeconds);
+    out << ",\"first_byte_s\":";
+    if (stats.firstByteSeconds < 0) {
+        out << "null";
+    } else {
+        writeNumber(out, stats.firstByteSeconds);
+    }
+    out << ",\"user_s\":";
+    writeNumber(out, stats.usage.userSeconds);
+    out << ",\"sys_s\":";
+    writeNumber(out, stats.usage.systemSeconds);
+    out << ",\"max_rss_kb\":" << stats.usage.maxRssKb
+        << ",\"voluntary_switches\":" << stats.usage.voluntarySwitches
+        << ",\"involuntary_switches\":" << stats.usage.involuntarySwitches
+        << ",\"streams\":{";
+
+    // Output streams only: the shell writes the input ones
+    bool first = true;
+    for (StreamIndex stream : {StreamIndex::STDOUT, StreamIndex::STDERR,
+                               StreamIndex::STDDBG, StreamIndex::STDDATO}) {
+        const StreamStats& s = stats.streams[static_cast<size_t>(stream)];
+        out << (first ? "" : ",") << "\"" << streamIndexName(stream) << "\":{\"bytes\":"
+            << s.bytes << ",\"dropped\":" << s.dropped << "}";
+        first = false;
+    }
+    out << "}}";
+}
+
+static void writeHistogram(std::ostream& out, const TelemetrySnapshot& latency, const char* name) {
+    const MetricSnapshot* found = nullptr;
+    for (const auto& metric : latency.metrics) {
+        if (metric.name == name) found = &metric;
+    }
+
+    out << "\"" << name << "\":{\"count\":" << (found ? found->count : 0);
+    if (found && found->count > 0) {
+        out << ",\"mean\":";
+        writeNumber(out, found->sum / static_cast<double>(found->count));
+        static const std::pair<const char*, double> quantiles[] = {
+            {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}};
+        for (const auto& [label, q] : quantiles) {
+            out << ",\"" << label << "\":";
+            writeNumber(out, found->quantile(q));
+        }
+        out << ",\"max\":";
+        writeNumber(out, found->max);
+    }
+    out << "}";
+}
+
+void writeJobStatsJson(std::ostream& out, const std::vector<JobStats>& jobs,
+                       const TelemetrySnapshot& latency) {
+    out << "{\"jobs\":[";
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (i > 0) out << ",";
+        writeJob(out, jobs[i]);
+    }
+    out << "],\"latency\":{";
+    writeHistogram(out, latency, kSpawnLatencyMetric);
+    out << ",";
+    writeHistogram(out, latency, kFirstByteLatencyMetric);
+    out << "}}" << std::endl;
+}
+
+} // namespace job
+} // namespace ariash
@@ -0,0 +1,495 @@
+/**
+ * AriaSH Job Placement Implementation
+ */
+
+#include "job/placement.hpp"
+#include "job/io_reactor.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <map>
+#include <mutex>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+namespace ariash {
+namespace job {
+
+// =============================================================================
+// CPU and node lists
+// =============================================================================
+
+bool parseCpuList(std::string_view text, std::vector<int>& cpus) {
+    cpus.clear();
+    while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) {
+        text.remove_suffix(1);
+    }
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view range = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+
+        int first = 0;
+        int last = 0;
+        const char* end = range.data() + range.size();
+        auto parsed = std::from_chars(range.data(), end, first);
+        if (parsed.ec != std::errc() || first < 0) {
+            return false;
+        }
+        last = first;
+        if (parsed.ptr != end) {
+            if (*parsed.ptr != '-') {
+                return false;
+            }
+            parsed = std::from_chars(parsed.ptr + 1, end, last);
+            if (parsed.ec != std::errc() || parsed.ptr != end || last < first) {
+                return false;
+            }
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return true;
+}
+
+#ifndef _WIN32
+// Contents of a small sysfs / cgroupfs file
+static bool readSmallFile(const std::string& path, std::string& text) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char buffer[4096];
+    ssize_t n;
+    do {
+        n = ::read(fd, buffer, sizeof(buffer));
+    } while (n < 0 && errno == EINTR);
+    int saved = errno;
+    ::close(fd);
+    if (n < 0) {
+        errno = saved;
+        return false;
+    }
+    text.assign(buffer, static_cast<size_t>(n));
+    return true;
+}
+
+// Replace the contents of an existing file (no O_CREAT: cgroupfs files)
+static bool writeSmallFile(const std::string& path, const std::string& text) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t written = ::write(fd, text.data(), text.size());
+    int saved = errno;
+    ::close(fd);
+    if (written != static_cast<ssize_t>(text.size())) {
+        errno = written < 0 ? saved : EIO;
+        return false;
+    }
+    return true;
+}
+#endif
+
+static constexpr const char* kNodeSysfs = "/sys/devices/system/node";
+
+bool numaNodeCpus(int node, std::vector<int>& cpus) {
+#ifndef _WIN32
+    std::string text;
+    if (node >= 0 &&
+        readSmallFile(std::string(kNodeSysfs) + "/node" + std::to_string(node) + "/cpulist", text)) {
+        return parseCpuList(text, cpus);
+    }
+    // Kernels without NUMA support have no node directory: node 0 is
+    // every CPU there is
+    struct stat st;
+    if (node == 0 && stat(kNodeSysfs, &st) != 0 &&
+        readSmallFile("/sys/devices/system/cpu/online", text)) {
+        return parseCpuList(text, cpus);
+    }
+#endif
+    (void)node;
+    cpus.clear();
+    return false;
+}
+
+int numaNodeOf(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return -1;
+    }
+#ifndef _WIN32
+    std::string text;
+    std::vector<int> nodes;
+    if (!readSmallFile(std::string(kNodeSysfs) + "/online", text) || !parseCpuList(text, nodes)) {
+        nodes = {0};
+    }
+    int found = -1;
+    std::vector<int> nodeCpus;
+    for (int node : nodes) {
+        if (!numaNodeCpus(node, nodeCpus)) continue;
+        bool within = std::all_of(cpus.begin(), cpus.end(), [&nodeCpus](int cpu) {
+            return std::binary_search(nodeCpus.begin(), nodeCpus.end(), cpu);
+        });
+        if (within) {
+            if (found >= 0) return -1;  // Overlapping lists: ambiguous
+            found = node;
+        }
+    }
+    return found;
+#else
+    return -1;
+#endif
+}
+
+// =============================================================================
+// PlacementPlan
+// =============================================================================
+
+#ifdef __linux__
+// uapi values (linux/mempolicy.h, linux/ioprio.h; libc has no wrappers)
+static constexpr int kMpolPreferred = 1;
+static constexpr int kIoprioWhoProcess = 1;
+static constexpr int kIoprioClassShift = 13;
+
+// cgroup directories the shell created, and the leases holding each
+struct CreatedCgroups {
+    std::mutex mutex;
+    std::map<std::string, size_t> holders;
+};
+
+static CreatedCgroups& createdCgroups() {
+    static CreatedCgroups* created = new CreatedCgroups();  // Leases may outlive main()
+    return *created;
+}
+
+// cgroup v2 directory of `name`, created (with its parents) if needed;
+// `lease` holds every directory on the path the shell created
+static bool makeCgroup(const std::string& name, std::string& path, std::vector<std::string>& lease) {
+    path = name.front() == '/' ? name : "/sys/fs/cgroup/" + name;
+    CreatedCgroups& created = createdCgroups();
+    std::lock_guard<std::mutex> lock(created.mutex);
+    for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        std::string prefix = path.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0755) == 0) {
+            created.holders.emplace(prefix, 0);
+        } else if (errno != EEXIST) {
+            return false;
+        }
+        auto it = created.holders.find(prefix);
+        if (it != created.holders.end()) {
+            ++it->second;
+            lease.insert(lease.begin(), prefix);
+        }
+        if (slash == std::string::npos) break;
+    }
+    return true;
+}
+
+// Write a controller's limit, enabling the controller for the leaf (in
+// its parent's cgroup.subtree_control) if its files are missing
+static bool writeCgroupLimit(const std::string& path, const char* controller,
+                             const char* file, const std::string& value) {
+    std::string target = path + "/" + file;
+    if (writeSmallFile(target, value)) {
+        return true;
+    }
+    if (errno != ENOENT) {
+        return false;
+    }
+    std::string parent = path.substr(0, path.rfind('/'));
+    if (!writeSmallFile(parent + "/cgroup.subtree_control", std::string("+") + controller)) {
+        return false;
+    }
+    return writeSmallFile(target, value);
+}
+#endif
+
+CgroupLease& CgroupLease::operator=(CgroupLease&& other) noexcept {
+    if (this != &other) {
+        release();
+        dirs_ = std::move(other.dirs_);
+        other.dirs_.clear();
+    }
+    return *this;
+}
+
+void CgroupLease::release() {
+#ifdef __linux__
+    if (dirs_.empty()) {
+        return;
+    }
+    CreatedCgroups& created = createdCgroups();
+    std::lock_guard<std::mutex> lock(created.mutex);
+    for (const std::string& dir : dirs_) {
+        auto it = created.holders.find(dir);
+        if (it != created.holders.end() && --it->second == 0) {
+            created.holders.erase(it);
+            rmdir(dir.c_str());  // EBUSY: something else still lives there
+        }
+    }
+#endif
+    dirs_.clear();
+}
+
+PlacementPlan::~PlacementPlan() {
+#ifdef __linux__
+    if (cgroupProcsFd_ >= 0) {
+        ::close(cgroupProcsFd_);
+    }
+#endif
+}
+
+bool PlacementPlan::prepare(const Placement& placement) {
+    if (placement.empty()) {
+        return true;
+    }
+#ifdef __linux__
+    // Allowed CPUs: the node's, narrowed by an explicit set
+    std::vector<int> allowed = placement.cpus;
+    if (placement.numaNode >= 0) {
+        std::vector<int> nodeCpus;
+        if (placement.numaNode >= static_cast<int>(sizeof(nodeMask_) * 8) ||
+            !numaNodeCpus(placement.numaNode, nodeCpus)) {
+            errno = ENOENT;
+            return false;
+        }
+        if (allowed.empty()) {
+            allowed = nodeCpus;
+        } else {
+            std::erase_if(allowed, [&nodeCpus](int cpu) {
+                return !std::binary_search(nodeCpus.begin(), nodeCpus.end(), cpu);
+            });
+            if (allowed.empty()) {
+                errno = EINVAL;  // None of the CPUs is on the node
+                return false;
+            }
+        }
+        setMemoryPolicy_ = true;
+        nodeMask_[placement.numaNode / (8 * sizeof(unsigned long))] |=
+            1UL << (placement.numaNode % (8 * sizeof(unsigned long)));
+    }
+    if (!allowed.empty()) {
+        CPU_ZERO(&cpus_);
+        for (int cpu : allowed) {
+            if (cpu < 0 || cpu >= CPU_SETSIZE) {
+                errno = EINVAL;
+                return false;
+            }
+            CPU_SET(cpu, &cpus_);
+        }
+        setAffinity_ = true;
+    }
+
+    serviceNode_ = placement.numaNode >= 0 ? placement.numaNode : numaNodeOf(allowed);
+    if (serviceNode_ >= 0) {
+        numaNodeCpus(serviceNode_, serviceCpus_);
+    }
+
+    if (placement.nice) {
+        if (*placement.nice < -20 || *placement.nice > 19) {
+            errno = EINVAL;
+            return false;
+        }
+        setNice_ = true;
+        nice_ = *placement.nice;
+    }
+
+    if (placement.ioClass != IoPriorityClass::INHERIT) {
+        int level = placement.ioClass == IoPriorityClass::IDLE ? 0 : placement.ioLevel;
+        if (level < 0 || level > 7) {
+            errno = EINVAL;
+            return false;
+        }
+        // INHERIT..IDLE line up with IOPRIO_CLASS_NONE..IOPRIO_CLASS_IDLE
+        ioPriority_ = (static_cast<int>(placement.ioClass) << kIoprioClassShift) | level;
+    }
+
+    if (!placement.cgroup.empty()) {
+        std::string path;
+        if (!makeCgroup(placement.cgroup, path, cgroupLease_.dirs_)) {
+            return false;
+        }
+        if (placement.cpuQuotaUs > 0 &&
+            !writeCgroupLimit(path, "cpu", "cpu.max",
+                              std::to_string(placement.cpuQuotaUs) + " " +
+                              std::to_string(placement.cpuPeriodUs))) {
+            return false;
+        }
+        if (placement.memoryMax > 0 &&
+            !writeCgroupLimit(path, "memory", "memory.max", std::to_string(placement.memoryMax))) {
+            return false;
+        }
+        cgroupProcsFd_ = ::open((path + "/cgroup.procs").c_str(), O_WRONLY | O_CLOEXEC);
+        if (cgroupProcsFd_ < 0) {
+            return false;
+        }
+    }
+    return true;
+#else
+    errno = ENOSYS;
+    return false;
+#endif
+}
+
+int PlacementPlan::applyInChild() const {
+#ifdef __linux__
+    // Join the cgroup first, so the limits cover everything after it
+    if (cgroupProcsFd_ >= 0 && ::write(cgroupProcsFd_, "0", 1) < 0) {
+        return errno;
+    }
+    if (setAffinity_ && sched_setaffinity(0, sizeof(cpus_), &cpus_) < 0) {
+        return errno;
+    }
+    // Without NUMA support there is nothing to prefer
+    if (setMemoryPolicy_ &&
+        syscall(SYS_set_mempolicy, kMpolPreferred, nodeMask_, sizeof(nodeMask_) * 8 + 1) < 0 &&
+        errno != ENOSYS) {
+        return errno;
+    }
+    if (setNice_ && setpriority(PRIO_PROCESS, 0, nice_) < 0) {
+        return errno;
+    }
+    if (ioPriority_ >= 0 && syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, ioPriority_) < 0) {
+        return errno;
+    }
+#endif
+    return 0;
+}
+
+// =============================================================================
+// Service threads
+// =============================================================================
+
+#ifdef __linux__
+// The shell's own CPU set, taken before anything was pinned
+static const cpu_set_t& shellCpus() {
+    static const cpu_set_t cpus = [] {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) < 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) CPU_SET(cpu, &set);
+        }
+        return set;
+    }();
+    return cpus;
+}
+
+// `cpus` as a mask (empty: the shell's own set)
+static cpu_set_t cpuMask(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return shellCpus();
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return set;
+}
+#endif
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set = cpuMask(cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+bool pinThread(std::thread& thread, const std::vector<int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set = cpuMask(cpus);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    (void)thread;
+    (void)cpus;
+    return false;
+#endif
+}
+
+namespace {
+
+// Leases by node, and the node the reactor was last pinned to
+struct ReactorPlacement {
+    std::mutex mutex;
+    std::map<int, size_t> leases;
+    int node = -1;
+
+    void update() {
+        int best = -1;
+        size_t most = 0;
+        for (const auto& [leaseNode, count] : leases) {
+            if (count > most) {  // Map order: ties go to the lowest node
+                best = leaseNode;
+                most = count;
+            }
+        }
+        if (best == node) {
+            return;
+        }
+        std::vector<int> cpus;
+        if (best >= 0 && !numaNodeCpus(best, cpus)) {
+            return;
+        }
+        if (getIoReactor().setAffinity(cpus)) {
+            node = best;
+        }
+    }
+};
+
+ReactorPlacement& reactorPlacement() {
+    static ReactorPlacement placement;
+    return placement;
+}
+
+} // namespace
+
+ServiceNodeLease::ServiceNodeLease(int node) : node_(node) {
+    if (node_ < 0) {
+        return;
+    }
+#ifdef __linux__
+    (void)shellCpus();  // Record it before the first pin
+#endif
+    ReactorPlacement& placement = reactorPlacement();
+    std::lock_guard<std::mutex> lock(placement.mutex);
+    ++placement.leases[node_];
+    placement.update();
+}
+
+ServiceNodeLease::~ServiceNodeLease() {
+    if (node_ < 0) {
+        return;
+    }
+    ReactorPlacement& placement = reactorPlacement();
+    std::lock_guard<std::mutex> lock(placement.mutex);
+    auto it = placement.leases.find(node_);
+    if (it != placement.leases.end() && --it->second == 0) {
+        placement.leases.erase(it);
+    }
+    placement.update();
+}
+
+int ServiceNodeLease::reactorNode() {
+    ReactorPlacement& placement = reactorPlacement();
+    std::lock_guard<std::mutex> lock(placement.mutex);
+    return placement.node;
+}
+
+} // namespace job
+} // namespace ariash
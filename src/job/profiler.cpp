@@ -0,0 +1,343 @@
+/**
+ * AriaSH Profiler Implementation
+ */
+
+#include "job/profiler.hpp"
+#include "job/job_stats.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+namespace ariash {
+namespace job {
+
+static constexpr uint32_t kNoParent = UINT32_MAX;
+
+struct Profiler::ThreadBuffer {
+    struct Site {
+        const char* kind;
+        std::string label;
+        size_t line;
+        size_t column;
+    };
+
+    struct Sample {
+        uint32_t site;
+        uint32_t parent;   // Enclosing sample on this thread, or kNoParent
+        int64_t start;
+        int64_t end;       // 0 while open
+    };
+
+    std::mutex mutex;  // Recording thread vs. reports and clear()
+    uint32_t threadId = 0;
+    uint64_t generation = 0;  // Bumped by clear(): open scopes go stale
+    std::vector<Site> sites;
+    std::unordered_map<const void*, uint32_t> siteIndex;
+    std::vector<Sample> samples;
+    uint32_t open = kNoParent;  // Innermost open sample
+
+    uint32_t intern(const void* key, const char* kind, std::string_view detail,
+                    size_t line, size_t column) {
+        auto found = siteIndex.find(key);
+        if (found != siteIndex.end()) {
+            const Site& site = sites[found->second];
+            // A freed node's address may come back as a different node
+            if (site.kind == kind && site.line == line && site.column == column) {
+                return found->second;
+            }
+        }
+        std::string label = kind;
+        if (!detail.empty()) {
+            label += ' ';
+            label.append(detail);
+        }
+        auto index = static_cast<uint32_t>(sites.size());
+        sites.push_back({kind, std::move(label), line, column});
+        siteIndex[key] = index;
+        return index;
+    }
+};
+
+std::atomic<bool> Profiler::active_{false};
+
+Profiler& getProfiler() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::start() {
+    active_.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::stop() {
+    active_.store(false, std::memory_order_relaxed);
+}
+
+void Profiler::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& buffer : buffers_) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->sites.clear();
+        buffer->siteIndex.clear();
+        buffer->samples.clear();
+        buffer->open = kNoParent;
+        ++buffer->generation;
+    }
+}
+
+Profiler::ThreadBuffer& Profiler::threadBuffer() {
+    // The profiler holds a reference too, so samples outlive the thread
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer->threadId = nextThreadId_++;
+        buffers_.push_back(buffer);
+    }
+    return *buffer;
+}
+
+// =============================================================================
+// ProfileScope
+// =============================================================================
+
+void ProfileScope::begin(const void* site, const char* kind, std::string_view detail,
+                         size_t line, size_t column) {
+    Profiler::ThreadBuffer& buffer = getProfiler().threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    uint32_t index = buffer.intern(site, kind, detail, line, column);
+    sample_ = buffer.samples.size();
+    generation_ = buffer.generation;
+    buffer.samples.push_back({index, buffer.open, steadyNanos(), 0});
+    buffer.open = static_cast<uint32_t>(sample_);
+    buffer_ = &buffer;
+}
+
+void ProfileScope::end() {
+    int64_t now = steadyNanos();
+    std::lock_guard<std::mutex> lock(buffer_->mutex);
+    if (buffer_->generation != generation_) {
+        return;  // Cleared while open
+    }
+    auto& sample = buffer_->samples[sample_];
+    sample.end = now;
+    buffer_->open = sample.parent;
+}
+
+// =============================================================================
+// Reports
+// =============================================================================
+
+static void writeString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (byte < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", byte);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+// Time of each finished sample's finished children
+static std::vector<int64_t> childNanos(const Profiler::ThreadBuffer& buffer) {
+    std::vector<int64_t> children(buffer.samples.size(), 0);
+    for (const auto& sample : buffer.samples) {
+        if (sample.end != 0 && sample.parent != kNoParent) {
+            children[sample.parent] += sample.end - sample.start;
+        }
+    }
+    return children;
+}
+
+std::vector<Hotspot> Profiler::hotspots() const {
+    std::map<std::tuple<std::string, size_t, size_t>, Hotspot> merged;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& buffer : buffers_) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        std::vector<int64_t> children = childNanos(*buffer);
+        for (size_t i = 0; i < buffer->samples.size(); ++i) {
+            const auto& sample = buffer->samples[i];
+            if (sample.end == 0) {
+                continue;  // Still open
+            }
+            const auto& site = buffer->sites[sample.site];
+            Hotspot& spot = merged[{site.label, site.line, site.column}];
+            if (spot.count == 0) {
+                spot.label = site.label;
+                spot.line = site.line;
+                spot.column = site.column;
+            }
+            int64_t duration = sample.end - sample.start;
+            ++spot.count;
+            spot.totalNanos += duration;
+            spot.selfNanos += duration - children[i];
+        }
+    }
+
+    std::vector<Hotspot> result;
+    result.reserve(merged.size());
+    for (auto& entry : merged) {
+        result.push_back(std::move(entry.second));
+    }
+    std::stable_sort(result.begin(), result.end(), [](const Hotspot& a, const Hotspot& b) {
+        return a.selfNanos > b.selfNanos;
+    });
+    return result;
+}
+
+void Profiler::writeHotspots(std::ostream& out, size_t limit) const {
+    std::vector<Hotspot> spots = hotspots();
+    int64_t self = 0;
+    for (const auto& spot : spots) {
+        self += spot.selfNanos;
+    }
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "ariash profile: %zu sites, %.3f ms\n",
+                  spots.size(), static_cast<double>(self) / 1e6);
+    out << line;
+    std::snprintf(line, sizeof(line), "%10s %10s %6s %9s %8s  %s\n",
+                  "self ms", "total ms", "self%", "count", "line", "statement");
+    out << line;
+
+    for (size_t i = 0; i < spots.size() && i < limit; ++i) {
+        const Hotspot& spot = spots[i];
+        char where[32] = "-";
+        if (spot.line > 0) {
+            std::snprintf(where, sizeof(where), "%zu:%zu", spot.line, spot.column);
+        }
+        double share = self > 0 ? 100.0 * static_cast<double>(spot.selfNanos) / static_cast<double>(self) : 0.0;
+        std::snprintf(line, sizeof(line), "%10.3f %10.3f %5.1f%% %9llu %8s  ",
+                      static_cast<double>(spot.selfNanos) / 1e6,
+                      static_cast<double>(spot.totalNanos) / 1e6, share,
+                      static_cast<unsigned long long>(spot.count), where);
+        out << line << spot.label << "\n";
+    }
+    if (spots.size() > limit) {
+        out << "(" << spots.size() - limit << " more)\n";
+    }
+}
+
+void Profiler::writeChromeTrace(std::ostream& out) const {
+#ifndef _WIN32
+    long pid = static_cast<long>(getpid());
+#else
+    long pid = static_cast<long>(GetCurrentProcessId());
+#endif
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Timestamps start at the first sample
+    int64_t origin = INT64_MAX;
+    for (const auto& buffer : buffers_) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        if (!buffer->samples.empty()) {
+            origin = std::min(origin, buffer->samples.front().start);
+        }
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char number[64];
+    for (const auto& buffer : buffers_) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        for (const auto& sample : buffer->samples) {
+            if (sample.end == 0) {
+                continue;
+            }
+            const auto& site = buffer->sites[sample.site];
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            first = false;
+            writeString(out, site.label);
+            out << ",\"cat\":";
+            writeString(out, site.kind);
+            // Microseconds, keeping the nanoseconds as decimals
+            std::snprintf(number, sizeof(number), ",\"ts\":%.3f,\"dur\":%.3f",
+                          static_cast<double>(sample.start - origin) / 1e3,
+                          static_cast<double>(sample.end - sample.start) / 1e3);
+            out << ",\"ph\":\"X\"" << number << ",\"pid\":" << pid
+                << ",\"tid\":" << buffer->threadId;
+            if (site.line > 0) {
+                out << ",\"args\":{\"line\":" << site.line << ",\"column\":" << site.column << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+}
+
+// Frame name in a folded stack: ';' separates frames
+static std::string frameName(const Profiler::ThreadBuffer& buffer, uint32_t siteIndex) {
+    const auto& site = buffer.sites[siteIndex];
+    std::string frame = site.label;
+    std::replace(frame.begin(), frame.end(), ';', ',');
+    std::replace(frame.begin(), frame.end(), '\n', ' ');
+    if (site.line > 0) {
+        frame += " (" + std::to_string(site.line) + ":" + std::to_string(site.column) + ")";
+    }
+    return frame;
+}
+
+void Profiler::writeFoldedStacks(std::ostream& out) const {
+    std::map<std::string, int64_t> folded;  // Sorted, so output is stable
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& buffer : buffers_) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        std::vector<int64_t> children = childNanos(*buffer);
+
+        // Samples are stored parents first: each gets the ID of its
+        // stack, (parent stack, site) interned
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> stackIds;
+        std::vector<std::string> stackNames;
+        std::vector<int64_t> stackNanos;
+        std::vector<uint32_t> sampleStack(buffer->samples.size(), kNoParent);
+
+        for (size_t i = 0; i < buffer->samples.size(); ++i) {
+            const auto& sample = buffer->samples[i];
+            uint32_t parentStack = sample.parent == kNoParent ? kNoParent : sampleStack[sample.parent];
+            auto [it, added] = stackIds.try_emplace({parentStack, sample.site},
+                                                    static_cast<uint32_t>(stackNames.size()));
+            if (added) {
+                std::string name = parentStack == kNoParent ? std::string() : stackNames[parentStack] + ";";
+                stackNames.push_back(name + frameName(*buffer, sample.site));
+                stackNanos.push_back(0);
+            }
+            sampleStack[i] = it->second;
+            if (sample.end != 0) {
+                stackNanos[it->second] += sample.end - sample.start - children[i];
+            }
+        }
+
+        for (size_t id = 0; id < stackNames.size(); ++id) {
+            folded[stackNames[id]] += stackNanos[id];
+        }
+    }
+
+    for (const auto& [stack, nanos] : folded) {
+        int64_t micros = (nanos + 500) / 1000;
+        if (micros > 0) {
+            out << stack << " " << micros << "\n";
+        }
+    }
+}
+
+} // namespace job
+} // namespace ariash
@@ -0,0 +1,231 @@
+/**
+ * AriaSH Spawn Engine Implementation
+ *
+ * clone(CLONE_VM | CLONE_VFORK | CLONE_PIDFD) fast path with a fork()
+ * fallback. See spawn_engine.hpp.
+ */
+
+#include "job/spawn_engine.hpp"
+#include "job/placement.hpp"
+
+#ifndef _WIN32
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <termios.h>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__linux__) && !defined(CLONE_PIDFD)
+#define CLONE_PIDFD 0x00001000  // Linux 5.2+, missing from older headers
+#endif
+
+namespace ariash {
+namespace job {
+
+// =============================================================================
+// Child side
+// =============================================================================
+
+namespace {
+
+// Child stack for the vfork path. Only touched pages are ever backed, so
+// this is an upper bound for exec's own needs (execvp builds the search
+// path and the ENOEXEC fallback argv on the stack).
+constexpr size_t kChildStackSize = 256 * 1024;
+
+struct ChildContext {
+    const SpawnRequest* request;
+    sigset_t parentMask;     // Mask to restore right before exec
+    volatile int execError;  // Written by the child (shared memory on vfork)
+};
+
+bool isJobControlSignal(int sig) {
+    switch (sig) {
+        case SIGINT: case SIGQUIT: case SIGTSTP: case SIGTTIN:
+        case SIGTTOU: case SIGCHLD: case SIGPIPE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Runs between clone/fork and exec
+ *
+ * On the vfork path this shares the parent's memory while the parent is
+ * suspended: syscalls only, no allocation, no locks.
+ */
+int childMain(void* arg) {
+    auto* ctx = static_cast<ChildContext*>(arg);
+    const SpawnRequest& req = *ctx->request;
+
+    // Join the pipeline's process group (the first stage leads it)
+    if (req.setProcessGroup) {
+        setpgid(0, req.pgid);
+    }
+
+    // Take the terminal while every signal is still blocked, so a
+    // background caller is not stopped by SIGTTOU
+    if (req.ttyFd >= 0) {
+        tcsetpgrp(req.ttyFd, req.pgid ? req.pgid : getpid());
+    }
+
+    // The shell's handlers must never run here (they would act on the
+    // parent's memory). Ignored job-control signals are restored too when
+    // asked, as a job must not inherit the shell's SIG_IGN.
+    for (int sig = 1; sig < NSIG; ++sig) {
+        struct sigaction sa;
+        if (sigaction(sig, nullptr, &sa) < 0 || sa.sa_handler == SIG_DFL) {
+            continue;
+        }
+        if (sa.sa_handler == SIG_IGN && !(req.resetSignals && isJobControlSignal(sig))) {
+            continue;
+        }
+        sa.sa_handler = SIG_DFL;
+        sa.sa_flags = 0;
+        sigemptyset(&sa.sa_mask);
+        sigaction(sig, &sa, nullptr);
+    }
+
+    // Placement fails the spawn like exec does: the job asked for it
+    if (req.placement) {
+        int error = req.placement->applyInChild();
+        if (error != 0) {
+            ctx->execError = error;
+            _exit(127);
+        }
+    }
+
+    // Redirect FDs 0-5. A source already sitting in 0-5 would be clobbered
+    // by an earlier dup2(); move it above the hex-stream range first.
+    int source[SpawnRequest::kMaxFds];
+    for (int i = 0; i < SpawnRequest::kMaxFds; ++i) {
+        source[i] = req.fdMap[i];
+        if (source[i] >= 0 && source[i] < SpawnRequest::kMaxFds) {
+            source[i] = fcntl(source[i], F_DUPFD_CLOEXEC, SpawnRequest::kMaxFds);
+            if (source[i] < 0) _exit(1);
+        }
+    }
+    for (int i = 0; i < SpawnRequest::kMaxFds; ++i) {
+        if (source[i] >= 0 && dup2(source[i], i) < 0) _exit(1);
+    }
+    for (int i = 0; i < SpawnRequest::kMaxFds; ++i) {
+        if (source[i] >= 0) ::close(source[i]);
+    }
+    for (int fd : req.inheritFds) {
+        if (fd >= SpawnRequest::kMaxFds && fcntl(fd, F_SETFD, 0) < 0) _exit(1);
+    }
+
+    sigprocmask(SIG_SETMASK, &ctx->parentMask, nullptr);
+
+    if (req.searchPath) {
+        if (req.envp) {
+            execvpe(req.path, req.argv, req.envp);
+        } else {
+            execvp(req.path, req.argv);
+        }
+    } else {
+        if (req.envp) {
+            execve(req.path, req.argv, req.envp);
+        } else {
+            execv(req.path, req.argv);
+        }
+    }
+
+    // If exec fails
+    ctx->execError = errno;
+    _exit(127);
+}
+
+#ifdef __linux__
+// Cleared the first time the kernel rejects CLONE_PIDFD
+std::atomic<bool> cloneVforkUsable{true};
+#endif
+
+} // namespace
+
+// =============================================================================
+// Parent side
+// =============================================================================
+
+SpawnResult spawnProcess(const SpawnRequest& request) {
+    SpawnResult result;
+    ChildContext ctx;
+    ctx.request = &request;
+    ctx.execError = 0;
+
+    // Block everything so no handler runs in the child before it has reset
+    // its dispositions; the child restores this mask right before exec
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &ctx.parentMask);
+
+#ifdef __linux__
+    if (cloneVforkUsable.load(std::memory_order_relaxed)) {
+        void* stack = mmap(nullptr, kChildStackSize, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (stack != MAP_FAILED) {
+            int pidfd = -1;
+            // Returns once the child has exec'd or exited
+            pid_t pid = clone(childMain, static_cast<char*>(stack) + kChildStackSize,
+                              CLONE_VM | CLONE_VFORK | CLONE_PIDFD | SIGCHLD,
+                              &ctx, &pidfd);
+            int cloneError = errno;
+            munmap(stack, kChildStackSize);
+
+            if (pid > 0) {
+                result.pid = pid;
+                // Kernels before 5.2 ignore the flag instead of failing
+                result.pidfd = pidfd >= 0 ? pidfd
+                                          : static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+                result.error = ctx.execError;
+                pthread_sigmask(SIG_SETMASK, &ctx.parentMask, nullptr);
+                return result;
+            }
+            if (cloneError != EINVAL && cloneError != ENOSYS && cloneError != EPERM) {
+                result.error = cloneError;
+                pthread_sigmask(SIG_SETMASK, &ctx.parentMask, nullptr);
+                return result;
+            }
+            cloneVforkUsable.store(false, std::memory_order_relaxed);
+        }
+    }
+#endif
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        childMain(&ctx);  // Does not return
+    }
+
+    if (pid < 0) {
+        result.error = errno;
+    } else {
+        result.pid = pid;
+#ifdef __linux__
+        result.pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#endif
+    }
+    pthread_sigmask(SIG_SETMASK, &ctx.parentMask, nullptr);
+    return result;
+}
+
+const char* spawnEngineName() {
+#ifdef __linux__
+    if (cloneVforkUsable.load(std::memory_order_relaxed)) {
+        return "clone-vfork";
+    }
+#endif
+    return "fork";
+}
+
+} // namespace job
+} // namespace ariash
+
+#endif // !_WIN32
@@ -4,20 +4,28 @@
  * ARIA-021: Shell Job Control State Machine Design
  *
  * Implements the Threaded Draining Model for deadlock-free I/O.
- * Uses C++20 std::jthread with cooperative interruption for safe thread lifecycle.
+ * Output drains run on the shared IoReactor; splice/tee relays keep a
+ * C++20 std::jthread each (they block inside the kernel).
  */
 
 #include "job/stream_controller.hpp"
+#include "job/placement.hpp"
 #include <cstring>
 #include <algorithm>
+#include <chrono>
+#include <deque>
+#include <new>
 
 #ifdef _WIN32
 #include <windows.h>
+#include "platform/windows_bootstrap.hpp"
 #else
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <signal.h>
 #ifdef __linux__
+#include <sys/mman.h>
 #include <sys/syscall.h>
 #endif
 #endif
@@ -29,80 +37,269 @@ namespace job {
 // Ring Buffer Implementation
 // =============================================================================
 
+static size_t roundUpPow2(size_t n) {
+    if (n == 0) return 0;
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+#ifdef __linux__
+// Two adjacent views of one memfd: byte i and byte i + size alias
+static uint8_t* mapMirrored(size_t size) {
+    int fd = memfd_create("ariash-ring", MFD_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    uint8_t* base = nullptr;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        void* reserve = mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserve != MAP_FAILED) {
+            base = static_cast<uint8_t*>(reserve);
+            void* lo = mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+            void* hi = mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+            if (lo == MAP_FAILED || hi == MAP_FAILED) {
+                munmap(reserve, 2 * size);
+                base = nullptr;
+            }
+        }
+    }
+
+    ::close(fd);  // The mappings keep the memory alive
+    return base;
+}
+#endif
+
 RingBuffer::RingBuffer(size_t cap)
-    : buffer(cap), capacity(cap) {}
+    : initialCapacity(roundUpPow2(cap)), maxCapacity(roundUpPow2(cap))
+{
+    if (maxCapacity > 0 && allocate(maxCapacity, storage, mirroredStorage)) {
+        capacity.store(maxCapacity, std::memory_order_release);
+    }
+}
 
-RingBuffer::~RingBuffer() = default;
+RingBuffer::RingBuffer(size_t initialCap, size_t maxCap, bool mirrored)
+    : initialCapacity(roundUpPow2(std::min(initialCap, maxCap))),
+      maxCapacity(roundUpPow2(maxCap)), wantMirror(mirrored) {}
 
-size_t RingBuffer::write(const void* data, size_t size) {
-    size_t free = freeSpace();
-    size_t toWrite = std::min(size, free);
+RingBuffer::~RingBuffer() {
+    freeStorage(storage, capacity.load(std::memory_order_relaxed), mirroredStorage);
+    for (const auto& old : retired) {
+        freeStorage(old.data, old.capacity, old.mirrored);
+    }
+}
 
-    if (toWrite == 0) return 0;
+bool RingBuffer::allocate(size_t cap, uint8_t*& data, bool& mirrored) {
+#ifdef __linux__
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    if (wantMirror && cap % pageSize == 0) {
+        data = mapMirrored(cap);
+        if (data) {
+            mirrored = true;
+            return true;
+        }
+    }
+#endif
+    data = new (std::nothrow) uint8_t[cap];
+    mirrored = false;
+    return data != nullptr;
+}
 
+void RingBuffer::freeStorage(uint8_t* data, size_t cap, bool mirrored) {
+    if (!data) return;
+#ifdef __linux__
+    if (mirrored) {
+        munmap(data, 2 * cap);
+        return;
+    }
+#endif
+    (void)cap;
+    (void)mirrored;
+    delete[] data;
+}
+
+size_t RingBuffer::contiguous(size_t pos, size_t len) const {
+    size_t cap = capacity.load(std::memory_order_relaxed);
+    if (mirroredStorage || len == 0) return len;
+    return std::min(len, cap - (pos & (cap - 1)));
+}
+
+bool RingBuffer::grow(size_t needed) {
+    // Producer only; the consumer is locked out while storage moves
+    std::lock_guard<std::mutex> lock(resizeMutex);
+
+    size_t cap = capacity.load(std::memory_order_relaxed);
+    if (cap >= maxCapacity) return false;
+
+    size_t rpos = readPos.load(std::memory_order_acquire);
     size_t wpos = writePos.load(std::memory_order_relaxed);
-    const uint8_t* src = static_cast<const uint8_t*>(data);
+    size_t used = wpos - rpos;
+
+    size_t newCap = std::max(cap * 2, initialCapacity);
+    while (newCap < used + needed && newCap < maxCapacity) {
+        newCap *= 2;
+    }
+    newCap = std::min(newCap, maxCapacity);
+
+    uint8_t* grown = nullptr;
+    bool grownMirrored = false;
+    if (!allocate(newCap, grown, grownMirrored)) return false;
+
+    // Positions are unchanged; pending bytes move to their new masked slots
+    for (size_t pos = rpos; pos < wpos;) {
+        size_t chunk = std::min(contiguous(pos, wpos - pos),
+                                newCap - (pos & (newCap - 1)));
+        std::memcpy(grown + (pos & (newCap - 1)), storage + (pos & (cap - 1)), chunk);
+        pos += chunk;
+    }
 
-    // Write in up to two parts (wrap around)
-    size_t firstPart = std::min(toWrite, capacity - wpos);
-    std::memcpy(buffer.data() + wpos, src, firstPart);
+    if (readPinned) {
+        retired.push_back({storage, cap, mirroredStorage});  // The consumer's span
+    } else {
+        freeStorage(storage, cap, mirroredStorage);
+    }
+    storage = grown;
+    mirroredStorage = grownMirrored;
+    capacity.store(newCap, std::memory_order_release);
+    return true;
+}
 
-    if (toWrite > firstPart) {
-        std::memcpy(buffer.data(), src + firstPart, toWrite - firstPart);
+std::span<uint8_t> RingBuffer::acquireWrite(size_t minSize) {
+    if (minSize > 0 && freeSpace() < minSize) {
+        grow(minSize);
     }
 
-    writePos.store((wpos + toWrite) % capacity, std::memory_order_release);
-    return toWrite;
+    size_t cap = capacity.load(std::memory_order_relaxed);
+    if (cap == 0) return {};
+
+    size_t wpos = writePos.load(std::memory_order_relaxed);
+    size_t len = contiguous(wpos, freeSpace());
+    return {storage + (wpos & (cap - 1)), len};
 }
 
-size_t RingBuffer::read(void* data, size_t maxSize) {
-    size_t avail = available();
-    size_t toRead = std::min(maxSize, avail);
+void RingBuffer::commitWrite(size_t n) {
+    writePos.store(writePos.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
 
-    if (toRead == 0) return 0;
+std::span<const uint8_t> RingBuffer::acquireRead() {
+    std::lock_guard<std::mutex> lock(resizeMutex);
+    readPinned = true;  // Cleared by release()
 
+    size_t cap = capacity.load(std::memory_order_relaxed);
     size_t rpos = readPos.load(std::memory_order_relaxed);
-    uint8_t* dst = static_cast<uint8_t*>(data);
+    size_t avail = writePos.load(std::memory_order_acquire) - rpos;
+    if (cap == 0 || avail == 0) return {};
+
+    return {storage + (rpos & (cap - 1)), contiguous(rpos, avail)};
+}
 
-    // Read in up to two parts (wrap around)
-    size_t firstPart = std::min(toRead, capacity - rpos);
-    std::memcpy(dst, buffer.data() + rpos, firstPart);
+void RingBuffer::release(size_t n) {
+    // seq_cst pairs with requestSpace(): either we see the request or the
+    // producer sees the space we just freed
+    std::vector<RetiredStorage> unpinned;
+    {
+        std::lock_guard<std::mutex> lock(resizeMutex);
+        readPos.store(readPos.load(std::memory_order_relaxed) + n, std::memory_order_seq_cst);
+        readPinned = false;
+        unpinned.swap(retired);
+    }
+    for (const auto& old : unpinned) {
+        freeStorage(old.data, old.capacity, old.mirrored);
+    }
+
+    if (n > 0 && spaceWanted.load(std::memory_order_seq_cst) != 0) {
+        signalSpace();
+    }
+}
+
+bool RingBuffer::requestSpace(size_t bytes) {
+    size_t cap = capacity.load(std::memory_order_acquire);
+    size_t want = std::max<size_t>(1, std::min(bytes, cap / 2));
 
-    if (toRead > firstPart) {
-        std::memcpy(dst + firstPart, buffer.data(), toRead - firstPart);
+    spaceWanted.store(want, std::memory_order_seq_cst);
+    if (freeSpace() < want) {
+        return false;  // The consumer will ring
     }
 
-    readPos.store((rpos + toRead) % capacity, std::memory_order_release);
-    return toRead;
+    // Already free: take the request back. If the consumer beat us to it
+    // a notification is on its way; wait for that instead.
+    size_t expected = want;
+    return spaceWanted.compare_exchange_strong(expected, 0);
 }
 
-size_t RingBuffer::peek(void* data, size_t maxSize) const {
-    size_t avail = available();
-    size_t toPeek = std::min(maxSize, avail);
+void RingBuffer::setSpaceNotifier(std::function<void()> notifier) {
+    std::lock_guard<std::mutex> lock(notifierMutex);
+    spaceNotifier = std::move(notifier);
+}
 
-    if (toPeek == 0) return 0;
+void RingBuffer::signalSpace() {
+    size_t want = spaceWanted.load(std::memory_order_seq_cst);
+    if (want == 0 || freeSpace() < want) return;
+    if (!spaceWanted.compare_exchange_strong(want, 0)) return;  // Someone else rang
 
-    size_t rpos = readPos.load(std::memory_order_acquire);
-    uint8_t* dst = static_cast<uint8_t*>(data);
+    std::lock_guard<std::mutex> lock(notifierMutex);
+    if (spaceNotifier) spaceNotifier();
+}
 
-    size_t firstPart = std::min(toPeek, capacity - rpos);
-    std::memcpy(dst, buffer.data() + rpos, firstPart);
+size_t RingBuffer::write(const void* data, size_t size) {
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    size_t written = 0;
+
+    // Up to two parts (wrap around); the first may grow the buffer
+    while (written < size) {
+        std::span<uint8_t> span = acquireWrite(written == 0 ? size : 0);
+        if (span.empty()) break;
 
-    if (toPeek > firstPart) {
-        std::memcpy(dst + firstPart, buffer.data(), toPeek - firstPart);
+        size_t chunk = std::min(span.size(), size - written);
+        std::memcpy(span.data(), src + written, chunk);
+        commitWrite(chunk);
+        written += chunk;
     }
+    return written;
+}
 
+size_t RingBuffer::read(void* data, size_t maxSize) {
+    uint8_t* dst = static_cast<uint8_t*>(data);
+    size_t total = 0;
+
+    // Up to two parts (wrap around)
+    while (total < maxSize) {
+        std::span<const uint8_t> span = acquireRead();
+        size_t chunk = std::min(span.size(), maxSize - total);
+        if (chunk > 0) {
+            std::memcpy(dst + total, span.data(), chunk);
+        }
+        release(chunk);
+        if (chunk == 0) break;
+        total += chunk;
+    }
+    return total;
+}
+
+size_t RingBuffer::peek(void* data, size_t maxSize) const {
+    std::lock_guard<std::mutex> lock(resizeMutex);
+
+    size_t cap = capacity.load(std::memory_order_relaxed);
+    size_t rpos = readPos.load(std::memory_order_relaxed);
+    size_t toPeek = std::min(maxSize, writePos.load(std::memory_order_acquire) - rpos);
+    uint8_t* dst = static_cast<uint8_t*>(data);
+
+    for (size_t done = 0; done < toPeek;) {
+        size_t chunk = contiguous(rpos + done, toPeek - done);
+        std::memcpy(dst + done, storage + ((rpos + done) & (cap - 1)), chunk);
+        done += chunk;
+    }
     return toPeek;
 }
 
 size_t RingBuffer::available() const {
-    size_t w = writePos.load(std::memory_order_acquire);
+    // Read position first: it never passes the write position
     size_t r = readPos.load(std::memory_order_acquire);
-    return (w >= r) ? (w - r) : (capacity - r + w);
+    size_t w = writePos.load(std::memory_order_acquire);
+    return w - r;
 }
 
 size_t RingBuffer::freeSpace() const {
-    return capacity - available() - 1;  // -1 to distinguish full from empty
+    return capacity.load(std::memory_order_acquire) - available();
 }
 
 bool RingBuffer::empty() const {
@@ -110,12 +307,23 @@ bool RingBuffer::empty() const {
 }
 
 bool RingBuffer::full() const {
-    return freeSpace() == 0;
+    // A growable buffer is only full once it has reached its cap
+    return capacity.load(std::memory_order_acquire) >= maxCapacity && freeSpace() == 0;
 }
 
 void RingBuffer::clear() {
-    readPos.store(0, std::memory_order_release);
-    writePos.store(0, std::memory_order_release);
+    // Consumer side: drop everything written so far
+    {
+        std::lock_guard<std::mutex> lock(resizeMutex);
+        readPos.store(writePos.load(std::memory_order_acquire), std::memory_order_seq_cst);
+    }
+    if (spaceWanted.load(std::memory_order_seq_cst) != 0) {
+        signalSpace();
+    }
+}
+
+size_t RingBuffer::allocated() const {
+    return storage ? capacity.load(std::memory_order_acquire) : 0;
 }
 
 // =============================================================================
@@ -164,102 +372,244 @@ bool HexStreamPipes::isValid() const {
 }
 
 // =============================================================================
-// Stream Drainer Implementation (C++20 jthread)
+// Stream Drainer Implementation (IoReactor handler)
 // =============================================================================
 
-StreamDrainer::StreamDrainer(StreamIndex stream, int fd, RingBuffer* buffer, bool dropOnOverflow)
-    : stream_(stream), fd_(fd), buffer_(buffer), dropOnOverflow_(dropOnOverflow)
+// Smallest free span a read goes straight into
+static constexpr size_t kMinInPlaceRead = 1024;
+
+StreamDrainer::StreamDrainer(StreamIndex stream, IoHandle fd, RingBuffer* buffer, bool dropOnOverflow,
+                             DrainHook hook, CoalesceWindow window, size_t readChunk)
+    : stream_(stream), fd_(fd), buffer_(buffer), dropOnOverflow_(dropOnOverflow),
+      hook_(std::move(hook)), window_(window)
 {
-    // Start worker thread immediately
-    worker_ = std::jthread([this](std::stop_token stoken) {
-        drainLoop(stoken);
-    });
+    active_.store(true, std::memory_order_release);
+
+    token_ = getIoReactor().add(fd_, [this](const IoEvent& event) {
+        return onEvent(event);
+    }, readChunk, [this] { return readTarget(); });
+    if (token_ == 0) {
+        finish();  // Not drainable (bad FD): report EOF right away
+    } else if (buffer_ && !dropOnOverflow_) {
+        // A stalled drainer sleeps until the consumer frees space
+        buffer_->setSpaceNotifier([token = token_] { getIoReactor().notify(token); });
+    }
 }
 
-void StreamDrainer::drainLoop(std::stop_token stoken) {
-    active_.store(true, std::memory_order_release);
-    
-    std::vector<uint8_t> readBuffer(4096);  // 4KB local buffer
+StreamDrainer::~StreamDrainer() {
+    // Waits out an in-flight handler; after this we are never called again
+    if (token_ != 0) {
+        if (buffer_) buffer_->setSpaceNotifier(nullptr);
+        getIoReactor().remove(token_);
+    }
+    if (active_.load(std::memory_order_acquire)) {
+        finish();  // Stopped before EOF: still release the drain barrier
+    }
+}
 
-    while (!stoken.stop_requested()) {
-        struct pollfd pfd;
-        pfd.fd = fd_;
-        pfd.events = POLLIN;
+bool StreamDrainer::dueNow() const {
+    if (window_.bytes == 0 && window_.micros == 0) return true;
+    if (window_.bytes > 0 && pending_ >= window_.bytes) return true;
+    return window_.micros > 0 &&
+           Clock::now() - firstPending_ >= std::chrono::microseconds(window_.micros);
+}
 
-        // Wait up to 100ms for data (allows checking stop_token periodically)
-        int ret = poll(&pfd, 1, 100);
+void StreamDrainer::fire() {
+    if (hook_ && pending_ > 0) {
+        hook_(stream_, false);
+    }
+    pending_ = 0;
+}
 
-        if (ret < 0) {
-            if (errno == EINTR) continue;  // Signal interruption, retry
-            break;  // Fatal error
-        }
+void StreamDrainer::finish() {
+    fire();
+    active_.store(false, std::memory_order_release);
 
-        if (ret == 0) {
-            // Timeout: loop back to check stop_requested()
-            continue;
+    if (hook_) {
+        hook_(stream_, true);
+    }
+}
+
+std::span<uint8_t> StreamDrainer::readTarget() {
+    // Carried bytes must land first, and tiny wrap-around tails are not
+    // worth a syscall (the scratch path also grows the buffer)
+    if (!buffer_ || !carry_.empty()) return {};
+    std::span<uint8_t> span = buffer_->acquireWrite();
+    return span.size() >= kMinInPlaceRead ? span : std::span<uint8_t>{};
+}
+
+bool StreamDrainer::flushCarry() {
+    // BLOCK MODE: bytes we read but could not buffer go in first
+    while (!carry_.empty()) {
+        size_t chunk = buffer_->write(carry_.data(), carry_.size());
+        if (chunk == 0) {
+            // Still full: let a streaming consumer drain it (a no-op
+            // until one registers) and try once more
+            if (hook_) hook_(stream_, false);
+            pending_ = 0;
+            chunk = buffer_->write(carry_.data(), carry_.size());
+            if (chunk == 0) return false;
         }
+        if (pending_ == 0) firstPending_ = Clock::now();
+        pending_ += chunk;
+        carry_.erase(carry_.begin(), carry_.begin() + chunk);
+    }
+    return true;
+}
 
-        // Data available
-        if (pfd.revents & POLLIN) {
-            ssize_t n = read(fd_, readBuffer.data(), readBuffer.size());
-            
-            if (n > 0) {
-                // Successful read
-                size_t written = buffer_->write(readBuffer.data(), n);
-                
-                if (written < static_cast<size_t>(n)) {
-                    // Buffer full - apply overflow policy
-                    if (dropOnOverflow_) {
-                        // DROP MODE: Discard excess data (acceptable for telemetry)
-                        // Already written what we could, drop the rest
-                    } else {
-                        // BLOCK MODE: Apply backpressure
-                        size_t remaining = n - written;
-                        const uint8_t* remainingData = readBuffer.data() + written;
-                        
-                        while (remaining > 0 && !stoken.stop_requested()) {
-                            size_t chunk = buffer_->write(remainingData, remaining);
-                            if (chunk == 0) {
-                                // Still full, yield to consumer
-                                std::this_thread::yield();
-                            } else {
-                                remainingData += chunk;
-                                remaining -= chunk;
-                            }
-                        }
-                    }
-                }
-                
-                bytesTransferred_.fetch_add(n, std::memory_order_relaxed);
-            } else if (n == 0) {
-                // EOF: Child closed the pipe (normal exit)
-                break;
-            } else {
-                // Error handling
-                if (errno != EAGAIN && errno != EINTR) {
-                    break;
+IoInterest StreamDrainer::onEvent(const IoEvent& event) {
+    IoInterest next;
+
+    if (event.kind == IoEvent::Kind::END) {
+        // EOF: child closed the pipe (normal exit) or a fatal read error.
+        // io_uring may report it while we are stalled: carried bytes
+        // still go in first.
+        eof_ = true;
+    }
+
+    if (event.kind == IoEvent::Kind::DATA) {
+        if (bytesTransferred_.fetch_add(event.size, std::memory_order_relaxed) == 0) {
+            firstDataNs_.store(steadyNanos(), std::memory_order_relaxed);
+        }
+        if (!buffer_) return next;  // Unbuffered stream: discard
+
+        if (event.inPlace) {
+            // Already sitting in ring storage: just publish it
+            if (pending_ == 0) firstPending_ = Clock::now();
+            buffer_->commitWrite(event.size);
+            pending_ += event.size;
+        } else if (!carry_.empty()) {
+            // Already stalled (reads the kernel had in flight): queue behind
+            carry_.insert(carry_.end(), event.data, event.data + event.size);
+        } else {
+            if (pending_ == 0) firstPending_ = Clock::now();
+
+            size_t written = buffer_->write(event.data, event.size);
+            pending_ += written;
+
+            if (written < event.size) {
+                // Buffer full - apply overflow policy
+                if (dropOnOverflow_) {
+                    // DROP MODE: Discard excess data (acceptable for telemetry)
+                    bytesDropped_.fetch_add(event.size - written, std::memory_order_relaxed);
+                    fire();
+                } else {
+                    carry_.assign(event.data + written, event.data + event.size);
                 }
             }
         }
-        
-        if (pfd.revents & (POLLHUP | POLLERR)) {
-            // Pipe closed or error
-            break;
+    }
+
+    while (!flushCarry()) {
+        // Stalled: stop reading so the pipe applies backpressure, and
+        // sleep until the consumer frees space (NOTIFY)
+        if (!buffer_->requestSpace(carry_.size())) {
+            next.armed = false;
+            return next;
         }
     }
-    
-    active_.store(false, std::memory_order_release);
+
+    if (eof_) {
+        finish();
+        next.done = true;
+        return next;
+    }
+
+    if (pending_ > 0 && dueNow()) fire();
+
+    // An open coalescing window needs a timer to close it
+    if (pending_ > 0 && window_.micros > 0) {
+        auto age = std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - firstPending_).count();
+        next.timerUs = std::max<int64_t>(window_.micros - age, 0);
+    }
+    return next;
 }
 
+// =============================================================================
+// Callback Delivery Pool
+// =============================================================================
+
+namespace {
+
+/**
+ * Threads that run stream callbacks off the reactor thread
+ *
+ * A worker is started whenever a task finds none idle, and an idle
+ * worker exits after a few seconds, so a callback that blocks (a full
+ * terminal, a slow consumer) holds one worker and never the others'
+ * deliveries or the reactor.
+ */
+class DeliveryPool {
+public:
+    static DeliveryPool& get() {
+        static DeliveryPool* pool = new DeliveryPool();  // Immortal: workers may outlive main()
+        return *pool;
+    }
+
+    void post(std::function<void()> task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        if (tasks.size() > idle) {
+            std::thread([this] { work(); }).detach();
+        } else {
+            wakeup.notify_one();
+        }
+    }
+
+private:
+    static constexpr auto kIdleExit = std::chrono::seconds(5);
+
+    void work() {
+#ifndef _WIN32
+        // Callbacks may write to a pipe whose reader went away
+        sigset_t pipeMask;
+        sigemptyset(&pipeMask);
+        sigaddset(&pipeMask, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipeMask, nullptr);
+#endif
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            ++idle;
+            bool ready = wakeup.wait_for(lock, kIdleExit, [this] { return !tasks.empty(); });
+            --idle;
+            if (!ready) return;
+
+            std::function<void()> task = std::move(tasks.front());
+            tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<std::function<void()>> tasks;
+    size_t idle = 0;
+};
+
+} // namespace
+
 // =============================================================================
 // Stream Controller Implementation
 // =============================================================================
 
-StreamController::StreamController() {
-    // Create ring buffers for output streams (1MB each for high throughput)
-    for (int i = 0; i < static_cast<int>(StreamIndex::COUNT); ++i) {
-        buffers[i] = std::make_unique<RingBuffer>(1024 * 1024);
+StreamOptionSet defaultStreamOptions() {
+    StreamOptionSet options;
+    for (StreamIndex input : {StreamIndex::STDIN, StreamIndex::STDDATI}) {
+        options[static_cast<size_t>(input)] = StreamOptions{0, 0, 0, false};
+    }
+    for (StreamIndex bulk : {StreamIndex::STDOUT, StreamIndex::STDDATO}) {
+        options[static_cast<size_t>(bulk)].mirrored = true;
     }
+    return options;
+}
+
+StreamController::StreamController() {
+    // Ring buffers for output streams; storage arrives with the first data
+    configureStreams(streamOptions);
     
     // Initialize drainers to nullptr
     for (int i = 0; i < 4; ++i) {
@@ -279,13 +629,22 @@ bool StreamController::createPipes() {
     sa.bInheritHandle = TRUE;
     sa.lpSecurityDescriptor = NULL;
 
-    // Create pipes for each stream
     for (int i = 0; i < 6; ++i) {
-        int readIdx = i * 2;
-        int writeIdx = i * 2 + 1;
-
-        if (!CreatePipe(&pipes.handles[readIdx], &pipes.handles[writeIdx],
-                        &sa, 0)) {
+        StreamIndex stream = static_cast<StreamIndex>(i);
+        HANDLE* parentEnd = &pipes.handles[parentSlot(stream)];
+        HANDLE* childEnd = &pipes.handles[childSlot(stream)];
+
+        bool created;
+        if (stream == StreamIndex::STDIN || stream == StreamIndex::STDDATI) {
+            // The shell writes these synchronously (writeStdin)
+            created = CreatePipe(childEnd, parentEnd, &sa, 0) &&
+                      SetHandleInformation(*parentEnd, HANDLE_FLAG_INHERIT, 0);
+        } else {
+            // Output streams are drained by the IoReactor's completion
+            // port, which needs an overlapped read end
+            created = platform::createOverlappedPipe(*parentEnd, *childEnd);
+        }
+        if (!created) {
             close();
             return false;
         }
@@ -294,6 +653,11 @@ bool StreamController::createPipes() {
 #else
     // Create pipes with O_CLOEXEC for security
     for (int i = 0; i < 6; ++i) {
+        // Stream already wired to an external FD (see attachChildFd)
+        if (pipes.fds[childSlot(static_cast<StreamIndex>(i))] >= 0) {
+            continue;
+        }
+
         int pipefd[2];
 #ifdef __linux__
         if (pipe2(pipefd, O_CLOEXEC) < 0) {
@@ -312,28 +676,29 @@ bool StreamController::createPipes() {
 
 bool StreamController::setupChild() {
 #ifndef _WIN32
-    // Redirect FDs 0-5 to pipes
-    // stdin (stream 0): read from parent's write end (pipes.fds[1])
-    if (dup2(pipes.fds[1], STDIN_FILENO) < 0) return false;
-
-    // stdout (stream 1): write to parent's read end (pipes.fds[3] is write end)
-    if (dup2(pipes.fds[3], STDOUT_FILENO) < 0) return false;
-
-    // stderr (stream 2): write to parent's read end (pipes.fds[5] is write end)
-    if (dup2(pipes.fds[5], STDERR_FILENO) < 0) return false;
-
-    // stddbg (stream 3, FD 3): write to parent's read end (pipes.fds[7] is write end)
-    if (dup2(pipes.fds[7], 3) < 0) return false;
-
-    // stddati (stream 4, FD 4): read from parent's write end (pipes.fds[9])
-    if (dup2(pipes.fds[9], 4) < 0) return false;
+    // Child-side FD for each stream: the read end for input streams
+    // (stdin, stddati), the write end for output streams.
+    int source[6];
+    for (int i = 0; i < 6; ++i) {
+        source[i] = pipes.fds[childSlot(static_cast<StreamIndex>(i))];
+        if (source[i] < 0) return false;
+
+        // A source already sitting in 0-5 would be clobbered by an earlier
+        // dup2(); move it above the hex-stream range first.
+        if (source[i] < 6) {
+            source[i] = fcntl(source[i], F_DUPFD_CLOEXEC, 6);
+            if (source[i] < 0) return false;
+        }
+    }
 
-    // stddato (stream 5, FD 5): write to parent's read end (pipes.fds[11] is write end)
-    if (dup2(pipes.fds[11], 5) < 0) return false;
+    // Redirect FDs 0-5 to the pipes
+    for (int i = 0; i < 6; ++i) {
+        if (dup2(source[i], i) < 0) return false;
+    }
 
-    // Close all original pipe FDs
+    // Close all original pipe FDs (anything in 0-5 is now a stream)
     for (int i = 0; i < 12; ++i) {
-        if (pipes.fds[i] >= 0) {
+        if (pipes.fds[i] >= 6) {
             ::close(pipes.fds[i]);
         }
     }
@@ -341,71 +706,211 @@ bool StreamController::setupChild() {
     return true;
 }
 
-bool StreamController::setupParent() {
+bool StreamController::getChildFds(int (&fds)[static_cast<int>(StreamIndex::COUNT)]) const {
 #ifndef _WIN32
-    // Close child-side FDs
+    for (int i = 0; i < static_cast<int>(StreamIndex::COUNT); ++i) {
+        fds[i] = pipes.fds[childSlot(static_cast<StreamIndex>(i))];
+        if (fds[i] < 0) return false;
+    }
+    return true;
+#else
+    (void)fds;
+    return false;
+#endif
+}
 
-    // stdin: close read end (child uses it)
-    ::close(pipes.fds[0]);
-    pipes.fds[0] = -1;
+bool StreamController::getChildHandles(IoHandle (&handles)[static_cast<int>(StreamIndex::COUNT)]) const {
+#ifdef _WIN32
+    for (int i = 0; i < static_cast<int>(StreamIndex::COUNT); ++i) {
+        handles[i] = pipes.handles[childSlot(static_cast<StreamIndex>(i))];
+        if (handles[i] == INVALID_HANDLE_VALUE) return false;
+    }
+    return true;
+#else
+    (void)handles;
+    return false;
+#endif
+}
 
-    // stdout: close write end (child uses it)
-    ::close(pipes.fds[3]);
-    pipes.fds[3] = -1;
+bool StreamController::setupParent() {
+#ifdef _WIN32
+    // The child holds duplicates now: ours would keep the output pipes
+    // from ever reporting ERROR_BROKEN_PIPE
+    for (int i = 0; i < 6; ++i) {
+        int slot = childSlot(static_cast<StreamIndex>(i));
+        if (pipes.handles[slot] != INVALID_HANDLE_VALUE) {
+            CloseHandle(pipes.handles[slot]);
+            pipes.handles[slot] = INVALID_HANDLE_VALUE;
+        }
+    }
+#else
+    // Close child-side FDs: stdin/stddati read ends, every output write end
+    for (int i = 0; i < 6; ++i) {
+        int slot = childSlot(static_cast<StreamIndex>(i));
+        if (pipes.fds[slot] >= 0) {
+            ::close(pipes.fds[slot]);
+            pipes.fds[slot] = -1;
+        }
+    }
+#endif
+    return true;
+}
 
-    // stderr: close write end
-    ::close(pipes.fds[5]);
-    pipes.fds[5] = -1;
+bool StreamController::attachChildFd(StreamIndex stream, int fd) {
+#ifndef _WIN32
+    int slot = childSlot(stream);
+    if (fd < 0 || pipes.fds[slot] >= 0) {
+        return false;
+    }
+    pipes.fds[slot] = fd;
+    return true;
+#else
+    (void)stream;
+    (void)fd;
+    return false;
+#endif
+}
 
-    // stddbg: close write end
-    ::close(pipes.fds[7]);
-    pipes.fds[7] = -1;
+bool StreamController::relayTo(StreamIndex stream, int outFd, bool mirror) {
+#ifdef __linux__
+    int idx = static_cast<int>(stream);
+    if (outFd < 0 || relays[idx]) {
+        return false;
+    }
+    // Only output streams can be relayed
+    if (stream == StreamIndex::STDIN || stream == StreamIndex::STDDATI) {
+        return false;
+    }
+    relays[idx] = std::make_unique<Relay>();
+    relays[idx]->outFd = outFd;
+    relays[idx]->mirror = mirror;
+    return true;
+#else
+    (void)stream;
+    (void)outFd;
+    (void)mirror;
+    return false;
+#endif
+}
 
-    // stddati: close read end
-    ::close(pipes.fds[8]);
-    pipes.fds[8] = -1;
+int StreamController::childSlot(StreamIndex stream) {
+    int i = static_cast<int>(stream);
+    bool input = (stream == StreamIndex::STDIN || stream == StreamIndex::STDDATI);
+    return input ? i * 2 : i * 2 + 1;
+}
 
-    // stddato: close write end
-    ::close(pipes.fds[11]);
-    pipes.fds[11] = -1;
-#endif
-    return true;
+int StreamController::parentSlot(StreamIndex stream) {
+    int i = static_cast<int>(stream);
+    bool input = (stream == StreamIndex::STDIN || stream == StreamIndex::STDDATI);
+    return input ? i * 2 + 1 : i * 2;
 }
 
 bool StreamController::startDraining() {
-#ifndef _WIN32
-    // Start C++20 jthread drainers for output streams
-    
+    // Register reactor drainers for output streams
+
+    // Parent read end of an output stream: an FD, or the overlapped pipe
+    // handle createPipes() made on Windows
+    auto source = [this](StreamIndex stream) -> IoHandle {
+#ifdef _WIN32
+        return pipes.handles[parentSlot(stream)];
+#else
+        return pipes.fds[parentSlot(stream)];
+#endif
+    };
+    auto drainable = [this, &source](StreamIndex stream) {
+#ifdef _WIN32
+        bool open = source(stream) != INVALID_HANDLE_VALUE;
+#else
+        bool open = source(stream) >= 0;
+#endif
+        return open && relays[static_cast<int>(stream)] == nullptr;
+    };
+
+    // Drainers report back through the hook; the final (eof) call of each
+    // one counts down the waitForDrain() barrier
+    DrainHook hook = [this](StreamIndex stream, bool eof) {
+        onDrainerEvent(stream, eof);
+    };
+    auto track = [this](StreamIndex stream) {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        ++openDrainers;
+        draining[static_cast<int>(stream)] = true;
+    };
+
     // stdout (fd index 2) - block on overflow (user output is critical)
-    if (pipes.fds[2] >= 0) {
+    if (drainable(StreamIndex::STDOUT)) {
+        track(StreamIndex::STDOUT);
         drainers[0] = std::make_unique<StreamDrainer>(StreamIndex::STDOUT,
-                                                       pipes.fds[2], 
+                                                       source(StreamIndex::STDOUT),
                                                        buffers[static_cast<int>(StreamIndex::STDOUT)].get(),
-                                                       false);  // block on overflow
+                                                       false,  // block on overflow
+                                                       hook, coalesce,
+                                                       streamOptions[static_cast<int>(StreamIndex::STDOUT)].readChunk);
     }
 
     // stderr (fd index 4) - block on overflow (errors are critical)
-    if (pipes.fds[4] >= 0) {
+    if (drainable(StreamIndex::STDERR)) {
+        track(StreamIndex::STDERR);
         drainers[1] = std::make_unique<StreamDrainer>(StreamIndex::STDERR,
-                                                       pipes.fds[4],
+                                                       source(StreamIndex::STDERR),
                                                        buffers[static_cast<int>(StreamIndex::STDERR)].get(),
-                                                       false);  // block on overflow
+                                                       false,  // block on overflow
+                                                       hook, coalesce,
+                                                       streamOptions[static_cast<int>(StreamIndex::STDERR)].readChunk);
     }
 
     // stddbg (fd index 6) - drop on overflow (telemetry should never block)
-    if (pipes.fds[6] >= 0) {
+    if (drainable(StreamIndex::STDDBG)) {
+        track(StreamIndex::STDDBG);
         drainers[2] = std::make_unique<StreamDrainer>(StreamIndex::STDDBG,
-                                                       pipes.fds[6],
+                                                       source(StreamIndex::STDDBG),
                                                        buffers[static_cast<int>(StreamIndex::STDDBG)].get(),
-                                                       true);  // drop on overflow
+                                                       true,   // drop on overflow
+                                                       hook, coalesce,
+                                                       streamOptions[static_cast<int>(StreamIndex::STDDBG)].readChunk);
     }
 
     // stddato (fd index 10) - block on overflow (binary data is critical)
-    if (pipes.fds[10] >= 0) {
+    if (drainable(StreamIndex::STDDATO)) {
+        track(StreamIndex::STDDATO);
         drainers[3] = std::make_unique<StreamDrainer>(StreamIndex::STDDATO,
-                                                       pipes.fds[10],
+                                                       source(StreamIndex::STDDATO),
                                                        buffers[static_cast<int>(StreamIndex::STDDATO)].get(),
-                                                       false);  // block on overflow
+                                                       false,  // block on overflow
+                                                       hook, coalesce,
+                                                       streamOptions[static_cast<int>(StreamIndex::STDDATO)].readChunk);
+    }
+
+#ifdef __linux__
+    // Kernel-side relays for streams wired to another process
+    for (int i = 0; i < static_cast<int>(StreamIndex::COUNT); ++i) {
+        Relay* relay = relays[i].get();
+        int inFd = pipes.fds[parentSlot(static_cast<StreamIndex>(i))];
+        if (!relay || inFd < 0 || relay->worker.joinable()) continue;
+
+        RingBuffer* mirror = relay->mirror ? buffers[i].get() : nullptr;
+        relay->worker = std::jthread([this, relay, inFd, mirror](std::stop_token stoken) {
+            if (!serviceCpus.empty()) {
+                pinCurrentThread(serviceCpus);  // Next to the job it serves
+            }
+
+            // A consumer that exits early must surface as EPIPE here,
+            // not as a SIGPIPE that takes down the whole shell
+            sigset_t pipeMask;
+            sigemptyset(&pipeMask);
+            sigaddset(&pipeMask, SIGPIPE);
+            pthread_sigmask(SIG_BLOCK, &pipeMask, nullptr);
+
+            if (mirror) {
+                teePipeToPipe(inFd, relay->outFd, mirror, *relay, stoken);
+            } else {
+                splicePipeToPipe(inFd, relay->outFd, *relay, stoken);
+            }
+
+            // EOF (or stop): close our end so the consumer sees EOF too
+            ::close(relay->outFd);
+            relay->outFd = -1;
+        });
     }
 #endif
 
@@ -413,9 +918,32 @@ bool StreamController::startDraining() {
 }
 
 void StreamController::stopDraining() {
-    // C++20 jthread auto-stops and joins on destruction
+    // Drainers unregister from the reactor on destruction
     for (int i = 0; i < 4; ++i) {
-        drainers[i].reset();  // Triggers jthread destructor -> request_stop() + join()
+        drainers[i].reset();  // Waits out an in-flight handler
+    }
+    stopRelays();
+
+    // Nothing posts deliveries any more; wait out the queued ones (unless
+    // a callback stops its own controller)
+    std::unique_lock<std::mutex> lock(deliveryMutex);
+    if (deliveryThread != std::this_thread::get_id()) {
+        deliveryCv.wait(lock, [this] { return !deliveryScheduled; });
+    }
+}
+
+void StreamController::stopRelays() {
+    for (int i = 0; i < static_cast<int>(StreamIndex::COUNT); ++i) {
+        if (!relays[i]) continue;
+
+        if (relays[i]->worker.joinable()) {
+            relays[i]->worker.request_stop();
+            relays[i]->worker.join();
+        }
+        if (relays[i]->outFd >= 0) {
+            ::close(relays[i]->outFd);
+            relays[i]->outFd = -1;
+        }
     }
 }
 
@@ -431,6 +959,18 @@ ssize_t StreamController::writeStdin(const void* data, size_t size) {
 #endif
 }
 
+ssize_t StreamController::writeStdDatI(const void* data, size_t size) {
+#ifdef _WIN32
+    DWORD written;
+    if (!WriteFile(pipes.handles[9], data, (DWORD)size, &written, NULL)) {
+        return -1;
+    }
+    return written;
+#else
+    return write(pipes.fds[9], data, size);
+#endif
+}
+
 void StreamController::closeStdin() {
 #ifdef _WIN32
     if (pipes.handles[1] != INVALID_HANDLE_VALUE) {
@@ -445,23 +985,183 @@ void StreamController::closeStdin() {
 #endif
 }
 
+void StreamController::closeStdDatI() {
+#ifdef _WIN32
+    if (pipes.handles[9] != INVALID_HANDLE_VALUE) {
+        CloseHandle(pipes.handles[9]);
+        pipes.handles[9] = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (pipes.fds[9] >= 0) {
+        ::close(pipes.fds[9]);
+        pipes.fds[9] = -1;
+    }
+#endif
+}
+
+bool StreamController::waitForDrain(uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(drainMutex);
+    auto drained = [this] { return openDrainers == 0; };
+
+    if (timeout_ms == 0) {
+        drainCv.wait(lock, drained);
+        return true;
+    }
+    return drainCv.wait_for(lock, std::chrono::milliseconds(timeout_ms), drained);
+}
+
+void StreamController::onDrainerEvent(StreamIndex stream, bool eof) {
+    // Not callbackMutex: a running callback holds it
+    bool consumed = hasCallbacks.load(std::memory_order_acquire) ||
+                    (stream == StreamIndex::STDDBG && telemetry);
+
+    {
+        // Callbacks run on the delivery pool, in order per controller;
+        // once any are queued, later events queue behind them
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+        if (consumed || deliveryScheduled) {
+            uint32_t bit = 1u << static_cast<int>(stream);
+            pendingData |= bit;
+            if (eof) pendingEof |= bit;
+            if (!deliveryScheduled) {
+                deliveryScheduled = true;
+                DeliveryPool::get().post([this] { runDeliveries(); });
+            }
+            return;
+        }
+    }
+
+    // Nothing to call: the data stays buffered for readBuffer()
+    finishEvent(stream, eof);
+}
+
+void StreamController::runDeliveries() {
+    std::unique_lock<std::mutex> lock(deliveryMutex);
+    deliveryThread = std::this_thread::get_id();
+    while (pendingData != 0) {
+        uint32_t data = pendingData;
+        uint32_t eofs = pendingEof;
+        pendingData = 0;
+        pendingEof = 0;
+        lock.unlock();
+
+        for (int i = 0; i < static_cast<int>(StreamIndex::COUNT); ++i) {
+            if (data & (1u << i)) {
+                StreamIndex stream = static_cast<StreamIndex>(i);
+                deliver(stream);
+                finishEvent(stream, (eofs & (1u << i)) != 0);
+            }
+        }
+        lock.lock();
+    }
+    deliveryThread = std::thread::id();
+    deliveryScheduled = false;
+    deliveryCv.notify_all();  // The controller may be destroyed once this returns
+}
+
+void StreamController::finishEvent(StreamIndex stream, bool eof) {
+    if (eof && stream == StreamIndex::STDDBG && telemetry) {
+        std::lock_guard<std::mutex> lock(consumeMutex[static_cast<int>(stream)]);
+        telemetry->finish();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        if (eof) {
+            --openDrainers;
+            draining[static_cast<int>(stream)] = false;
+            drainCv.notify_all();
+        }
+    }
+    dataCv.notify_all();
+}
+
+void StreamController::deliver(StreamIndex stream) {
+    {
+        // Without a streaming consumer data stays buffered for readBuffer()
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        bool parsed = stream == StreamIndex::STDDBG && telemetry;
+        if (callbacks.empty() && !parsed) return;
+    }
+
+    int idx = static_cast<int>(stream);
+    std::lock_guard<std::mutex> lock(consumeMutex[idx]);
+    consumeToCallbacks(stream);
+}
+
+void StreamController::consumeToCallbacks(StreamIndex stream) {
+    // Caller holds consumeMutex; callbacks see ring memory directly
+    RingBuffer* buffer = buffers[static_cast<int>(stream)].get();
+    if (!buffer) return;
+
+    while (true) {
+        std::span<const uint8_t> span = buffer->acquireRead();
+        if (span.empty()) {
+            buffer->release(0);
+            break;
+        }
+        if (stream == StreamIndex::STDDBG && telemetry) {
+            telemetry->feed(span.data(), span.size());
+        }
+        notifyData(stream, span.data(), span.size());
+        buffer->release(span.size());
+    }
+}
+
 size_t StreamController::readBuffer(StreamIndex stream, void* data, size_t maxSize) {
     int idx = static_cast<int>(stream);
-    return buffers[idx]->read(data, maxSize);
+    std::lock_guard<std::mutex> lock(consumeMutex[idx]);
+    return buffers[idx] ? buffers[idx]->read(data, maxSize) : 0;
 }
 
 size_t StreamController::availableData(StreamIndex stream) const {
     int idx = static_cast<int>(stream);
-    return buffers[idx]->available();
+    return buffers[idx] ? buffers[idx]->available() : 0;
+}
+
+bool StreamController::waitForData(StreamIndex stream, uint32_t timeout_ms) {
+    int idx = static_cast<int>(stream);
+    std::unique_lock<std::mutex> lock(drainMutex);
+    auto ready = [this, stream, idx] { return availableData(stream) > 0 || !draining[idx]; };
+
+    if (timeout_ms == 0) {
+        dataCv.wait(lock, ready);
+    } else {
+        dataCv.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+    }
+    return availableData(stream) > 0;
+}
+
+size_t StreamController::consumeBuffer(StreamIndex stream,
+                                       const std::function<size_t(std::span<const uint8_t>)>& consumer) {
+    int idx = static_cast<int>(stream);
+    std::lock_guard<std::mutex> lock(consumeMutex[idx]);
+    RingBuffer* buffer = buffers[idx].get();
+    if (!buffer) return 0;
+
+    size_t total = 0;
+    while (true) {
+        std::span<const uint8_t> span = buffer->acquireRead();
+        size_t taken = span.empty() ? 0 : std::min(consumer(span), span.size());
+        buffer->release(taken);
+        total += taken;
+        if (taken == 0 || taken < span.size()) break;
+    }
+    return total;
 }
 
 bool StreamController::hasPendingData(StreamIndex stream) const {
     return availableData(stream) > 0;
 }
 
+void StreamController::parseTelemetry(std::shared_ptr<TelemetryMetrics> metrics) {
+    telemetry = metrics ? std::make_unique<TelemetryParser>(std::move(metrics)) : nullptr;
+}
+
 void StreamController::onData(StreamCallback callback) {
     std::lock_guard<std::mutex> lock(callbackMutex);
     callbacks.push_back(callback);
+    hasCallbacks.store(true, std::memory_order_release);
 }
 
 void StreamController::notifyData(StreamIndex stream, const void* data, size_t size) {
@@ -476,15 +1176,9 @@ void StreamController::setForegroundMode(bool foreground) {
 }
 
 void StreamController::flushBuffers() {
-    uint8_t buf[4096];
-
     for (int i = 0; i < static_cast<int>(StreamIndex::COUNT); ++i) {
-        while (!buffers[i]->empty()) {
-            size_t n = buffers[i]->read(buf, sizeof(buf));
-            if (n > 0) {
-                notifyData(static_cast<StreamIndex>(i), buf, n);
-            }
-        }
+        std::lock_guard<std::mutex> lock(consumeMutex[i]);
+        consumeToCallbacks(static_cast<StreamIndex>(i));
     }
 }
 
@@ -493,6 +1187,19 @@ void StreamController::close() {
     pipes.close();
 }
 
+void StreamController::configureStreams(const StreamOptionSet& options) {
+    streamOptions = options;
+    for (int i = 0; i < static_cast<int>(StreamIndex::COUNT); ++i) {
+        const StreamOptions& opt = streamOptions[i];
+        if (opt.maxCapacity == 0) {
+            buffers[i].reset();
+        } else {
+            buffers[i] = std::make_unique<RingBuffer>(opt.initialCapacity, opt.maxCapacity,
+                                                      opt.mirrored);
+        }
+    }
+}
+
 size_t StreamController::getTotalBytesTransferred() const {
     size_t total = 0;
     for (int i = 0; i < 4; ++i) {
@@ -500,6 +1207,51 @@ size_t StreamController::getTotalBytesTransferred() const {
             total += drainers[i]->bytesTransferred();
         }
     }
+    for (int i = 0; i < static_cast<int>(StreamIndex::COUNT); ++i) {
+        if (relays[i]) {
+            total += relays[i]->bytes.load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+StreamStats StreamController::getStreamStats(StreamIndex stream) const {
+    StreamStats stats;
+    int idx = static_cast<int>(stream);
+    for (int i = 0; i < 4; ++i) {
+        if (drainers[i] && drainers[i]->getStream() == stream) {
+            stats.bytes = drainers[i]->bytesTransferred();
+            stats.dropped = drainers[i]->bytesDropped();
+        }
+    }
+    if (relays[idx]) {
+        stats.bytes += relays[idx]->bytes.load(std::memory_order_relaxed);
+        stats.dropped += relays[idx]->dropped.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+int64_t StreamController::getFirstDataTime() const {
+    int64_t first = 0;
+    auto earliest = [&first](int64_t stamp) {
+        if (stamp != 0 && (first == 0 || stamp < first)) first = stamp;
+    };
+    for (int i = 0; i < 4; ++i) {
+        if (drainers[i]) earliest(drainers[i]->firstDataNs());
+    }
+    for (int i = 0; i < static_cast<int>(StreamIndex::COUNT); ++i) {
+        if (relays[i]) earliest(relays[i]->firstNs.load(std::memory_order_relaxed));
+    }
+    return first;
+}
+
+size_t StreamController::getBufferMemory() const {
+    size_t total = 0;
+    for (const auto& buffer : buffers) {
+        if (buffer) {
+            total += buffer->allocated();
+        }
+    }
     return total;
 }
 
@@ -514,8 +1266,23 @@ size_t StreamController::getActiveThreadCount() const {
 }
 
 #ifdef __linux__
+// Wait until fdIn has data and fdOut has room. Polled one side at a time:
+// polling both together returns immediately on a readable input while the
+// output is still full, which would spin.
+static void waitRelayReady(int fdIn, int fdOut) {
+    struct pollfd pfd;
+    pfd.fd = fdIn;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, 100) <= 0) return;  // 100ms timeout for stop_token check
+
+    pfd.fd = fdOut;
+    pfd.events = POLLOUT;
+    poll(&pfd, 1, 100);
+}
+
 // Zero-copy splice optimization for Linux
-ssize_t StreamController::splicePipeToPipe(int fdIn, int fdOut, std::stop_token stoken) {
+ssize_t StreamController::splicePipeToPipe(int fdIn, int fdOut, Relay& relay,
+                                           std::stop_token stoken) {
     ssize_t totalBytes = 0;
     
     while (!stoken.stop_requested()) {
@@ -526,19 +1293,16 @@ ssize_t StreamController::splicePipeToPipe(int fdIn, int fdOut, std::stop_token
                             SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE);
 
         if (ret > 0) {
+            if (totalBytes == 0) relay.firstNs.store(steadyNanos(), std::memory_order_relaxed);
             totalBytes += ret;
+            relay.bytes.fetch_add(ret, std::memory_order_relaxed);
         } else if (ret == 0) {
             // EOF
             break;
         } else {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 // Pipe is empty (read) or full (write)
-                // Wait for readiness using poll()
-                struct pollfd pfds[2];
-                pfds[0].fd = fdIn;   pfds[0].events = POLLIN;
-                pfds[1].fd = fdOut;  pfds[1].events = POLLOUT;
-                
-                poll(pfds, 2, 100);  // 100ms timeout for stop_token check
+                waitRelayReady(fdIn, fdOut);
                 continue;
             }
             if (errno == EINTR) continue;
@@ -549,6 +1313,52 @@ ssize_t StreamController::splicePipeToPipe(int fdIn, int fdOut, std::stop_token
     
     return totalBytes;
 }
+
+// splice() variant that mirrors the stream into a ring buffer via tee(2)
+ssize_t StreamController::teePipeToPipe(int fdIn, int fdOut, RingBuffer* mirror, Relay& relay,
+                                        std::stop_token stoken) {
+    ssize_t totalBytes = 0;
+    std::vector<uint8_t> scratch(64 * 1024);
+
+    while (!stoken.stop_requested()) {
+        // Duplicate pipe pages into fdOut without consuming them from fdIn
+        ssize_t ret = tee(fdIn, fdOut, scratch.size(), SPLICE_F_NONBLOCK);
+
+        if (ret > 0) {
+            if (totalBytes == 0) relay.firstNs.store(steadyNanos(), std::memory_order_relaxed);
+
+            // Consume the same bytes from fdIn into the mirror. Inspection is
+            // best-effort: whatever does not fit in the ring buffer is dropped.
+            size_t remaining = ret;
+            while (remaining > 0) {
+                ssize_t n = read(fdIn, scratch.data(), std::min(remaining, scratch.size()));
+                if (n > 0) {
+                    size_t kept = mirror->write(scratch.data(), n);
+                    relay.dropped.fetch_add(static_cast<size_t>(n) - kept, std::memory_order_relaxed);
+                    remaining -= n;
+                } else if (n < 0 && errno == EINTR) {
+                    continue;
+                } else {
+                    break;
+                }
+            }
+            totalBytes += ret;
+            relay.bytes.fetch_add(ret, std::memory_order_relaxed);
+        } else if (ret == 0) {
+            // EOF: no data left and no writers
+            break;
+        } else {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                waitRelayReady(fdIn, fdOut);
+                continue;
+            }
+            if (errno == EINTR) continue;
+            break;
+        }
+    }
+
+    return totalBytes;
+}
 #endif
 
 } // namespace job
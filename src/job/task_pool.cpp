@@ -0,0 +1,128 @@
+/**
+ * AriaSH Task Pool Implementation
+ */
+
+#include "job/task_pool.hpp"
+#include "job/stream_controller.hpp"
+#include <algorithm>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace ariash {
+namespace job {
+
+// Matches the Executor's foreground drain bound
+static constexpr uint32_t kTaskDrainTimeoutMs = 1000;
+
+size_t onlineCpus() {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        int count = CPU_COUNT(&set);
+        if (count > 0) return static_cast<size_t>(count);
+    }
+#endif
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+TaskPool::TaskPool(size_t concurrency)
+    : concurrency_(concurrency > 0 ? concurrency : onlineCpus()) {}
+
+size_t TaskPool::add(std::vector<SpawnOptions> stages) {
+    for (auto& stage : stages) {
+        stage.background = true;
+    }
+    tasks_.push_back(std::move(stages));
+    results_.emplace_back();
+    return tasks_.size() - 1;
+}
+
+bool TaskPool::start(size_t task, uint32_t& jobId) {
+    JobManager& jobs = getJobManager();
+    jobId = jobs.spawnPipeline(tasks_[task]);
+    JobControlBlock* job = jobId ? jobs.getJob(jobId) : nullptr;
+    if (!job) {
+        jobId = 0;
+        return false;
+    }
+
+    job->streams->closeStdin();
+    TaskResult* result = &results_[task];
+    job->streams->onData([this, result](StreamIndex stream, const void* data, size_t size) {
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        if (stream == StreamIndex::STDOUT) {
+            result->output.append(static_cast<const char*>(data), size);
+        } else if (stream == StreamIndex::STDERR) {
+            result->errors.append(static_cast<const char*>(data), size);
+        }
+    });
+    return true;
+}
+
+size_t TaskPool::run() {
+    JobManager& jobs = getJobManager();
+    std::vector<uint32_t> running;    // Job IDs
+    std::vector<size_t> runningTask;  // Task index of each, in step
+    size_t next = 0;
+    size_t failed = 0;
+
+    auto finish = [&](size_t task) {
+        if (results_[task].exitCode != 0) ++failed;
+        if (onComplete_) onComplete_(task, results_[task]);
+    };
+
+    while (next < tasks_.size() || !running.empty()) {
+        // Fill every free slot from the queue
+        while (next < tasks_.size() && running.size() < concurrency_) {
+            size_t task = next++;
+            uint32_t jobId;
+            if (start(task, jobId)) {
+                running.push_back(jobId);
+                runningTask.push_back(task);
+                peakRunning_ = std::max(peakRunning_, running.size());
+            } else {
+                results_[task].exitCode = 127;
+                results_[task].errors = "Failed to spawn: " + tasks_[task][0].command + "\n";
+                finish(task);
+            }
+        }
+        if (running.empty()) break;
+
+        uint32_t done = jobs.waitAny(running);
+        if (done == 0) {
+            // Every remaining job vanished from the table (removed elsewhere)
+            for (size_t task : runningTask) {
+                finish(task);
+            }
+            running.clear();
+            runningTask.clear();
+            continue;
+        }
+
+        size_t slot = static_cast<size_t>(
+            std::find(running.begin(), running.end(), done) - running.begin());
+        size_t task = runningTask[slot];
+        running.erase(running.begin() + static_cast<std::ptrdiff_t>(slot));
+        runningTask.erase(runningTask.begin() + static_cast<std::ptrdiff_t>(slot));
+
+        JobControlBlock* job = jobs.getJob(done);
+        job->streams->waitForDrain(kTaskDrainTimeoutMs);
+        job->streams->flushBuffers();
+        {
+            std::lock_guard<std::mutex> lock(outputMutex_);
+            results_[task].exitCode = job->exitCode;
+        }
+        jobs.removeJob(done);
+        finish(task);
+    }
+
+    return failed;
+}
+
+} // namespace job
+} // namespace ariash
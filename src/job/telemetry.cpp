@@ -0,0 +1,576 @@
+/**
+ * AriaSH Telemetry Implementation
+ */
+
+#include "job/telemetry.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ariash {
+namespace job {
+
+// Open-addressed slots per shard: at most half full
+static constexpr size_t kSlots = TelemetryMetrics::kMaxMetrics * 2;
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* metricKindName(MetricKind kind) {
+    switch (kind) {
+        case MetricKind::COUNTER:   return "counter";
+        case MetricKind::GAUGE:     return "gauge";
+        case MetricKind::HISTOGRAM: return "histogram";
+    }
+    return "unknown";
+}
+
+// =============================================================================
+// Histogram buckets
+// =============================================================================
+
+static constexpr int kLowestOctave = -16;
+
+static size_t bucketOf(double value) {
+    if (!(value > 0)) return 0;
+    int exponent;
+    double mantissa = std::frexp(value, &exponent);  // value = mantissa * 2^exponent
+    int octave = exponent - 1;                       // 2^octave <= value < 2^(octave+1)
+    int sub = static_cast<int>((mantissa * 2 - 1) * 4);
+    long index = static_cast<long>(octave - kLowestOctave) * 4 + sub;
+    return static_cast<size_t>(std::clamp<long>(index, 0, MetricSnapshot::kBuckets - 1));
+}
+
+// Midpoint of a bucket's range
+static double bucketValue(size_t index) {
+    int octave = static_cast<int>(index / 4) + kLowestOctave;
+    double sub = static_cast<double>(index % 4);
+    return std::ldexp(1.0 + (sub + 0.5) / 4, octave);
+}
+
+double MetricSnapshot::quantile(double q) const {
+    if (buckets.empty() || count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= std::max<uint64_t>(rank, 1)) {
+            return std::clamp(bucketValue(i), min, max);
+        }
+    }
+    return max;
+}
+
+// =============================================================================
+// TelemetryMetrics Implementation
+// =============================================================================
+
+struct TelemetryMetrics::Metric {
+    std::string name;
+    MetricKind kind;
+    std::atomic<uint64_t> count{0};
+    std::atomic<double> sum{0};
+    std::atomic<double> min{std::numeric_limits<double>::infinity()};
+    std::atomic<double> max{-std::numeric_limits<double>::infinity()};
+    std::atomic<double> last{0};
+    std::atomic<int64_t> lastNs{0};
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets;  // Histograms only
+
+    Metric(std::string_view n, MetricKind k) : name(n), kind(k) {
+        if (kind == MetricKind::HISTOGRAM) {
+            buckets = std::make_unique<std::atomic<uint64_t>[]>(MetricSnapshot::kBuckets);
+        }
+    }
+};
+
+// One cache line of counters, then the slot table; metrics are
+// inserted by CAS and never move or go away until destruction
+struct TelemetryMetrics::Shard {
+    alignas(64) std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> malformed{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<size_t> used{0};
+    std::array<std::atomic<Metric*>, kSlots> slots{};
+
+    ~Shard() {
+        for (auto& slot : slots) {
+            delete slot.load(std::memory_order_relaxed);
+        }
+    }
+
+    Metric* find(std::string_view name, MetricKind kind) {
+        size_t i = std::hash<std::string_view>{}(name) & (kSlots - 1);
+        for (size_t probe = 0; probe < kSlots; ++probe, i = (i + 1) & (kSlots - 1)) {
+            Metric* metric = slots[i].load(std::memory_order_acquire);
+            if (!metric) {
+                if (used.fetch_add(1, std::memory_order_relaxed) >= TelemetryMetrics::kMaxMetrics) {
+                    used.fetch_sub(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                auto* fresh = new Metric(name, kind);
+                if (slots[i].compare_exchange_strong(metric, fresh, std::memory_order_acq_rel)) {
+                    return fresh;
+                }
+                // Another writer took the slot first: look at what it put there
+                delete fresh;
+                used.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (metric->name == name) {
+                return metric;  // The first record's kind sticks
+            }
+        }
+        return nullptr;
+    }
+};
+
+template <typename Compare>
+static void storeIf(std::atomic<double>& target, double value, Compare better) {
+    double current = target.load(std::memory_order_relaxed);
+    while (better(value, current) &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+TelemetryMetrics::TelemetryMetrics()
+    : shards_(std::make_unique<Shard[]>(kShards)) {
+}
+
+TelemetryMetrics::~TelemetryMetrics() = default;
+
+TelemetryMetrics::Shard& TelemetryMetrics::localShard() {
+    // Threads are spread over the shards in the order they first record
+    static std::atomic<unsigned> nextThread{0};
+    thread_local unsigned thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+    return shards_[thread % kShards];
+}
+
+void TelemetryMetrics::record(std::string_view name, MetricKind kind, double value) {
+    Shard& shard = localShard();
+    shard.records.fetch_add(1, std::memory_order_relaxed);
+    if (name.empty()) return;
+
+    Metric* metric = shard.find(name, kind);
+    if (!metric) {
+        shard.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    metric->count.fetch_add(1, std::memory_order_relaxed);
+    metric->sum.fetch_add(value, std::memory_order_relaxed);
+    storeIf(metric->min, value, std::less<double>());
+    storeIf(metric->max, value, std::greater<double>());
+    if (metric->kind == MetricKind::GAUGE) {
+        metric->last.store(value, std::memory_order_relaxed);
+        metric->lastNs.store(nowNs(), std::memory_order_relaxed);
+    } else if (metric->buckets) {
+        metric->buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TelemetryMetrics::recordMalformed() {
+    Shard& shard = localShard();
+    shard.records.fetch_add(1, std::memory_order_relaxed);
+    shard.malformed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TelemetryMetrics::touch() {
+    int64_t now = nowNs();
+    int64_t expected = 0;
+    firstNs_.compare_exchange_strong(expected, now, std::memory_order_relaxed);
+    lastNs_.store(now, std::memory_order_relaxed);
+}
+
+TelemetrySnapshot TelemetryMetrics::snapshot() const {
+    TelemetrySnapshot result;
+    std::map<std::string_view, MetricSnapshot> merged;
+    std::map<std::string_view, int64_t> lastNs;  // Gauges: newest shard wins
+
+    for (size_t s = 0; s < kShards; ++s) {
+        const Shard& shard = shards_[s];
+        result.records += shard.records.load(std::memory_order_relaxed);
+        result.malformed += shard.malformed.load(std::memory_order_relaxed);
+        result.dropped += shard.dropped.load(std::memory_order_relaxed);
+
+        for (const auto& slot : shard.slots) {
+            const Metric* metric = slot.load(std::memory_order_acquire);
+            if (!metric) continue;
+            uint64_t count = metric->count.load(std::memory_order_relaxed);
+            if (count == 0) continue;  // Inserted, first update still in flight
+
+            auto [it, fresh] = merged.try_emplace(metric->name);
+            MetricSnapshot& out = it->second;
+            double min = metric->min.load(std::memory_order_relaxed);
+            double max = metric->max.load(std::memory_order_relaxed);
+            if (fresh) {
+                out.name = metric->name;
+                out.kind = metric->kind;
+                out.min = min;
+                out.max = max;
+            } else {
+                out.min = std::min(out.min, min);
+                out.max = std::max(out.max, max);
+            }
+            out.count += count;
+            out.sum += metric->sum.load(std::memory_order_relaxed);
+
+            int64_t stamp = metric->lastNs.load(std::memory_order_relaxed);
+            int64_t& newest = lastNs[it->first];
+            if (fresh || stamp > newest) {
+                newest = stamp;
+                out.last = metric->last.load(std::memory_order_relaxed);
+            }
+
+            if (metric->buckets) {
+                out.buckets.resize(MetricSnapshot::kBuckets);
+                for (size_t b = 0; b < MetricSnapshot::kBuckets; ++b) {
+                    out.buckets[b] += metric->buckets[b].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    int64_t first = firstNs_.load(std::memory_order_relaxed);
+    result.seconds = static_cast<double>(lastNs_.load(std::memory_order_relaxed) - first) / 1e9;
+    result.metrics.reserve(merged.size());
+    for (auto& pair : merged) {
+        result.metrics.push_back(std::move(pair.second));
+    }
+    return result;
+}
+
+// =============================================================================
+// Record scanning
+// =============================================================================
+
+namespace {
+
+// First byte of `p` that is one of `set` (or `end`), 16 bytes at a time
+template <size_t N>
+const char* findFirst(const char* p, const char* end, const char (&set)[N]) {
+#if defined(__SSE2__)
+    while (end - p >= 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hit = _mm_setzero_si128();
+        for (size_t i = 0; i + 1 < N; ++i) {
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(set[i])));
+        }
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+        for (size_t i = 0; i + 1 < N; ++i) {
+            if (*p == set[i]) return p;
+        }
+    }
+    return end;
+}
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline void skipSpace(const char*& p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+}
+
+// Body of a string whose opening quote is already consumed; escapes are
+// left as they are
+bool scanString(const char*& p, const char* end, std::string_view& out) {
+    const char* start = p;
+    for (;;) {
+        const char* q = findFirst(p, end, "\"\\");
+        if (q == end) return false;
+        if (*q == '\\') {
+            p = q + 2;
+            if (p > end) return false;
+            continue;
+        }
+        out = std::string_view(start, static_cast<size_t>(q - start));
+        p = q + 1;
+        return true;
+    }
+}
+
+// Past a JSON object or array starting at `p`
+bool skipNested(const char*& p, const char* end) {
+    int depth = 0;
+    for (;;) {
+        const char* q = findFirst(p, end, "\"{}[]");
+        if (q == end) return false;
+        p = q + 1;
+        if (*q == '"') {
+            std::string_view ignored;
+            if (!scanString(p, end, ignored)) return false;
+        } else if (*q == '{' || *q == '[') {
+            ++depth;
+        } else if (--depth == 0) {
+            return true;
+        }
+    }
+}
+
+struct Fields {
+    std::string_view metric;
+    std::string_view type;
+    std::string_view value;
+    bool hasValue = false;
+
+    void set(std::string_view key, std::string_view text) {
+        if (key == "metric" || key == "name") {
+            metric = text;
+        } else if (key == "type" || key == "kind") {
+            type = text;
+        } else if (key == "value") {
+            value = text;
+            hasValue = true;
+        }
+    }
+};
+
+bool parseJson(std::string_view line, Fields& fields) {
+    const char* p = line.data() + 1;  // Past '{'
+    const char* end = line.data() + line.size();
+
+    skipSpace(p, end);
+    if (p < end && *p == '}') {
+        ++p;
+    } else {
+        for (;;) {
+            std::string_view key, text;
+            skipSpace(p, end);
+            if (p == end || *p != '"') return false;
+            ++p;
+            if (!scanString(p, end, key)) return false;
+            skipSpace(p, end);
+            if (p == end || *p != ':') return false;
+            ++p;
+            skipSpace(p, end);
+            if (p == end) return false;
+
+            if (*p == '"') {
+                ++p;
+                if (!scanString(p, end, text)) return false;
+            } else if (*p == '{' || *p == '[') {
+                if (!skipNested(p, end)) return false;
+            } else {
+                // Number, true, false or null
+                const char* q = findFirst(p, end, ",} \t\r");
+                text = std::string_view(p, static_cast<size_t>(q - p));
+                p = q;
+            }
+            fields.set(key, text);
+
+            skipSpace(p, end);
+            if (p == end) return false;
+            if (*p == ',') {
+                ++p;
+                continue;
+            }
+            if (*p != '}') return false;
+            ++p;
+            break;
+        }
+    }
+
+    skipSpace(p, end);
+    return p == end;
+}
+
+bool parseLogfmt(std::string_view line, Fields& fields) {
+    const char* p = line.data();
+    const char* end = p + line.size();
+
+    while (p < end) {
+        skipSpace(p, end);
+        if (p == end) break;
+
+        const char* q = findFirst(p, end, " =\"\t");
+        std::string_view key(p, static_cast<size_t>(q - p));
+        if (key.empty() || (q < end && *q == '"')) return false;
+        p = q;
+        if (p == end || *p != '=') {
+            continue;  // Bare key: a flag, no value
+        }
+
+        ++p;  // '='
+        std::string_view text;
+        if (p < end && *p == '"') {
+            ++p;
+            if (!scanString(p, end, text)) return false;
+            if (p < end && !isSpace(*p)) return false;
+        } else {
+            q = findFirst(p, end, " \t");
+            text = std::string_view(p, static_cast<size_t>(q - p));
+            p = q;
+        }
+        fields.set(key, text);
+    }
+    return true;
+}
+
+} // namespace
+
+bool TelemetryParser::parseRecord(std::string_view line, std::string_view& name,
+                                  MetricKind& kind, double& value) {
+    size_t start = 0;
+    while (start < line.size() && isSpace(line[start])) ++start;
+    line.remove_prefix(start);
+
+    Fields fields;
+    bool parsed = !line.empty() && line.front() == '{' ? parseJson(line, fields)
+                                                       : parseLogfmt(line, fields);
+    if (!parsed) return false;
+
+    name = fields.metric;
+    if (fields.type.empty() || fields.type == "counter" || fields.type == "c") {
+        kind = MetricKind::COUNTER;
+    } else if (fields.type == "gauge" || fields.type == "g") {
+        kind = MetricKind::GAUGE;
+    } else if (fields.type == "histogram" || fields.type == "h") {
+        kind = MetricKind::HISTOGRAM;
+    } else {
+        return false;
+    }
+
+    if (!fields.hasValue) {
+        // Counting an occurrence needs no value; the others do
+        value = 1;
+        return kind == MetricKind::COUNTER || name.empty();
+    }
+    const char* first = fields.value.data();
+    const char* last = first + fields.value.size();
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    return ec == std::errc() && ptr == last && std::isfinite(value);
+}
+
+// =============================================================================
+// TelemetryParser Implementation
+// =============================================================================
+
+TelemetryParser::TelemetryParser(std::shared_ptr<TelemetryMetrics> metrics)
+    : metrics_(std::move(metrics)) {
+}
+
+void TelemetryParser::parseLine(std::string_view line) {
+    while (!line.empty() && isSpace(line.back())) {
+        line.remove_suffix(1);
+    }
+    size_t start = 0;
+    while (start < line.size() && isSpace(line[start])) ++start;
+    if (start == line.size()) return;  // Blank lines are not records
+
+    std::string_view name;
+    MetricKind kind;
+    double value;
+    if (parseRecord(line, name, kind, value)) {
+        metrics_->record(name, kind, value);
+    } else {
+        metrics_->recordMalformed();
+    }
+}
+
+void TelemetryParser::feed(const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    const char* end = p + size;
+    metrics_->touch();
+
+    // Keeps what remains of an unfinished line, unless it is too long
+    auto keep = [this](const char* from, const char* to) {
+        if (overlong_) return;
+        size_t n = static_cast<size_t>(to - from);
+        if (carry_.size() + n > kMaxRecord) {
+            overlong_ = true;
+            carry_.clear();
+        } else {
+            carry_.append(from, n);
+        }
+    };
+
+    // Finish the line split by the previous delivery
+    if (!carry_.empty() || overlong_) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', size));
+        if (!nl) {
+            keep(p, end);
+            return;
+        }
+        keep(p, nl);
+        if (overlong_) {
+            metrics_->recordMalformed();
+        } else {
+            parseLine(carry_);
+        }
+        carry_.clear();
+        overlong_ = false;
+        p = nl + 1;
+    }
+
+    // Whole lines are parsed where they are
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!nl) break;
+        parseLine(std::string_view(p, static_cast<size_t>(nl - p)));
+        p = nl + 1;
+    }
+    if (p < end) {
+        keep(p, end);
+    }
+}
+
+void TelemetryParser::finish() {
+    if (overlong_) {
+        metrics_->recordMalformed();
+    } else if (!carry_.empty()) {
+        parseLine(carry_);
+    }
+    carry_.clear();
+    overlong_ = false;
+}
+
+// =============================================================================
+// TelemetryRegistry Implementation
+// =============================================================================
+
+std::shared_ptr<TelemetryMetrics> TelemetryRegistry::attach(uint32_t jobId,
+                                                            const std::string& command) {
+    auto metrics = std::make_shared<TelemetryMetrics>();
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back({jobId, command, metrics});
+    if (entries_.size() > kRetained) {
+        entries_.erase(entries_.begin());
+    }
+    return metrics;
+}
+
+TelemetryRegistry::Entry TelemetryRegistry::find(uint32_t jobId) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : entries_) {
+        if (entry.jobId == jobId) return entry;
+    }
+    return Entry();
+}
+
+std::vector<TelemetryRegistry::Entry> TelemetryRegistry::entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_;
+}
+
+TelemetryRegistry& getTelemetryRegistry() {
+    static TelemetryRegistry registry;
+    return registry;
+}
+
+} // namespace job
+} // namespace ariash
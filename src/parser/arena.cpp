@@ -0,0 +1,42 @@
+/**
+ * Arena Implementation
+ */
+
+#include "parser/arena.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace ariash {
+namespace parser {
+
+Arena::~Arena() {
+    while (head_) {
+        Block* next = head_->next;
+        std::free(head_);
+        head_ = next;
+    }
+}
+
+void* Arena::allocateSlow(size_t size, size_t align) {
+    // Blocks double up to kMaxBlockSize; an oversized request gets a block
+    // of its own
+    size_t header = (sizeof(Block) + align - 1) & ~(align - 1);
+    size_t blockSize = std::max(nextBlockSize_, header + size);
+    nextBlockSize_ = std::min(nextBlockSize_ * 2, kMaxBlockSize);
+
+    auto* block = static_cast<Block*>(std::malloc(blockSize));
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    block->next = head_;
+    head_ = block;
+    ++blockCount_;
+
+    char* base = reinterpret_cast<char*>(block);
+    cursor_ = base + header;
+    end_ = base + blockSize;
+    return allocate(size, align);
+}
+
+} // namespace parser
+} // namespace ariash
@@ -14,6 +14,7 @@ void VariableExpr::accept(ASTVisitor& visitor) { visitor.visit(*this); }
 void BinaryOpExpr::accept(ASTVisitor& visitor) { visitor.visit(*this); }
 void UnaryOpExpr::accept(ASTVisitor& visitor) { visitor.visit(*this); }
 void CallExpr::accept(ASTVisitor& visitor) { visitor.visit(*this); }
+void CommandSubstExpr::accept(ASTVisitor& visitor) { visitor.visit(*this); }
 
 // Statements
 void BlockStmt::accept(ASTVisitor& visitor) { visitor.visit(*this); }
@@ -26,6 +27,7 @@ void ReturnStmt::accept(ASTVisitor& visitor) { visitor.visit(*this); }
 void ExprStmt::accept(ASTVisitor& visitor) { visitor.visit(*this); }
 void CommandStmt::accept(ASTVisitor& visitor) { visitor.visit(*this); }
 void PipelineStmt::accept(ASTVisitor& visitor) { visitor.visit(*this); }
+void ParallelStmt::accept(ASTVisitor& visitor) { visitor.visit(*this); }
 void Program::accept(ASTVisitor& visitor) { visitor.visit(*this); }
 
 } // namespace parser
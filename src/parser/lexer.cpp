@@ -3,8 +3,12 @@
  */
 
 #include "parser/lexer.hpp"
-#include <cctype>
+#include <charconv>
+#include <cstring>
 #include <stdexcept>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace ariash {
 namespace parser {
@@ -24,6 +28,7 @@ const char* tokenTypeToString(TokenType type) {
         case TokenType::KW_ELSE: return "else";
         case TokenType::KW_WHILE: return "while";
         case TokenType::KW_FOR: return "for";
+        case TokenType::KW_PARALLEL: return "parallel";
         
         case TokenType::PLUS: return "+";
         case TokenType::MINUS: return "-";
@@ -45,56 +50,177 @@ const char* tokenTypeToString(TokenType type) {
         
         case TokenType::PIPE: return "|";
         case TokenType::REDIRECT_OUT: return ">";
+        case TokenType::SUBST_START: return "$(";
         case TokenType::END_OF_FILE: return "EOF";
         default: return "UNKNOWN";
     }
 }
 
+// =============================================================================
+// Keyword Table
+// =============================================================================
+
+namespace {
+
+struct Keyword {
+    std::string_view text;
+    TokenType type = TokenType::IDENTIFIER;
+};
+
+constexpr Keyword kKeywords[] = {
+    // Control flow
+    {"if", TokenType::KW_IF},
+    {"else", TokenType::KW_ELSE},
+    {"while", TokenType::KW_WHILE},
+    {"for", TokenType::KW_FOR},
+    {"in", TokenType::KW_IN},
+    {"func", TokenType::KW_FUNC},
+    {"return", TokenType::KW_RETURN},
+    {"break", TokenType::KW_BREAK},
+    {"continue", TokenType::KW_CONTINUE},
+    {"spawn", TokenType::KW_SPAWN},
+    {"parallel", TokenType::KW_PARALLEL},
+    
+    // Types
+    {"int8", TokenType::KW_INT8},
+    {"int16", TokenType::KW_INT16},
+    {"int32", TokenType::KW_INT32},
+    {"int64", TokenType::KW_INT64},
+    {"tbb8", TokenType::KW_TBB8},
+    {"tbb16", TokenType::KW_TBB16},
+    {"tbb32", TokenType::KW_TBB32},
+    {"tbb64", TokenType::KW_TBB64},
+    {"string", TokenType::KW_STRING},
+    {"buffer", TokenType::KW_BUFFER},
+    {"bool", TokenType::KW_BOOL},
+    {"gc", TokenType::KW_GC},
+    {"wild", TokenType::KW_WILD},
+};
+
+constexpr size_t kKeywordTableSize = 64;
+
+// Length, first and last byte are enough to tell every keyword apart;
+// adding a keyword may need new multipliers (the static_assert says so)
+constexpr size_t keywordHash(std::string_view text) {
+    return (text.size() +
+            static_cast<unsigned char>(text.front()) * 10 +
+            static_cast<unsigned char>(text.back()) * 14) & (kKeywordTableSize - 1);
+}
+
+struct KeywordTable {
+    Keyword slots[kKeywordTableSize];
+    bool perfect = true;
+};
+
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table;
+    for (const Keyword& keyword : kKeywords) {
+        Keyword& slot = table.slots[keywordHash(keyword.text)];
+        if (!slot.text.empty()) {
+            table.perfect = false;
+        }
+        slot = keyword;
+    }
+    return table;
+}
+
+constexpr KeywordTable kKeywordTable = buildKeywordTable();
+static_assert(kKeywordTable.perfect, "keyword hash collision: choose new multipliers");
+
+// =============================================================================
+// Character Runs
+// =============================================================================
+
+inline bool isWhitespaceChar(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool isDigitChar(char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline bool isIdentifierStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+inline bool isIdentifierChar(char c) {
+    return isIdentifierStart(c) || isDigitChar(c);
+}
+
+#if defined(__SSE2__)
+inline __m128i inRange(__m128i bytes, char lo, char hi) {
+    // Signed compares: bytes >= 0x80 are negative and never match
+    return _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(bytes, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+// Index of the first zero bit of a 16-lane match mask (16 if none)
+inline size_t firstMismatch(__m128i matches) {
+    unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(matches)) & 0xFFFFu;
+    return mask ? static_cast<size_t>(__builtin_ctz(mask)) : 16;
+}
+#endif
+
+// Length of the whitespace run at `p`
+size_t whitespaceRun(const char* p, const char* end) {
+    const char* start = p;
+#if defined(__SSE2__)
+    while (end - p >= 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                         _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))),
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')),
+                         _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))));
+        size_t n = firstMismatch(ws);
+        p += n;
+        if (n < 16) {
+            return static_cast<size_t>(p - start);
+        }
+    }
+#endif
+    while (p < end && isWhitespaceChar(*p)) ++p;
+    return static_cast<size_t>(p - start);
+}
+
+// Length of the [A-Za-z0-9_] run at `p`
+size_t identifierRun(const char* p, const char* end) {
+    const char* start = p;
+#if defined(__SSE2__)
+    while (end - p >= 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i ident = _mm_or_si128(
+            _mm_or_si128(inRange(bytes, 'a', 'z'), inRange(bytes, 'A', 'Z')),
+            _mm_or_si128(inRange(bytes, '0', '9'), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_'))));
+        size_t n = firstMismatch(ident);
+        p += n;
+        if (n < 16) {
+            return static_cast<size_t>(p - start);
+        }
+    }
+#endif
+    while (p < end && isIdentifierChar(*p)) ++p;
+    return static_cast<size_t>(p - start);
+}
+
+} // namespace
+
 // =============================================================================
 // ShellLexer Implementation
 // =============================================================================
 
-ShellLexer::ShellLexer(const std::string& source)
+ShellLexer::ShellLexer(std::string_view source)
     : source_(source)
     , current_(0)
     , line_(1)
     , column_(1)
 {
     stateStack_.push(LexerState::ROOT);
-    initKeywords();
-}
-
-void ShellLexer::initKeywords() {
-    // Control flow
-    keywords_["if"] = TokenType::KW_IF;
-    keywords_["else"] = TokenType::KW_ELSE;
-    keywords_["while"] = TokenType::KW_WHILE;
-    keywords_["for"] = TokenType::KW_FOR;
-    keywords_["in"] = TokenType::KW_IN;
-    keywords_["func"] = TokenType::KW_FUNC;
-    keywords_["return"] = TokenType::KW_RETURN;
-    keywords_["break"] = TokenType::KW_BREAK;
-    keywords_["continue"] = TokenType::KW_CONTINUE;
-    keywords_["spawn"] = TokenType::KW_SPAWN;
-    
-    // Types
-    keywords_["int8"] = TokenType::KW_INT8;
-    keywords_["int16"] = TokenType::KW_INT16;
-    keywords_["int32"] = TokenType::KW_INT32;
-    keywords_["int64"] = TokenType::KW_INT64;
-    keywords_["tbb8"] = TokenType::KW_TBB8;
-    keywords_["tbb16"] = TokenType::KW_TBB16;
-    keywords_["tbb32"] = TokenType::KW_TBB32;
-    keywords_["tbb64"] = TokenType::KW_TBB64;
-    keywords_["string"] = TokenType::KW_STRING;
-    keywords_["buffer"] = TokenType::KW_BUFFER;
-    keywords_["bool"] = TokenType::KW_BOOL;
-    keywords_["gc"] = TokenType::KW_GC;
-    keywords_["wild"] = TokenType::KW_WILD;
 }
 
 std::vector<Token> ShellLexer::tokenize() {
     std::vector<Token> tokens;
+    tokens.reserve(source_.length() / 4 + 1);  // ~1 token per 4-6 bytes
     
     while (!isAtEnd()) {
         Token token = nextToken();
@@ -140,12 +266,12 @@ Token ShellLexer::nextToken() {
     }
     
     // Numbers
-    if (std::isdigit(c)) {
+    if (isDigitChar(c)) {
         return scanNumber();
     }
     
     // Identifiers and keywords
-    if (std::isalpha(c) || c == '_') {
+    if (isIdentifierStart(c)) {
         return scanIdentifier();
     }
     
@@ -176,6 +302,21 @@ char ShellLexer::advance() {
     return c;
 }
 
+void ShellLexer::advanceBy(size_t count) {
+    const char* p = source_.data() + current_;
+    const char* end = p + count;
+    current_ += count;
+    
+    // Only newlines need looking at
+    const char* lineStart = nullptr;
+    while (const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p))) {
+        line_++;
+        p = static_cast<const char*>(nl) + 1;
+        lineStart = p;
+    }
+    column_ = lineStart ? 1 + static_cast<size_t>(end - lineStart) : column_ + count;
+}
+
 bool ShellLexer::match(char expected) {
     if (isAtEnd()) return false;
     if (source_[current_] != expected) return false;
@@ -184,7 +325,7 @@ bool ShellLexer::match(char expected) {
     return true;
 }
 
-Token ShellLexer::makeToken(TokenType type, const std::string& lexeme) {
+Token ShellLexer::makeToken(TokenType type, std::string_view lexeme) {
     return Token(type, lexeme, currentLocation());
 }
 
@@ -193,28 +334,35 @@ SourceLocation ShellLexer::currentLocation() const {
 }
 
 void ShellLexer::skipWhitespace() {
-    while (!isAtEnd() && isWhitespace(peek())) {
-        char c = peek();
-        
-        // Newline can be a token in interactive mode
-        if (c == '\n') {
-            // For now, treat as whitespace (require semicolons)
-            advance();
-        } else {
-            advance();
-        }
-    }
+    // Newlines are whitespace too (statements end with semicolons)
+    advanceBy(whitespaceRun(source_.data() + current_, source_.data() + source_.length()));
 }
 
 bool ShellLexer::isWhitespace(char c) const {
-    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    return isWhitespaceChar(c);
 }
 
 Token ShellLexer::scanString(char quote) {
     SourceLocation loc = currentLocation();
     advance();  // Consume opening quote
     
-    std::string value;
+    // Without escapes the value is the source text between the quotes
+    size_t start = current_;
+    size_t end = start;
+    while (end < source_.length() && source_[end] != quote && source_[end] != '\\') {
+        end++;
+    }
+    if (end >= source_.length() || source_[end] == quote) {
+        advanceBy(end - start);
+        std::string_view value = source_.substr(start, end - start);
+        if (!isAtEnd()) {
+            advance();  // Consume closing quote
+        }
+        return Token(TokenType::STRING, value, loc);
+    }
+    
+    std::string value(source_.substr(start, end - start));
+    advanceBy(end - start);
     
     while (!isAtEnd() && peek() != quote) {
         char c = advance();
@@ -249,78 +397,77 @@ Token ShellLexer::scanString(char quote) {
         advance();  // Consume closing quote
     }
     
-    Token token(TokenType::STRING, value, loc);
-    return token;
+    decoded_.push_back(std::move(value));
+    return Token(TokenType::STRING, decoded_.back(), loc);
 }
 
-std::string ShellLexer::scanTemplateString() {
-    std::string value;
-    
-    while (!isAtEnd() && peek() != '`') {
-        char c = advance();
-        
-        // Check for interpolation &{
-        if (c == '&' && peek() == '{') {
-            // TODO: Implement full interpolation parsing
-            // For now, include literally
-            value += c;
-        } else {
-            value += c;
-        }
+std::string_view ShellLexer::scanTemplateString() {
+    // TODO: Implement &{ interpolation; for now the text is taken literally
+    size_t start = current_;
+    size_t end = source_.find('`', start);
+    if (end == std::string_view::npos) {
+        end = source_.length();
     }
+    advanceBy(end - start);
     
     if (!isAtEnd()) {
         advance();  // Consume closing `
         stateStack_.pop();  // Exit template state
     }
     
-    return value;
+    return source_.substr(start, end - start);
 }
 
 Token ShellLexer::scanNumber() {
     SourceLocation loc = currentLocation();
-    std::string value;
+    size_t start = current_;
     
-    while (!isAtEnd() && std::isdigit(peek())) {
-        value += advance();
+    while (!isAtEnd() && isDigitChar(peek())) {
+        current_++;
     }
     
     // Check for decimal point
-    if (peek() == '.' && std::isdigit(peekNext())) {
-        value += advance();  // Consume '.'
+    bool isFloat = false;
+    if (peek() == '.' && isDigitChar(peekNext())) {
+        isFloat = true;
+        current_++;  // Consume '.'
         
-        while (!isAtEnd() && std::isdigit(peek())) {
-            value += advance();
+        while (!isAtEnd() && isDigitChar(peek())) {
+            current_++;
         }
-        
+    }
+    
+    std::string_view value = source_.substr(start, current_ - start);
+    column_ += value.length();
+    const char* first = value.data();
+    const char* last = first + value.length();
+    
+    if (isFloat) {
         Token token(TokenType::FLOAT, value, loc);
-        token.floatValue = std::stod(value);
+        std::from_chars(first, last, token.floatValue);
         return token;
     }
     
     Token token(TokenType::INTEGER, value, loc);
-    token.intValue = std::stoll(value);
+    if (std::from_chars(first, last, token.intValue).ec != std::errc()) {
+        throw std::out_of_range("Integer literal out of range: " + std::string(value));
+    }
     return token;
 }
 
 Token ShellLexer::scanIdentifier() {
     SourceLocation loc = currentLocation();
-    std::string value;
+    size_t length = identifierRun(source_.data() + current_, source_.data() + source_.length());
+    std::string_view value = source_.substr(current_, length);
+    current_ += length;
+    column_ += length;
     
-    while (!isAtEnd() && (std::isalnum(peek()) || peek() == '_')) {
-        value += advance();
-    }
-    
-    TokenType type = identifierType(value);
-    return Token(type, value, loc);
+    return Token(identifierType(value), value, loc);
 }
 
-TokenType ShellLexer::identifierType(const std::string& text) {
-    auto it = keywords_.find(text);
-    if (it != keywords_.end()) {
-        return it->second;
-    }
-    return TokenType::IDENTIFIER;
+TokenType ShellLexer::identifierType(std::string_view text) {
+    const Keyword& keyword = kKeywordTable.slots[keywordHash(text)];
+    return keyword.text == text ? keyword.type : TokenType::IDENTIFIER;
 }
 
 Token ShellLexer::scanOperator() {
@@ -365,6 +512,10 @@ Token ShellLexer::scanOperator() {
             if (match('&')) return makeToken(TokenType::AND, "&&");
             return makeToken(TokenType::BACKGROUND, "&");
             
+        case '$':
+            if (match('(')) return makeToken(TokenType::SUBST_START, "$(");
+            return makeToken(TokenType::UNKNOWN, "$");
+            
         case '|':
             if (match('|')) return makeToken(TokenType::OR, "||");
             return makeToken(TokenType::PIPE, "|");
@@ -387,7 +538,7 @@ Token ShellLexer::scanOperator() {
         case ':': return makeToken(TokenType::COLON, ":");
         
         default:
-            return makeToken(TokenType::UNKNOWN, std::string(1, c));
+            return makeToken(TokenType::UNKNOWN, source_.substr(current_ - 1, 1));
     }
 }
 
@@ -13,16 +13,42 @@ namespace parser {
 // ============================================================================
 
 const Token& ShellParser::peek(int offset) const {
+    if (lexer_) {
+        // Streaming: pull from the lexer as far as the lookahead needs
+        while (buffered_ <= static_cast<size_t>(offset)) {
+            lookahead_[buffered_++] = lexer_->nextToken();
+        }
+        return lookahead_[offset];
+    }
+    
     size_t index = current_ + offset;
-    if (index >= tokens_.size()) {
-        return tokens_.back();  // Return EOF
+    if (index >= tokens_->size()) {
+        return tokens_->back();  // Return EOF
     }
-    return tokens_[index];
+    return (*tokens_)[index];
 }
 
 const Token& ShellParser::consume() {
+    if (lexer_) {
+        if (!isAtEnd()) {
+            previous_ = lookahead_[0];
+            for (size_t i = 1; i < buffered_; i++) {
+                lookahead_[i - 1] = lookahead_[i];
+            }
+            buffered_--;
+        }
+        return previous_;
+    }
+    
     if (!isAtEnd()) current_++;
-    return tokens_[current_ - 1];
+    return previous();
+}
+
+const Token& ShellParser::previous() const {
+    if (lexer_) {
+        return previous_;
+    }
+    return (*tokens_)[current_ - 1];
 }
 
 bool ShellParser::match(TokenType type) {
@@ -56,7 +82,8 @@ bool ShellParser::isAtEnd() const {
 bool ShellParser::isKeywordStart() const {
     TokenType t = peek().type;
     return t == TokenType::KW_IF || t == TokenType::KW_WHILE || 
-           t == TokenType::KW_FOR || t == TokenType::KW_RETURN;
+           t == TokenType::KW_FOR || t == TokenType::KW_RETURN ||
+           t == TokenType::KW_PARALLEL;
 }
 
 bool ShellParser::isTypeKeyword() const {
@@ -74,6 +101,8 @@ bool ShellParser::isAssignmentAhead() const {
 
 std::unique_ptr<Program> ShellParser::parseProgram() {
     auto program = std::make_unique<Program>();
+    arena_ = &program->arena;
+    errorCount_ = 0;
     program->location = peek().location;
     
     while (!isAtEnd()) {
@@ -85,6 +114,7 @@ std::unique_ptr<Program> ShellParser::parseProgram() {
             }
         } catch (const ParseError& e) {
             std::cerr << e.what() << std::endl;
+            ++errorCount_;
             // Synchronize: skip to next statement
             while (!isAtEnd() && peek().type != TokenType::SEMICOLON && 
                    peek().type != TokenType::RBRACE) {
@@ -102,7 +132,7 @@ std::unique_ptr<Program> ShellParser::parseProgram() {
 // Statement Parsing - Disambiguation Logic
 // ============================================================================
 
-std::unique_ptr<StmtNode> ShellParser::parseStatement() {
+NodePtr<StmtNode> ShellParser::parseStatement() {
     
     // Consume optional leading semicolons
     while (match(TokenType::SEMICOLON)) {}
@@ -114,6 +144,7 @@ std::unique_ptr<StmtNode> ShellParser::parseStatement() {
     if (check(TokenType::KW_WHILE)) return parseWhile();
     if (check(TokenType::KW_FOR)) return parseFor();
     if (check(TokenType::KW_RETURN)) return parseReturn();
+    if (check(TokenType::KW_PARALLEL)) return parseParallel();
     if (check(TokenType::LBRACE)) return parseBlock();
     
     // 2. Type check (variable declaration)
@@ -123,34 +154,39 @@ std::unique_ptr<StmtNode> ShellParser::parseStatement() {
     
     // 3. Assignment check
     if (isAssignmentAhead()) {
-        std::string varName = consume().lexeme;
+        std::string varName(consume().lexeme);
         return parseAssignment(varName);
     }
     
     // 4. Expression statement (arithmetic/logical expressions to evaluate)
     // Only treat as expression if there are OPERATORS present
-    if (check(TokenType::INTEGER) || check(TokenType::LPAREN)) {
+    if (check(TokenType::INTEGER) || check(TokenType::LPAREN) || check(TokenType::SUBST_START)) {
         auto expr = parseExpression();
         match(TokenType::SEMICOLON);
-        return std::make_unique<ExprStmt>(std::move(expr), expr->location);
+        return make<ExprStmt>(std::move(expr), expr->location);
     }
     
     if (check(TokenType::IDENTIFIER)) {
         // Peek ahead to check if this is an expression with operators
         TokenType next = peek(1).type;
         
+        // "name < "file"" and "name > "file"" redirect a command; any other
+        // right-hand side makes them comparisons
+        bool redirects = (next == TokenType::LT || next == TokenType::GT) &&
+                         peek(2).type == TokenType::STRING;
+        
         // If followed by arithmetic/logical operator, it's an expression
-        if (next == TokenType::PLUS || next == TokenType::MINUS ||
+        if (!redirects && (next == TokenType::PLUS || next == TokenType::MINUS ||
             next == TokenType::STAR || next == TokenType::SLASH ||
             next == TokenType::EQ || next == TokenType::NE ||
             next == TokenType::LT || next == TokenType::GT ||
             next == TokenType::LE || next == TokenType::GE ||
             next == TokenType::AND || next == TokenType::OR ||
-            next == TokenType::LPAREN) {  // Function call
+            next == TokenType::LPAREN)) {  // Function call
             // Expression statement
             auto expr = parseExpression();
             match(TokenType::SEMICOLON);
-            return std::make_unique<ExprStmt>(std::move(expr), expr->location);
+            return make<ExprStmt>(std::move(expr), expr->location);
         }
     }
     
@@ -162,111 +198,111 @@ std::unique_ptr<StmtNode> ShellParser::parseStatement() {
 // Expression Parsing - Precedence Climbing
 // ============================================================================
 
-std::unique_ptr<ExprNode> ShellParser::parseExpression() {
+NodePtr<ExprNode> ShellParser::parseExpression() {
     return parseLogicalOr();
 }
 
-std::unique_ptr<ExprNode> ShellParser::parseLogicalOr() {
+NodePtr<ExprNode> ShellParser::parseLogicalOr() {
     auto left = parseLogicalAnd();
     
     while (match(TokenType::OR)) {
-        TokenType op = tokens_[current_ - 1].type;
-        SourceLocation loc = tokens_[current_ - 1].location;
+        TokenType op = previous().type;
+        SourceLocation loc = previous().location;
         auto right = parseLogicalAnd();
-        left = std::make_unique<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
+        left = make<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
     }
     
     return left;
 }
 
-std::unique_ptr<ExprNode> ShellParser::parseLogicalAnd() {
+NodePtr<ExprNode> ShellParser::parseLogicalAnd() {
     auto left = parseEquality();
     
     while (match(TokenType::AND)) {
-        TokenType op = tokens_[current_ - 1].type;
-        SourceLocation loc = tokens_[current_ - 1].location;
+        TokenType op = previous().type;
+        SourceLocation loc = previous().location;
         auto right = parseEquality();
-        left = std::make_unique<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
+        left = make<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
     }
     
     return left;
 }
 
-std::unique_ptr<ExprNode> ShellParser::parseEquality() {
+NodePtr<ExprNode> ShellParser::parseEquality() {
     auto left = parseComparison();
     
     while (match(TokenType::EQ) || match(TokenType::NE)) {
-        TokenType op = tokens_[current_ - 1].type;
-        SourceLocation loc = tokens_[current_ - 1].location;
+        TokenType op = previous().type;
+        SourceLocation loc = previous().location;
         auto right = parseComparison();
-        left = std::make_unique<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
+        left = make<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
     }
     
     return left;
 }
 
-std::unique_ptr<ExprNode> ShellParser::parseComparison() {
+NodePtr<ExprNode> ShellParser::parseComparison() {
     auto left = parseAdditive();
     
     while (match(TokenType::LT) || match(TokenType::LE) || 
            match(TokenType::GT) || match(TokenType::GE)) {
-        TokenType op = tokens_[current_ - 1].type;
-        SourceLocation loc = tokens_[current_ - 1].location;
+        TokenType op = previous().type;
+        SourceLocation loc = previous().location;
         auto right = parseAdditive();
-        left = std::make_unique<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
+        left = make<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
     }
     
     return left;
 }
 
-std::unique_ptr<ExprNode> ShellParser::parseAdditive() {
+NodePtr<ExprNode> ShellParser::parseAdditive() {
     auto left = parseMultiplicative();
     
     while (match(TokenType::PLUS) || match(TokenType::MINUS)) {
-        TokenType op = tokens_[current_ - 1].type;
-        SourceLocation loc = tokens_[current_ - 1].location;
+        TokenType op = previous().type;
+        SourceLocation loc = previous().location;
         auto right = parseMultiplicative();
-        left = std::make_unique<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
+        left = make<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
     }
     
     return left;
 }
 
-std::unique_ptr<ExprNode> ShellParser::parseMultiplicative() {
+NodePtr<ExprNode> ShellParser::parseMultiplicative() {
     auto left = parseUnary();
     
     while (match(TokenType::STAR) || match(TokenType::SLASH)) {
-        TokenType op = tokens_[current_ - 1].type;
-        SourceLocation loc = tokens_[current_ - 1].location;
+        TokenType op = previous().type;
+        SourceLocation loc = previous().location;
         auto right = parseUnary();
-        left = std::make_unique<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
+        left = make<BinaryOpExpr>(op, std::move(left), std::move(right), loc);
     }
     
     return left;
 }
 
-std::unique_ptr<ExprNode> ShellParser::parseUnary() {
+NodePtr<ExprNode> ShellParser::parseUnary() {
     if (match(TokenType::MINUS) || match(TokenType::NOT)) {
-        TokenType op = tokens_[current_ - 1].type;
-        SourceLocation loc = tokens_[current_ - 1].location;
+        TokenType op = previous().type;
+        SourceLocation loc = previous().location;
         auto operand = parseUnary();
-        return std::make_unique<UnaryOpExpr>(op, std::move(operand), loc);
+        return make<UnaryOpExpr>(op, std::move(operand), loc);
     }
     
     return parsePrimary();
 }
 
-std::unique_ptr<ExprNode> ShellParser::parsePrimary() {
+NodePtr<ExprNode> ShellParser::parsePrimary() {
     // Integer literal
     if (match(TokenType::INTEGER)) {
-        Token tok = tokens_[current_ - 1];
-        return std::make_unique<IntegerLiteral>(tok.intValue, tok.location);
+        const Token& tok = previous();
+        return make<IntegerLiteral>(tok.intValue, tok.location);
     }
     
     // String literal
     if (match(TokenType::STRING)) {
-        Token tok = tokens_[current_ - 1];
-        return std::make_unique<StringLiteral>(tok.lexeme, tok.location);
+        const Token& tok = previous();
+        return make<StringLiteral>(std::string(tok.lexeme), tok.location);
     }
     
     // Parenthesized expression
@@ -281,15 +317,23 @@ std::unique_ptr<ExprNode> ShellParser::parsePrimary() {
         return parseCallOrVariable();
     }
     
+    // Command substitution
+    if (match(TokenType::SUBST_START)) {
+        SourceLocation loc = previous().location;
+        auto pipeline = parsePipeline();
+        expect(TokenType::RPAREN, "Expected ')' after command substitution");
+        return make<CommandSubstExpr>(std::move(pipeline), loc);
+    }
+    
     throw ParseError("Expected expression", peek().location);
 }
 
-std::unique_ptr<ExprNode> ShellParser::parseCallOrVariable() {
+NodePtr<ExprNode> ShellParser::parseCallOrVariable() {
     Token nameToken = consume();
     
     // Function call
     if (match(TokenType::LPAREN)) {
-        auto call = std::make_unique<CallExpr>(nameToken.lexeme, nameToken.location);
+        auto call = make<CallExpr>(std::string(nameToken.lexeme), nameToken.location);
         
         if (!check(TokenType::RPAREN)) {
             do {
@@ -302,16 +346,16 @@ std::unique_ptr<ExprNode> ShellParser::parseCallOrVariable() {
     }
     
     // Variable
-    return std::make_unique<VariableExpr>(nameToken.lexeme, nameToken.location);
+    return make<VariableExpr>(std::string(nameToken.lexeme), nameToken.location);
 }
 
 // ============================================================================
 // Statement Parsing - Control Flow
 // ============================================================================
 
-std::unique_ptr<BlockStmt> ShellParser::parseBlock() {
+NodePtr<BlockStmt> ShellParser::parseBlock() {
     SourceLocation loc = peek().location;
-    auto block = std::make_unique<BlockStmt>(loc);
+    auto block = make<BlockStmt>(loc);
     
     expect(TokenType::LBRACE, "Expected '{'");
     
@@ -324,17 +368,17 @@ std::unique_ptr<BlockStmt> ShellParser::parseBlock() {
     return block;
 }
 
-std::unique_ptr<VarDeclStmt> ShellParser::parseVarDecl() {
+NodePtr<VarDeclStmt> ShellParser::parseVarDecl() {
     SourceLocation loc = peek().location;
     
     // Type
-    std::string type = consume().lexeme;
+    std::string type(consume().lexeme);
     
     // Variable name
     expect(TokenType::IDENTIFIER, "Expected variable name");
-    std::string name = tokens_[current_ - 1].lexeme;
+    std::string name(previous().lexeme);
     
-    auto decl = std::make_unique<VarDeclStmt>(type, name, loc);
+    auto decl = make<VarDeclStmt>(type, name, loc);
     
     // Optional initializer
     if (match(TokenType::ASSIGN)) {
@@ -345,19 +389,19 @@ std::unique_ptr<VarDeclStmt> ShellParser::parseVarDecl() {
     return decl;
 }
 
-std::unique_ptr<AssignStmt> ShellParser::parseAssignment(const std::string& varName) {
+NodePtr<AssignStmt> ShellParser::parseAssignment(const std::string& varName) {
     SourceLocation loc = peek().location;
     
     expect(TokenType::ASSIGN, "Expected '='");
     auto value = parseExpression();
     
-    auto assign = std::make_unique<AssignStmt>(varName, std::move(value), loc);
+    auto assign = make<AssignStmt>(varName, std::move(value), loc);
     
     match(TokenType::SEMICOLON);
     return assign;
 }
 
-std::unique_ptr<IfStmt> ShellParser::parseIf() {
+NodePtr<IfStmt> ShellParser::parseIf() {
     SourceLocation loc = peek().location;
     
     expect(TokenType::KW_IF, "Expected 'if'");
@@ -367,7 +411,7 @@ std::unique_ptr<IfStmt> ShellParser::parseIf() {
     
     auto thenBranch = parseStatement();
     
-    auto ifStmt = std::make_unique<IfStmt>(std::move(condition), std::move(thenBranch), loc);
+    auto ifStmt = make<IfStmt>(std::move(condition), std::move(thenBranch), loc);
     
     if (match(TokenType::KW_ELSE)) {
         ifStmt->elseBranch = parseStatement();
@@ -376,7 +420,36 @@ std::unique_ptr<IfStmt> ShellParser::parseIf() {
     return ifStmt;
 }
 
-std::unique_ptr<WhileStmt> ShellParser::parseWhile() {
+NodePtr<ParallelStmt> ShellParser::parseParallel() {
+    SourceLocation loc = peek().location;
+    
+    expect(TokenType::KW_PARALLEL, "Expected 'parallel'");
+    auto parallel = make<ParallelStmt>(loc);
+    
+    // Optional concurrency limit: parallel (N) { ... }
+    if (match(TokenType::LPAREN)) {
+        parallel->limit = parseExpression();
+        expect(TokenType::RPAREN, "Expected ')' after parallel limit");
+    }
+    
+    expect(TokenType::LBRACE, "Expected '{' after 'parallel'");
+    while (!check(TokenType::RBRACE) && !isAtEnd()) {
+        while (match(TokenType::SEMICOLON)) {}
+        if (check(TokenType::RBRACE)) break;
+        
+        SourceLocation taskLoc = peek().location;
+        if (!check(TokenType::IDENTIFIER)) {
+            throw ParseError("Only commands and pipelines can run in parallel", taskLoc);
+        }
+        parallel->tasks.push_back(parsePipeline());
+        match(TokenType::SEMICOLON);
+    }
+    expect(TokenType::RBRACE, "Expected '}'");
+    
+    return parallel;
+}
+
+NodePtr<WhileStmt> ShellParser::parseWhile() {
     SourceLocation loc = peek().location;
     
     expect(TokenType::KW_WHILE, "Expected 'while'");
@@ -386,10 +459,10 @@ std::unique_ptr<WhileStmt> ShellParser::parseWhile() {
     
     auto body = parseStatement();
     
-    return std::make_unique<WhileStmt>(std::move(condition), std::move(body), loc);
+    return make<WhileStmt>(std::move(condition), std::move(body), loc);
 }
 
-std::unique_ptr<ForStmt> ShellParser::parseFor() {
+NodePtr<ForStmt> ShellParser::parseFor() {
     SourceLocation loc = peek().location;
     
     expect(TokenType::KW_FOR, "Expected 'for'");
@@ -397,7 +470,7 @@ std::unique_ptr<ForStmt> ShellParser::parseFor() {
     
     // Loop variable
     expect(TokenType::IDENTIFIER, "Expected loop variable");
-    std::string variable = tokens_[current_ - 1].lexeme;
+    std::string variable(previous().lexeme);
     
     expect(TokenType::KW_IN, "Expected 'in' in for loop");
     
@@ -408,15 +481,15 @@ std::unique_ptr<ForStmt> ShellParser::parseFor() {
     
     auto body = parseStatement();
     
-    return std::make_unique<ForStmt>(variable, std::move(iterable), std::move(body), loc);
+    return make<ForStmt>(variable, std::move(iterable), std::move(body), loc);
 }
 
-std::unique_ptr<ReturnStmt> ShellParser::parseReturn() {
+NodePtr<ReturnStmt> ShellParser::parseReturn() {
     SourceLocation loc = peek().location;
     
     expect(TokenType::KW_RETURN, "Expected 'return'");
     
-    auto ret = std::make_unique<ReturnStmt>(loc);
+    auto ret = make<ReturnStmt>(loc);
     
     if (!check(TokenType::SEMICOLON) && !isAtEnd()) {
         ret->value = parseExpression();
@@ -430,9 +503,9 @@ std::unique_ptr<ReturnStmt> ShellParser::parseReturn() {
 // Command Parsing - Shell Mode
 // ============================================================================
 
-std::unique_ptr<PipelineStmt> ShellParser::parsePipeline() {
+NodePtr<PipelineStmt> ShellParser::parsePipeline() {
     SourceLocation loc = peek().location;
-    auto pipeline = std::make_unique<PipelineStmt>(loc);
+    auto pipeline = make<PipelineStmt>(loc);
     
     // Parse first command
     pipeline->commands.push_back(parseCommand());
@@ -448,26 +521,33 @@ std::unique_ptr<PipelineStmt> ShellParser::parsePipeline() {
     return pipeline;
 }
 
-std::unique_ptr<CommandStmt> ShellParser::parseCommand() {
+NodePtr<CommandStmt> ShellParser::parseCommand() {
     SourceLocation loc = peek().location;
     
-    // Command name
-    if (!check(TokenType::IDENTIFIER)) {
+    // Command name ("[" is the test builtin)
+    if (!check(TokenType::IDENTIFIER) && !check(TokenType::LBRACKET)) {
         throw ParseError("Expected command name", peek().location);
     }
-    std::string executable = consume().lexeme;
+    std::string executable(consume().lexeme);
     
-    auto cmd = std::make_unique<CommandStmt>(executable, loc);
+    auto cmd = make<CommandStmt>(executable, loc);
     
-    // Arguments (any identifier or string, not operators)
-    while (check(TokenType::IDENTIFIER) || check(TokenType::STRING) || 
-           check(TokenType::INTEGER) || check(TokenType::MINUS)) {
-        cmd->arguments.push_back(consume().lexeme);
+    // Arguments (any identifier or string, not operators, plus the "]"
+    // that closes "["), with redirections anywhere among them
+    while (true) {
+        if (isRedirectionAhead()) {
+            for (auto& redir : parseRedirections()) {
+                cmd->redirections.push_back(std::move(redir));
+            }
+        } else if (check(TokenType::IDENTIFIER) || check(TokenType::STRING) ||
+                   check(TokenType::INTEGER) || check(TokenType::MINUS) ||
+                   check(TokenType::RBRACKET)) {
+            cmd->arguments.emplace_back(consume().lexeme);
+        } else {
+            break;
+        }
     }
     
-    // Redirections
-    cmd->redirections = parseRedirections();
-    
     // Background
     if (match(TokenType::BACKGROUND)) {
         cmd->background = true;
@@ -476,13 +556,41 @@ std::unique_ptr<CommandStmt> ShellParser::parseCommand() {
     return cmd;
 }
 
+// Redirection prefixes cover the hex-stream FDs (stdin .. stddato)
+static constexpr int64_t kMaxRedirectFd = 5;
+
+static bool isRedirectionOperator(TokenType type) {
+    return type == TokenType::LT || type == TokenType::GT || type == TokenType::REDIRECT_APPEND;
+}
+
+bool ShellParser::isFdPrefixAhead() const {
+    // "2>" names stream 2; "2 >" is an argument followed by ">". Lexemes
+    // view the source, so the character after the digits tells them apart.
+    const Token& digits = peek();
+    if (digits.type != TokenType::INTEGER || digits.intValue < 0 ||
+        digits.intValue > kMaxRedirectFd ||
+        !isRedirectionOperator(peek(1).type)) {
+        return false;
+    }
+    char next = digits.lexeme.data()[digits.lexeme.size()];
+    return next == '<' || next == '>';
+}
+
+bool ShellParser::isRedirectionAhead() const {
+    return isRedirectionOperator(peek().type) || isFdPrefixAhead();
+}
+
 std::vector<Redirection> ShellParser::parseRedirections() {
     std::vector<Redirection> redirects;
     
-    while (check(TokenType::LT) || check(TokenType::GT) || 
-           check(TokenType::REDIRECT_APPEND)) {
+    while (isRedirectionAhead()) {
         Redirection redir;
         
+        // Target stream (optional, e.g. 2> or 5>)
+        if (isFdPrefixAhead()) {
+            redir.fd = static_cast<int>(consume().intValue);
+        }
+        
         if (match(TokenType::LT)) {
             redir.type = RedirectionType::INPUT;
         } else if (match(TokenType::GT)) {
@@ -491,12 +599,9 @@ std::vector<Redirection> ShellParser::parseRedirections() {
             redir.type = RedirectionType::APPEND;
         }
         
-        // File descriptor (optional, e.g., 2>)
-        // For now, assume default fds (0 for <, 1 for >, 2 for 2>)
-        
         // Filename
         if (check(TokenType::STRING) || check(TokenType::IDENTIFIER)) {
-            redir.target = consume().lexeme;
+            redir.target = std::string(consume().lexeme);
         } else {
             throw ParseError("Expected filename after redirection", peek().location);
         }
@@ -10,6 +10,8 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <atomic>
+#include <cwchar>
 
 namespace ariash {
 namespace platform {
@@ -116,6 +118,47 @@ bool WindowsHandleMap::validateHandles() const {
     return true;
 }
 
+// =============================================================================
+// Overlapped Pipes
+// =============================================================================
+
+static constexpr DWORD kPipeBufferSize = 64 * 1024;
+
+bool createOverlappedPipe(HANDLE& readEnd, HANDLE& writeEnd, DWORD bufferSize) {
+    // Names only have to be unique on this machine
+    static std::atomic<unsigned long> serial{0};
+    wchar_t name[64];
+    swprintf(name, 64, L"\\\\.\\pipe\\ariash-%lu-%lu",
+             static_cast<unsigned long>(GetCurrentProcessId()), serial.fetch_add(1));
+
+    if (bufferSize == 0) bufferSize = kPipeBufferSize;
+
+    // NULL security attributes: the read end is not inheritable
+    readEnd = CreateNamedPipeW(name,
+                               PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED |
+                                   FILE_FLAG_FIRST_PIPE_INSTANCE,
+                               PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT |
+                                   PIPE_REJECT_REMOTE_CLIENTS,
+                               1, bufferSize, bufferSize, 0, NULL);
+    if (readEnd == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    // Opening the client end connects the instance; no ConnectNamedPipe
+    SECURITY_ATTRIBUTES saAttr;
+    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
+    saAttr.bInheritHandle = TRUE;
+    saAttr.lpSecurityDescriptor = NULL;
+    writeEnd = CreateFileW(name, GENERIC_WRITE, 0, &saAttr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, NULL);
+    if (writeEnd == INVALID_HANDLE_VALUE) {
+        CloseHandle(readEnd);
+        readEnd = INVALID_HANDLE_VALUE;
+        return false;
+    }
+    return true;
+}
+
 // =============================================================================
 // WindowsBootstrap Implementation
 // =============================================================================
@@ -148,23 +191,21 @@ bool WindowsBootstrap::createPipes() {
     }
     SetHandleInformation(parentHandles_.hStdIn, HANDLE_FLAG_INHERIT, 0);  // Parent write not inherited
     
-    // Create pipe for stdout (Stream 1)
-    if (!CreatePipe(&parentHandles_.hStdOut, &childHandles_.hStdOut, &saAttr, 0)) {
+    // Create pipe for stdout (Stream 1) - parent read end is overlapped
+    // and never inherited
+    if (!createOverlappedPipe(parentHandles_.hStdOut, childHandles_.hStdOut)) {
         return false;
     }
-    SetHandleInformation(parentHandles_.hStdOut, HANDLE_FLAG_INHERIT, 0);  // Parent read not inherited
     
     // Create pipe for stderr (Stream 2)
-    if (!CreatePipe(&parentHandles_.hStdErr, &childHandles_.hStdErr, &saAttr, 0)) {
+    if (!createOverlappedPipe(parentHandles_.hStdErr, childHandles_.hStdErr)) {
         return false;
     }
-    SetHandleInformation(parentHandles_.hStdErr, HANDLE_FLAG_INHERIT, 0);
     
     // Create pipe for stddbg (Stream 3) - child writes debug logs
-    if (!CreatePipe(&parentHandles_.hStdDbg, &childHandles_.hStdDbg, &saAttr, 0)) {
+    if (!createOverlappedPipe(parentHandles_.hStdDbg, childHandles_.hStdDbg)) {
         return false;
     }
-    SetHandleInformation(parentHandles_.hStdDbg, HANDLE_FLAG_INHERIT, 0);
     
     // Create pipe for stddati (Stream 4) - child reads binary data
     if (!CreatePipe(&childHandles_.hStdDatI, &parentHandles_.hStdDatI, &saAttr, 0)) {
@@ -173,14 +214,19 @@ bool WindowsBootstrap::createPipes() {
     SetHandleInformation(parentHandles_.hStdDatI, HANDLE_FLAG_INHERIT, 0);
     
     // Create pipe for stddato (Stream 5) - child writes binary data
-    if (!CreatePipe(&parentHandles_.hStdDatO, &childHandles_.hStdDatO, &saAttr, 0)) {
+    if (!createOverlappedPipe(parentHandles_.hStdDatO, childHandles_.hStdDatO)) {
         return false;
     }
-    SetHandleInformation(parentHandles_.hStdDatO, HANDLE_FLAG_INHERIT, 0);
     
     return true;
 }
 
+void WindowsBootstrap::useChildHandles(const WindowsHandleMap& handles) {
+    closeAll();
+    childHandles_ = handles;
+    ownsChildHandles_ = false;
+}
+
 bool WindowsBootstrap::createStartupInfo(STARTUPINFOEXW& si) {
     ZeroMemory(&si, sizeof(si));
     si.StartupInfo.cb = sizeof(STARTUPINFOEXW);
@@ -350,6 +396,10 @@ void WindowsBootstrap::closeParentHandles() {
 void WindowsBootstrap::closeAll() {
     closeParentHandles();
     
+    if (!ownsChildHandles_) {
+        childHandles_ = WindowsHandleMap();  // The owner closes them
+    }
+    
     // Close child handles
     if (childHandles_.hStdIn != INVALID_HANDLE_VALUE) {
         CloseHandle(childHandles_.hStdIn);
@@ -8,15 +8,40 @@
  * - Executor: Interpretation
  * 
  * This is the user-facing shell interface.
+ * 
+ * Usage:
+ *   ariash                 Interactive REPL (or run stdin if it is not a tty)
+ *   ariash FILE            Run a script file
+ *   ariash -c CODE         Run CODE
+ *   ariash -               Run stdin
+ *   ariash --profile[=PREFIX] FILE | -c CODE | -
+ *                          Run under the profiler (job/profiler.hpp):
+ *                          hotspots on stderr, PREFIX.trace.json and
+ *                          PREFIX.folded written (PREFIX: ariash-profile)
+ * 
+ * The non-interactive modes go straight to the script runner
+ * (executor/script.hpp) without touching the terminal.
  */
 
 #include "repl/input_engine.hpp"
 #include "repl/terminal.hpp"
-#include "parser/lexer.hpp"
+#include "repl/history.hpp"
+#include "repl/completion.hpp"
 #include "parser/parser.hpp"
 #include "executor/executor.hpp"
+#include "executor/script.hpp"
+#include "executor/command_cache.hpp"
+#include "job/io_reactor.hpp"
+#include "job/profiler.hpp"
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
+#include <string>
+#include <cstring>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 using namespace ariash;
 
@@ -45,6 +70,9 @@ void printHelp() {
     std::cout << "  exit / quit   - Exit the shell\n";
     std::cout << "  clear         - Clear the screen\n";
     std::cout << "\n";
+    std::cout << "Builtins (run in-process):\n";
+    std::cout << "  echo, printf, test, true, false, pwd, cd, sleep, hash\n";
+    std::cout << "\n";
     std::cout << "Modal Input System:\n";
     std::cout << "  ESC           - Toggle between RUN and EDIT mode\n";
     std::cout << "\n";
@@ -67,12 +95,40 @@ void printHelp() {
     std::cout << "  Pipelines:    ls | grep test\n";
     std::cout << "\n";
     std::cout << "Other Shortcuts:\n";
+    std::cout << "  Up/Down       - Previous/next history entry (starting with the input)\n";
+    std::cout << "  Ctrl+R        - Search history\n";
+    std::cout << "  Tab           - Complete a command or variable name\n";
     std::cout << "  Ctrl+C        - Cancel current input\n";
     std::cout << "  Ctrl+D        - Exit shell\n";
     std::cout << "  Ctrl+L        - Clear screen\n\n";
 }
 
-int main() {
+void printUsage(std::ostream& out) {
+    out << "Usage: ariash [--profile[=PREFIX]] [FILE | -c CODE | -]\n";
+    out << "  (no arguments)  interactive shell\n";
+    out << "  FILE            run a script\n";
+    out << "  -c CODE         run CODE\n";
+    out << "  -               run standard input\n";
+    out << "  --profile       time every statement: hotspots on stderr,\n";
+    out << "                  PREFIX.trace.json (Chrome trace) and PREFIX.folded\n";
+    out << "                  (flame graph stacks); PREFIX defaults to ariash-profile\n";
+}
+
+static bool stdinIsTerminal() {
+#ifndef _WIN32
+    return isatty(STDIN_FILENO) != 0;
+#else
+    return true;
+#endif
+}
+
+static int runStdin(executor::Environment& env) {
+    std::string source((std::istreambuf_iterator<char>(std::cin)),
+                       std::istreambuf_iterator<char>());
+    return executor::runScript(source, "stdin", env);
+}
+
+int runRepl() {
     // Print banner
     printBanner();
     
@@ -84,6 +140,11 @@ int main() {
     
     // Create input engine
     repl::InputEngine inputEngine(terminal);
+    repl::History history(repl::defaultHistoryPath());
+    inputEngine.setHistory(&history);
+    repl::CompletionIndex completion;  // Lists PATH in the background
+    inputEngine.setCompletion(&completion);
+    int exitStatus = 0;
     
     // Setup input callbacks
     auto onSubmit = [&](const std::string& input) {
@@ -114,13 +175,7 @@ int main() {
             trimmed = trimmed.substr(0, end + 1);
         }
         
-        // Handle built-in commands (case-sensitive for now)
-        if (trimmed == "exit" || trimmed == "quit") {
-            std::cout << "Goodbye!\n";
-            inputEngine.requestExit();
-            return;
-        }
-        
+        // REPL screen commands (the other builtins run in the executor)
         if (trimmed == "help") {
             printHelp();
             return;
@@ -134,24 +189,22 @@ int main() {
         
         // Execute code
         try {
-            // Lex
-            parser::ShellLexer lexer(trimmed);
-            auto tokens = lexer.tokenize();
+            // Lex, parse and compile (cached per source text), then run
+            executor::Executor exec(globalEnv);
+            exec.executeSource(trimmed);
             
-            // Parse
-            parser::ShellParser parser(tokens);
-            auto ast = parser.parseProgram();
+            // exit / quit
+            if (exec.exitRequested()) {
+                std::cout << "Goodbye!\n";
+                exitStatus = exec.getLastStatus();
+                inputEngine.requestExit();
+                return;
+            }
             
-            // Execute only if we have statements
-            if (ast && !ast->statements.empty()) {
-                executor::Executor exec(globalEnv);
-                exec.execute(*ast);
-                
-                // Show result if there was one
-                auto result = exec.getLastResult();
-                if (result) {
-                    std::cout << "=> " << executor::valueToString(*result) << "\n";
-                }
+            // Show result if there was one
+            auto result = exec.getLastResult();
+            if (result) {
+                std::cout << "=> " << executor::valueToString(*result) << "\n";
             }
             
         } catch (const parser::ParseError& e) {
@@ -161,6 +214,10 @@ int main() {
         } catch (...) {
             std::cerr << "Unknown error during execution\n";
         }
+        
+        // New variables, and anything the command installed
+        completion.setVariables(globalEnv.names());
+        completion.refresh();
     };
     
     auto onExit = [&]() {
@@ -174,5 +231,112 @@ int main() {
     // Run the REPL (blocks until exit)
     inputEngine.run();
     
-    return 0;
+    return exitStatus;
+}
+
+// Write the profile of a finished run; false if a file could not be written
+static bool writeProfile(const std::string& prefix) {
+    job::Profiler& profiler = job::getProfiler();
+    profiler.writeHotspots(std::cerr);
+    
+    bool written = true;
+    std::string tracePath = prefix + ".trace.json";
+    std::ofstream trace(tracePath);
+    profiler.writeChromeTrace(trace);
+    if (!trace.flush()) {
+        std::cerr << "ariash: " << tracePath << ": cannot write profile\n";
+        written = false;
+    }
+    std::string foldedPath = prefix + ".folded";
+    std::ofstream folded(foldedPath);
+    profiler.writeFoldedStacks(folded);
+    if (!folded.flush()) {
+        std::cerr << "ariash: " << foldedPath << ": cannot write profile\n";
+        written = false;
+    }
+    if (written) {
+        std::cerr << "ariash: profile written to " << tracePath << " and " << foldedPath << "\n";
+    }
+    return written;
+}
+
+static int runArguments(int argc, char** argv, executor::Environment& env) {
+    if (argc < 2) {
+        return runStdin(env);  // Piped input: nothing to be interactive with
+    }
+    
+    const char* arg = argv[1];
+    if (std::strcmp(arg, "-c") == 0) {
+        if (argc < 3) {
+            std::cerr << "ariash: -c: option requires an argument\n";
+            printUsage(std::cerr);
+            return 2;
+        }
+        // argv outlives the run, so tokens view it directly
+        return executor::runScript(argv[2], "-c", env);
+    }
+    if (std::strcmp(arg, "-") == 0) {
+        return runStdin(env);
+    }
+    if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+        printUsage(std::cout);
+        return 0;
+    }
+    if (std::strcmp(arg, "--version") == 0) {
+        std::cout << "ariash 0.1.0\n";
+        return 0;
+    }
+    if (arg[0] == '-') {
+        std::cerr << "ariash: " << arg << ": invalid option\n";
+        printUsage(std::cerr);
+        return 2;
+    }
+    
+    return executor::runScriptFile(arg, env);
+}
+
+int main(int argc, char** argv) {
+    executor::Environment env;
+    
+    // --profile[=PREFIX] comes first; the rest is parsed as usual
+    std::string profilePrefix;
+    if (argc >= 2 && std::strncmp(argv[1], "--profile", 9) == 0 &&
+        (argv[1][9] == '\0' || argv[1][9] == '=')) {
+        profilePrefix = argv[1][9] == '=' ? argv[1] + 10 : "ariash-profile";
+        if (profilePrefix.empty()) {
+            std::cerr << "ariash: --profile=: empty prefix\n";
+            return 2;
+        }
+        argv[1] = argv[0];
+        ++argv;
+        --argc;
+        if (argc < 2 && stdinIsTerminal()) {
+            std::cerr << "ariash: --profile: no script to run\n";
+            printUsage(std::cerr);
+            return 2;
+        }
+    }
+    
+    if (argc < 2 && stdinIsTerminal()) {
+        return runRepl();
+    }
+    
+    // Short-lived from here on: PATH watches and an io_uring instance
+    // cost more to set up and tear down than they save (without watches
+    // the command cache searches PATH again on every miss, so commands a
+    // script installs are found at once)
+    executor::getCommandCache().setWatchesEnabled(false);
+    job::preferReadinessBackend();
+    
+    if (profilePrefix.empty()) {
+        return runArguments(argc, argv, env);
+    }
+    
+    job::getProfiler().start();
+    int status = runArguments(argc, argv, env);
+    job::getProfiler().stop();
+    if (!writeProfile(profilePrefix) && status == 0) {
+        status = 1;
+    }
+    return status;
 }
@@ -0,0 +1,192 @@
+/**
+ * Completion Index Implementation
+ */
+
+#include "repl/completion.hpp"
+#include "executor/builtins.hpp"
+#include "executor/command_cache.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace ariash {
+namespace repl {
+
+// Executables in `path` (nothing if it cannot be read)
+static std::vector<std::string> listExecutables(const std::string& path) {
+    std::vector<std::string> names;
+#ifndef _WIN32
+    DIR* dir = opendir(path.empty() ? "." : path.c_str());
+    if (!dir) return names;
+
+    // Same test as command lookup: anything executable but a directory
+    int fd = dirfd(dir);
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.' &&
+            (entry->d_name[1] == '\0' || (entry->d_name[1] == '.' && entry->d_name[2] == '\0'))) {
+            continue;
+        }
+        if (entry->d_type == DT_DIR) continue;
+
+        struct stat st;
+        if (fstatat(fd, entry->d_name, &st, 0) == 0 &&
+            !S_ISDIR(st.st_mode) && (st.st_mode & S_IXUSR)) {
+            names.emplace_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+#else
+    (void)path;
+#endif
+    return names;
+}
+
+CompletionIndex::CompletionIndex()
+    : worker_(&CompletionIndex::worker, this) {
+}
+
+CompletionIndex::~CompletionIndex() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    worker_.join();
+}
+
+void CompletionIndex::refresh() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++requested_;
+    }
+    wake_.notify_one();
+}
+
+void CompletionIndex::setVariables(std::vector<std::string> names) {
+    std::sort(names.begin(), names.end());
+    variables_ = std::move(names);
+}
+
+bool CompletionIndex::ready() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return commands_ != nullptr;
+}
+
+void CompletionIndex::waitForRefresh() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = requested_;
+    published_.wait(lock, [&] { return completed_ >= target; });
+}
+
+uint64_t CompletionIndex::directoryScans() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scans_;
+}
+
+std::vector<std::string> CompletionIndex::complete(std::string_view prefix, size_t limit) const {
+    std::shared_ptr<const Names> commands;
+    {
+        // Held only to copy the pointer: the worker never scans under it
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands = commands_;
+    }
+
+    auto matching = [prefix](const Names& names) {
+        auto first = std::lower_bound(names.begin(), names.end(), prefix,
+                                      [](const std::string& a, std::string_view b) { return a < b; });
+        auto last = first;
+        while (last != names.end() && std::string_view(*last).substr(0, prefix.size()) == prefix) {
+            ++last;
+        }
+        return std::make_pair(first, last);
+    };
+
+    std::vector<std::string> result;
+    auto [varFirst, varLast] = matching(variables_);
+    if (commands) {
+        auto [first, last] = matching(*commands);
+        result.reserve(static_cast<size_t>((last - first) + (varLast - varFirst)));
+        std::set_union(first, last, varFirst, varLast, std::back_inserter(result));
+    } else {
+        result.assign(varFirst, varLast);
+    }
+
+    if (limit > 0 && result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
+}
+
+void CompletionIndex::worker() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return stop_ || completed_ < requested_; });
+        if (stop_) return;
+        uint64_t target = requested_;
+
+        lock.unlock();
+        rebuild();
+        lock.lock();
+
+        completed_ = target;
+        published_.notify_all();
+    }
+}
+
+bool CompletionIndex::rebuild() {
+    std::vector<executor::CommandCache::DirectoryVersion> directories =
+        executor::getCommandCache().directories();
+
+    // List only the directories invalidated since their last listing
+    bool changed = false;
+    std::unordered_set<std::string> current;
+    uint64_t scans = 0;
+    for (const auto& dir : directories) {
+        if (!current.insert(dir.path).second) continue;  // Listed twice in PATH
+
+        auto it = listings_.find(dir.path);
+        if (it != listings_.end() && it->second.version == dir.version) continue;
+
+        Listing& listing = listings_[dir.path];
+        listing.version = dir.version;
+        listing.names = listExecutables(dir.path);
+        ++scans;
+        changed = true;
+    }
+    for (auto it = listings_.begin(); it != listings_.end(); ) {
+        if (current.count(it->first) == 0) {
+            it = listings_.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scans_ += scans;
+        first = commands_ == nullptr;
+    }
+    if (!changed && !first) return false;
+
+    auto commands = std::make_shared<Names>(executor::getBuiltins().names());
+    for (const auto& pair : listings_) {
+        commands->insert(commands->end(), pair.second.names.begin(), pair.second.names.end());
+    }
+    std::sort(commands->begin(), commands->end());
+    commands->erase(std::unique(commands->begin(), commands->end()), commands->end());
+    commands->shrink_to_fit();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    commands_ = std::move(commands);
+    return true;
+}
+
+} // namespace repl
+} // namespace ariash
@@ -0,0 +1,311 @@
+/**
+ * History Implementation
+ */
+
+#include "repl/history.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ariash {
+namespace repl {
+
+// Entries indexed per lock of indexMutex_
+static constexpr size_t kIndexBatch = 4096;
+
+static uint32_t trigramAt(const char* p) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(p[0])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(p[1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(p[2]));
+}
+
+// Distinct trigrams of `text`
+static void trigramsOf(std::string_view text, std::vector<uint32_t>& out) {
+    out.clear();
+    for (size_t i = 0; i + 3 <= text.size(); ++i) {
+        out.push_back(trigramAt(text.data() + i));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+static bool matches(std::string_view entry, std::string_view text, bool prefix) {
+    return prefix ? entry.substr(0, text.size()) == text
+                  : entry.find(text) != std::string_view::npos;
+}
+
+// Start of the entry ending (NUL excluded) at `end`, not before `floor`
+static size_t entryStart(const char* data, size_t floor, size_t end) {
+    if (end <= floor) return floor;
+    const void* nul = memrchr(data + floor, '\0', end - floor);
+    return nul ? static_cast<size_t>(static_cast<const char*>(nul) - data) + 1 : floor;
+}
+
+// Newest matching entry in [floor, limit); limit is an entry boundary
+static std::optional<size_t> scan(const char* data, size_t floor, size_t limit,
+                                  std::string_view text, bool prefix) {
+    size_t end = limit;
+    while (end > floor) {
+        size_t start = entryStart(data, floor, end - 1);
+        if (matches(std::string_view(data + start, end - 1 - start), text, prefix)) {
+            return start;
+        }
+        end = start;
+    }
+    return std::nullopt;
+}
+
+std::string defaultHistoryPath() {
+    if (const char* file = std::getenv("ARIASH_HISTFILE")) {
+        return file;
+    }
+    const char* home = std::getenv("HOME");
+    return home && *home ? std::string(home) + "/.ariash_history" : std::string();
+}
+
+#ifndef _WIN32
+
+History::Mapping::~Mapping() {
+    if (data) {
+        munmap(const_cast<char*>(data), size);
+    }
+}
+
+History::History(std::string path)
+    : path_(std::move(path)) {
+    if (path_.empty()) {
+        indexDone_ = true;
+        return;
+    }
+
+    fd_ = open(path_.c_str(), O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    if (fd_ < 0) {
+        indexDone_ = true;
+        return;
+    }
+
+    refresh();
+    base_ = end_;
+    indexedFrom_ = base_;
+
+    if (map_ && base_ > 0) {
+        indexer_ = std::thread(&History::buildIndex, this, map_, base_);
+    } else {
+        indexDone_ = true;
+    }
+}
+
+History::~History() {
+    stop_ = true;
+    if (indexer_.joinable()) {
+        indexer_.join();
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void History::waitForIndex() {
+    if (indexer_.joinable()) {
+        indexer_.join();
+    }
+}
+
+void History::refresh() {
+    struct stat st;
+    if (fd_ < 0 || fstat(fd_, &st) < 0) return;
+
+    size_t size = static_cast<size_t>(st.st_size);
+    if (map_ ? size == map_->size : size == 0) return;
+
+    // Remapped rather than grown: the indexer keeps its own mapping
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) return;
+
+    auto map = std::make_shared<Mapping>();
+    map->data = static_cast<const char*>(data);
+    map->size = size;
+
+    // A write still in progress leaves an entry without its NUL: ignore it
+    const void* nul = memrchr(map->data, '\0', size);
+    end_ = nul ? static_cast<size_t>(static_cast<const char*>(nul) - map->data) + 1 : 0;
+    map_ = std::move(map);
+}
+
+bool History::add(const std::string& entry) {
+    if (fd_ < 0) return false;
+
+    std::string record;
+    record.reserve(entry.size() + 1);
+    for (char c : entry) {
+        if (c != '\0') record += c;
+    }
+    if (record.find_first_not_of(" \t\n") == std::string::npos) {
+        return false;
+    }
+
+    // Consecutive duplicates are kept once
+    if (auto newest = findPrefix("")) {
+        if (entryAt(*newest) == record) return false;
+    }
+    record += '\0';
+
+    // One write under the lock: sessions never interleave within an entry
+    if (flock(fd_, LOCK_EX) < 0) return false;
+    const char* next = record.data();
+    size_t left = record.size();
+    while (left > 0) {
+        ssize_t written = write(fd_, next, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        next += written;
+        left -= static_cast<size_t>(written);
+    }
+    flock(fd_, LOCK_UN);
+    return left == 0;
+}
+
+std::string History::entryAt(size_t offset) {
+    refresh();
+    if (!map_ || offset >= end_) return std::string();
+    const char* start = map_->data + offset;
+    return std::string(start, strnlen(start, end_ - offset));
+}
+
+std::optional<size_t> History::findPrefix(std::string_view prefix, size_t before) {
+    return find(prefix, true, before);
+}
+
+std::optional<size_t> History::findSubstring(std::string_view text, size_t before) {
+    return find(text, false, before);
+}
+
+std::optional<size_t> History::find(std::string_view text, bool prefix, size_t before) {
+    refresh();
+    std::shared_ptr<const Mapping> map = map_;
+    if (!map) return std::nullopt;
+
+    size_t limit = std::min(before, end_);
+
+    // Written since open: not indexed, and the newest anyway
+    if (limit > base_) {
+        if (auto hit = scan(map->data, base_, limit, text, prefix)) return hit;
+        limit = base_;
+    }
+
+    // Shorter patterns have no trigram: scanned, like what is not indexed yet
+    if (text.size() >= 3) {
+        std::lock_guard<std::mutex> lock(indexMutex_);
+        if (limit > indexedFrom_) {
+            if (auto hit = findIndexed(text, prefix, *map, limit)) return hit;
+            limit = indexedFrom_;
+        }
+    }
+    return scan(map->data, 0, limit, text, prefix);
+}
+
+// Caller holds indexMutex_
+std::optional<size_t> History::findIndexed(std::string_view text, bool prefix,
+                                           const Mapping& map, size_t limit) {
+    std::vector<uint32_t> grams;
+    trigramsOf(text, grams);
+
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (uint32_t gram : grams) {
+        auto it = postings_.find(gram);
+        if (it == postings_.end()) return std::nullopt;
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](auto* a, auto* b) { return a->size() < b->size(); });
+
+    // Ids run newest first; start at the first entry older than `limit`
+    uint32_t firstId = static_cast<uint32_t>(
+        std::partition_point(offsets_.begin(), offsets_.end(),
+                             [limit](size_t offset) { return offset >= limit; }) -
+        offsets_.begin());
+
+    const std::vector<uint32_t>& shortest = *lists.front();
+    for (auto it = std::lower_bound(shortest.begin(), shortest.end(), firstId);
+         it != shortest.end(); ++it) {
+        bool inAll = std::all_of(lists.begin() + 1, lists.end(), [id = *it](auto* list) {
+            return std::binary_search(list->begin(), list->end(), id);
+        });
+        if (!inAll) continue;
+
+        // Trigrams in common are necessary, not sufficient
+        size_t start = offsets_[*it];
+        const char* entry = map.data + start;
+        if (matches(std::string_view(entry, strnlen(entry, map.size - start)), text, prefix)) {
+            return start;
+        }
+    }
+    return std::nullopt;
+}
+
+void History::buildIndex(std::shared_ptr<const Mapping> map, size_t end) {
+    std::unordered_map<uint32_t, std::vector<uint32_t>> batch;
+    std::vector<size_t> starts;
+    std::vector<uint32_t> grams;
+    uint32_t nextId = 0;
+
+    while (end > 0 && !stop_.load(std::memory_order_relaxed)) {
+        // A batch of entries, newest first, indexed without the lock
+        batch.clear();
+        starts.clear();
+        for (size_t n = 0; n < kIndexBatch && end > 0; ++n) {
+            size_t start = entryStart(map->data, 0, end - 1);
+            trigramsOf(std::string_view(map->data + start, end - 1 - start), grams);
+            for (uint32_t gram : grams) {
+                batch[gram].push_back(nextId);
+            }
+            starts.push_back(start);
+            ++nextId;
+            end = start;
+        }
+
+        std::lock_guard<std::mutex> lock(indexMutex_);
+        for (auto& [gram, ids] : batch) {
+            auto& list = postings_[gram];
+            list.insert(list.end(), ids.begin(), ids.end());
+        }
+        offsets_.insert(offsets_.end(), starts.begin(), starts.end());
+        indexedFrom_ = end;
+    }
+
+    indexDone_.store(true, std::memory_order_release);
+}
+
+#else
+
+// Windows: no persistent history yet
+History::Mapping::~Mapping() {}
+History::History(std::string path) : path_(std::move(path)) { indexDone_ = true; }
+History::~History() {}
+void History::waitForIndex() {}
+void History::refresh() {}
+bool History::add(const std::string&) { return false; }
+std::string History::entryAt(size_t) { return std::string(); }
+std::optional<size_t> History::findPrefix(std::string_view, size_t) { return std::nullopt; }
+std::optional<size_t> History::findSubstring(std::string_view, size_t) { return std::nullopt; }
+std::optional<size_t> History::find(std::string_view, bool, size_t) { return std::nullopt; }
+std::optional<size_t> History::findIndexed(std::string_view, bool, const Mapping&, size_t) {
+    return std::nullopt;
+}
+void History::buildIndex(std::shared_ptr<const Mapping>, size_t) {}
+
+#endif
+
+} // namespace repl
+} // namespace ariash
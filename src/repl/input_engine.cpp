@@ -8,6 +8,8 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <iterator>
+#include <string_view>
 
 namespace ariash {
 namespace repl {
@@ -27,6 +29,7 @@ void EditBuffer::insertChar(char32_t ch) {
     }
     
     std::string& line = lines_[cursor_.line];
+    invalidateFrom(cursor_.line);
     
     // Simple ASCII for now (TODO: full UTF-8 support)
     if (ch < 128) {
@@ -41,6 +44,7 @@ void EditBuffer::insertNewline() {
     }
     
     // Split current line at cursor
+    invalidateFrom(cursor_.line);
     std::string& currentLine = lines_[cursor_.line];
     std::string remainder = currentLine.substr(cursor_.column);
     currentLine = currentLine.substr(0, cursor_.column);
@@ -53,7 +57,48 @@ void EditBuffer::insertNewline() {
     cursor_.column = 0;
 }
 
+void EditBuffer::insertText(const std::string& text) {
+    if (cursor_.line >= lines_.size()) {
+        lines_.resize(cursor_.line + 1);
+    }
+    invalidateFrom(cursor_.line);
+    
+    // Kept byte for byte (UTF-8 included); other control characters
+    // than tab are dropped
+    auto append = [](std::string& line, std::string_view segment) {
+        for (char c : segment) {
+            if (static_cast<unsigned char>(c) >= 32 || c == '\t') {
+                line += c;
+            }
+        }
+    };
+    
+    std::string& first = lines_[cursor_.line];
+    std::string tail = first.substr(cursor_.column);
+    first.erase(cursor_.column);
+    
+    std::string_view rest(text);
+    size_t newline = rest.find('\n');
+    append(first, rest.substr(0, newline));
+    
+    // All new lines go in with one insert, however long the paste
+    std::vector<std::string> added;
+    while (newline != std::string_view::npos) {
+        rest.remove_prefix(newline + 1);
+        newline = rest.find('\n');
+        added.emplace_back();
+        append(added.back(), rest.substr(0, newline));
+    }
+    lines_.insert(lines_.begin() + static_cast<std::ptrdiff_t>(cursor_.line) + 1,
+                  std::make_move_iterator(added.begin()), std::make_move_iterator(added.end()));
+    
+    cursor_.line += added.size();
+    cursor_.column = lines_[cursor_.line].length();
+    lines_[cursor_.line] += tail;
+}
+
 void EditBuffer::backspace() {
+    invalidateFrom(cursor_.line > 0 && cursor_.column == 0 ? cursor_.line - 1 : cursor_.line);
     if (cursor_.column > 0) {
         // Delete character before cursor on current line
         lines_[cursor_.line].erase(cursor_.column - 1, 1);
@@ -69,6 +114,7 @@ void EditBuffer::backspace() {
 }
 
 void EditBuffer::deleteChar() {
+    invalidateFrom(cursor_.line);
     if (cursor_.column < lines_[cursor_.line].length()) {
         // Delete character at cursor
         lines_[cursor_.line].erase(cursor_.column, 1);
@@ -80,6 +126,7 @@ void EditBuffer::deleteChar() {
 }
 
 void EditBuffer::clear() {
+    lineStates_.clear();
     lines_.clear();
     lines_.push_back("");
     cursor_ = BufferPosition{0, 0};
@@ -146,7 +193,12 @@ std::string EditBuffer::getContent() const {
 }
 
 int EditBuffer::getBraceDepth() const {
-    return calculateBraceDepth(getContent());
+    // Rescan only the lines edited since the last call
+    while (lineStates_.size() < lines_.size()) {
+        LineState start = lineStates_.empty() ? LineState{} : lineStates_.back();
+        lineStates_.push_back(scanLine(lines_[lineStates_.size()], start));
+    }
+    return lineStates_.back().depth;
 }
 
 bool EditBuffer::isBalanced() const {
@@ -158,69 +210,66 @@ bool EditBuffer::hasSyntaxError() const {
     return getBraceDepth() < 0;
 }
 
-int EditBuffer::calculateBraceDepth(const std::string& content) const {
-    int depth = 0;
-    bool inString = false;
-    char quoteChar = 0;
-    bool inComment = false;
-    
-    for (size_t i = 0; i < content.length(); ++i) {
-        char c = content[i];
+void EditBuffer::invalidateFrom(size_t line) {
+    if (lineStates_.size() > line) {
+        lineStates_.resize(line);
+    }
+}
+
+EditBuffer::LineState EditBuffer::scanLine(const std::string& line, LineState state) {
+    for (size_t i = 0; i < line.length(); ++i) {
+        char c = line[i];
         
-        // Handle comment state
-        if (inComment) {
-            if (c == '\n') inComment = false;
+        // Handle string state (strings may span lines)
+        if (state.quote) {
+            if (c == state.quote && (i == 0 || line[i - 1] != '\\')) {
+                state.quote = 0;
+            }
             continue;
         }
         
-        // Check for comment start
-        if (c == '/' && i + 1 < content.length() && content[i + 1] == '/') {
-            inComment = true;
-            i++;
-            continue;
-        }
-        
-        // Handle string state
-        if (inString) {
-            if (c == quoteChar && (i == 0 || content[i - 1] != '\\')) {
-                inString = false;
-            }
-            continue;
+        // Comment: the rest of the line
+        if (c == '/' && i + 1 < line.length() && line[i + 1] == '/') {
+            break;
         }
         
         // Check for string start
         if (c == '"' || c == '\'' || c == '`') {
-            inString = true;
-            quoteChar = c;
+            state.quote = c;
             continue;
         }
         
         // Count braces outside strings and comments
         if (c == '{' || c == '[' || c == '(') {
-            depth++;
+            state.depth++;
         } else if (c == '}' || c == ']' || c == ')') {
-            depth--;
+            state.depth--;
         }
     }
     
-    return depth;
+    return state;
+}
+
+// Last non-whitespace characters of the buffer, up to `count`, last first
+static std::string lastNonSpace(const std::vector<std::string>& lines, size_t count) {
+    std::string found;
+    for (size_t i = lines.size(); i-- > 0 && found.size() < count;) {
+        const std::string& line = lines[i];
+        for (size_t j = line.size(); j-- > 0 && found.size() < count;) {
+            char c = line[j];
+            if (c != ' ' && c != '\t' && c != '\r') {
+                found += c;
+            }
+        }
+    }
+    return found;
 }
 
 bool EditBuffer::shouldAutoSubmit() const {
     // Auto-submit if:
     // 1. Braces are balanced (no unclosed braces)
     // 2. Content ends with semicolon (indicating statement completion)
-    
-    std::string content = getContent();
-    
-    // Trim trailing whitespace
-    size_t lastNonSpace = content.find_last_not_of(" \t\n\r");
-    if (lastNonSpace == std::string::npos) {
-        return false;  // Empty or all whitespace
-    }
-    
-    // Check if ends with semicolon
-    if (content[lastNonSpace] != ';') {
+    if (lastNonSpace(lines_, 1) != ";") {
         return false;
     }
     
@@ -230,26 +279,7 @@ bool EditBuffer::shouldAutoSubmit() const {
 
 bool EditBuffer::endsWithDoubleSemicolon() const {
     // Check if buffer ends with ;; (ignoring whitespace)
-    std::string content = getContent();
-    
-    // Trim trailing whitespace
-    size_t end = content.find_last_not_of(" \t\n\r");
-    if (end == std::string::npos || end < 1) {
-        return false;  // Empty or too short
-    }
-    
-    // Check for two semicolons
-    if (content[end] != ';') {
-        return false;
-    }
-    
-    // Find previous non-whitespace character
-    size_t prev = content.find_last_not_of(" \t\n\r", end - 1);
-    if (prev == std::string::npos) {
-        return false;
-    }
-    
-    return content[prev] == ';';
+    return lastNonSpace(lines_, 2) == ";;";
 }
 
 void EditBuffer::ensureCursorValid() {
@@ -268,6 +298,8 @@ void EditBuffer::ensureCursorValid() {
 InputEngine::InputEngine(PlatformTerminal& terminal)
     : terminal_(terminal)
     , state_(InputState::IDLE)
+    , dirty_(false)
+    , viewTop_(0)
     , running_(false)
     , continuationMode_(false)
     , editMode_(false)  // Start in RUN mode (Enter submits)
@@ -284,27 +316,19 @@ void InputEngine::run() {
     running_ = true;
     state_ = InputState::IDLE;
     
-    renderPrompt();
+    renderer_.reset();
+    render();
     
     while (running_) {
         auto event = terminal_.readEvent();
-        if (!event) {
-            continue;  // Timeout, keep waiting
+        if (event) {
+            handleEvent(*event);
         }
         
-        switch (state_) {
-            case InputState::IDLE:
-                handleIdle(*event);
-                break;
-            case InputState::BUFFER_MANIPULATION:
-                handleBufferManipulation(*event);
-                break;
-            case InputState::CHORD_ANALYSIS:
-                handleChordAnalysis(*event);
-                break;
-            case InputState::SUBMISSION:
-                handleSubmission();
-                break;
+        // While keys keep arriving, apply them all and draw at most one
+        // frame per refresh interval
+        if (dirty_ && running_ && (!terminal_.hasPendingInput() || renderer_.frameDue())) {
+            render();
         }
     }
     
@@ -312,16 +336,40 @@ void InputEngine::run() {
     terminal_.restoreMode();
 }
 
+void InputEngine::handleEvent(const KeyEvent& event) {
+    if (event.type != KeyType::TAB && !candidates_.empty()) {
+        candidates_.clear();
+        requestRender();
+    }
+    
+    if (searching_) {
+        handleSearch(event);
+        return;
+    }
+    
+    switch (state_) {
+        case InputState::IDLE:
+            handleIdle(event);
+            break;
+        case InputState::BUFFER_MANIPULATION:
+            handleBufferManipulation(event);
+            break;
+        case InputState::CHORD_ANALYSIS:
+            handleChordAnalysis(event);
+            break;
+        case InputState::SUBMISSION:
+            handleSubmission();
+            break;
+    }
+}
+
 void InputEngine::handleIdle(const KeyEvent& event) {
     // Transition to appropriate state based on input
     
     // ESC toggles between RUN and EDIT mode
     if (event.type == KeyType::ESCAPE) {
         editMode_ = !editMode_;
-        std::string mode = editMode_ ? "EDIT" : "RUN";
-        std::cout << " [" << mode << " MODE]";
-        std::cout << "\r\033[K";  // Clear line
-        renderPrompt();
+        requestRender();
         return;
     }
     
@@ -351,15 +399,16 @@ void InputEngine::handleIdle(const KeyEvent& event) {
     
     // Handle direct actions
     if (event.type == KeyType::CTRL_C) {
+        endFrame("^C");
         buffer_.clear();
-        std::cout << "^C\n";
-        renderPrompt();
+        continuationMode_ = false;
+        requestRender();
         return;
     }
     
     if (event.type == KeyType::CTRL_D) {
         if (buffer_.isEmpty()) {
-            std::cout << "\n";
+            endFrame();
             if (exitCallback_) {
                 exitCallback_();
             }
@@ -367,15 +416,22 @@ void InputEngine::handleIdle(const KeyEvent& event) {
         }
         return;
     }
+    
+    // Cursor keys and the rest edit the buffer too
+    state_ = InputState::BUFFER_MANIPULATION;
+    handleBufferManipulation(event);
 }
 
 void InputEngine::handleBufferManipulation(const KeyEvent& event) {
-    // Process editing commands
+    // Process editing commands; each one just marks the frame dirty
+    
+    // Any edit makes the entry shown the new draft
+    if (event.type != KeyType::ARROW_UP && event.type != KeyType::ARROW_DOWN) {
+        browsed_.clear();
+    }
     
     if (event.type == KeyType::CHARACTER) {
         buffer_.insertChar(event.codepoint);
-        // Echo the character (simple echo for now, cursor at end)
-        std::cout << static_cast<char>(event.codepoint) << std::flush;
     }
     else if (event.type == KeyType::ENTER) {
         // Mode-dependent behavior
@@ -385,66 +441,72 @@ void InputEngine::handleBufferManipulation(const KeyEvent& event) {
                 // Remove the extra semicolon before submitting
                 buffer_.backspace();  // Remove one ;
                 state_ = InputState::SUBMISSION;
-                std::cout << "\n";
                 handleSubmission();
                 return;
             }
             
             // Otherwise, add newline for multi-line editing
             buffer_.insertNewline();
-            std::cout << "\n";
             continuationMode_ = true;
-            renderPrompt();
             applyAutoIndent();
         } else {
             // RUN mode: Enter always submits
             state_ = InputState::SUBMISSION;
-            std::cout << "\n";
             handleSubmission();
             return;
         }
     }
+    else if (event.type == KeyType::PASTE) {
+        buffer_.insertText(event.text);  // Never submits, even in RUN mode
+    }
     else if (event.type == KeyType::BACKSPACE) {
         buffer_.backspace();
-        std::cout << "\b \b" << std::flush;  // Erase character
     }
     else if (event.type == KeyType::DELETE) {
         buffer_.deleteChar();
     }
     else if (event.type == KeyType::ARROW_LEFT) {
         buffer_.moveCursorLeft();
-        renderCursor();
     }
     else if (event.type == KeyType::ARROW_RIGHT) {
         buffer_.moveCursorRight();
-        renderCursor();
     }
     else if (event.type == KeyType::ARROW_UP) {
-        buffer_.moveCursorUp();
-        renderCursor();
+        // History from the first line, like moving up past the top
+        if (buffer_.getCursor().line > 0 || !historyPrevious()) {
+            buffer_.moveCursorUp();
+        }
     }
     else if (event.type == KeyType::ARROW_DOWN) {
-        buffer_.moveCursorDown();
-        renderCursor();
+        if (buffer_.getCursor().line + 1 < buffer_.lineCount() || !historyNext()) {
+            buffer_.moveCursorDown();
+        }
+    }
+    else if (event.type == KeyType::CTRL_R && history_) {
+        searching_ = true;
+        draft_ = buffer_.getContent();
+        query_.clear();
+        match_.reset();
+        matchText_.clear();
+    }
+    else if (event.type == KeyType::TAB) {
+        completeWord();
     }
     else if (event.type == KeyType::HOME) {
         buffer_.moveCursorToLineStart();
-        renderCursor();
     }
     else if (event.type == KeyType::END) {
         buffer_.moveCursorToLineEnd();
-        renderCursor();
     }
     else if (event.type == KeyType::CTRL_C) {
+        endFrame("^C");
         buffer_.clear();
-        std::cout << "^C\n";
         continuationMode_ = false;
-        renderPrompt();
     }
     else if (event.type == KeyType::CTRL_L) {
         clearScreen();
-        renderBuffer();
     }
+    requestRender();
     
     // Check for chord transitions
     if (event.modifiers & KeyModifiers::CTRL) {
@@ -472,17 +534,17 @@ void InputEngine::handleChordAnalysis(const KeyEvent& event) {
     }
     
     if (event.type == KeyType::CTRL_C) {
+        endFrame("^C");
         buffer_.clear();
-        std::cout << "^C\n";
         continuationMode_ = false;
-        renderPrompt();
+        requestRender();
         state_ = InputState::IDLE;
         return;
     }
     
     if (event.type == KeyType::CTRL_D) {
         if (buffer_.isEmpty()) {
-            std::cout << "\n";
+            endFrame();
             if (exitCallback_) {
                 exitCallback_();
             }
@@ -516,8 +578,14 @@ void InputEngine::handleSubmission() {
         return;
     }
     
-    // Valid submission!
-    std::cout << "\n";  // Move to new line after code
+    // Valid submission! The code stays on screen, output goes below it
+    endFrame();
+    std::cout << "\n";
+    
+    if (history_) {
+        history_->add(code);
+    }
+    browsed_.clear();
     
     if (submissionCallback_) {
         submissionCallback_(code);
@@ -527,65 +595,226 @@ void InputEngine::handleSubmission() {
     buffer_.clear();
     continuationMode_ = false;
     state_ = InputState::IDLE;
-    renderPrompt();
+    requestRender();
 }
 
-std::string InputEngine::getPrompt() const {
-    std::string modeIndicator = editMode_ ? "[EDIT] " : "[RUN] ";
+void InputEngine::handleSearch(const KeyEvent& event) {
+    // Incremental: every change to the query searches again from the newest
+    if (event.type == KeyType::CHARACTER && event.codepoint >= 32 && event.codepoint < 127) {
+        query_ += static_cast<char>(event.codepoint);
+        searchHistory(std::string::npos);
+    }
+    else if (event.type == KeyType::PASTE) {
+        query_ += event.text;
+        searchHistory(std::string::npos);
+    }
+    else if (event.type == KeyType::BACKSPACE) {
+        if (!query_.empty()) {
+            query_.pop_back();
+        }
+        searchHistory(std::string::npos);
+    }
+    else if (event.type == KeyType::CTRL_R) {
+        // Next older match (the current one stays if there is none)
+        if (match_) {
+            std::optional<size_t> current = match_;
+            searchHistory(*match_);
+            if (!match_) {
+                match_ = current;
+                matchText_ = history_->entryAt(*current);
+            }
+        }
+    }
+    else if (event.type == KeyType::ESCAPE || event.type == KeyType::CTRL_C) {
+        searching_ = false;  // Cancel: the buffer was never touched
+    }
+    else {
+        // Anything else accepts the match and then acts on it as usual,
+        // except Enter, which only accepts
+        searching_ = false;
+        if (match_) {
+            loadBuffer(matchText_);
+        }
+        if (event.type != KeyType::ENTER) {
+            handleEvent(event);
+        }
+    }
+    requestRender();
+}
+
+void InputEngine::searchHistory(size_t before) {
+    match_ = query_.empty() ? std::nullopt : history_->findSubstring(query_, before);
+    matchText_ = match_ ? history_->entryAt(*match_) : std::string();
+}
+
+bool InputEngine::historyPrevious() {
+    if (!history_) return false;
+    if (browsed_.empty()) {
+        draft_ = buffer_.getContent();
+    }
     
-    if (continuationMode_) {
-        // Continuation prompt with indent hint
-        int indent = calculateIndent();
-        return modeIndicator + std::string(indent * 2, ' ') + "... ";
+    // Entries starting with the draft; the same text twice is shown once
+    std::string current = buffer_.getContent();
+    size_t before = browsed_.empty() ? std::string::npos : browsed_.back();
+    while (auto hit = history_->findPrefix(draft_, before)) {
+        std::string text = history_->entryAt(*hit);
+        if (text != current) {
+            browsed_.push_back(*hit);
+            loadBuffer(text);
+            return true;
+        }
+        before = *hit;
     }
-    return modeIndicator + "aria> ";
+    return !browsed_.empty();  // Oldest match: stay on it
 }
 
-void InputEngine::toggleMode() {
-    editMode_ = !editMode_;
+bool InputEngine::historyNext() {
+    if (browsed_.empty()) return false;
+    browsed_.pop_back();
+    loadBuffer(browsed_.empty() ? draft_ : history_->entryAt(browsed_.back()));
+    return true;
+}
+
+void InputEngine::loadBuffer(const std::string& text) {
+    buffer_.clear();
+    buffer_.insertText(text);
+}
+
+void InputEngine::completeWord() {
+    if (!completion_) return;
     
-    // Clear line and reprint prompt with new mode
-    std::cout << "\r\033[K";  // Clear line
-    renderPrompt();
-    renderBuffer();
+    // The word ends at the cursor and starts after a separator
+    const std::string& line = buffer_.getLines()[buffer_.getCursor().line];
+    size_t end = buffer_.getCursor().column;
+    size_t start = line.find_last_of(" \t(){}[];|&<>=,!\"'", end > 0 ? end - 1 : 0);
+    start = (start == std::string::npos || end == 0) ? 0 : start + 1;
+    std::string word = line.substr(start, end - start);
+    
+    // Answered from the index as it stands; changes show up next time
+    std::vector<std::string> matches = completion_->complete(word);
+    completion_->refresh();
+    if (word.empty() || matches.empty()) return;
+    
+    // Extend to what all matches share; a single match is finished off
+    size_t common = matches.front().size();
+    for (const auto& match : matches) {
+        auto diverge = std::mismatch(matches.front().begin(), matches.front().begin() + common,
+                                     match.begin(), match.end());
+        common = static_cast<size_t>(diverge.first - matches.front().begin());
+    }
+    std::string extension = matches.front().substr(word.size(), common - word.size());
+    if (matches.size() == 1) {
+        extension += ' ';
+    }
+    
+    if (!extension.empty()) {
+        buffer_.insertText(extension);
+    } else {
+        candidates_ = std::move(matches);  // Nothing to add: list them
+    }
 }
 
-void InputEngine::renderPrompt() {
-    std::cout << getPrompt() << std::flush;
+std::string InputEngine::candidateRow() const {
+    static constexpr size_t kShownCandidates = 50;
+    
+    std::string row;
+    for (size_t i = 0; i < candidates_.size() && i < kShownCandidates; ++i) {
+        if (i > 0) row += "  ";
+        row += candidates_[i];
+    }
+    if (candidates_.size() > kShownCandidates) {
+        row += "  (" + std::to_string(candidates_.size() - kShownCandidates) + " more)";
+    }
+    return row;
 }
 
-void InputEngine::renderBuffer() {
-    // Redraw entire buffer (for clear-screen)
-    std::cout << "\r";  // Carriage return
-    renderPrompt();
+std::string InputEngine::linePrompt(size_t line) const {
+    std::string modeIndicator = editMode_ ? "[EDIT] " : "[RUN] ";
     
-    auto lines = buffer_.getLines();
-    for (size_t i = 0; i < lines.size(); ++i) {
-        std::cout << lines[i];
-        if (i < lines.size() - 1) {
-            std::cout << "\n";
-            renderPrompt();
-        }
+    // Continuation lines carry their indent in the buffer (applyAutoIndent)
+    return modeIndicator + (line == 0 ? "aria> " : "... ");
+}
+
+std::string InputEngine::getPrompt() const {
+    return linePrompt(buffer_.getCursor().line);
+}
+
+Frame InputEngine::composeFrame(size_t maxRows) {
+    if (searching_) {
+        // (reverse-i-search)`query': first line of the match
+        std::string label = std::string(match_ || query_.empty() ? "" : "failed ") +
+                            "(reverse-i-search)`" + query_;
+        Frame frame;
+        frame.rows.push_back(label + "': " + matchText_.substr(0, matchText_.find('\n')));
+        frame.cursorColumn = label.size();
+        return frame;
+    }
+    
+    const std::vector<std::string>& lines = buffer_.getLines();
+    BufferPosition cursor = buffer_.getCursor();
+    
+    // Scroll the window just enough to keep the cursor in it (the
+    // candidate list takes a row of its own)
+    if (!candidates_.empty() && maxRows > 1) {
+        --maxRows;
+    }
+    size_t rows = maxRows > 0 ? std::min(maxRows, lines.size()) : lines.size();
+    viewTop_ = std::min(viewTop_, lines.size() - rows);
+    if (cursor.line < viewTop_) {
+        viewTop_ = cursor.line;
+    } else if (cursor.line >= viewTop_ + rows) {
+        viewTop_ = cursor.line - rows + 1;
+    }
+    
+    Frame frame;
+    frame.rows.reserve(rows);
+    for (size_t i = viewTop_; i < viewTop_ + rows; ++i) {
+        frame.rows.push_back(linePrompt(i) + lines[i]);
+    }
+    
+    if (!candidates_.empty()) {
+        frame.rows.push_back(candidateRow());
     }
     
-    std::cout << std::flush;
+    frame.cursorRow = cursor.line - viewTop_;
+    frame.cursorColumn = linePrompt(cursor.line).size() + cursor.column;
+    return frame;
 }
 
-void InputEngine::renderCursor() {
-    // TODO: ANSI cursor movement sequences
-    // For now, just flush (cursor movement happens via arrow keys)
-    std::cout << std::flush;
+void InputEngine::toggleMode() {
+    editMode_ = !editMode_;
+    requestRender();
+}
+
+void InputEngine::render() {
+    std::cout.flush();  // Anything printed around the input area goes first
+    auto [columns, height] = terminal_.getSize();  // 0 when the tty does not know
+    renderer_.setWidth(columns > 0 ? static_cast<size_t>(columns) : 0);
+    
+    // A frame taller than the screen would scroll rows out of reach
+    size_t maxRows = height > 1 ? static_cast<size_t>(height - 1) : 0;
+    renderer_.present(composeFrame(maxRows));
+    dirty_ = false;
+}
+
+void InputEngine::endFrame(const std::string& trailer) {
+    if (dirty_) {
+        render();
+    }
+    renderer_.finish(trailer);
 }
 
 void InputEngine::clearScreen() {
-    // ANSI clear screen: ESC[2J ESC[H
-    std::cout << "\x1B[2J\x1B[H" << std::flush;
+    // ANSI clear screen, sent with the next frame
+    renderer_.clearScreen();
+    requestRender();
 }
 
 void InputEngine::showError(const std::string& message) {
-    // Red error message
-    std::cout << "\n\x1B[31m" << message << "\x1B[0m\n";
-    renderPrompt();
+    // Red error message; the buffer is redrawn below it for fixing
+    endFrame();
+    std::cout << "\x1B[31m" << message << "\x1B[0m\n" << std::flush;
+    requestRender();
 }
 
 int InputEngine::calculateIndent() const {
@@ -597,9 +826,8 @@ void InputEngine::applyAutoIndent() {
     // Automatically indent based on brace depth
     int indent = calculateIndent();
     std::string spaces(indent * 2, ' ');
-    std::cout << spaces << std::flush;
     
-    // Insert spaces into buffer
+    // Insert spaces into buffer (the next frame shows them)
     for (char c : spaces) {
         buffer_.insertChar(c);
     }
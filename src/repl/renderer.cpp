@@ -0,0 +1,214 @@
+/**
+ * Frame Renderer Implementation
+ */
+
+#include "repl/renderer.hpp"
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace ariash {
+namespace repl {
+
+// CSI n <final>: cursor up/down/forward
+static void cursorMove(std::string& out, size_t count, char direction) {
+    out += "\x1B[";
+    out += std::to_string(count);
+    out += direction;
+}
+
+FrameRenderer::FrameRenderer(int fd)
+    : fd_(fd) {
+    setRefreshRate(kDefaultRefreshRate);
+    reset();
+}
+
+void FrameRenderer::setRefreshRate(unsigned int hz) {
+    interval_ = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::seconds(1)) / std::max(hz, 1u);
+}
+
+bool FrameRenderer::frameDue() const {
+    return std::chrono::steady_clock::now() - lastFrame_ >= interval_;
+}
+
+void FrameRenderer::reset() {
+    screen_.clear();
+    rowsUsed_ = 1;
+    row_ = 0;
+    column_ = 0;
+}
+
+void FrameRenderer::clearScreen() {
+    pending_ = "\x1B[2J\x1B[H";
+    reset();
+}
+
+void FrameRenderer::layout(const Frame& frame, std::vector<std::string>& rows,
+                           size_t& cursorRow, size_t& cursorColumn) const {
+    rows.clear();
+    cursorRow = 0;
+    cursorColumn = 0;
+
+    for (size_t i = 0; i < frame.rows.size(); ++i) {
+        const std::string& text = frame.rows[i];
+        size_t first = rows.size();
+
+        for (size_t start = 0; start < text.size(); start += width_) {
+            rows.push_back(text.substr(start, width_));
+        }
+        if (text.empty()) {
+            rows.emplace_back();
+        }
+
+        if (i == frame.cursorRow) {
+            size_t column = std::min(frame.cursorColumn, text.size());
+            cursorRow = first + column / width_;
+            cursorColumn = column % width_;
+            // Cursor just past a row that fills the last physical row:
+            // it is shown at the start of a row of its own
+            if (cursorRow == rows.size()) {
+                rows.emplace_back();
+            }
+        }
+    }
+
+    if (rows.empty()) {
+        rows.emplace_back();
+    }
+}
+
+void FrameRenderer::moveTo(std::string& out, size_t row, size_t column) {
+    if (row > row_) {
+        // Rows the frame already occupies are reached without scrolling;
+        // new ones are opened at the bottom
+        size_t onScreen = std::min(row, rowsUsed_ - 1);
+        if (onScreen > row_) {
+            cursorMove(out, onScreen - row_, 'B');
+            row_ = onScreen;
+            column_ = std::min(column_, width_ - 1);
+        }
+        while (row_ < row) {
+            out += "\r\n";
+            ++row_;
+            column_ = 0;
+        }
+        rowsUsed_ = std::max(rowsUsed_, row_ + 1);
+    } else if (row < row_) {
+        cursorMove(out, row_ - row, 'A');
+        row_ = row;
+        column_ = std::min(column_, width_ - 1);
+    }
+
+    // Columns are set from the left edge: exact even after a row that
+    // filled the width left the terminal waiting to wrap
+    if (column != column_) {
+        out += '\r';
+        if (column > 0) {
+            cursorMove(out, column, 'C');
+        }
+        column_ = column;
+    }
+}
+
+std::string FrameRenderer::render(const Frame& frame) {
+    std::vector<std::string> rows;
+    size_t cursorRow, cursorColumn;
+    layout(frame, rows, cursorRow, cursorColumn);
+
+    std::string out;
+    out.swap(pending_);
+
+    size_t count = std::max(rows.size(), screen_.size());
+    for (size_t r = 0; r < count; ++r) {
+        if (r < rows.size()) {
+            const std::string& text = rows[r];
+            size_t from = 0;
+            bool shorter = false;
+
+            if (r < screen_.size()) {
+                const std::string& old = screen_[r];
+                if (old == text) continue;
+                auto diverge = std::mismatch(text.begin(), text.end(), old.begin(), old.end());
+                from = static_cast<size_t>(diverge.first - text.begin());
+                shorter = old.size() > text.size();
+            }
+
+            moveTo(out, r, from);
+            out.append(text, from, std::string::npos);
+            column_ = text.size();
+            if (shorter) {
+                out += "\x1B[K";  // Erase the old row's tail
+            }
+        } else if (!screen_[r].empty()) {
+            // Row no longer part of the frame
+            moveTo(out, r, 0);
+            out += "\x1B[K";
+        }
+    }
+
+    moveTo(out, cursorRow, cursorColumn);
+    screen_ = std::move(rows);
+
+    ++frames_;
+    bytes_ += out.size();
+    lastFrame_ = std::chrono::steady_clock::now();
+    return out;
+}
+
+void FrameRenderer::present(const Frame& frame) {
+    std::string out = render(frame);
+    if (!out.empty()) {
+        write(out);
+    }
+}
+
+void FrameRenderer::finish(const std::string& trailer) {
+    std::string out;
+    out.swap(pending_);
+
+    if (!screen_.empty()) {
+        size_t last = screen_.size() - 1;
+        if (screen_[last].size() < width_) {
+            moveTo(out, last, screen_[last].size());
+        } else {
+            // Full row: the trailer goes on a row of its own
+            moveTo(out, last, 0);
+            out += "\r\n";
+        }
+    }
+    out += trailer;
+    out += "\r\n";
+
+    bytes_ += out.size();
+    write(out);
+    reset();
+}
+
+void FrameRenderer::write(const std::string& data) {
+    if (fd_ < 0) return;
+
+    const char* next = data.data();
+    size_t left = data.size();
+    while (left > 0) {
+#ifdef _WIN32
+        int written = ::_write(fd_, next, static_cast<unsigned int>(left));
+#else
+        ssize_t written = ::write(fd_, next, left);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        next += written;
+        left -= static_cast<size_t>(written);
+    }
+}
+
+} // namespace repl
+} // namespace ariash
@@ -81,6 +81,11 @@ bool PlatformTerminal::enterRawMode() {
         return false;
     }
     
+    // Bracketed paste: the terminal wraps pastes in ESC[200~ ... ESC[201~
+    if (isatty(STDOUT_FILENO)) {
+        bracketedPaste_ = write(STDOUT_FILENO, "\x1B[?2004h", 8) == 8;
+    }
+    
     rawModeActive_ = true;
     return true;
 }
@@ -88,6 +93,10 @@ bool PlatformTerminal::enterRawMode() {
 void PlatformTerminal::restoreMode() {
     if (!rawModeActive_) return;
     
+    if (bracketedPaste_) {
+        bracketedPaste_ = write(STDOUT_FILENO, "\x1B[?2004l", 8) != 8;
+    }
+    
     if (termiosValid_) {
         tcsetattr(STDIN_FILENO, TCSAFLUSH, &originalTermios_);
     }
@@ -153,72 +162,144 @@ bool PlatformTerminal::detectXTermModifyKeys() {
     return true;
 }
 
+// Bracketed paste markers (DEC private mode 2004)
+static const std::string kPasteStart = "\x1B[200~";
+static const std::string kPasteEnd = "\x1B[201~";
+
+// How long to wait for the rest of a split escape sequence, and for the
+// next block of a paste still in flight
+static constexpr int kSequenceTimeoutMs = 50;
+static constexpr int kPasteTimeoutMs = 1000;
+
 std::optional<KeyEvent> PlatformTerminal::readEvent() {
-    char buf[8];
-    ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+    if (events_.empty()) {
+        if (!fillInput(0)) {
+            return std::nullopt;  // Timeout or error
+        }
+        decodeInput();
+    }
     
+    if (events_.empty()) {
+        return std::nullopt;  // Only unrecognised bytes
+    }
+    KeyEvent event = std::move(events_.front());
+    events_.pop_front();
+    return event;
+}
+
+bool PlatformTerminal::fillInput(int timeout_ms) {
+    if (timeout_ms > 0) {
+        struct pollfd pfd;
+        pfd.fd = STDIN_FILENO;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            return false;
+        }
+    }
+    
+    // Everything the terminal has at once: a paste or key repeat is
+    // decoded from this one block
+    char buf[4096];
+    ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
     if (n <= 0) {
-        return std::nullopt;  // Timeout or error
+        return false;
     }
+    input_.append(buf, static_cast<size_t>(n));
+    return true;
+}
+
+void PlatformTerminal::decodeInput() {
+    size_t pos = 0;
+    while (pos < input_.size()) {
+        size_t used = decodeEvent(pos, false);
+        if (used == 0) {
+            // Incomplete: the rest of a sequence or paste is on its way,
+            // unless nothing arrives in time
+            bool pasting = input_.compare(pos, kPasteStart.size(), kPasteStart) == 0;
+            if (!fillInput(pasting ? kPasteTimeoutMs : kSequenceTimeoutMs)) {
+                used = decodeEvent(pos, true);
+            }
+        }
+        pos += used;
+    }
+    input_.erase(0, pos);
+}
+
+// Decode the event starting at input_[pos]; 0 if more bytes are needed
+// (with `final`, whatever is there is taken as it is)
+size_t PlatformTerminal::decodeEvent(size_t pos, bool final) {
+    const std::string& in = input_;
+    unsigned char c = static_cast<unsigned char>(in[pos]);
     
-    // Single byte: simple character or control code
-    if (n == 1) {
-        unsigned char c = buf[0];
-        
+    if (c != 0x1B) {
         // Control characters
-        if (c == 0x03) return KeyEvent{KeyType::CTRL_C};
-        if (c == 0x04) return KeyEvent{KeyType::CTRL_D};
-        if (c == 0x0C) return KeyEvent{KeyType::CTRL_L};
-        if (c == 0x1A) return KeyEvent{KeyType::CTRL_Z};
-        if (c == 0x0D || c == 0x0A) return KeyEvent{KeyType::ENTER};
-        if (c == 0x7F || c == 0x08) return KeyEvent{KeyType::BACKSPACE};
-        if (c == 0x09) return KeyEvent{KeyType::TAB};
-        if (c == 0x1B) {
-            // Standalone ESC (wait to see if sequence follows)
-            struct pollfd pfd;
-            pfd.fd = STDIN_FILENO;
-            pfd.events = POLLIN;
-            
-            if (poll(&pfd, 1, 50) <= 0) {
-                // No follow-up: genuine ESC key
-                return KeyEvent{KeyType::ESCAPE};
-            }
-            
-            // Sequence follows, recurse to parse it
-            return parseEscapeSequence();
+        if (c == 0x03) events_.emplace_back(KeyType::CTRL_C);
+        else if (c == 0x04) events_.emplace_back(KeyType::CTRL_D);
+        else if (c == 0x0C) events_.emplace_back(KeyType::CTRL_L);
+        else if (c == 0x12) events_.emplace_back(KeyType::CTRL_R);
+        else if (c == 0x1A) events_.emplace_back(KeyType::CTRL_Z);
+        else if (c == 0x0D || c == 0x0A) events_.emplace_back(KeyType::ENTER);
+        else if (c == 0x7F || c == 0x08) events_.emplace_back(KeyType::BACKSPACE);
+        else if (c == 0x09) events_.emplace_back(KeyType::TAB);
+        // Printable ASCII or UTF-8 byte (TODO: full UTF-8 decoder)
+        else if (c >= 32) {
+            events_.emplace_back(KeyType::CHARACTER, KeyModifiers::NONE, static_cast<char32_t>(c));
         }
-        
-        // Printable ASCII or UTF-8 start byte
-        if (c >= 32 && c < 127) {
-            return KeyEvent{KeyType::CHARACTER, KeyModifiers::NONE, static_cast<char32_t>(c)};
+        return 1;
+    }
+    
+    if (pos + 1 >= in.size()) {
+        // ESC with nothing after it (yet): genuine ESC once the wait is over
+        if (!final) return 0;
+        events_.emplace_back(KeyType::ESCAPE);
+        return 1;
+    }
+    
+    size_t end;  // Last byte of the sequence
+    if (in[pos + 1] == '[') {
+        // CSI: parameters and intermediates up to a final byte 0x40-0x7E
+        end = pos + 2;
+        while (end < in.size() && (in[end] < 0x40 || in[end] > 0x7E)) {
+            ++end;
+        }
+    } else if (in[pos + 1] == 'O') {
+        end = pos + 2;  // SS3 (F1-F4)
+    } else {
+        end = pos + 1;  // ESC + key (Alt+Enter)
+    }
+    if (end >= in.size()) {
+        return final ? in.size() - pos : 0;  // Drop a truncated sequence
+    }
+    
+    std::string seq = in.substr(pos, end - pos + 1);
+    if (seq == kPasteStart) {
+        size_t close = in.find(kPasteEnd, end + 1);
+        if (close == std::string::npos && !final) {
+            return 0;
         }
+        size_t stop = close == std::string::npos ? in.size() : close;
         
-        // UTF-8 multi-byte (TODO: full UTF-8 decoder)
-        if (c >= 0x80) {
-            return KeyEvent{KeyType::CHARACTER, KeyModifiers::NONE, static_cast<char32_t>(c)};
+        KeyEvent paste(KeyType::PASTE);
+        paste.text.reserve(stop - end - 1);
+        for (size_t i = end + 1; i < stop; ++i) {
+            if (in[i] == '\r') {
+                paste.text += '\n';
+                if (i + 1 < stop && in[i + 1] == '\n') ++i;  // CRLF
+            } else {
+                paste.text += in[i];
+            }
         }
+        events_.push_back(std::move(paste));
+        return (close == std::string::npos ? in.size() : close + kPasteEnd.size()) - pos;
     }
     
-    // Multi-byte sequence: likely escape code
-    if (n > 1 && buf[0] == 0x1B) {
-        std::string seq(buf, n);
-        return parseAnsiSequence(seq);
+    if (auto event = decodeSequence(seq)) {
+        events_.push_back(std::move(*event));
     }
-    
-    return std::nullopt;
+    return seq.size();
 }
 
-std::optional<KeyEvent> PlatformTerminal::parseEscapeSequence() {
-    char buf[32];
-    ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
-    
-    if (n <= 0) {
-        return KeyEvent{KeyType::ESCAPE};  // Timeout: genuine ESC
-    }
-    
-    std::string seq = "\x1B";
-    seq.append(buf, n);
-    
+std::optional<KeyEvent> PlatformTerminal::decodeSequence(const std::string& seq) {
     // Check protocol-specific sequences
     if (protocolLevel_ == ProtocolLevel::KITTY_PROGRESSIVE) {
         auto kittyEvent = parseKittySequence(seq);
@@ -348,6 +429,16 @@ std::optional<KeyEvent> PlatformTerminal::parseXTermSequence(const std::string&
     return KeyEvent{KeyType::CHARACTER, mods, static_cast<char32_t>(codepoint)};
 }
 
+bool PlatformTerminal::hasPendingInput() const {
+    if (!events_.empty()) {
+        return true;
+    }
+    struct pollfd pfd;
+    pfd.fd = STDIN_FILENO;
+    pfd.events = POLLIN;
+    return poll(&pfd, 1, 0) > 0;
+}
+
 std::pair<int, int> PlatformTerminal::getSize() const {
     struct winsize ws;
     if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) < 0) {
@@ -571,6 +662,11 @@ std::optional<KeyEvent> PlatformTerminal::convertWindowsEvent(const KEY_EVENT_RE
     return std::nullopt;
 }
 
+bool PlatformTerminal::hasPendingInput() const {
+    DWORD count = 0;
+    return GetNumberOfConsoleInputEvents(hStdin_, &count) && count > 0;
+}
+
 std::pair<int, int> PlatformTerminal::getSize() const {
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     if (GetConsoleScreenBufferInfo(hStdout_, &csbi)) {
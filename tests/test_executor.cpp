@@ -5,9 +5,25 @@
 #include "parser/lexer.hpp"
 #include "parser/parser.hpp"
 #include "executor/executor.hpp"
+#include "executor/command_cache.hpp"
+#include "executor/program_cache.hpp"
+#include "executor/script.hpp"
+#include "executor/optimizer.hpp"
+#include "job/task_pool.hpp"
+#include "job/profiler.hpp"
 #include <iostream>
 #include <cassert>
 #include <sstream>
+#include <map>
+#include <optional>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <csignal>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 
 using namespace ariash;
 
@@ -246,10 +262,10 @@ void test_string_operations() {
     exec.execute(*ast);
     
     auto greeting = env.get("greeting");
-    assert(std::holds_alternative<std::string>(greeting));
-    assert(std::get<std::string>(greeting) == "Hello Aria");
+    assert(std::holds_alternative<executor::SharedString>(greeting));
+    assert(std::get<executor::SharedString>(greeting) == "Hello Aria");
     
-    std::cout << "greeting = \"" << std::get<std::string>(greeting) << "\"\n";
+    std::cout << "greeting = \"" << std::get<executor::SharedString>(greeting) << "\"\n";
     std::cout << "✓ String concatenation working\n";
 }
 
@@ -303,6 +319,1061 @@ void test_command_execution() {
     */
 }
 
+// Run code and return everything the executor wrote to stdout
+static std::string runCaptured(const std::string& code, int64_t* exitCode) {
+    parser::ShellLexer lexer(code);
+    auto tokens = lexer.tokenize();
+    parser::ShellParser parser(tokens);
+    auto ast = parser.parseProgram();
+    
+    executor::Environment env;
+    executor::Executor exec(env);
+    
+    std::ostringstream captured;
+    std::streambuf* saved = std::cout.rdbuf(captured.rdbuf());
+    exec.execute(*ast);
+    std::cout.rdbuf(saved);
+    
+    auto result = exec.getLastResult();
+    *exitCode = (result && std::holds_alternative<int64_t>(*result))
+                    ? std::get<int64_t>(*result) : -1;
+    return captured.str();
+}
+
+void test_pipeline_execution() {
+    std::cout << "\n=== Test: Pipeline Execution ===\n";
+    
+    int64_t status = -1;
+    std::string out = runCaptured("echo hello pipeline | cat | cat;", &status);
+    std::cout << "Output: " << out;
+    assert(out == "hello pipeline\n");
+    assert(status == 0);
+    
+    // Pipefail: rightmost failing stage wins, success only if all succeed
+    runCaptured("false | true;", &status);
+    assert(status == 1);
+    runCaptured("true | false;", &status);
+    assert(status == 1);
+    runCaptured("true | true;", &status);
+    assert(status == 0);
+    std::cout << "Pipefail status: " << status << "\n";
+    
+    std::cout << "✓ Multi-command pipelines working\n";
+}
+
+void test_command_cache() {
+    std::cout << "\n=== Test: Command Cache ===\n";
+    
+    executor::CommandCache& cache = executor::getCommandCache();
+    
+    // Private PATH directory in front of the system one
+    char dirTemplate[] = "/tmp/ariash_hash_XXXXXX";
+    std::string dir = mkdtemp(dirTemplate);
+    std::string savedPath = std::getenv("PATH") ? std::getenv("PATH") : "";
+    setenv("PATH", (dir + ":/usr/bin:/bin").c_str(), 1);
+    
+    const std::string probe = "ariash_hash_probe";
+    const std::string probePath = dir + "/" + probe;
+    
+    // Not in PATH yet: returned as given, and the negative answer is cached
+    std::string resolved = cache.resolve(probe);
+    assert(resolved == probe);
+    
+    // Tight loop: only the first lookup searches PATH
+    auto before = cache.getStats();
+    for (int i = 0; i < 1000; ++i) {
+        resolved = cache.resolve("sh");
+    }
+    auto after = cache.getStats();
+    std::cout << "sh -> " << resolved << ", misses in loop: "
+              << (after.misses - before.misses) << "\n";
+    assert(after.misses - before.misses == 1);
+    assert(after.hits - before.hits == 999);
+    
+    // Creating the command must invalidate the negative entry (inotify,
+    // or the mtime fallback once a second)
+    {
+        std::ofstream script(probePath);
+        script << "#!/bin/sh\necho probe\n";
+    }
+    chmod(probePath.c_str(), 0755);
+    for (int i = 0; i < 30 && cache.resolve(probe) != probePath; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    resolved = cache.resolve(probe);
+    std::cout << "After create: " << resolved << "\n";
+    assert(resolved == probePath);
+    
+    // ...and removing it drops the positive entry
+    unlink(probePath.c_str());
+    for (int i = 0; i < 30 && cache.resolve(probe) != probe; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    resolved = cache.resolve(probe);
+    std::cout << "After remove: " << resolved << "\n";
+    assert(resolved == probe);
+    
+    // hash -r empties the table
+    int64_t status = -1;
+    runCaptured("hash \"-r\";", &status);
+    assert(status == 0);
+    size_t remaining = cache.entries().size();
+    std::cout << "Entries after hash -r: " << remaining << "\n";
+    assert(remaining == 0);
+    
+    // hash NAME fills it; a PATH change starts over
+    runCaptured("hash sh;", &status);
+    assert(status == 0 && cache.entries().size() == 1);
+    setenv("PATH", savedPath.c_str(), 1);
+    assert(cache.entries().size() == 1);  // Rekeyed lazily on next lookup
+    cache.resolve("sh");
+    std::cout << "Entries after PATH change: " << cache.entries().size() << "\n";
+    
+    rmdir(dir.c_str());
+    std::cout << "✓ Hashed PATH lookups working\n";
+}
+
+// Run a program through the VM and through the reference tree-walker
+struct RunOutcome {
+    std::string error;
+    std::optional<executor::Value> lastResult;
+    std::map<std::string, std::string> values;
+};
+
+static RunOutcome runProgram(const std::string& code, bool treeWalk,
+                             const std::vector<std::string>& names,
+                             bool optimizeTree = false) {
+    parser::ShellLexer lexer(code);
+    auto tokens = lexer.tokenize();
+    parser::ShellParser parser(tokens);
+    auto ast = parser.parseProgram();
+    if (treeWalk && optimizeTree) {
+        executor::Optimizer().optimize(*ast);  // execute() does this itself
+    }
+
+    executor::Environment env;
+    executor::Executor exec(env);
+    RunOutcome outcome;
+    try {
+        if (treeWalk) {
+            ast->accept(exec);
+        } else {
+            exec.execute(*ast);
+        }
+    } catch (const std::exception& e) {
+        outcome.error = e.what();
+    }
+    outcome.lastResult = exec.getLastResult();
+    for (const auto& name : names) {
+        outcome.values[name] = env.exists(name) ? executor::valueToString(env.get(name)) : "<unset>";
+    }
+    return outcome;
+}
+
+void test_bytecode_vm() {
+    std::cout << "\n=== Test: Bytecode VM ===\n";
+
+    struct Case {
+        std::string code;
+        std::vector<std::string> names;
+    };
+    std::vector<Case> cases = {
+        {"int8 a = 7; int8 b = a * (a - 2) / 3; int8 c = -b + 1;", {"a", "b", "c"}},
+        {"int8 i = 0; int8 s = 0; while (i < 10) { if (i == 3) { s = s + 100; } else { s = s + i; } i = i + 1; }",
+         {"i", "s"}},
+        {"string n = \"Aria\"; string g = \"Hi \" + n; int8 l = len(g); int8 same = n == \"Aria\";",
+         {"n", "g", "l", "same"}},
+        {"int8 x = 1; int8 t = !x; int8 u = x && (x - 1); int8 v = x || 0;", {"x", "t", "u", "v"}},
+        {"int8 x = 5; x = x / (x - 5);", {"x"}},
+        {"int8 x = 1; x = y + 1;", {"x"}},
+        {"int8 x = 1; return x + 1; x = 99;", {"x"}},
+        {"int8 x = len(1, 2);", {"x"}},
+        {"int8 x = frob(1);", {"x"}},
+        {"int8 x; string s; int8 k = 2; while (k) { k = k - 1; }", {"x", "s", "k"}},
+        {"int8 x = 4; x + 1;", {"x"}},
+        // Block scopes: locals shadow, vanish with their block, and see
+        // the outer binding in their own initializer
+        {"int8 x = 1; int8 seen = 0; if (x) { int8 x = x + 10; seen = x; x = 50; } int8 after = x;",
+         {"x", "seen", "after"}},
+        {"int8 i = 0; int8 s = 0; while (i < 4) { int8 sq = i * i; s = s + sq; i = i + 1; }",
+         {"i", "s", "sq"}},
+        {"int8 a = 1; if (a) { int8 b = 2; if (b) { int8 c = a + b; a = c; } b = c; }", {"a", "b", "c"}},
+        {"if (1) { string t; t = t + \"!\"; return t; }", {"t"}},
+        // Folded and statically typed code
+        {"int32 a = 2 * 3 + 4; string s = \"n\" + 1 + 2; int32 n = -(5 - 7); int32 l = len(\"abc\");",
+         {"a", "s", "n", "l"}},
+        {"int32 z = 1 / 0;", {"z"}},
+        {"int32 x = 9; x = \"nine\"; string y = x + \"!\";", {"x", "y"}},
+        {"int32 i = 0; int32 s = 0; while (i < 5) { int32 d = i * 2; s = s + d - 1; i = i + 1; } int32 r = s / 2;",
+         {"i", "s", "r"}},
+        {"if (2 > 1) { int32 k = 1; } else { int32 k = 2; } while (0) { frob(); }", {"k"}},
+        {"int32 x = 3; if (x < 4) x = x + 1; int32 y = -x;", {"x", "y"}},
+        // Overflow wraps, typed or not
+        {"string m = \"x\"; m = 9223372036854775807; int64 a = m + 1; int64 b = a - 1; int64 c = m * 3;",
+         {"a", "b", "c"}},
+        {"int64 m = 9223372036854775807; int64 a = m + 1; int64 b = a - 1; int64 c = m * 3;", {"a", "b", "c"}},
+    };
+
+    for (const auto& c : cases) {
+        RunOutcome tree = runProgram(c.code, true, c.names);
+        RunOutcome vm = runProgram(c.code, false, c.names);
+        RunOutcome typed = runProgram(c.code, true, c.names, true);
+        if (tree.error != vm.error) {
+            std::cerr << c.code << "\n  tree: " << tree.error << "\n  vm:   " << vm.error << "\n";
+        }
+        assert(tree.error == vm.error);
+        assert(tree.values == vm.values);
+        assert(tree.lastResult.has_value() == vm.lastResult.has_value());
+        if (tree.lastResult) {
+            assert(*tree.lastResult == *vm.lastResult);
+        }
+        assert(typed.error == tree.error);
+        assert(typed.values == tree.values);
+        (void)vm;
+        (void)typed;
+    }
+    std::cout << "✓ " << cases.size() << " programs match the tree-walker (optimised or not)\n";
+
+    // INT64_MIN / -1 overflows: an error, not SIGFPE, in every engine
+    for (const char* code : {"int8 m = -9223372036854775807 - 1; int8 d = -1; int8 q = m / d;",
+                             "int32 m = -9223372036854775807 - 1; int32 d = -1; int32 q = m / d;",
+                             "int32 q = (-9223372036854775807 - 1) / -1;"}) {
+        RunOutcome tree = runProgram(code, true, {"q"});
+        RunOutcome vm = runProgram(code, false, {"q"});
+        RunOutcome typed = runProgram(code, true, {"q"}, true);
+        assert(tree.error == "Integer overflow in division");
+        assert(vm.error == tree.error && typed.error == tree.error);
+        (void)tree;
+        (void)vm;
+        (void)typed;
+    }
+    RunOutcome wrapped = runProgram(cases[cases.size() - 2].code, false, {"a", "b", "c"});
+    assert(wrapped.values["a"] == std::to_string(INT64_MIN));
+    assert(wrapped.values["b"] == std::to_string(INT64_MAX));
+    assert(wrapped.values["c"] == std::to_string(INT64_MAX - 2));
+    (void)wrapped;
+    std::cout << "✓ Overflowing division is an error, the rest wraps\n";
+
+    // The loop the VM is built for
+    std::string loop = R"(
+        int8 i = 0;
+        int8 s = 0;
+        while (i < 1000000) {
+            s = s + i * 2;
+            i = i + 1;
+        }
+    )";
+    auto time = [&](bool treeWalk) {
+        auto start = std::chrono::steady_clock::now();
+        RunOutcome outcome = runProgram(loop, treeWalk, {"s"});
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        assert(outcome.values["s"] == "999999000000");
+        (void)outcome;
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    };
+    double treeMs = time(true);
+    double vmMs = time(false);
+    std::cout << "1M iterations: tree-walk " << treeMs << "ms, vm " << vmMs
+              << "ms (" << treeMs / vmMs << "x)\n";
+    assert(vmMs * 2 < treeMs);
+    std::cout << "✓ Bytecode VM working\n";
+}
+
+void test_block_scopes() {
+    std::cout << "\n=== Test: Block Scopes ===\n";
+    
+    RunOutcome shadow = runProgram(
+        "int8 x = 1; int8 seen = 0; if (x) { int8 x = x + 10; seen = x; x = 50; } int8 after = x;",
+        false, {"x", "seen", "after"});
+    assert(shadow.error.empty());
+    assert(shadow.values["seen"] == "11");
+    assert(shadow.values["after"] == "1");
+    assert(shadow.values["x"] == "1");
+    
+    RunOutcome loop = runProgram(
+        "int8 i = 0; int8 s = 0; while (i < 4) { int8 sq = i * i; s = s + sq; i = i + 1; }",
+        false, {"s", "sq"});
+    assert(loop.values["s"] == "14");
+    assert(loop.values["sq"] == "<unset>");  // Never reaches the Environment
+    
+    RunOutcome gone = runProgram("if (1) { int8 c = 3; } int8 d = c;", false, {"d"});
+    assert(gone.error == "Undefined variable: c");
+    
+    std::cout << "✓ Block scopes working\n";
+}
+
+static std::unique_ptr<parser::Program> parseOnly(const std::string& code) {
+    parser::ShellLexer lexer(code);
+    auto tokens = lexer.tokenize();
+    parser::ShellParser parser(tokens);
+    return parser.parseProgram();
+}
+
+[[maybe_unused]] static size_t countOps(const executor::Chunk& chunk, executor::OpCode op) {
+    size_t count = 0;
+    for (const auto& in : chunk.code) {
+        count += in.op == op;
+    }
+    return count;
+}
+
+void test_optimizer() {
+    std::cout << "\n=== Test: Optimizer ===\n";
+    
+    // Constant folding
+    auto folded = parseOnly("int32 x = 2 * 3 + 4; string s = \"a\" + 1; int32 z = 1 / 0;");
+    executor::Optimizer optimizer;
+    optimizer.optimize(*folded);
+    auto* x = dynamic_cast<parser::VarDeclStmt*>(folded->statements[0].get());
+    auto* xValue = dynamic_cast<parser::IntegerLiteral*>(x->initializer.get());
+    assert(xValue && xValue->value == 10);
+    auto* s = dynamic_cast<parser::VarDeclStmt*>(folded->statements[1].get());
+    auto* sValue = dynamic_cast<parser::StringLiteral*>(s->initializer.get());
+    assert(sValue && sValue->value == "a1");
+    auto* z = dynamic_cast<parser::VarDeclStmt*>(folded->statements[2].get());
+    assert(dynamic_cast<parser::BinaryOpExpr*>(z->initializer.get()));  // Still throws
+    assert(optimizer.getStats().folded == 3);
+    (void)xValue;
+    (void)sValue;
+    (void)z;
+    std::cout << "✓ Literals folded, division by zero left to run time\n";
+    
+    // Constant conditions
+    auto branches = parseOnly("if (1 < 2) { print(1); } else { print(2); } while (0) { print(3); }");
+    optimizer.optimize(*branches);
+    assert(optimizer.getStats().branchesRemoved == 2);
+    assert(dynamic_cast<parser::BlockStmt*>(branches->statements[0].get()));
+    auto* dead = dynamic_cast<parser::BlockStmt*>(branches->statements[1].get());
+    assert(dead && dead->statements.empty());
+    (void)dead;
+    std::cout << "✓ Constant if/while conditions removed\n";
+    
+    // Typed loop: every operation specialised
+    const std::string loop =
+        "int32 i = 0; int32 s = 0; while (i < 100) { int32 d = i * 2; s = s + d; i = i + 1; }";
+    auto typed = parseOnly(loop);
+    optimizer.optimize(*typed);
+    assert(optimizer.getStats().typedVariables == 3);
+    assert(optimizer.warnings().empty());
+    executor::Compiler compiler;
+    executor::Chunk chunk = compiler.compile(*typed);
+    assert(countOps(chunk, executor::OpCode::ADD_INT) == 2);
+    assert(countOps(chunk, executor::OpCode::MUL_INT) == 1);
+    assert(countOps(chunk, executor::OpCode::JUMP_WHEN_INT) == 1);
+    assert(countOps(chunk, executor::OpCode::ADD) == 0);
+    assert(countOps(chunk, executor::OpCode::JUMP_WHEN) == 0);
+    
+    // One string store makes a variable dynamic again, and is reported
+    auto mixed = parseOnly("int32 i = 0; i = \"text\"; int32 j = i + 1; int8 k = 300;");
+    optimizer.optimize(*mixed);
+    assert(optimizer.getStats().typedVariables == 1);  // k
+    assert(optimizer.warnings().size() == 2);
+    assert(optimizer.warnings()[0] == "line 1: storing string in int32 'i'");
+    assert(optimizer.warnings()[1] == "line 1: 300 does not fit in int8 'k'");
+    chunk = compiler.compile(*mixed);
+    assert(countOps(chunk, executor::OpCode::ADD_INT) == 0);
+    std::cout << "✓ Declared types checked and specialised\n";
+    
+    // Reads before a global's declaration may see any earlier binding
+    executor::Environment env;
+    env.define("v", executor::Value(executor::SharedString("old")));
+    executor::Executor exec(env);
+    auto before = parseOnly("string a = v + 1; int32 v = 5; int32 b = v + 1;");
+    exec.execute(*before);
+    assert(std::get<executor::SharedString>(env.get("a")) == "old1");
+    assert(std::get<int64_t>(env.get("b")) == 6);
+    
+    // An unbraced body defines a global only sometimes
+    auto maybe = parseOnly("if (v < 0) string v = \"s\"; int32 w = v + 1;");
+    optimizer.optimize(*maybe);
+    chunk = compiler.compile(*maybe);
+    assert(countOps(chunk, executor::OpCode::ADD_INT) == 0);
+    std::cout << "✓ Only provable types specialised\n";
+    
+    // Fewer dispatches per iteration: compare against the generic VM
+    const std::string hot =
+        "int64 i = 0; int64 s = 0; while (i < 1000000) { s = s + i * 2; i = i + 1; }";
+    auto runVm = [&](bool optimize) {
+        auto program = parseOnly(hot);
+        if (!optimize) {
+            program->optimized = true;  // Skip the pass
+        }
+        executor::Environment vmEnv;
+        executor::Executor vm(vmEnv);
+        auto start = std::chrono::steady_clock::now();
+        vm.execute(*program);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        assert(std::get<int64_t>(vmEnv.get("s")) == 999999000000);
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    };
+    double genericMs = runVm(false);
+    double typedMs = runVm(true);
+    std::cout << "1M iterations: generic " << genericMs << "ms, typed " << typedMs << "ms\n";
+    std::cout << "✓ Optimizer working\n";
+}
+
+void test_builtins() {
+    std::cout << "\n=== Test: Builtins ===\n";
+    
+    int64_t status = -1;
+    assert(runCaptured("echo hello world;", &status) == "hello world\n" && status == 0);
+    assert(runCaptured("echo \"-n\" no newline;", &status) == "no newline");
+    assert(runCaptured("printf \"%s=%d\\n\" a 5 b 6;", &status) == "a=5\nb=6\n");
+    assert(runCaptured("printf \"[%4s|%-3d]\" ab 7;", &status) == "[  ab|7  ]");
+    
+    runCaptured("test 3 \"-lt\" 5;", &status);
+    assert(status == 0);
+    runCaptured("test abc \"=\" abd;", &status);
+    assert(status == 1);
+    runCaptured("test \"-d\" \"/tmp\";", &status);
+    assert(status == 0);
+    runCaptured("test \"!\" \"-z\" text;", &status);
+    assert(status == 0);
+    runCaptured("test x \"-eq\" 1;", &status);
+    assert(status == 2);
+    runCaptured("[ \"-d\" \"/tmp\" ];", &status);
+    assert(status == 0);
+    runCaptured("[ abc \"=\" abd ];", &status);
+    assert(status == 1);
+    runCaptured("[ abc \"=\" abc;", &status);
+    assert(status == 2);
+    std::cout << "✓ echo, printf and test\n";
+    
+    // Builtin stages feed external ones and the other way round
+    assert(runCaptured("echo into cat | cat;", &status) == "into cat\n" && status == 0);
+    assert(runCaptured("printf \"b\\na\\n\" | sort | cat;", &status) == "a\nb\n");
+    assert(runCaptured("echo dropped | cat | echo kept;", &status) == "kept\n");
+    runCaptured("true | cat | false;", &status);
+    assert(status == 1);
+    std::string chained = runCaptured("echo one | tr \"o\" \"O\" | echo two | tr \"wo\" \"WO\";", &status);
+    assert(chained == "tWO\n");
+    (void)chained;
+
+    // A builtin that ignores stdin ends its upstream stage with SIGPIPE
+    // instead of collecting an endless output
+    std::string ignored = runCaptured("yes | true;", &status);
+    assert(ignored.empty() && status == 128 + SIGPIPE);
+    ignored = runCaptured("yes | cat | echo done;", &status);
+    assert(ignored == "done\n" && status == 128 + SIGPIPE);
+    (void)ignored;
+    std::cout << "✓ In-process pipeline stages\n";
+    
+    // cd and pwd change and report the shell's own directory
+    char saved[4096];
+    if (!getcwd(saved, sizeof(saved))) {
+        saved[0] = '\0';
+    }
+    assert(runCaptured("cd \"/tmp\"; pwd;", &status) == "/tmp\n");
+    assert(runCaptured("cd \"-\";", &status) == std::string(saved) + "\n");
+    assert(runCaptured("cd \"/\" | true; pwd;", &status) == std::string(saved) + "\n");
+    runCaptured("cd \"/nonexistent/ariash\";", &status);
+    assert(status == 1);
+    int restored = chdir(saved);
+    assert(restored == 0);
+    (void)restored;
+    std::cout << "✓ cd and pwd\n";
+    
+    // exit stops the program with its status; inside a pipeline it does not
+    parser::ShellLexer lexer("echo a; exit 3; echo b;");
+    auto tokens = lexer.tokenize();
+    parser::ShellParser parser(tokens);
+    auto ast = parser.parseProgram();
+    executor::Environment env;
+    executor::Executor exec(env);
+    std::ostringstream captured;
+    std::streambuf* savedBuf = std::cout.rdbuf(captured.rdbuf());
+    exec.execute(*ast);
+    std::cout.rdbuf(savedBuf);
+    assert(captured.str() == "a\n");
+    assert(exec.exitRequested() && exec.getLastStatus() == 3);
+    assert(runCaptured("exit 4 | true; echo after;", &status) == "after\n");
+    std::cout << "✓ exit\n";
+    
+    // No fork/exec: a test in a loop costs microseconds
+    auto start = std::chrono::steady_clock::now();
+    runCaptured("int32 i = 0; while (i < 10000) { test 1 \"-lt\" 2; i = i + 1; }", &status);
+    double perIteration = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start).count() / 10000;
+    std::cout << "test in a loop: " << perIteration << "us per iteration\n";
+    assert(perIteration < 100);
+    assert(status == 0);
+    
+    std::cout << "✓ Builtins working\n";
+}
+
+static std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+void test_redirections() {
+    std::cout << "\n=== Test: Redirections ===\n";
+    
+    std::string dir = "/tmp/ariash_redir_" + std::to_string(getpid());
+    mkdir(dir.c_str(), 0755);
+    std::string file = dir + "/out";
+    int64_t status = -1;
+    
+    // External commands get the file as their stream; builtins write it
+    std::string out = runCaptured("printf \"b\\na\\n\" > \"" + file + "\"; sort < \"" + file +
+                                  "\" > \"" + file + ".sorted\"; echo more >> \"" + file + ".sorted\";",
+                                  &status);
+    assert(out.empty() && status == 0);
+    std::string sorted = readFile(file + ".sorted");
+    assert(sorted == "a\nb\nmore\n");
+    std::cout << "✓ <, > and >> for builtins and external commands\n";
+    
+    // Every stage of a pipeline, and the hex streams by number
+    out = runCaptured("cat < \"" + file + ".sorted\" | grep \"-v\" more | sort \"-r\" > \"" + file +
+                      ".piped\"; sh \"-c\" \"cat <&4 >&5; echo oops >&2\" 4< \"" + file +
+                      "\" 5> \"" + file + ".dato\" 2> \"" + file + ".err\";", &status);
+    assert(out.empty() && status == 0);
+    std::string piped = readFile(file + ".piped");
+    std::string dato = readFile(file + ".dato");
+    std::string errors = readFile(file + ".err");
+    assert(piped == "b\na\n" && dato == "b\na\n" && errors == "oops\n");
+    std::cout << "✓ Pipeline stages and streams 2, 4, 5\n";
+    
+    // A builtin is handed its `<` file unread: an endless one is fine
+    out = runCaptured("true < \"/dev/zero\"; echo done;", &status);
+    assert(out == "done\n" && status == 0);
+    
+    // A file that cannot be opened fails the command without running it
+    out = runCaptured("echo never > \"" + dir + "/missing/x\"; cat < \"" + dir + "/missing\";", &status);
+    assert(out.empty() && status == 1);
+    
+    std::string cleanup = "rm -rf " + dir;
+    int removed = std::system(cleanup.c_str());
+    (void)removed;
+    (void)out;
+    (void)sorted;
+    (void)piped;
+    (void)dato;
+    (void)errors;
+    std::cout << "✓ Unopenable targets reported\n";
+}
+
+void test_parallel() {
+    std::cout << "\n=== Test: Parallel ===\n";
+    
+    // Four 0.2 s tasks, two at a time: two rounds, not one or four
+    int64_t status = -1;
+    auto start = std::chrono::steady_clock::now();
+    std::string out = runCaptured(
+        "parallel (2) { sleep \"0.2\"; sleep \"0.2\"; sleep \"0.2\"; sleep \"0.2\"; }", &status);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "4 x sleep 0.2 at limit 2: " << elapsed << "s\n";
+    assert(elapsed > 0.35 && elapsed < 0.7);
+    assert(out.empty() && status == 0);
+    
+    // Each task's output stays together; the status counts the failures
+    out = runCaptured("parallel { printf \"a\\nb\\n\"; false; echo c | cat; false; }", &status);
+    assert(out.size() == 6 && out.find("a\nb\n") != std::string::npos);
+    assert(out.find("c\n") != std::string::npos);
+    assert(status == 2);
+    
+    parser::ShellLexer lexer("parallel (\"two\") { true; }");
+    auto tokens = lexer.tokenize();
+    parser::ShellParser parser(tokens);
+    auto ast = parser.parseProgram();
+    executor::Environment env;
+    executor::Executor exec(env);
+    bool threw = false;
+    try {
+        exec.execute(*ast);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+    
+    // The pool itself: bounded, collects exit codes and output per task
+    job::TaskPool pool(3);
+    for (int i = 0; i < 8; i++) {
+        job::SpawnOptions options;
+        options.command = "/bin/sh";
+        options.args = {"-c", "sleep 0.05; echo task" + std::to_string(i) + "; exit " +
+                              std::to_string(i % 2)};
+        pool.add({options});
+    }
+    size_t completed = 0;
+    pool.onComplete([&completed](size_t, const job::TaskResult&) { ++completed; });
+    size_t failed = pool.run();
+    assert(failed == 4 && completed == 8);
+    assert(pool.peakRunning() == 3);
+    for (size_t i = 0; i < 8; i++) {
+        assert(pool.results()[i].exitCode == static_cast<int>(i % 2));
+        assert(pool.results()[i].output == "task" + std::to_string(i) + "\n");
+    }
+    (void)failed;
+    assert(job::onlineCpus() >= 1 && job::TaskPool().concurrency() == job::onlineCpus());
+    
+    // A job removed by another thread while being waited for: the waiter
+    // still gets its status (or -1 if it was gone first), never a freed JCB
+    job::JobManager& jobs = job::getJobManager();
+    for (int i = 0; i < 20; i++) {
+        job::SpawnOptions options;
+        options.command = "/bin/sh";
+        options.args = {"-c", "exit 3"};
+        uint32_t jobId = jobs.spawnPipeline({options});
+        assert(jobId != 0);
+        int waited = 0;
+        std::thread waiter([&] { waited = jobs.wait(jobId); });
+        while (!jobs.removeJob(jobId)) {
+            jobs.processEvents(1);
+        }
+        waiter.join();
+        assert(waited == 3 || waited == -1);
+        (void)waited;
+    }
+    
+    std::cout << "✓ Parallel fan-out working\n";
+}
+
+void test_program_cache() {
+    std::cout << "\n=== Test: Program Cache ===\n";
+    
+    executor::Environment env;
+    env.define("n", static_cast<int64_t>(0));
+    
+    // Repeated submissions compile once
+    auto& cache = executor::getProgramCache();
+    auto before = cache.getStats();
+    for (int i = 0; i < 3; i++) {
+        executor::Executor exec(env);
+        exec.executeSource("n = n + 1; n * 10;");
+        assert(std::get<int64_t>(*exec.getLastResult()) == (i + 1) * 10);
+    }
+    auto after = cache.getStats();
+    assert(after.misses - before.misses == 1);
+    assert(after.hits - before.hits == 2);
+    (void)before;
+    (void)after;
+    assert(std::get<int64_t>(env.get("n")) == 3);
+    
+    // Least recently used entries go first
+    executor::ProgramCache small(2);
+    auto a = small.get("int8 a = 1;");
+    small.get("int8 b = 2;");
+    auto refreshed = small.get("int8 a = 1;");  // Refresh a
+    assert(refreshed == a);
+    small.get("int8 c = 3;");                    // Evicts b
+    assert(small.size() == 2);
+    assert(small.getStats().evictions == 1);
+    auto kept = small.get("int8 a = 1;");
+    assert(kept == a);
+    (void)refreshed;
+    (void)kept;
+    uint64_t misses = small.getStats().misses;
+    (void)misses;
+    small.get("int8 b = 2;");
+    assert(small.getStats().misses == misses + 1);
+    
+    // Sources with parse errors are never cached
+    small.clear();
+    small.get("int8 = 5;");
+    assert(small.size() == 0);
+    
+    // An evicted entry stays valid for its holder
+    small.setCapacity(0);
+    assert(small.size() == 0);
+    assert(a->program->statements.size() == 1);
+    (void)a;
+    
+    // Hit vs. miss cost for a typical snippet
+    std::string snippet = R"(
+        int8 total = 0;
+        int8 k = 0;
+        while (k < 3) { if (k == 1) { total = total + 10; } else { total = total + k; } k = k + 1; }
+    )";
+    executor::ProgramCache timing;
+    constexpr int kRounds = 2000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; i++) {
+        timing.clear();
+        timing.get(snippet);
+    }
+    auto missTime = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; i++) {
+        timing.get(snippet);
+    }
+    auto hitTime = std::chrono::steady_clock::now() - start;
+    double missUs = std::chrono::duration<double, std::micro>(missTime).count() / kRounds;
+    double hitUs = std::chrono::duration<double, std::micro>(hitTime).count() / kRounds;
+    std::cout << "compile " << missUs << "us, cached " << hitUs << "us\n";
+    assert(hitUs < missUs);
+    
+    std::cout << "✓ Program cache working\n";
+}
+
+void test_script_mode() {
+    std::cout << "\n=== Test: Script Mode ===\n";
+    
+    executor::Environment env;
+    
+    // Status of the last command; shebang skipped with line numbers intact
+    assert(executor::runScript("#!/usr/bin/env ariash\nint8 n = 4;\ntrue;", "t", env) == 0);
+    assert(std::get<int64_t>(env.get("n")) == 4);
+    assert(executor::runScript("true; false;", "t", env) == 1);
+    assert(executor::runScript("int8 m = n * 2;", "t", env) == 0);
+    assert(std::get<int64_t>(env.get("m")) == 8);
+    assert(executor::runScript("", "t", env) == 0);
+    
+    // Parse errors run nothing; runtime errors are status 1
+    assert(executor::runScript("int8 before = 1; int8 = 5;", "t", env) == 2);
+    assert(!env.exists("before"));
+    assert(executor::runScript("int8 bad = missing + 1;", "t", env) == 1);
+    
+    // Files are mapped and run in place
+    char fileTemplate[] = "/tmp/ariash_script_XXXXXX";
+    int fd = mkstemp(fileTemplate);
+    assert(fd >= 0);
+    std::string script = "#!/usr/bin/env ariash\nint8 fromFile = 6 * 7;\nsh \"-c\" \"exit 3\";\n";
+    ssize_t written = write(fd, script.data(), script.size());
+    assert(written == static_cast<ssize_t>(script.size()));
+    (void)written;
+    close(fd);
+    
+    executor::SourceFile file;
+    bool opened = file.open(fileTemplate);
+    assert(opened && file.text() == script);
+    (void)opened;
+    
+    int status = executor::runScriptFile(fileTemplate, env);
+    std::cout << "script exit status: " << status << "\n";
+    assert(status == 3);
+    assert(std::get<int64_t>(env.get("fromFile")) == 42);
+    unlink(fileTemplate);
+    
+    assert(executor::runScriptFile("/nonexistent/ariash_script", env) == 127);
+    assert(executor::runScriptFile("/tmp", env) == 127);
+    
+    // As scripts run (no PATH watches): a tool the script installs runs
+    // right away, although it was looked up and missed before
+    executor::CommandCache& cache = executor::getCommandCache();
+    cache.setWatchesEnabled(false);
+    char dirTemplate[] = "/tmp/ariash_tools_XXXXXX";
+    std::string dir = mkdtemp(dirTemplate);
+    std::string savedPath = std::getenv("PATH") ? std::getenv("PATH") : "";
+    setenv("PATH", (dir + ":/usr/bin:/bin").c_str(), 1);
+    std::string tool = dir + "/ariash_built_tool";
+    std::string install = "ariash_built_tool;\n"
+                          "cp \"/bin/true\" \"" + tool + "\";\n"
+                          "ariash_built_tool;\n";
+    status = executor::runScript(install, "t", env);
+    std::cout << "installed tool exit status: " << status << "\n";
+    assert(status == 0);
+    unlink(tool.c_str());
+    rmdir(dir.c_str());
+    setenv("PATH", savedPath.c_str(), 1);
+    cache.setWatchesEnabled(true);
+    
+    std::cout << "✓ Script mode working\n";
+}
+
+void test_command_cache_without_watches() {
+    std::cout << "\n=== Test: Command Cache (mtime only) ===\n";
+    
+    executor::CommandCache& cache = executor::getCommandCache();
+    cache.setWatchesEnabled(false);
+    
+    char dirTemplate[] = "/tmp/ariash_hash_XXXXXX";
+    std::string dir = mkdtemp(dirTemplate);
+    std::string savedPath = std::getenv("PATH") ? std::getenv("PATH") : "";
+    setenv("PATH", (dir + ":/usr/bin:/bin").c_str(), 1);
+    
+    const std::string probe = "ariash_hash_probe";
+    const std::string probePath = dir + "/" + probe;
+    std::string missed = cache.resolve(probe);
+    assert(missed == probe);
+    (void)missed;
+    
+    // A cached miss is searched again, without waiting for the
+    // once-a-second mtime check
+    {
+        std::ofstream script(probePath);
+        script << "#!/bin/sh\n";
+    }
+    chmod(probePath.c_str(), 0755);
+    std::string found = cache.resolve(probe);
+    std::cout << "After create: " << found << "\n";
+    assert(found == probePath);
+    assert(cache.found(probe));
+    
+    unlink(probePath.c_str());
+    rmdir(dir.c_str());
+    setenv("PATH", savedPath.c_str(), 1);
+    cache.setWatchesEnabled(true);
+    std::cout << "✓ mtime-only command cache working\n";
+}
+
+static long maxRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void test_command_substitution() {
+    std::cout << "\n=== Test: Command Substitution ===\n";
+    
+    // Builtins, external commands and mixed pipelines, in both engines;
+    // trailing newlines are stripped, inner ones kept
+    std::string code =
+        "string a = $(echo hi); string b = $(seq 1 3 | tr \"123\" \"xyz\"); string c = $(echo one | cat);"
+        "string d = $(printf \"\\n\\n\"); string all = \"\"; int64 n = 0;"
+        "for (line in $(seq 1 3)) { n = n + 1; all = all + line + \",\"; }"
+        "for (w in $(printf \"p\\nq\\n\")) { all = all + w; } for (w in b) { all = all + w; }";
+    std::vector<std::string> names = {"a", "b", "c", "d", "all", "n"};
+    for (bool treeWalk : {false, true}) {
+        RunOutcome outcome = runProgram(code, treeWalk, names);
+        assert(outcome.error.empty());
+        assert(outcome.values["a"] == "hi" && outcome.values["b"] == "x\ny\nz");
+        assert(outcome.values["c"] == "one" && outcome.values["d"].empty());
+        assert(outcome.values["all"] == "1,2,3,pqxyz" && outcome.values["n"] == "3");
+        (void)outcome;
+    }
+    std::cout << "✓ $(...) values and for loops over lines\n";
+    
+    // The substitution's exit status is the last status; its stderr is
+    // not part of the value
+    {
+        std::string statusCode = "string s = $(sh \"-c\" \"echo out; echo err >&2; exit 3\");";
+        parser::ShellLexer lexer(statusCode);
+        parser::ShellParser parser(lexer);
+        auto ast = parser.parseProgram();
+        executor::Environment env;
+        executor::Executor exec(env);
+        exec.execute(*ast);
+        assert(std::get<executor::SharedString>(env.get("s")) == "out");
+        assert(exec.getLastStatus() == 3);
+        
+        // Iterating a string is not a command, anything else is an error
+        RunOutcome bad = runProgram("for (x in 5) { }", false, {});
+        RunOutcome badTree = runProgram("for (x in 5) { }", true, {});
+        assert(!bad.error.empty() && bad.error == badTree.error);
+        (void)bad;
+        (void)badTree;
+    }
+    std::cout << "✓ Exit status and errors\n";
+    
+    // A loop consumes output as it is produced: 20 MB of lines pass
+    // through a 1 MB ring without being held at once
+    long before = maxRssKb();
+    RunOutcome lines = runProgram(
+        "int64 n = 0; for (l in $(sh \"-c\" \"yes $(printf %01000d 0) | head -n 20000\")) { n = n + 1; }",
+        false, {"n"});
+    long loopGrowth = maxRssKb() - before;
+    std::cout << "20 MB line loop peak RSS growth: " << loopGrowth << " KB\n";
+    assert(lines.error.empty() && lines.values["n"] == "20000");
+    assert(loopGrowth < 8 * 1024);
+    
+    // A capture is built once, in place: well under three times its size
+    constexpr long kBigBytes = 32l << 20;
+    before = maxRssKb();
+    {
+        std::string bigCode = "string big = $(head \"-c\" \"" + std::to_string(kBigBytes) +
+                              "\" \"/dev/zero\"); int64 size = len(big);";
+        parser::ShellLexer lexer(bigCode);
+        parser::ShellParser parser(lexer);
+        auto ast = parser.parseProgram();
+        executor::Environment env;
+        executor::Executor exec(env);
+        exec.execute(*ast);
+        const executor::SharedString& big = std::get<executor::SharedString>(env.get("big"));
+        assert(std::get<int64_t>(env.get("size")) == kBigBytes);
+        assert(big.capacity() < 2 * static_cast<size_t>(kBigBytes));
+        (void)big;
+    }
+    long captureGrowth = maxRssKb() - before;
+    std::cout << "32 MB capture peak RSS growth: " << captureGrowth << " KB\n";
+    assert(captureGrowth < 2 * (kBigBytes >> 10));
+    (void)loopGrowth;
+    (void)captureGrowth;
+    std::cout << "✓ Streaming capture memory bounded\n";
+}
+
+void test_profiler() {
+    std::cout << "\n=== Test: Profiler ===\n";
+    
+    job::Profiler& profiler = job::getProfiler();
+    executor::Environment env;
+    
+    // Off: nothing is recorded
+    profiler.clear();
+    assert(executor::runScript("int8 off = 1;\ntrue;", "t", env) == 0);
+    assert(profiler.hotspots().empty());
+    
+    std::string script =
+        "int8 i = 0;\n"
+        "while (i < 3) {\n"
+        "    sh \"-c\" \"exit 0\";\n"
+        "    i = i + 1;\n"
+        "}\n";
+    profiler.start();
+    int status = executor::runScript(script, "t", env);
+    profiler.stop();
+    assert(status == 0);
+    (void)status;
+    // The tree-walker ran it, with the same result as the VM
+    assert(std::get<int64_t>(env.get("i")) == 3);
+    
+    profiler.writeHotspots(std::cout);
+    std::map<std::string, job::Hotspot> byLabel;
+    for (const auto& spot : profiler.hotspots()) {
+        assert(spot.selfNanos >= 0 && spot.selfNanos <= spot.totalNanos);
+        byLabel[spot.label] = spot;
+    }
+    assert(byLabel.count("declare i") && byLabel["declare i"].line == 1);
+    assert(byLabel.count("while") && byLabel["while"].line == 2 && byLabel["while"].count == 1);
+    assert(byLabel["command sh"].line == 3 && byLabel["command sh"].count == 3);
+    assert(byLabel["assign i"].line == 4 && byLabel["assign i"].count == 3);
+    // Process lifecycle spans nest inside their command
+    assert(byLabel["spawn"].count == 3 && byLabel["wait"].count == 3 && byLabel["drain"].count == 3);
+    assert(byLabel["command sh"].totalNanos >= byLabel["spawn"].totalNanos + byLabel["wait"].totalNanos);
+    assert(byLabel["while"].totalNanos >= byLabel["command sh"].totalNanos);
+    
+    // Each thread records into its own buffer (its own trace row)
+    profiler.start();
+    std::thread worker([] {
+        static const char site[] = "worker";
+        job::ProfileScope scope(site, site);
+    });
+    worker.join();
+    profiler.stop();
+    
+    std::ostringstream trace;
+    profiler.writeChromeTrace(trace);
+    std::string json = trace.str();
+    assert(json.find("\"traceEvents\"") != std::string::npos);
+    assert(json.find("{\"name\":\"while\",\"cat\":\"while\",\"ph\":\"X\"") != std::string::npos);
+    assert(json.find("\"args\":{\"line\":3,") != std::string::npos);
+    assert(json.find("\"name\":\"worker\"") != std::string::npos);
+    assert(json.find("\"tid\":1") != std::string::npos && json.find("\"tid\":2") != std::string::npos);
+    
+    std::ostringstream folded;
+    profiler.writeFoldedStacks(folded);
+    std::cout << folded.str();
+    std::string stacks = folded.str();
+    std::string commandFrame = "while (2:1);command sh (3:5)";
+    assert(stacks.find(commandFrame + ";wait ") != std::string::npos);
+    assert(stacks.find(commandFrame + " ") != std::string::npos ||
+           stacks.find(commandFrame + ";spawn ") != std::string::npos);
+    (void)commandFrame;
+    
+    profiler.clear();
+    assert(profiler.hotspots().empty());
+    
+    std::cout << "✓ Profiler working\n";
+}
+
+void test_string_values() {
+    std::cout << "\n=== Test: String Values ===\n";
+    using executor::SharedString;
+    
+    // A Value is a word of payload and its tag
+    static_assert(sizeof(executor::Value) == 16);
+    
+    // Copies share the text; a mutation copies it first
+    SharedString a("path");
+    SharedString b = a;
+    assert(b.data() == a.data() && !a.unique());
+    b.append("/bin");
+    assert(a == "path" && b == "path/bin" && a.unique() && b.unique());
+    SharedString moved = std::move(b);
+    assert(moved == "path/bin" && b.empty() && b.capacity() == 0);
+    
+    // Appending grows geometrically, in place, even from its own text
+    const char* buffer = nullptr;
+    size_t moves = 0;
+    for (int i = 0; i < 1000; ++i) {
+        moved.append("/x");
+        if (moved.data() != buffer) {
+            buffer = moved.data();
+            ++moves;
+        }
+    }
+    assert(moved.size() == 2008 && moves < 20);
+    moved.append(moved.view());
+    assert(moved.size() == 4016 && moved.view().substr(2008, 8) == "path/bin");
+    (void)moves;
+    
+    // One interned copy per text, never mutated, gone with its last user
+    size_t interned = SharedString::internedCount();
+    {
+        SharedString lit = SharedString::intern("literal");
+        assert(lit.interned() && lit.data() == SharedString::intern("literal").data());
+        SharedString edited = lit;
+        edited.append("!");
+        assert(lit == "literal" && edited == "literal!" && !edited.interned());
+        assert(SharedString::intern("").empty() && !SharedString().interned());
+        SharedString held = lit;
+        lit = SharedString();
+        assert(held.interned() && SharedString::internedCount() == interned + 1);
+    }
+    assert(SharedString::internedCount() == interned);
+    
+    // Threads interning and dropping one text: a dying copy is replaced,
+    // never revived
+    std::vector<std::thread> interners;
+    for (int t = 0; t < 4; ++t) {
+        interners.emplace_back([] {
+            for (int i = 0; i < 20000; ++i) {
+                SharedString text = SharedString::intern("contended");
+                assert(text == "contended");
+            }
+        });
+    }
+    for (auto& thread : interners) {
+        thread.join();
+    }
+    assert(SharedString::internedCount() == interned);
+    (void)interned;
+    
+    // Numbers are formatted without allocating, as valueToString() does
+    executor::ValueTextBuffer text;
+    assert(executor::valueText(INT64_MIN, text) == std::to_string(INT64_MIN));
+    assert(executor::valueText(2.5, text) == std::to_string(2.5));
+    assert(executor::valueText(true, text) == "true");
+    assert(executor::valueToString(executor::Value(a)) == "path");
+    (void)text;
+    
+    // VM and tree-walker agree, appending in place or copying when the
+    // old value is still seen elsewhere
+    std::string code =
+        "string s = \"a\"; int32 i = 0; while (i < 500) { s = s + i; i = i + 1; }"
+        " string kept = s; s = s + \"!\"; string d = \"xy\"; d = d + d; d = d + d;"
+        " string e = \"lit\"; string f = \"lit\"; string g = e + f; int64 n = len(s);";
+    std::vector<std::string> names = {"kept", "n", "d", "g"};
+    RunOutcome vm = runProgram(code, false, names);
+    RunOutcome tree = runProgram(code, true, names);
+    assert(vm.error.empty() && vm.values == tree.values);
+    assert(vm.values["n"] == std::to_string(vm.values["kept"].size() + 1));
+    assert(vm.values["kept"].substr(0, 6) == "a01234" && vm.values["kept"].back() == '9');
+    assert(vm.values["d"] == "xyxyxyxy" && vm.values["g"] == "litlit");
+    (void)vm;
+    (void)tree;
+    
+    // Values made from one literal share its interned text
+    {
+        parser::ShellLexer lexer("string e = \"same\"; string f = \"same\";");
+        parser::ShellParser parser(lexer);
+        auto ast = parser.parseProgram();
+        executor::Environment env;
+        executor::Executor exec(env);
+        exec.execute(*ast);
+        const auto& e = std::get<SharedString>(env.get("e"));
+        const auto& f = std::get<SharedString>(env.get("f"));
+        assert(e.interned() && e.data() == f.data());
+        (void)e;
+        (void)f;
+    }
+    
+    std::cout << "✓ Shared, interned and in-place string values\n";
+}
+
 int main() {
     try {
         test_integer_literals();
@@ -316,6 +1387,20 @@ int main() {
         test_string_operations();
         test_builtin_functions();
         test_command_execution();
+        test_pipeline_execution();
+        test_command_cache();
+        test_bytecode_vm();
+        test_block_scopes();
+        test_optimizer();
+        test_builtins();
+        test_redirections();
+        test_parallel();
+        test_program_cache();
+        test_script_mode();
+        test_command_cache_without_watches();
+        test_command_substitution();
+        test_profiler();
+        test_string_values();
         
         std::cout << "\n✅ All executor tests passed!\n";
         return 0;
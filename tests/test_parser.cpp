@@ -6,6 +6,7 @@
 #include "parser/parser.hpp"
 #include <iostream>
 #include <cassert>
+#include <sstream>
 
 using namespace ariash::parser;
 
@@ -47,6 +48,12 @@ public:
         std::cout << "])";
     }
     
+    void visit(CommandSubstExpr& node) override {
+        std::cout << "SUBST(";
+        node.pipeline->accept(*this);
+        std::cout << ")";
+    }
+    
     void visit(BlockStmt& node) override {
         std::cout << "BLOCK{";
         for (auto& stmt : node.statements) {
@@ -104,6 +111,12 @@ public:
         std::cout << ")";
     }
     
+    void visit(ExprStmt& node) override {
+        std::cout << "EXPR(";
+        node.expression->accept(*this);
+        std::cout << ")";
+    }
+    
     void visit(CommandStmt& node) override {
         std::cout << "CMD(" << node.executable;
         for (const auto& arg : node.arguments) {
@@ -129,6 +142,19 @@ public:
         std::cout << ")";
     }
     
+    void visit(ParallelStmt& node) override {
+        std::cout << "PARALLEL(";
+        if (node.limit) {
+            node.limit->accept(*this);
+            std::cout << ", ";
+        }
+        for (size_t i = 0; i < node.tasks.size(); i++) {
+            if (i > 0) std::cout << "; ";
+            node.tasks[i]->accept(*this);
+        }
+        std::cout << ")";
+    }
+    
     void visit(Program& node) override {
         std::cout << "PROGRAM[\n";
         for (auto& stmt : node.statements) {
@@ -247,6 +273,17 @@ void test_commands() {
     ast->accept(printer);
     std::cout << "\n";
     
+    // "[" names the test builtin and "]" closes its arguments
+    ShellLexer bracketLexer("[ \"-d\" \"/tmp\" ] | cat;");
+    ShellParser bracketParser(bracketLexer);
+    auto bracketAst = bracketParser.parseProgram();
+    assert(bracketParser.errorCount() == 0 && bracketAst->statements.size() == 1);
+    auto* pipeline = dynamic_cast<PipelineStmt*>(bracketAst->statements[0].get());
+    assert(pipeline && pipeline->commands.size() == 2);
+    assert(pipeline->commands[0]->executable == "[");
+    assert((pipeline->commands[0]->arguments == std::vector<std::string>{"-d", "/tmp", "]"}));
+    (void)pipeline;
+    
     std::cout << "✓ Command with arguments working\n";
 }
 
@@ -279,6 +316,34 @@ void test_redirections() {
     ast->accept(printer);
     std::cout << "\n";
     
+    // FD prefixes name any hex stream; a spaced digit stays an argument
+    std::string prefixed = "sort \"-r\" 2>\"err\" 5>> \"dat\" 4< \"in\" 2 > out \"-u\";";
+    ShellLexer prefixedLexer(prefixed);
+    auto prefixedTokens = prefixedLexer.tokenize();
+    ShellParser prefixedParser(prefixedTokens);
+    auto prefixedAst = prefixedParser.parseProgram();
+    assert(prefixedParser.errorCount() == 0);
+    auto* pipeline = dynamic_cast<PipelineStmt*>(prefixedAst->statements[0].get());
+    assert(pipeline && pipeline->commands.size() == 1);
+    const CommandStmt& sort = *pipeline->commands[0];
+    assert((sort.arguments == std::vector<std::string>{"-r", "2", "-u"}));
+    assert(sort.redirections.size() == 4);
+    assert(sort.redirections[0].targetFd() == 2 && sort.redirections[0].target == "err");
+    assert(sort.redirections[1].type == RedirectionType::APPEND && sort.redirections[1].targetFd() == 5);
+    assert(sort.redirections[2].type == RedirectionType::INPUT && sort.redirections[2].targetFd() == 4);
+    assert(sort.redirections[3].fd == -1 && sort.redirections[3].targetFd() == 1);
+    (void)pipeline;
+    (void)sort;
+    
+    // A quoted right-hand side makes < and > redirections, anything else
+    // a comparison
+    ShellLexer inputLexer("cat < \"in\"; x < 5;");
+    ShellParser inputParser(inputLexer);
+    auto inputAst = inputParser.parseProgram();
+    assert(inputParser.errorCount() == 0 && inputAst->statements.size() == 2);
+    assert(dynamic_cast<PipelineStmt*>(inputAst->statements[0].get()));
+    assert(dynamic_cast<ExprStmt*>(inputAst->statements[1].get()));
+    
     std::cout << "✓ Redirections working\n";
 }
 
@@ -309,6 +374,193 @@ void test_mixed_statements() {
     std::cout << "✓ Mixed statements working\n";
 }
 
+void test_arena_allocation() {
+    std::cout << "\n=== Test: Arena Allocation ===\n";
+    
+    std::string code;
+    for (int i = 0; i < 500; i++) {
+        code += "int8 v" + std::to_string(i) + " = " + std::to_string(i) + " * 2 + 1;\n";
+    }
+    
+    ShellLexer lexer(code);
+    auto tokens = lexer.tokenize();
+    ShellParser parser(tokens);
+    auto ast = parser.parseProgram();
+    assert(ast->statements.size() == 500);
+    assert(parser.errorCount() == 0);
+    
+    // Every node lives in one of a handful of arena blocks
+    size_t used = ast->arena.bytesUsed();
+    size_t blocks = ast->arena.blockCount();
+    assert(used >= 500 * (sizeof(VarDeclStmt) + 2 * sizeof(BinaryOpExpr)));
+    assert(blocks > 0 && blocks < 40);
+    std::cout << "3000 nodes in " << used << " bytes, " << blocks << " blocks\n";
+    
+    // Oversized and over-aligned requests
+    Arena arena;
+    void* big = arena.allocate(Arena::kMaxBlockSize * 2, 8);
+    void* aligned = arena.allocate(3, 16);
+    assert(big != nullptr);
+    assert(reinterpret_cast<uintptr_t>(aligned) % 16 == 0);
+    (void)big;
+    (void)aligned;
+    
+    // Error recovery is counted
+    std::string broken = "int8 = 5; int8 ok = 1;";
+    ShellLexer brokenLexer(broken);
+    auto brokenTokens = brokenLexer.tokenize();
+    ShellParser brokenParser(brokenTokens);
+    auto partial = brokenParser.parseProgram();
+    assert(brokenParser.errorCount() == 1);
+    (void)partial;
+    
+    std::cout << "✓ Arena allocation working\n";
+}
+
+static std::string printAST(Program& program) {
+    std::ostringstream out;
+    std::streambuf* saved = std::cout.rdbuf(out.rdbuf());
+    ASTPrinter printer;
+    program.accept(printer);
+    std::cout.rdbuf(saved);
+    return out.str();
+}
+
+void test_zero_copy_lexer() {
+    std::cout << "\n=== Test: Zero-Copy Lexer ===\n";
+    
+    // Lexemes view the source; only escaped strings are copied
+    std::string code = "string greeting = \"plain\"; string esc = \"a\\tb\";";
+    ShellLexer lexer(code);
+    auto tokens = lexer.tokenize();
+    auto inSource = [&](std::string_view text) {
+        return text.data() >= code.data() && text.data() + text.size() <= code.data() + code.size();
+    };
+    assert(tokens[1].lexeme == "greeting" && inSource(tokens[1].lexeme));
+    assert(tokens[3].type == TokenType::STRING && tokens[3].lexeme == "plain");
+    assert(inSource(tokens[3].lexeme));
+    assert(tokens[8].lexeme == "a\tb" && !inSource(tokens[8].lexeme));
+    (void)inSource;
+    
+    // Every keyword through the perfect hash; near misses stay identifiers
+    const char* keywords[] = {"if", "else", "while", "for", "in", "func", "return", "break",
+                              "continue", "spawn", "int8", "int16", "int32", "int64", "tbb8",
+                              "tbb16", "tbb32", "tbb64", "string", "buffer", "bool", "gc", "wild"};
+    for (const char* keyword : keywords) {
+        ShellLexer kwLexer(keyword);
+        Token token = kwLexer.nextToken();
+        assert(token.isKeyword());
+        assert(token.lexeme == keyword);
+        (void)token;
+    }
+    for (const char* name : {"iff", "int", "tbb", "gcc", "w", "x", "int88", "returns", "bools"}) {
+        ShellLexer idLexer(name);
+        assert(idLexer.nextToken().type == TokenType::IDENTIFIER);
+    }
+    
+    // Long runs cross the 16-byte vector scans; locations must still agree
+    std::string spaced = "a                    \n\n     \t   long_identifier_name_over_16 \xC3\xA9 99";
+    ShellLexer spacedLexer(spaced);
+    auto spacedTokens = spacedLexer.tokenize();
+    assert(spacedTokens[1].lexeme == "long_identifier_name_over_16");
+    assert(spacedTokens[1].location.line == 3);
+    assert(spacedTokens[1].location.column == 10);
+    assert(spacedTokens[2].type == TokenType::UNKNOWN);  // Non-ASCII byte
+    assert(spacedTokens[4].type == TokenType::INTEGER && spacedTokens[4].intValue == 99);
+    assert(spacedTokens[4].location.column == 42);
+    
+    bool threw = false;
+    try {
+        ShellLexer big("99999999999999999999");
+        big.tokenize();
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+    
+    // The streaming parser builds the same tree as the token vector
+    std::string program = R"(
+        int8 x = 5 * (2 + y);
+        if (x >= 10) { echo "big" | wc "-l" > out; } else { x = 0 - x; }
+        while (x < 100) { x = x + len("abc"); }
+    )";
+    ShellLexer vectorLexer(program);
+    auto programTokens = vectorLexer.tokenize();
+    ShellParser vectorParser(programTokens);
+    auto fromVector = vectorParser.parseProgram();
+    
+    ShellLexer streamLexer(program);
+    ShellParser streamParser(streamLexer);
+    auto fromStream = streamParser.parseProgram();
+    assert(printAST(*fromVector) == printAST(*fromStream));
+    assert(fromStream->statements.size() == 3);
+    
+    std::cout << "✓ Zero-copy lexer working\n";
+}
+
+void test_parallel() {
+    std::cout << "\n=== Test: Parallel ===\n";
+    
+    std::string code = "parallel (n + 1) { sleep 1; ls | wc; } parallel { true; }";
+    ShellLexer lexer(code);
+    auto tokens = lexer.tokenize();
+    ShellParser parser(tokens);
+    auto ast = parser.parseProgram();
+    assert(parser.errorCount() == 0);
+    assert(ast->statements.size() == 2);
+    
+    auto* bounded = dynamic_cast<ParallelStmt*>(ast->statements[0].get());
+    assert(bounded && bounded->limit && bounded->tasks.size() == 2);
+    assert(bounded->tasks[1]->commands.size() == 2);
+    auto* unbounded = dynamic_cast<ParallelStmt*>(ast->statements[1].get());
+    assert(unbounded && !unbounded->limit && unbounded->tasks.size() == 1);
+    (void)bounded;
+    (void)unbounded;
+    std::cout << printAST(*ast);
+    
+    // Only commands can be fanned out
+    ShellLexer badLexer("parallel { int32 x = 1; }");
+    auto badTokens = badLexer.tokenize();
+    ShellParser badParser(badTokens);
+    badParser.parseProgram();
+    assert(badParser.errorCount() > 0);
+    
+    std::cout << "✓ Parallel statement working\n";
+}
+
+void test_command_substitution() {
+    std::cout << "\n=== Test: Command Substitution ===\n";
+    
+    std::string code = "string s = $(ls \"-l\" | wc); for (line in $(cat \"f\")) { echo line; }";
+    ShellLexer lexer(code);
+    auto tokens = lexer.tokenize();
+    ShellParser parser(tokens);
+    auto ast = parser.parseProgram();
+    assert(parser.errorCount() == 0);
+    assert(ast->statements.size() == 2);
+    
+    auto* decl = dynamic_cast<VarDeclStmt*>(ast->statements[0].get());
+    assert(decl);
+    auto* subst = dynamic_cast<CommandSubstExpr*>(decl->initializer.get());
+    assert(subst && subst->pipeline->commands.size() == 2);
+    assert(subst->pipeline->commands[0]->arguments == std::vector<std::string>{"-l"});
+    auto* loop = dynamic_cast<ForStmt*>(ast->statements[1].get());
+    assert(loop && dynamic_cast<CommandSubstExpr*>(loop->iterable.get()));
+    (void)subst;
+    (void)loop;
+    std::cout << printAST(*ast);
+    
+    // A lone '$' is not an operator
+    ShellLexer badLexer("string s = $ls;");
+    auto badTokens = badLexer.tokenize();
+    ShellParser badParser(badTokens);
+    badParser.parseProgram();
+    assert(badParser.errorCount() > 0);
+    
+    std::cout << "✓ Command substitution parsing working\n";
+}
+
 int main() {
     try {
         test_whitespace_insensitive_parsing();
@@ -319,6 +571,10 @@ int main() {
         test_pipeline();
         test_redirections();
         test_mixed_statements();
+        test_arena_allocation();
+        test_zero_copy_lexer();
+        test_parallel();
+        test_command_substitution();
         
         std::cout << "\n✅ All parser tests passed!\n";
         return 0;
@@ -0,0 +1,583 @@
+/**
+ * REPL Tests - Validates frame rendering and input composition
+ *
+ * Runs without a terminal: the renderer is built with fd -1 and the
+ * escape sequences it would write are compared directly; terminal input
+ * is fed through a pipe in place of stdin.
+ */
+
+#include "repl/renderer.hpp"
+#include "repl/input_engine.hpp"
+#include "repl/history.hpp"
+#include "repl/completion.hpp"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ariash::repl;
+
+static Frame frame(std::vector<std::string> rows, size_t row, size_t column) {
+    Frame f;
+    f.rows = std::move(rows);
+    f.cursorRow = row;
+    f.cursorColumn = column;
+    return f;
+}
+
+void test_incremental_frames() {
+    std::cout << "\n=== Test: Incremental Frames ===\n";
+
+    FrameRenderer renderer(-1);
+
+    // First frame is drawn in full; the cursor ends where the text does
+    assert(renderer.render(frame({"> "}, 0, 2)) == "> ");
+
+    // Typing at the end sends only the new character
+    assert(renderer.render(frame({"> l"}, 0, 3)) == "l");
+    assert(renderer.render(frame({"> ls"}, 0, 4)) == "s");
+
+    // Nothing changed: nothing to send
+    assert(renderer.render(frame({"> ls"}, 0, 4)).empty());
+
+    // Cursor moves are positioned from the left edge
+    assert(renderer.render(frame({"> ls"}, 0, 3)) == "\r\x1B[3C");
+
+    // Inserting mid-line rewrites the tail only
+    assert(renderer.render(frame({"> lxs"}, 0, 4)) == "xs\r\x1B[4C");
+
+    // Backspace at the end erases the old tail
+    assert(renderer.render(frame({"> l"}, 0, 3)) == "\r\x1B[3C\x1B[K");
+
+    std::cout << "✓ Only changed cells are sent\n";
+}
+
+void test_multiline_frames() {
+    std::cout << "\n=== Test: Multi-line Frames ===\n";
+
+    FrameRenderer renderer(-1);
+    renderer.render(frame({"> {"}, 0, 3));
+
+    // A new row is opened below; the first is left alone
+    assert(renderer.render(frame({"> {", "... "}, 1, 4)) == "\r\n... ");
+    assert(renderer.render(frame({"> {", "... x"}, 1, 5)) == "x");
+
+    // Editing the first row from the second moves up and back
+    std::string out = renderer.render(frame({"> {}", "... x"}, 1, 5));
+    assert(out == "\x1B[1A\r\x1B[3C}\x1B[1B\r\x1B[5C");
+
+    // Rows that went away are cleared; the cursor goes back up
+    out = renderer.render(frame({"> {}"}, 0, 4));
+    assert(out == "\r\x1B[K\x1B[1A\r\x1B[4C");
+
+    // The cleared row is reused without scrolling
+    out = renderer.render(frame({"> {}", "... y"}, 1, 5));
+    assert(out == "\x1B[1B\r... y");
+    (void)out;
+
+    std::cout << "✓ Rows are added, edited and removed in place\n";
+}
+
+void test_wrapping() {
+    std::cout << "\n=== Test: Wrapping ===\n";
+
+    FrameRenderer renderer(-1);
+    renderer.setWidth(10);
+
+    // 25 characters over three physical rows
+    std::string text(25, 'a');
+    std::string out = renderer.render(frame({text}, 0, 25));
+    assert(out == "aaaaaaaaaa\r\naaaaaaaaaa\r\naaaaa");
+
+    // Cursor to column 12: second physical row, column 2
+    out = renderer.render(frame({text}, 0, 12));
+    assert(out == "\x1B[1A\r\x1B[2C");
+
+    // Exactly full: the cursor sits at the start of a row of its own
+    FrameRenderer full(-1);
+    full.setWidth(10);
+    out = full.render(frame({std::string(10, 'b')}, 0, 10));
+    assert(out == "bbbbbbbbbb\r\n");
+    (void)out;
+
+    std::cout << "✓ Long rows wrap at the terminal width\n";
+}
+
+void test_finish_and_clear() {
+    std::cout << "\n=== Test: Finish and Clear ===\n";
+
+    FrameRenderer renderer(-1);
+    renderer.render(frame({"> {", "... ab"}, 0, 1));
+
+    // finish() parks below the last row; the next frame starts afresh
+    size_t before = renderer.bytesWritten();
+    renderer.finish("^C");
+    assert(renderer.bytesWritten() - before == std::string("\x1B[1B\r\x1B[6C^C\r\n").size());
+    assert(renderer.render(frame({"> "}, 0, 2)) == "> ");
+
+    // clearScreen() prefixes the next frame, which is drawn in full
+    renderer.clearScreen();
+    assert(renderer.render(frame({"> "}, 0, 2)) == "\x1B[2J\x1B[H> ");
+    (void)before;
+
+    std::cout << "✓ finish() and clearScreen()\n";
+}
+
+void test_paste_cost() {
+    std::cout << "\n=== Test: Paste Cost ===\n";
+
+    // A 2000-character line typed (or pasted) one key at a time: a full
+    // redraw per key sends O(n^2) bytes, the diff sends each key once
+    FrameRenderer renderer(-1);
+    renderer.setWidth(4096);
+    std::string line = "> ";
+    size_t fullRedraw = 0;
+    renderer.render(frame({line}, 0, line.size()));
+    for (int i = 0; i < 2000; i++) {
+        line += static_cast<char>('a' + i % 26);
+        renderer.render(frame({line}, 0, line.size()));
+        fullRedraw += 1 + line.size();  // "\r" + prompt + buffer
+    }
+    std::cout << "Diff: " << renderer.bytesWritten() << " bytes, full redraw: "
+              << fullRedraw << " bytes\n";
+    assert(renderer.bytesWritten() == line.size());
+
+    std::cout << "✓ Paste cost is linear\n";
+}
+
+void test_frame_pacing() {
+    std::cout << "\n=== Test: Frame Pacing ===\n";
+
+    FrameRenderer renderer(-1);
+    renderer.setRefreshRate(20);  // 50 ms
+    renderer.render(frame({"> "}, 0, 2));
+    assert(!renderer.frameDue());
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    assert(renderer.frameDue());
+
+    std::cout << "✓ Frames are paced to the refresh rate\n";
+}
+
+void test_compose_frame() {
+    std::cout << "\n=== Test: Compose Frame ===\n";
+
+    PlatformTerminal terminal;
+    InputEngine engine(terminal);
+    Frame f = engine.composeFrame();
+    assert(f.rows.size() == 1 && f.rows[0] == "[RUN] aria> ");
+    assert(f.cursorRow == 0 && f.cursorColumn == f.rows[0].size());
+
+    engine.toggleMode();
+    f = engine.composeFrame();
+    assert(f.rows[0] == "[EDIT] aria> ");
+    (void)f;
+
+    std::cout << "✓ Prompt and buffer composed into a frame\n";
+}
+
+// Feed `bytes` to PlatformTerminal through a pipe on stdin; `later`
+// arrives after a pause, as the tail of a paste split across reads would
+static std::vector<KeyEvent> decode(const std::string& bytes, const std::string& later = "") {
+    int fds[2];
+    int piped = pipe(fds);
+    assert(piped == 0);
+    (void)piped;
+    int savedStdin = dup(STDIN_FILENO);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+    
+    std::thread writer([&]() {
+        ssize_t n = write(fds[1], bytes.data(), bytes.size());
+        if (!later.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            n = write(fds[1], later.data(), later.size());
+        }
+        (void)n;
+        close(fds[1]);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    
+    PlatformTerminal terminal;
+    std::vector<KeyEvent> events;
+    while (auto event = terminal.readEvent()) {
+        events.push_back(*event);
+    }
+    writer.join();
+    
+    dup2(savedStdin, STDIN_FILENO);
+    close(savedStdin);
+    return events;
+}
+
+void test_batched_decoding() {
+    std::cout << "\n=== Test: Batched Decoding ===\n";
+    
+    // Keys, a bracketed paste and an arrow key from one read
+    auto events = decode("ab\x1B[200~one\r\ntwo {\rthree\x1B[201~\x1B[A\x03");
+    assert(events.size() == 5);
+    assert(events[0].type == KeyType::CHARACTER && events[0].codepoint == 'a');
+    assert(events[1].type == KeyType::CHARACTER && events[1].codepoint == 'b');
+    assert(events[2].type == KeyType::PASTE && events[2].text == "one\ntwo {\nthree");
+    assert(events[3].type == KeyType::ARROW_UP);
+    assert(events[4].type == KeyType::CTRL_C);
+    
+    // A paste split across reads is still one event
+    events = decode("\x1B[200~first half, ", "second half\x1B[201~x");
+    assert(events.size() == 2);
+    assert(events[0].type == KeyType::PASTE && events[0].text == "first half, second half");
+    assert(events[1].type == KeyType::CHARACTER && events[1].codepoint == 'x');
+    
+    // Lone ESC, then an unterminated sequence that is dropped
+    events = decode("\x1B");
+    assert(events.size() == 1 && events[0].type == KeyType::ESCAPE);
+    events = decode("\x1B[1");
+    assert(events.empty());
+    
+    std::cout << "✓ Keys and pastes decoded in batches\n";
+}
+
+void test_incremental_depth() {
+    std::cout << "\n=== Test: Incremental Depth ===\n";
+    
+    EditBuffer buffer;
+    buffer.insertText("if (x) {\n  print(\"}\"); // }\n  s = 'multi\nline {';");
+    assert(buffer.lineCount() == 4);
+    assert(buffer.getBraceDepth() == 1);
+    
+    buffer.insertText("\n}");
+    assert(buffer.getBraceDepth() == 0 && buffer.isBalanced());
+    
+    // Editing an earlier line rescans from there
+    buffer.moveCursorToStart();
+    buffer.insertChar('{');
+    assert(buffer.getBraceDepth() == 1);
+    buffer.backspace();
+    assert(buffer.getBraceDepth() == 0);
+    
+    // "//" inside a string does not start a comment
+    EditBuffer url;
+    url.insertText("echo \"http://x\" {");
+    assert(url.getBraceDepth() == 1);
+    
+    // Pasting mid-line keeps the tail after the paste
+    EditBuffer mid;
+    mid.insertText("ab");
+    mid.moveCursorLeft();
+    mid.insertText("1\n2");
+    assert(mid.getContent() == "a1\n2b");
+    assert(mid.getCursor().line == 1 && mid.getCursor().column == 1);
+    
+    EditBuffer semis;
+    semis.insertText("x;\n ; \n");
+    assert(semis.endsWithDoubleSemicolon() && semis.shouldAutoSubmit());
+    
+    std::cout << "✓ Brace depth tracked per line\n";
+}
+
+void test_large_paste() {
+    std::cout << "\n=== Test: Large Paste ===\n";
+    
+    std::string script;
+    for (int i = 0; i < 2000; i++) {
+        script += "if (i < " + std::to_string(i) + ") { echo \"line\" " + std::to_string(i) + "; }\n";
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    EditBuffer buffer;
+    buffer.insertText(script);
+    int depth = buffer.getBraceDepth();
+    // Typing after the paste rescans only the last line
+    for (int i = 0; i < 1000; i++) {
+        buffer.insertChar('{');
+        depth = buffer.getBraceDepth();
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "2000-line paste + 1000 keys: " << ms << "ms\n";
+    assert(buffer.lineCount() == 2001);
+    assert(depth == 1000);
+    assert(ms < 100);
+    (void)depth;
+    
+    std::cout << "✓ Large pastes land in one step\n";
+}
+
+static std::string tempHistory() {
+    char path[] = "/tmp/ariash_history_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    return path;
+}
+
+void test_history_log() {
+    std::cout << "\n=== Test: History Log ===\n";
+    
+    std::string path = tempHistory();
+    {
+        History history(path);
+        assert(history.isOpen());
+        bool added = history.add("ls \"-l\"");
+        assert(added);
+        added = history.add("ls \"-l\"");
+        assert(!added);  // Consecutive duplicate
+        added = history.add("  \n");
+        assert(!added);  // Blank
+        added = history.add("if (x) {\n  echo \"hi\";\n}");
+        assert(added);
+        
+        // A second session sees the first one's entries and vice versa
+        History other(path);
+        added = other.add("pwd");
+        assert(added);
+        auto newest = history.findPrefix("");
+        assert(newest && history.entryAt(*newest) == "pwd");
+        
+        // Multi-line entries are one entry
+        auto hit = history.findSubstring("echo");
+        assert(hit && history.entryAt(*hit) == "if (x) {\n  echo \"hi\";\n}");
+        
+        // Older matches are found from a previous one
+        added = history.add("ls \"-a\"");
+        assert(added);
+        hit = history.findPrefix("ls");
+        assert(hit && history.entryAt(*hit) == "ls \"-a\"");
+        hit = history.findPrefix("ls", *hit);
+        assert(hit && history.entryAt(*hit) == "ls \"-l\"");
+        assert(!history.findPrefix("ls", *hit));
+        assert(!history.findSubstring("missing"));
+        (void)added;
+        (void)newest;
+    }
+    
+    // Reopened: the index answers for everything written before
+    History reopened(path);
+    reopened.waitForIndex();
+    assert(reopened.indexReady());
+    auto hit = reopened.findSubstring("echo \"hi");
+    assert(hit && reopened.entryAt(*hit).find("if (x)") == 0);
+    hit = reopened.findSubstring("ls \"");
+    assert(hit && reopened.entryAt(*hit) == "ls \"-a\"");
+    hit = reopened.findSubstring("ls \"", *hit);
+    assert(hit && reopened.entryAt(*hit) == "ls \"-l\"");
+    (void)hit;
+    
+    std::remove(path.c_str());
+    std::cout << "✓ Entries shared between sessions and searched\n";
+}
+
+void test_history_scale() {
+    std::cout << "\n=== Test: History Scale ===\n";
+    
+    std::string path = tempHistory();
+    {
+        // 200k entries written directly (as years of sessions would)
+        FILE* file = std::fopen(path.c_str(), "w");
+        for (int i = 0; i < 200000; i++) {
+            std::fprintf(file, "echo \"entry %d\" | grep \"%d\"%c", i, i * 7, '\0');
+        }
+        std::fclose(file);
+    }
+    
+    // Opening maps the file; nothing is read up front
+    auto start = std::chrono::steady_clock::now();
+    History history(path);
+    double openMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Open: " << openMs << "ms\n";
+    assert(openMs < 50);
+    
+    // Newest first even before the index is ready
+    auto newest = history.findPrefix("echo");
+    assert(newest && history.entryAt(*newest) == "echo \"entry 199999\" | grep \"1399993\"");
+    
+    history.waitForIndex();
+    start = std::chrono::steady_clock::now();
+    auto hit = history.findSubstring("entry 12345\"");
+    double queryMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Indexed substring search: " << queryMs << "ms\n";
+    assert(hit && history.entryAt(*hit) == "echo \"entry 12345\" | grep \"86415\"");
+    if (queryMs >= 5) {
+        throw std::runtime_error("indexed substring search took " + std::to_string(queryMs) + "ms");
+    }
+    (void)openMs;
+    (void)newest;
+    (void)hit;
+    
+    std::remove(path.c_str());
+    std::cout << "✓ Large histories open and search quickly\n";
+}
+
+static KeyEvent key(KeyType type, uint32_t codepoint = 0) {
+    KeyEvent event;
+    event.type = type;
+    event.codepoint = codepoint;
+    return event;
+}
+
+static void typeText(InputEngine& engine, const std::string& text) {
+    for (char c : text) {
+        engine.handleEvent(key(KeyType::CHARACTER, static_cast<unsigned char>(c)));
+    }
+}
+
+// Single-line input as displayed, without the prompt
+[[maybe_unused]] static std::string shown(InputEngine& engine) {
+    Frame f = engine.composeFrame();
+    return f.rows[0].substr(std::string("[RUN] aria> ").size());
+}
+
+void test_history_keys() {
+    std::cout << "\n=== Test: History Keys ===\n";
+    
+    std::string path = tempHistory();
+    History history(path);
+    history.add("ls \"-l\"");
+    history.add("echo \"one\"");
+    history.add("ls \"-a\"");
+    
+    PlatformTerminal terminal;
+    InputEngine engine(terminal);
+    engine.setHistory(&history);
+    
+    // Up walks back through entries starting with what was typed
+    typeText(engine, "ls");
+    engine.handleEvent(key(KeyType::ARROW_UP));
+    assert(shown(engine) == "ls \"-a\"");
+    engine.handleEvent(key(KeyType::ARROW_UP));
+    assert(shown(engine) == "ls \"-l\"");
+    engine.handleEvent(key(KeyType::ARROW_UP));  // Oldest: stays
+    assert(shown(engine) == "ls \"-l\"");
+    engine.handleEvent(key(KeyType::ARROW_DOWN));
+    engine.handleEvent(key(KeyType::ARROW_DOWN));
+    assert(shown(engine) == "ls");  // Back to the draft
+    
+    // Ctrl+R searches as the query is typed, Enter accepts
+    engine.handleEvent(key(KeyType::CTRL_R));
+    typeText(engine, "on");
+    Frame f = engine.composeFrame();
+    assert(f.rows.size() == 1 && f.rows[0] == "(reverse-i-search)`on': echo \"one\"");
+    typeText(engine, "x");
+    f = engine.composeFrame();
+    assert(f.rows[0] == "failed (reverse-i-search)`onx': ");
+    engine.handleEvent(key(KeyType::BACKSPACE));
+    engine.handleEvent(key(KeyType::ENTER));
+    assert(shown(engine) == "echo \"one\"");
+    
+    // Ctrl+R again steps to older matches; ESC leaves the buffer alone
+    engine.handleEvent(key(KeyType::CTRL_R));
+    typeText(engine, "ls");
+    engine.handleEvent(key(KeyType::CTRL_R));
+    f = engine.composeFrame();
+    assert(f.rows[0] == "(reverse-i-search)`ls': ls \"-l\"");
+    engine.handleEvent(key(KeyType::ESCAPE));
+    assert(shown(engine) == "echo \"one\"");
+    (void)f;
+    
+    std::remove(path.c_str());
+    std::cout << "✓ Up/Down and Ctrl+R browse history\n";
+}
+
+static void touch(const std::string& path, mode_t mode) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    assert(file);
+    std::fclose(file);
+    chmod(path.c_str(), mode);
+}
+
+void test_completion_index() {
+    std::cout << "\n=== Test: Completion Index ===\n";
+    
+    char first[] = "/tmp/ariash_bin_XXXXXX";
+    char second[] = "/tmp/ariash_bin_XXXXXX";
+    bool made = mkdtemp(first) && mkdtemp(second);
+    assert(made);
+    (void)made;
+    touch(std::string(first) + "/aria_tool_one", 0755);
+    touch(std::string(first) + "/aria_tool_two", 0755);
+    touch(std::string(first) + "/aria_tool_data", 0644);  // Not executable
+    touch(std::string(second) + "/aria_tool_other", 0755);
+    std::string savedPath = std::getenv("PATH") ? std::getenv("PATH") : "";
+    setenv("PATH", (std::string(first) + ":" + second).c_str(), 1);
+    
+    CompletionIndex index;
+    index.waitForRefresh();
+    assert(index.ready());
+    auto names = index.complete("aria_tool");
+    assert((names == std::vector<std::string>{"aria_tool_one", "aria_tool_other", "aria_tool_two"}));
+    assert(index.complete("ech") == std::vector<std::string>{"echo"});  // Builtins
+    assert(index.complete("aria_tool", 1).size() == 1);
+    
+    // Variables are merged in
+    index.setVariables({"aria_total", "x"});
+    assert(index.complete("aria_to").size() == 4);
+    
+    // A new file invalidates its directory only, which alone is listed again
+    uint64_t scans = index.directoryScans();
+    touch(std::string(second) + "/aria_tool_new", 0755);
+    index.refresh();
+    index.waitForRefresh();
+    assert(index.directoryScans() == scans + 1);
+    assert(index.complete("aria_tool_n") == std::vector<std::string>{"aria_tool_new"});
+    
+    // Nothing changed: nothing is listed
+    index.refresh();
+    index.waitForRefresh();
+    assert(index.directoryScans() == scans + 1);
+    
+    // TAB in the input engine
+    PlatformTerminal terminal;
+    InputEngine engine(terminal);
+    engine.setCompletion(&index);
+    typeText(engine, "echo \"a\" | aria_tool_o");
+    engine.handleEvent(key(KeyType::TAB));  // "one" and "other": no longer prefix
+    Frame f = engine.composeFrame();
+    assert(f.rows.size() == 2 && f.rows[1] == "aria_tool_one  aria_tool_other");
+    typeText(engine, "n");
+    engine.handleEvent(key(KeyType::TAB));
+    f = engine.composeFrame();
+    assert(f.rows.size() == 1 && f.rows[0] == "[RUN] aria> echo \"a\" | aria_tool_one ");
+    (void)f;
+    (void)names;
+    (void)scans;
+    
+    setenv("PATH", savedPath.c_str(), 1);
+    for (const char* dir : {first, second}) {
+        std::string command = std::string("rm -rf ") + dir;
+        int removed = std::system(command.c_str());
+        (void)removed;
+    }
+    std::cout << "✓ PATH, builtins and variables completed from the index\n";
+}
+
+int main() {
+    try {
+        test_incremental_frames();
+        test_multiline_frames();
+        test_wrapping();
+        test_finish_and_clear();
+        test_paste_cost();
+        test_frame_pacing();
+        test_compose_frame();
+        test_batched_decoding();
+        test_incremental_depth();
+        test_large_paste();
+        test_history_log();
+        test_history_scale();
+        test_history_keys();
+        test_completion_index();
+
+        std::cout << "\n✅ All REPL tests passed!\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << "\n";
+        return 1;
+    }
+}
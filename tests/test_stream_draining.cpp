@@ -1,18 +1,29 @@
 /**
  * Stream Draining Test - Deadlock Prevention Demonstration
  *
- * Tests the C++20 jthread-based stream draining model.
+ * Tests the reactor-based stream draining model.
  * Verifies that:
  * 1. Large outputs (>64KB) don't cause deadlock
- * 2. C++20 jthread properly handles cooperative cancellation
+ * 2. Stopping a drain on a hanging child is prompt
  * 3. Overflow policies work (block vs drop)
  * 4. Performance metrics are accurate
+ * 5. Thread count stays flat as the number of jobs grows
+ * 6. Floods of tiny stddbg writes arrive intact (io_uring or epoll backend)
+ * 7. Ring buffers are allocated lazily and grow only as far as needed
+ * 8. Spans expose ring memory without copies; mirrored rings never split
+ * 9. A stalled BLOCK-mode stream costs no CPU and resumes on consumer reads
+ * 10. A slow callback stalls neither other jobs' delivery nor its ring's growth
  */
 
 #include "job/stream_controller.hpp"
+#include <atomic>
 #include <iostream>
+#include <fstream>
+#include <memory>
+#include <string>
 #include <vector>
 #include <cstring>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -190,7 +201,7 @@ void test_multiple_streams() {
 }
 
 void test_cooperative_cancellation() {
-    std::cout << CYAN << "\n=== Test 4: Cooperative Cancellation (jthread) ===" << RESET << "\n";
+    std::cout << CYAN << "\n=== Test 4: Cooperative Cancellation ===" << RESET << "\n";
     
     StreamController controller;
     controller.createPipes();
@@ -212,13 +223,13 @@ void test_cooperative_cancellation() {
     controller.setupParent();
     controller.startDraining();
     
-    std::cout << "Started draining threads for hanging child...\n";
+    std::cout << "Started draining hanging child...\n";
     usleep(500000);  // Wait 500ms
     
-    std::cout << "Destroying controller (triggers jthread stop_token)...\n";
+    std::cout << "Destroying controller (unregisters from the reactor)...\n";
     
     auto start = std::chrono::steady_clock::now();
-    controller.close();  // Should cleanly stop threads within ~100ms
+    controller.close();  // Should unregister immediately
     auto duration = std::chrono::steady_clock::now() - start;
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
     
@@ -229,21 +240,426 @@ void test_cooperative_cancellation() {
     waitpid(pid, nullptr, 0);
     
     if (ms < 500) {  // Should stop quickly (within poll timeout + overhead)
-        std::cout << GREEN << "✓ jthread cooperative cancellation works!" << RESET << "\n";
+        std::cout << GREEN << "✓ Drain cancellation works!" << RESET << "\n";
     } else {
         std::cout << YELLOW << "⚠ Cancellation took " << ms << "ms (expected <500ms)" << RESET << "\n";
     }
 }
 
+// Threads in this process, from /proc/self/status (0 if unavailable)
+static int countThreads() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("Threads:", 0) == 0) {
+            return std::stoi(line.substr(8));
+        }
+    }
+    return 0;
+}
+
+void test_many_jobs() {
+    std::cout << CYAN << "\n=== Test 5: Thread Count vs Job Count ===" << RESET << "\n";
+    
+    const int jobCount = 64;
+    int before = countThreads();
+    
+    std::vector<std::unique_ptr<StreamController>> controllers;
+    std::vector<pid_t> pids;
+    
+    for (int i = 0; i < jobCount; ++i) {
+        auto controller = std::make_unique<StreamController>();
+        if (!controller->createPipes()) break;
+        
+        pid_t pid = fork();
+        if (pid < 0) break;
+        
+        if (pid == 0) {
+            // Child - keep all streams open for a while, then say hello
+            controller->setupChild();
+            usleep(300000);
+            write(STDOUT_FILENO, "x", 1);
+            _exit(0);
+        }
+        
+        controller->setupParent();
+        controller->startDraining();
+        controllers.push_back(std::move(controller));
+        pids.push_back(pid);
+    }
+    
+    int during = countThreads();
+    
+    for (pid_t pid : pids) {
+        waitpid(pid, nullptr, 0);
+    }
+    
+    size_t delivered = 0;
+    for (auto& controller : controllers) {
+        controller->waitForDrain(1000);
+        delivered += controller->availableData(StreamIndex::STDOUT);
+    }
+    
+    std::cout << "Jobs: " << controllers.size() << ", threads before: " << before
+              << ", while draining: " << during << "\n";
+    std::cout << "Bytes delivered: " << delivered << "\n";
+    
+    // At most the shared reactor thread may appear (if no earlier test started it)
+    if (during - before <= 1 && delivered == controllers.size()) {
+        std::cout << GREEN << "✓ Thread count independent of job count" << RESET << "\n";
+    } else {
+        std::cout << RED << "✗ Thread count grew with jobs or output was lost" << RESET << "\n";
+    }
+}
+
+void test_small_writes() {
+    std::cout << CYAN << "\n=== Test 6: Many Small stddbg Writes ===" << RESET << "\n";
+    std::cout << "Reactor backend: " << getIoReactor().backendName() << "\n";
+    
+    const size_t writes = 20000;
+    const char msg[] = "dbg: tick 0000\n";
+    const size_t msgLen = sizeof(msg) - 1;
+    
+    StreamController controller;
+    if (!controller.createPipes()) {
+        std::cout << RED << "✗ Failed to create pipes" << RESET << "\n";
+        return;
+    }
+    
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cout << RED << "✗ Fork failed" << RESET << "\n";
+        return;
+    }
+    
+    if (pid == 0) {
+        controller.setupChild();
+        for (size_t i = 0; i < writes; ++i) {
+            if (write(3, msg, msgLen) != static_cast<ssize_t>(msgLen)) _exit(1);
+        }
+        _exit(0);
+    }
+    
+    controller.setupParent();
+    controller.startDraining();
+    waitpid(pid, nullptr, 0);
+    controller.waitForDrain(2000);
+    
+    size_t buffered = controller.availableData(StreamIndex::STDDBG);
+    std::cout << "Expected: " << writes * msgLen << ", buffered: " << buffered << "\n";
+    
+    if (buffered == writes * msgLen) {
+        std::cout << GREEN << "✓ All small writes delivered" << RESET << "\n";
+    } else {
+        std::cout << RED << "✗ Small writes lost" << RESET << "\n";
+    }
+}
+
+void test_lazy_buffers() {
+    std::cout << CYAN << "\n=== Test 7: Lazy, Growable Ring Buffers ===" << RESET << "\n";
+    
+    // Growth doubles from the initial size and stops at the cap
+    RingBuffer growable(16, 64);
+    std::vector<uint8_t> data(100, 'g');
+    size_t before = growable.allocated();
+    size_t first = growable.write(data.data(), 40);
+    size_t afterFirst = growable.allocated();
+    size_t second = growable.write(data.data(), 40);
+    std::cout << "Allocated: " << before << " -> " << afterFirst << " -> "
+              << growable.allocated() << ", accepted " << first << " + " << second << "\n";
+    bool growOk = before == 0 && first == 40 && afterFirst == 64 &&
+                  second == 24 && growable.full();
+    
+    // A controller costs nothing until a stream produces data, and a
+    // one-line job only allocates the initial size for that stream
+    StreamController controller;
+    size_t idle = controller.getBufferMemory();
+    size_t used = 0;
+    size_t buffered = 0;
+    
+    if (controller.createPipes()) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            controller.setupChild();
+            const char line[] = "just one line\n";
+            ssize_t wrote = write(STDOUT_FILENO, line, sizeof(line) - 1);
+            (void)wrote;
+            _exit(0);
+        }
+        if (pid > 0) {
+            controller.setupParent();
+            controller.startDraining();
+            waitpid(pid, nullptr, 0);
+            controller.waitForDrain(1000);
+            used = controller.getBufferMemory();
+            buffered = controller.availableData(StreamIndex::STDOUT);
+        }
+    }
+    
+    std::cout << "Controller memory idle: " << idle << ", after one line: " << used
+              << " (" << buffered << " bytes buffered)\n";
+    
+    StreamOptions defaults;
+    if (growOk && idle == 0 && used == defaults.initialCapacity && buffered == 14) {
+        std::cout << GREEN << "✓ Buffers allocated on demand" << RESET << "\n";
+    } else {
+        std::cout << RED << "✗ Unexpected buffer allocation" << RESET << "\n";
+    }
+}
+
+void test_spans() {
+    std::cout << CYAN << "\n=== Test 8: Zero-Copy Spans and Mirrored Rings ===" << RESET << "\n";
+    
+    // Wrap-around: a plain ring splits the span, a mirrored one does not
+    bool spansOk = true;
+    for (bool mirrored : {false, true}) {
+        RingBuffer ring(4096, 4096, mirrored);
+        std::vector<uint8_t> chunk(3000);
+        for (size_t i = 0; i < chunk.size(); ++i) chunk[i] = static_cast<uint8_t>(i % 251);
+        
+        ring.write(chunk.data(), chunk.size());
+        std::vector<uint8_t> sink(3000);
+        ring.read(sink.data(), sink.size());
+        ring.write(chunk.data(), chunk.size());  // Wraps at 4096
+        
+        std::span<const uint8_t> span = ring.acquireRead();
+        size_t expected = ring.isMirrored() ? 3000 : 4096 - 3000;
+        bool match = span.size() == expected &&
+                     std::memcmp(span.data(), chunk.data(), span.size()) == 0;
+        ring.release(span.size());
+        
+        std::cout << (ring.isMirrored() ? "Mirrored" : "Plain") << " ring span after wrap: "
+                  << span.size() << " bytes\n";
+        spansOk = spansOk && match;
+    }
+    
+    // End to end: callbacks receive ring memory, bytes arrive intact
+    StreamController controller;
+    std::vector<uint8_t> received;
+    controller.onData([&received](StreamIndex stream, const void* data, size_t size) {
+        if (stream != StreamIndex::STDOUT) return;
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        received.insert(received.end(), bytes, bytes + size);
+    });
+    
+    const size_t total = 512 * 1024;
+    if (controller.createPipes()) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            controller.setupChild();
+            std::vector<uint8_t> data(total);
+            for (size_t i = 0; i < total; ++i) data[i] = static_cast<uint8_t>(i % 251);
+            size_t off = 0;
+            while (off < total) {
+                ssize_t n = write(STDOUT_FILENO, data.data() + off, total - off);
+                if (n <= 0) _exit(1);
+                off += n;
+            }
+            _exit(0);
+        }
+        if (pid > 0) {
+            controller.setupParent();
+            controller.startDraining();
+            waitpid(pid, nullptr, 0);
+            controller.waitForDrain(2000);
+        }
+    }
+    
+    bool intact = received.size() == total;
+    for (size_t i = 0; intact && i < total; ++i) {
+        intact = received[i] == static_cast<uint8_t>(i % 251);
+    }
+    std::cout << "Streamed " << received.size() << " of " << total << " bytes\n";
+    
+    if (spansOk && intact) {
+        std::cout << GREEN << "✓ Spans and streamed data intact" << RESET << "\n";
+    } else {
+        std::cout << RED << "✗ Span data mismatch" << RESET << "\n";
+    }
+}
+
+static double cpuSeconds() {
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+void test_backpressure() {
+    std::cout << CYAN << "\n=== Test 9: Backpressure Without Polling ===" << RESET << "\n";
+    
+    // Small stdout ring so the child outruns us immediately
+    StreamOptionSet options = defaultStreamOptions();
+    options[static_cast<size_t>(StreamIndex::STDOUT)].maxCapacity = 64 * 1024;
+    
+    StreamController controller;
+    controller.configureStreams(options);
+    if (!controller.createPipes()) {
+        std::cout << RED << "✗ Failed to create pipes" << RESET << "\n";
+        return;
+    }
+    
+    const size_t total = 2 * 1024 * 1024;
+    pid_t pid = fork();
+    if (pid == 0) {
+        controller.setupChild();
+        std::vector<uint8_t> data(64 * 1024);
+        for (size_t off = 0; off < total; off += data.size()) {
+            for (size_t i = 0; i < data.size(); ++i) {
+                data[i] = static_cast<uint8_t>((off + i) % 241);
+            }
+            size_t done = 0;
+            while (done < data.size()) {
+                ssize_t n = write(STDOUT_FILENO, data.data() + done, data.size() - done);
+                if (n <= 0) _exit(1);
+                done += n;
+            }
+        }
+        _exit(0);
+    }
+    if (pid < 0) return;
+    
+    controller.setupParent();
+    controller.startDraining();
+    
+    // Let the ring and the pipe fill up, then stay away for a while
+    usleep(100000);
+    double cpuBefore = cpuSeconds();
+    usleep(400000);
+    double stalledCpu = cpuSeconds() - cpuBefore;
+    
+    // Now consume everything; each read wakes the drainer
+    std::vector<uint8_t> buf(16 * 1024);
+    size_t received = 0;
+    bool intact = true;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (received < total && std::chrono::steady_clock::now() < deadline) {
+        size_t n = controller.readBuffer(StreamIndex::STDOUT, buf.data(), buf.size());
+        for (size_t i = 0; i < n; ++i) {
+            intact = intact && buf[i] == static_cast<uint8_t>((received + i) % 241);
+        }
+        received += n;
+        if (n == 0) usleep(1000);
+    }
+    waitpid(pid, nullptr, 0);
+    
+    std::cout << "CPU while stalled: " << stalledCpu * 1000 << " ms over 400 ms\n";
+    std::cout << "Received " << received << " of " << total << " bytes\n";
+    
+    if (stalledCpu < 0.05 && received == total && intact) {
+        std::cout << GREEN << "✓ Stalled stream idle, resumed on read" << RESET << "\n";
+    } else {
+        std::cout << RED << "✗ Backpressure busy-waited or lost data" << RESET << "\n";
+    }
+}
+
+void test_slow_callback() {
+    std::cout << CYAN << "\n=== Test 10: Slow Callback Isolation ===" << RESET << "\n";
+    
+    auto nowMs = [] {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    };
+    const size_t total = 1024 * 1024;
+    
+    // Job A: a megabyte of patterned output, consumed by a callback that
+    // stalls on its first chunk while the ring has to grow under it
+    StreamController slow;
+    std::atomic<bool> stalled{false};
+    size_t slowReceived = 0;
+    bool intact = true;
+    slow.onData([&](StreamIndex stream, const void* data, size_t size) {
+        if (stream != StreamIndex::STDOUT) return;
+        if (!stalled.exchange(true)) {
+            usleep(500000);
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            intact = intact && bytes[i] == static_cast<uint8_t>((slowReceived + i) % 241);
+        }
+        slowReceived += size;
+    });
+    
+    // Job B: one line, consumed by a callback that returns at once
+    StreamController fast;
+    std::atomic<int64_t> fastAt{0};
+    fast.onData([&](StreamIndex stream, const void*, size_t) {
+        if (stream == StreamIndex::STDOUT) {
+            fastAt.store(nowMs());
+        }
+    });
+    
+    if (!slow.createPipes() || !fast.createPipes()) {
+        std::cout << RED << "✗ Failed to create pipes" << RESET << "\n";
+        return;
+    }
+    
+    pid_t slowPid = fork();
+    if (slowPid == 0) {
+        slow.setupChild();
+        std::vector<uint8_t> data(total);
+        for (size_t i = 0; i < total; ++i) {
+            data[i] = static_cast<uint8_t>(i % 241);
+        }
+        size_t done = 0;
+        while (done < total) {
+            ssize_t n = write(STDOUT_FILENO, data.data() + done, total - done);
+            if (n <= 0) _exit(1);
+            done += n;
+        }
+        _exit(0);
+    }
+    if (slowPid < 0) return;
+    slow.setupParent();
+    slow.startDraining();
+    
+    // Once A's callback is stuck, start B
+    while (!stalled.load()) usleep(1000);
+    int64_t started = nowMs();
+    
+    pid_t fastPid = fork();
+    if (fastPid == 0) {
+        fast.setupChild();
+        write(STDOUT_FILENO, "hello\n", 6);
+        _exit(0);
+    }
+    if (fastPid < 0) return;
+    fast.setupParent();
+    fast.startDraining();
+    
+    fast.waitForDrain(5000);
+    int64_t fastMs = fastAt.load() == 0 ? -1 : fastAt.load() - started;
+    
+    waitpid(fastPid, nullptr, 0);
+    waitpid(slowPid, nullptr, 0);
+    slow.waitForDrain(10000);
+    
+    std::cout << "Fast job delivered after " << fastMs << " ms (slow callback holds 500 ms)\n";
+    std::cout << "Slow job received " << slowReceived << " of " << total << " bytes, ring "
+              << slow.getBufferMemory() / 1024 << " KB\n";
+    
+    if (fastMs >= 0 && fastMs < 250 && slowReceived == total && intact) {
+        std::cout << GREEN << "✓ Slow consumer held only its own job" << RESET << "\n";
+    } else {
+        std::cout << RED << "✗ Slow callback stalled other jobs or lost data" << RESET << "\n";
+    }
+}
+
 int main() {
     std::cout << CYAN << "\n╔═══════════════════════════════════════════════════════╗\n";
-    std::cout << "║  AriaSH Stream Draining Test Suite (C++20 jthread)  ║\n";
+    std::cout << "║     AriaSH Stream Draining Test Suite (reactor)     ║\n";
     std::cout << "╚═══════════════════════════════════════════════════════╝" << RESET << "\n";
     
     test_ring_buffer();
     test_no_deadlock();
     test_multiple_streams();
     test_cooperative_cancellation();
+    test_many_jobs();
+    test_small_writes();
+    test_lazy_buffers();
+    test_spans();
+    test_backpressure();
+    test_slow_callback();
     
     std::cout << CYAN << "\n╔═══════════════════════════════════════════════════════╗\n";
     std::cout << "║                  All Tests Complete!                  ║\n";
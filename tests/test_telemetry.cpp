@@ -0,0 +1,414 @@
+/**
+ * Telemetry Tests - Validates stddbg parsing and aggregation
+ *
+ * Records are parsed from memory first, then from a real job's stream 3
+ * through the JobManager, and read back with the telemetry builtin.
+ * Job statistics (resource usage, stream drops, latencies) are read back
+ * with the jobs builtin. Jobs are finally spawned and waited for from
+ * several threads at once.
+ */
+
+#include "job/telemetry.hpp"
+#include "job/job_control.hpp"
+#include "executor/builtins.hpp"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ariash;
+using namespace ariash::job;
+
+static bool parses(std::string_view line, std::string_view& name, MetricKind& kind, double& value) {
+    return TelemetryParser::parseRecord(line, name, kind, value);
+}
+
+void test_record_formats() {
+    std::cout << "\n=== Test: Record Formats ===\n";
+
+    std::string_view name;
+    MetricKind kind;
+    double value;
+
+    // JSON: field order is free, unknown fields (nested ones too) are skipped
+    bool ok = parses(R"({"ts": 17, "tags": {"a": [1, "}"]}, "value": 2.5, "metric": "lat", "type": "histogram"})",
+                     name, kind, value);
+    assert(ok && name == "lat" && kind == MetricKind::HISTOGRAM && value == 2.5);
+
+    // Counters count occurrences without a value
+    ok = parses(R"({"metric":"requests"})", name, kind, value);
+    assert(ok && name == "requests" && kind == MetricKind::COUNTER && value == 1);
+
+    // logfmt, quoted values included; "name" works as well as "metric"
+    ok = parses("level=info msg=\"hello world\" name=queue type=gauge value=-3 debug", name, kind, value);
+    assert(ok && name == "queue" && kind == MetricKind::GAUGE && value == -3);
+
+    // Records without a metric are still records
+    ok = parses("level=warn msg=\"no metric here\"", name, kind, value);
+    assert(ok && name.empty());
+
+    // Malformed
+    ok = parses(R"({"metric":"x", "value": )", name, kind, value);
+    assert(!ok);
+    ok = parses(R"({"metric":"x","value":"abc"})", name, kind, value);
+    assert(!ok);
+    ok = parses("metric=x type=gauge", name, kind, value);  // Gauge without a value
+    assert(!ok);
+    ok = parses("metric=x type=set value=1", name, kind, value);
+    assert(!ok);
+    ok = parses("msg=\"unterminated", name, kind, value);
+    assert(!ok);
+    (void)ok;
+
+    std::cout << "✓ JSON and logfmt records parsed in place\n";
+}
+
+void test_split_records() {
+    std::cout << "\n=== Test: Split Records ===\n";
+
+    auto metrics = std::make_shared<TelemetryMetrics>();
+    TelemetryParser parser(metrics);
+
+    // Records cut anywhere by delivery boundaries
+    std::string stream;
+    for (int i = 0; i < 100; i++) {
+        stream += i % 2 ? "metric=hits value=2\n" : "{\"metric\":\"hits\",\"value\":1}\r\n";
+    }
+    stream += "\n  \nnot=\"valid\n";
+    for (size_t pos = 0; pos < stream.size(); pos += 7) {
+        parser.feed(stream.data() + pos, std::min<size_t>(7, stream.size() - pos));
+    }
+    parser.feed("metric=last", 11);  // No newline: parsed at end of stream
+    parser.finish();
+
+    // An overlong line is skipped as one malformed record
+    std::string huge(TelemetryParser::kMaxRecord + 10, 'x');
+    parser.feed(huge.data(), huge.size());
+    parser.feed("x\nmetric=hits\n", 14);
+
+    TelemetrySnapshot snap = metrics->snapshot();
+    assert(snap.records == 104);
+    assert(snap.malformed == 2);
+    assert(snap.metrics.size() == 2);
+    assert(snap.metrics[0].name == "hits" && snap.metrics[0].sum == 151 && snap.metrics[0].count == 101);
+    assert(snap.metrics[1].name == "last" && snap.metrics[1].sum == 1);
+    (void)snap;
+
+    std::cout << "✓ Partial and overlong lines handled\n";
+}
+
+void test_concurrent_aggregation() {
+    std::cout << "\n=== Test: Concurrent Aggregation ===\n";
+
+    TelemetryMetrics metrics;
+    const int perThread = 100000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&metrics, t]() {
+            for (int i = 0; i < perThread; i++) {
+                metrics.record("events", MetricKind::COUNTER, 1);
+                metrics.record("latency", MetricKind::HISTOGRAM, 1 + i % 100);
+            }
+            metrics.record("depth", MetricKind::GAUGE, t);
+        });
+    }
+
+    // Snapshots are taken while the writers run
+    for (int i = 0; i < 10; i++) {
+        TelemetrySnapshot partial = metrics.snapshot();
+        (void)partial;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    metrics.record("depth", MetricKind::GAUGE, 42);
+
+    TelemetrySnapshot snap = metrics.snapshot();
+    assert(snap.records == 4u * perThread * 2 + 5);
+    const MetricSnapshot& depth = snap.metrics[0];
+    const MetricSnapshot& events = snap.metrics[1];
+    const MetricSnapshot& latency = snap.metrics[2];
+    assert(depth.name == "depth" && depth.last == 42 && depth.min == 0 && depth.max == 42);
+    assert(events.name == "events" && events.sum == 4.0 * perThread);
+    assert(latency.count == 4u * perThread && latency.min == 1 && latency.max == 100);
+    double p50 = latency.quantile(0.5);
+    double p99 = latency.quantile(0.99);
+    std::cout << "p50 " << p50 << ", p99 " << p99 << "\n";
+    assert(std::abs(p50 - 50) <= 50 * 0.125 + 1);
+    assert(std::abs(p99 - 99) <= 99 * 0.125 + 1);
+    (void)depth;
+    (void)events;
+    (void)p50;
+    (void)p99;
+
+    std::cout << "✓ Lock-free shards merge exactly\n";
+}
+
+void test_throughput() {
+    std::cout << "\n=== Test: Throughput ===\n";
+
+    std::string block;
+    for (int i = 0; i < 1000; i++) {
+        block += i % 2 ? "{\"ts\":1700000000,\"metric\":\"rpc_ms\",\"type\":\"histogram\",\"value\":"
+                             + std::to_string(i % 37) + ".5}\n"
+                       : "ts=1700000000 level=info metric=requests msg=\"served\" value=1\n";
+    }
+
+    auto metrics = std::make_shared<TelemetryMetrics>();
+    TelemetryParser parser(metrics);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; i++) {
+        parser.feed(block.data(), block.size());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t records = metrics->snapshot().records;
+    double rate = static_cast<double>(records) / seconds;
+    std::cout << records << " records in " << seconds * 1000 << "ms ("
+              << rate / 1e6 << "M records/s, "
+              << static_cast<double>(block.size()) * 1000 / seconds / 1e6 << " MB/s)\n";
+    assert(records == 1000000);
+    if (rate < 1e5) {
+        throw std::runtime_error("parsed only " + std::to_string(rate) + " records/s");
+    }
+
+    std::cout << "✓ Parsing keeps up with 100k+ records per second\n";
+}
+
+void test_job_telemetry() {
+    std::cout << "\n=== Test: Job Telemetry ===\n";
+
+    SpawnOptions options;
+    options.command = "/bin/sh";
+    options.args = {"-c",
+                    "i=0; while [ $i -lt 500 ]; do echo 'metric=ticks' >&3; i=$((i+1)); done; "
+                    "echo '{\"metric\":\"depth\",\"type\":\"gauge\",\"value\":7}' >&3"};
+    options.background = true;
+
+    JobManager& jobs = getJobManager();
+    uint32_t jobId = jobs.spawn(options);
+    assert(jobId != 0);
+    JobControlBlock* job = jobs.getJob(jobId);
+    job->streams->closeStdin();
+    jobs.wait(jobId);
+    job->streams->waitForDrain(2000);
+    jobs.removeJob(jobId);
+
+    // The job is gone; its telemetry is not
+    auto entry = getTelemetryRegistry().find(jobId);
+    assert(entry.metrics);
+    TelemetrySnapshot snap = entry.metrics->snapshot();
+    assert(snap.records == 501);
+    assert(snap.metrics.size() == 2 && snap.metrics[1].sum == 500 && snap.metrics[0].last == 7);
+
+    // As shown by the builtin
+    std::ostringstream out, err;
+    std::string spec = "%";
+    spec += std::to_string(jobId);
+    std::vector<std::string> args = {spec};
+    executor::BuiltinContext ctx{args, out, err};
+    int status = executor::getBuiltins().find("telemetry")(ctx);
+    std::cout << out.str();
+    assert(status == 0);
+    assert(out.str().find("501 records") != std::string::npos);
+    assert(out.str().find("counter\tticks\ttotal 500") != std::string::npos);
+    assert(out.str().find("gauge\tdepth\tlast 7") != std::string::npos);
+
+    args = {"9999"};
+    executor::BuiltinContext missing{args, out, err};
+    status = executor::getBuiltins().find("telemetry")(missing);
+    assert(status == 1 && err.str().find("no such job") != std::string::npos);
+    (void)status;
+
+    std::cout << "✓ A job's stddbg aggregated and reported\n";
+}
+
+void test_job_stats() {
+    std::cout << "\n=== Test: Job Statistics ===\n";
+
+    // Burns some CPU and overflows a small stddbg buffer nobody reads
+    SpawnOptions options;
+    options.command = "/bin/sh";
+    options.args = {"-c",
+                    "head -c 65536 /dev/zero >&3; "
+                    "i=0; while [ $i -lt 50000 ]; do i=$((i+1)); done; echo done"};
+    options.background = true;
+    options.parseTelemetry = false;
+    options.streamOptions[static_cast<size_t>(StreamIndex::STDDBG)] = StreamOptions{4096, 4096, 64 * 1024, false};
+
+    uint64_t spawnsBefore = 0;
+    for (const auto& metric : getLatencyMetrics().snapshot().metrics) {
+        if (metric.name == kSpawnLatencyMetric) spawnsBefore = metric.count;
+    }
+
+    JobManager& jobs = getJobManager();
+    uint32_t jobId = jobs.spawn(options);
+    assert(jobId != 0);
+    JobControlBlock* job = jobs.getJob(jobId);
+    job->streams->closeStdin();
+    jobs.wait(jobId);
+    job->streams->waitForDrain(2000);
+    bool removed = jobs.removeJob(jobId);
+    assert(removed);
+    (void)removed;
+
+    // Retained after removal
+    JobStats stats;
+    bool found = jobs.getStats(jobId, stats);
+    assert(found);
+    (void)found;
+    const StreamStats& dbg = stats.streams[static_cast<size_t>(StreamIndex::STDDBG)];
+    std::cout << "wall " << stats.wallSeconds * 1000 << "ms, spawn " << stats.spawnSeconds * 1e6
+              << "us, first byte " << stats.firstByteSeconds * 1000 << "ms, cpu "
+              << (stats.usage.userSeconds + stats.usage.systemSeconds) * 1000 << "ms, rss "
+              << stats.usage.maxRssKb << " KiB\n";
+    assert(stats.state == JobState::TERMINATED && stats.exitCode == 0 && stats.processes == 1);
+    assert(stats.usage.userSeconds + stats.usage.systemSeconds > 0);
+    assert(stats.usage.maxRssKb > 0);
+    assert(stats.streams[static_cast<size_t>(StreamIndex::STDOUT)].bytes == 5);
+    assert(dbg.bytes == 65536 && dbg.dropped == 65536 - 4096);
+    assert(stats.spawnSeconds > 0 && stats.firstByteSeconds >= stats.spawnSeconds);
+    assert(stats.wallSeconds >= stats.firstByteSeconds);
+    (void)dbg;
+
+    // Both latencies reached the shell-wide histograms
+    uint64_t spawnsAfter = 0, firstBytes = 0;
+    for (const auto& metric : getLatencyMetrics().snapshot().metrics) {
+        if (metric.name == kSpawnLatencyMetric) spawnsAfter = metric.count;
+        if (metric.name == kFirstByteLatencyMetric) firstBytes = metric.count;
+    }
+    assert(spawnsAfter == spawnsBefore + 1 && firstBytes > 0);
+    (void)spawnsBefore;
+    (void)spawnsAfter;
+    (void)firstBytes;
+
+    // As shown by the builtin
+    std::string spec = "%";
+    spec += std::to_string(jobId);
+    std::ostringstream out, err;
+    std::vector<std::string> args = {"--stats", spec};
+    executor::BuiltinContext ctx{args, out, err};
+    int status = executor::getBuiltins().find("jobs")(ctx);
+    std::cout << out.str();
+    assert(status == 0);
+    assert(out.str().find(": TERMINATED, exit 0, 1 process") != std::string::npos);
+    assert(out.str().find("stddbg 65536 B (61440 dropped)") != std::string::npos);
+    assert(out.str().find("spawn latency: count") != std::string::npos);
+
+    std::ostringstream dump;
+    args = {"--json", spec};
+    executor::BuiltinContext jsonCtx{args, dump, err};
+    status = executor::getBuiltins().find("jobs")(jsonCtx);
+    std::string expectId = "{\"jobs\":[{\"id\":" + std::to_string(jobId) + ",";
+    assert(status == 0 && dump.str().rfind(expectId, 0) == 0);
+    assert(dump.str().find("\"stddbg\":{\"bytes\":65536,\"dropped\":61440}") != std::string::npos);
+    assert(dump.str().find("\"latency\":{\"spawn_us\":{\"count\":") != std::string::npos);
+
+    args = {"--stats", "9999"};
+    executor::BuiltinContext missing{args, out, err};
+    status = executor::getBuiltins().find("jobs")(missing);
+    assert(status == 1 && err.str().find("no such job") != std::string::npos);
+    (void)status;
+
+    std::cout << "✓ Resource usage, stream drops and latencies reported\n";
+}
+
+void test_concurrent_jobs() {
+    std::cout << "\n=== Test: Concurrent Spawn / Wait ===\n";
+
+    // Threads spawn, wait for and remove their own jobs side by side
+    JobManager& jobs = getJobManager();
+    constexpr int kThreads = 8;
+    constexpr int kJobsPerThread = 16;
+    std::vector<std::vector<uint32_t>> ids(kThreads);
+    std::vector<int> failures(kThreads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&jobs, &ids, &failures, t]() {
+            for (int i = 0; i < kJobsPerThread; ++i) {
+                SpawnOptions options;
+                options.command = "/bin/sh";
+                options.args = {"-c", "exit " + std::to_string(i % 4)};
+                options.background = true;
+                uint32_t jobId = jobs.spawn(options);
+                if (jobId == 0) {
+                    ++failures[t];
+                    continue;
+                }
+                jobs.getJob(jobId)->streams->closeStdin();
+                if (jobs.wait(jobId, 5000) != i % 4) ++failures[t];
+                jobs.getJob(jobId)->streams->waitForDrain(1000);
+                if (!jobs.removeJob(jobId)) ++failures[t];
+                ids[t].push_back(jobId);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<uint32_t> all;
+    for (int t = 0; t < kThreads; ++t) {
+        assert(failures[t] == 0);
+        all.insert(all.end(), ids[t].begin(), ids[t].end());
+    }
+    std::sort(all.begin(), all.end());
+    assert(all.size() == kThreads * kJobsPerThread);
+    assert(std::adjacent_find(all.begin(), all.end()) == all.end());
+    std::cout << "✓ " << all.size() << " jobs from " << kThreads << " threads, unique IDs and exit codes\n";
+
+    // wait() wakes on the pidfd, not on a polling interval
+    SpawnOptions options;
+    options.command = "/bin/sleep";
+    options.args = {"0.05"};
+    options.background = true;
+    uint32_t jobId = jobs.spawn(options);
+    assert(jobId != 0);
+    jobs.getJob(jobId)->streams->closeStdin();
+    auto start = std::chrono::steady_clock::now();
+    int status = jobs.wait(jobId);
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "sleep 0.05: wait returned after " << waited << "ms\n";
+    assert(status == 0 && waited < 100);
+
+    // A timeout still times out
+    options.args = {"5"};
+    jobId = jobs.spawn(options);
+    assert(jobId != 0);
+    jobs.getJob(jobId)->streams->closeStdin();
+    status = jobs.wait(jobId, 50);
+    uint32_t early = jobs.waitAny({jobId}, 50);
+    jobs.terminate(jobId, true);
+    uint32_t done = jobs.waitAny({jobId}, 5000);
+    assert(status == -1 && early == 0 && done == jobId);
+    (void)status;
+    (void)early;
+    (void)done;
+    jobs.getJob(jobId)->streams->waitForDrain(1000);
+    jobs.removeJob(jobId);
+    std::cout << "✓ wait() returns on exit; timeouts honoured\n";
+}
+
+int main() {
+    try {
+        test_record_formats();
+        test_split_records();
+        test_concurrent_aggregation();
+        test_throughput();
+        test_job_telemetry();
+        test_job_stats();
+        test_concurrent_jobs();
+
+        std::cout << "\n✅ All telemetry tests passed!\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << "\n";
+        return 1;
+    }
+}